@@ -10,6 +10,8 @@
 # - re-open and "Configure" your project again.
 #
 # @author Marty Stepp, Reid Watson, Rasmus Rygaard, Jess Fisher, etc.
+# @version 2026/10/18
+# - link pthread on Mac/Linux for the worker threads of headless batch mode
 # @version 2015/04/09
 # - decreased Mac stack size to avoid sporatic crashes on Mac systems
 # @version 2014/11/29
@@ -101,6 +103,7 @@ unix:!macx {
     QMAKE_CXXFLAGS += -Wno-dangling-field
     QMAKE_CXXFLAGS += -Wno-unused-const-variable
     LIBS += -ldl
+    LIBS += -lpthread
 }
 
 # increase system stack size (helpful for recursive programs)
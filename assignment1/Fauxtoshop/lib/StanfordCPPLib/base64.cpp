@@ -6,6 +6,11 @@
  * http://en.wikipedia.org/wiki/Base64
  *
  * @author Marty Stepp, based upon open-source Apache Base64 en/decoder
+ * @version 2026/10/18
+ * - rewrote encode and decode to work in caller-supplied buffers, with
+ *   SSSE3 and AVX2 versions chosen at run time; decode no longer copies
+ *   its result through a string stream or returns trailing zero bytes
+ * - added the Encoder and Decoder classes and stream versions
  * @version 2014/10/08
  * - removed 'using namespace' statement
  * 2014/08/14
@@ -15,7 +20,13 @@
 
 #include "base64.h"
 #include <cstring>
-#include <sstream>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BASE64_X86
+#include <immintrin.h>
+#define SSSE3_TARGET __attribute__((target("ssse3")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
 
 /* aaaack but it's fast and const should make it shared text page. */
 static const unsigned char pr2six[256] = {
@@ -53,122 +64,480 @@ int Base64decode_len(const char *bufcoded) {
 }
 
 int Base64decode(char *bufplain, const char *bufcoded) {
-    int nbytesdecoded;
-    const unsigned char *bufin;
-    unsigned char *bufout;
-    int nprbytes;
+    int nbytesdecoded = Base64::decode(bufcoded, (int) strlen(bufcoded), bufplain);
+    bufplain[nbytesdecoded] = '\0';
+    return nbytesdecoded;
+}
 
-    bufin = (const unsigned char *) bufcoded;
-    while (pr2six[*(bufin++)] <= 63);
-    nprbytes = (bufin - (const unsigned char *) bufcoded) - 1;
-    nbytesdecoded = ((nprbytes + 3) / 4) * 3;
+static const char basis_64[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-    bufout = (unsigned char *) bufplain;
-    bufin = (const unsigned char *) bufcoded;
+int Base64encode_len(int len) {
+    return ((len + 2) / 3 * 4) + 1;
+}
+
+int Base64encode(char *encoded, const char *string, int len) {
+    int n = Base64::encode(string, len, encoded);
+    encoded[n] = '\0';
+    return n + 1;
+}
+
+/*
+ * Implementation notes: vectorized encoding and decoding
+ * ------------------------------------------------------
+ * The SSSE3 and AVX2 versions follow the methods published by Wojciech
+ * Mula and Daniel Lemire, as used in Alfred Klomp's base64 library.
+ * Encoding spreads each 3 bytes over 4 bytes with a shuffle, moves the
+ * four 6-bit fields into place with two multiplies, and turns each field
+ * into its character by adding an offset looked up from its range.
+ * Decoding classifies each character by its two nibbles with two table
+ * lookups, which also detects characters outside the alphabet, then
+ * packs the 6-bit values back together with two multiply-adds.
+ *
+ * The vector loops stop at the first block that holds a character
+ * outside the alphabet, such as '=', and leave the rest to the scalar
+ * code.  They never read past the end of the input or write more than
+ * the bytes they produce, so the caller's buffers need no extra room.
+ * The versions are compiled with per-function target attributes, as in
+ * the kernels of planar.cpp, and picked on first use.
+ */
 
-    while (nprbytes > 4) {
-        *(bufout++) =
-                (unsigned char) (pr2six[*bufin] << 2 | pr2six[bufin[1]] >> 4);
-        *(bufout++) =
-                (unsigned char) (pr2six[bufin[1]] << 4 | pr2six[bufin[2]] >> 2);
-        *(bufout++) =
-                (unsigned char) (pr2six[bufin[2]] << 6 | pr2six[bufin[3]]);
-        bufin += 4;
-        nprbytes -= 4;
+/*
+ * Encodes the complete 3-byte groups of the n bytes at src and returns
+ * the number of bytes used.
+ */
+static int encodeGroupsScalar(const unsigned char* src, int n, char* dst) {
+    int i = 0;
+    for (; i + 3 <= n; i += 3) {
+        unsigned int group = (src[i] << 16) | (src[i + 1] << 8) | src[i + 2];
+        *dst++ = basis_64[group >> 18];
+        *dst++ = basis_64[(group >> 12) & 0x3F];
+        *dst++ = basis_64[(group >> 6) & 0x3F];
+        *dst++ = basis_64[group & 0x3F];
+    }
+    return i;
+}
+
+/*
+ * Encodes the last 1 or 2 bytes of the data with '=' padding and returns
+ * the number of characters written.
+ */
+static int encodeTail(const unsigned char* src, int n, char* dst) {
+    if (n <= 0) {
+        return 0;
+    }
+    unsigned int group = src[0] << 16;
+    if (n > 1) {
+        group |= src[1] << 8;
     }
+    dst[0] = basis_64[group >> 18];
+    dst[1] = basis_64[(group >> 12) & 0x3F];
+    dst[2] = n > 1 ? basis_64[(group >> 6) & 0x3F] : '=';
+    dst[3] = '=';
+    return 4;
+}
 
-    /* Note: (nprbytes == 1) would be an error, so just ingore that case */
-    if (nprbytes > 1) {
-        *(bufout++) =
-                (unsigned char) (pr2six[*bufin] << 2 | pr2six[bufin[1]] >> 4);
+/*
+ * Decodes the complete groups of 4 characters at the start of the n
+ * characters at src, stopping at a group that holds a character outside
+ * the alphabet.  Returns the number of characters used and adds the
+ * number of bytes written to 'written'.
+ */
+static int decodeGroupsScalar(const unsigned char* src, int n, unsigned char* dst, int& written) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        unsigned int a = pr2six[src[i]];
+        unsigned int b = pr2six[src[i + 1]];
+        unsigned int c = pr2six[src[i + 2]];
+        unsigned int d = pr2six[src[i + 3]];
+        if ((a | b | c | d) & 64) {
+            break;
+        }
+        unsigned int group = (a << 18) | (b << 12) | (c << 6) | d;
+        *dst++ = (unsigned char) (group >> 16);
+        *dst++ = (unsigned char) (group >> 8);
+        *dst++ = (unsigned char) group;
+        written += 3;
     }
-    if (nprbytes > 2) {
-        *(bufout++) =
-                (unsigned char) (pr2six[bufin[1]] << 4 | pr2six[bufin[2]] >> 2);
+    return i;
+}
+
+/*
+ * Decodes a group of n valid characters, where n is at most 4, and
+ * returns the number of bytes written.  A single leftover character
+ * holds too few bits for a byte and is ignored.
+ */
+static int decodePartial(const unsigned char* src, int n, unsigned char* dst) {
+    unsigned int group = 0;
+    for (int i = 0; i < 4; i++) {
+        group = (group << 6) | (i < n ? pr2six[src[i]] : 0);
     }
-    if (nprbytes > 3) {
-        *(bufout++) =
-                (unsigned char) (pr2six[bufin[2]] << 6 | pr2six[bufin[3]]);
+    int bytes = n == 4 ? 3 : n == 3 ? 2 : n == 2 ? 1 : 0;
+    for (int i = 0; i < bytes; i++) {
+        dst[i] = (unsigned char) (group >> (16 - 8 * i));
     }
+    return bytes;
+}
 
-    *(bufout++) = '\0';
-    nbytesdecoded -= (4 - nprbytes) & 3;
-    return nbytesdecoded;
+#ifdef BASE64_X86
+
+SSSE3_TARGET
+static inline __m128i encodeReshuffleSsse3(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7,
+                                           4, 5, 3, 4, 1, 2, 0, 1));
+    __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
 }
 
-static const char basis_64[] =
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+SSSE3_TARGET
+static inline __m128i encodeTranslateSsse3(__m128i indices) {
+    // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+    __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+    __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                    '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    return _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+}
 
-int Base64encode_len(int len) {
-    return ((len + 2) / 3 * 4) + 1;
+SSSE3_TARGET
+static int encodeGroupsSsse3(const unsigned char* src, int n, char* dst) {
+    int i = 0;
+    // each step reads 16 bytes and encodes the first 12
+    for (; i + 16 <= n; i += 12) {
+        __m128i in = _mm_loadu_si128((const __m128i*) (src + i));
+        __m128i out = encodeTranslateSsse3(encodeReshuffleSsse3(in));
+        _mm_storeu_si128((__m128i*) dst, out);
+        dst += 16;
+    }
+    return i + encodeGroupsScalar(src + i, n - i, dst);
 }
 
-int Base64encode(char *encoded, const char *string, int len) {
-    int i;
-    char *p;
-
-    p = encoded;
-    for (i = 0; i < len - 2; i += 3) {
-        *p++ = basis_64[(string[i] >> 2) & 0x3F];
-        *p++ = basis_64[((string[i] & 0x3) << 4) |
-                ((int) (string[i + 1] & 0xF0) >> 4)];
-        *p++ = basis_64[((string[i + 1] & 0xF) << 2) |
-                ((int) (string[i + 2] & 0xC0) >> 6)];
-        *p++ = basis_64[string[i + 2] & 0x3F];
-    }
-    if (i < len) {
-        *p++ = basis_64[(string[i] >> 2) & 0x3F];
-        if (i == (len - 1)) {
-            *p++ = basis_64[((string[i] & 0x3) << 4)];
-            *p++ = '=';
+SSSE3_TARGET
+static inline bool decodeTranslateSsse3(__m128i& str) {
+    const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                          0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2F = _mm_set1_epi8(0x2F);
+    __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask2F);
+    __m128i loNibbles = _mm_and_si128(str, mask2F);
+    __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+    __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0) {
+        return false;
+    }
+    __m128i eq2F = _mm_cmpeq_epi8(str, mask2F);
+    __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles));
+    str = _mm_add_epi8(str, roll);
+    return true;
+}
+
+SSSE3_TARGET
+static inline __m128i decodeReshuffleSsse3(__m128i values) {
+    __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    __m128i groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(groups, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                                  14, 13, 12, -1, -1, -1, -1));
+}
+
+SSSE3_TARGET
+static int decodeGroupsSsse3(const unsigned char* src, int n, unsigned char* dst, int& written) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i str = _mm_loadu_si128((const __m128i*) (src + i));
+        if (!decodeTranslateSsse3(str)) {
+            break;
         }
-        else {
-            *p++ = basis_64[((string[i] & 0x3) << 4) |
-                    ((int) (string[i + 1] & 0xF0) >> 4)];
-            *p++ = basis_64[((string[i + 1] & 0xF) << 2)];
+        __m128i out = decodeReshuffleSsse3(str);
+        _mm_storel_epi64((__m128i*) dst, out);
+        int last = _mm_cvtsi128_si32(_mm_srli_si128(out, 8));
+        std::memcpy(dst + 8, &last, 4);
+        dst += 12;
+        written += 12;
+    }
+    return i + decodeGroupsScalar(src + i, n - i, dst, written);
+}
+
+AVX2_TARGET
+static int encodeGroupsAvx2(const unsigned char* src, int n, char* dst) {
+    int i = 0;
+    // each step encodes 24 bytes, 12 per 128-bit lane, reading 28
+    for (; i + 28 <= n; i += 24) {
+        __m128i lo = _mm_loadu_si128((const __m128i*) (src + i));
+        __m128i hi = _mm_loadu_si128((const __m128i*) (src + i + 12));
+        __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        in = _mm256_shuffle_epi8(in, _mm256_setr_epi8(
+                1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+        __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+        __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+        __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        __m256i indices = _mm256_or_si256(t1, t3);
+        __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        range = _mm256_or_si256(range, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+        __m256i offsets = _mm256_setr_epi8(
+                'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+                'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+        __m256i out = _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices);
+        _mm256_storeu_si256((__m256i*) dst, out);
+        dst += 32;
+    }
+    return i + encodeGroupsSsse3(src + i, n - i, dst);
+}
+
+AVX2_TARGET
+static int decodeGroupsAvx2(const unsigned char* src, int n, unsigned char* dst, int& written) {
+    const __m256i lutLo = _mm256_setr_epi8(
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lutHi = _mm256_setr_epi8(
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lutRoll = _mm256_setr_epi8(
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask2F = _mm256_set1_epi8(0x2F);
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i str = _mm256_loadu_si256((const __m256i*) (src + i));
+        __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask2F);
+        __m256i loNibbles = _mm256_and_si256(str, mask2F);
+        __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+        __m256i lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+        if (_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_and_si256(lo, hi),
+                                                   _mm256_setzero_si256())) != 0) {
+            break;
         }
-        *p++ = '=';
+        __m256i eq2F = _mm256_cmpeq_epi8(str, mask2F);
+        __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(eq2F, hiNibbles));
+        str = _mm256_add_epi8(str, roll);
+        __m256i pairs = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+        __m256i groups = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+        groups = _mm256_shuffle_epi8(groups, _mm256_setr_epi8(
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        // move the 12 bytes of the upper lane next to those of the lower one
+        groups = _mm256_permutevar8x32_epi32(groups, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm_storeu_si128((__m128i*) dst, _mm256_castsi256_si128(groups));
+        _mm_storel_epi64((__m128i*) (dst + 16), _mm256_extracti128_si256(groups, 1));
+        dst += 24;
+        written += 24;
     }
+    return i + decodeGroupsSsse3(src + i, n - i, dst, written);
+}
+
+#endif // BASE64_X86
 
-    *p++ = '\0';
-    return p - encoded;
+/*
+ * The instruction sets the codec can use, best last.
+ */
+enum Base64Level { BASE64_SCALAR, BASE64_SSSE3, BASE64_AVX2 };
+
+static Base64Level bestSupportedLevel() {
+#ifdef BASE64_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return BASE64_AVX2;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return BASE64_SSSE3;
+    }
+#endif
+    return BASE64_SCALAR;
+}
+
+static Base64Level currentLevel() {
+    static const Base64Level level = bestSupportedLevel();
+    return level;
+}
+
+static int encodeGroups(const unsigned char* src, int n, char* dst) {
+    switch (currentLevel()) {
+#ifdef BASE64_X86
+    case BASE64_AVX2: return encodeGroupsAvx2(src, n, dst);
+    case BASE64_SSSE3: return encodeGroupsSsse3(src, n, dst);
+#endif
+    default: return encodeGroupsScalar(src, n, dst);
+    }
+}
+
+static int decodeGroups(const unsigned char* src, int n, unsigned char* dst, int& written) {
+    switch (currentLevel()) {
+#ifdef BASE64_X86
+    case BASE64_AVX2: return decodeGroupsAvx2(src, n, dst, written);
+    case BASE64_SSSE3: return decodeGroupsSsse3(src, n, dst, written);
+#endif
+    default: return decodeGroupsScalar(src, n, dst, written);
+    }
 }
 
 namespace Base64 {
+/* number of bytes read at a time by the stream versions; a multiple of 3 and 4 */
+static const int STREAM_BLOCK_SIZE = 3 * 4 * 1024;
+
 std::string encode(const std::string& s) {
-    // make C char* buffer to store the encoded output (for compatibility)
-    int len = Base64encode_len(s.length());
-    char* buf = (char*) malloc(len);
-    memset(buf, 0, len);
-    Base64encode(buf, s.c_str(), s.length());
-    
-    // convert back into a C++ string, and return it
-    // (unlike below in decode(), I can just directly construct the C++
-    // string from the C one, because the Base64-encoded C string will
-    // not contain any intermediate null bytes by definition)
-    std::string result(buf);
-    free(buf);
+    std::string result(encodedLength(s.length()), '\0');
+    if (!s.empty()) {
+        encode(s.data(), s.length(), &result[0]);
+    }
     return result;
 }
 
 std::string decode(const std::string& s) {
-    // convert into C string and decode into that char* buffer
-    const char* cstr = s.c_str();
-    int len = Base64decode_len(cstr);
-    char* buf = (char*) malloc(len);
-    memset(buf, 0, len);
-    Base64decode(buf, cstr);
-    
-    // read bytes from that buffer into a C++ string
-    // (cannot just construct/assign C++ string from C char* buffer,
-    // because that will terminate the string at the first null \0 byte)
-    std::ostringstream out;
-    for (int i = 0; i < len; i++) {
-        out << (char) buf[i];
-    }
-    std::string result = out.str();
-    
-    free(buf);
+    std::string result(maxDecodedLength(s.length()), '\0');
+    if (!result.empty()) {
+        result.resize(decode(s.data(), s.length(), &result[0]));
+    }
     return result;
 }
+
+int encodedLength(int n) {
+    return (n + 2) / 3 * 4;
+}
+
+int maxDecodedLength(int n) {
+    return n / 4 * 3 + 2;
+}
+
+int encode(const char* src, int n, char* dst) {
+    const unsigned char* in = (const unsigned char*) src;
+    int used = encodeGroups(in, n, dst);
+    char* out = dst + used / 3 * 4;
+    out += encodeTail(in + used, n - used, out);
+    return out - dst;
+}
+
+int decode(const char* src, int n, char* dst) {
+    const unsigned char* in = (const unsigned char*) src;
+    unsigned char* out = (unsigned char*) dst;
+    int written = 0;
+    int used = decodeGroups(in, n, out, written);
+    int valid = 0;
+    while (used + valid < n && valid < 4 && pr2six[in[used + valid]] <= 63) {
+        valid++;
+    }
+    return written + decodePartial(in + used, valid, out + written);
+}
+
+void encode(std::istream& input, std::ostream& output) {
+    char in[STREAM_BLOCK_SIZE];
+    char out[STREAM_BLOCK_SIZE / 3 * 4 + 4];
+    Encoder encoder;
+    while (input.read(in, STREAM_BLOCK_SIZE) || input.gcount() > 0) {
+        output.write(out, encoder.encode(in, input.gcount(), out));
+    }
+    output.write(out, encoder.finish(out));
+}
+
+void decode(std::istream& input, std::ostream& output) {
+    char in[STREAM_BLOCK_SIZE];
+    char out[STREAM_BLOCK_SIZE / 4 * 3 + 8];
+    Decoder decoder;
+    while (!decoder.isDone() && (input.read(in, STREAM_BLOCK_SIZE) || input.gcount() > 0)) {
+        output.write(out, decoder.decode(in, input.gcount(), out));
+    }
+    output.write(out, decoder.finish(out));
+}
+
+Encoder::Encoder() : pendingCount(0) {
+    // empty
+}
+
+int Encoder::encode(const char* src, int n, char* dst) {
+    const unsigned char* in = (const unsigned char*) src;
+    char* out = dst;
+    if (pendingCount > 0) {
+        if (pendingCount + n < 3) {
+            std::memcpy(pending + pendingCount, in, n);
+            pendingCount += n;
+            return 0;
+        }
+        unsigned char group[3];
+        int taken = 3 - pendingCount;
+        std::memcpy(group, pending, pendingCount);
+        std::memcpy(group + pendingCount, in, taken);
+        out += encodeGroupsScalar(group, 3, out) / 3 * 4;
+        in += taken;
+        n -= taken;
+        pendingCount = 0;
+    }
+    int used = encodeGroups(in, n, out);
+    out += used / 3 * 4;
+    pendingCount = n - used;
+    std::memcpy(pending, in + used, pendingCount);
+    return out - dst;
+}
+
+int Encoder::finish(char* dst) {
+    int written = encodeTail(pending, pendingCount, dst);
+    pendingCount = 0;
+    return written;
+}
+
+Decoder::Decoder() : pendingCount(0), done(false) {
+    // empty
+}
+
+int Decoder::decode(const char* src, int n, char* dst) {
+    if (done) {
+        return 0;
+    }
+    const unsigned char* in = (const unsigned char*) src;
+    unsigned char* out = (unsigned char*) dst;
+    unsigned char* group = (unsigned char*) pending;
+    int written = 0;
+    int i = 0;
+    if (pendingCount > 0) {
+        while (pendingCount < 4 && i < n && pr2six[in[i]] <= 63) {
+            pending[pendingCount++] = in[i++];
+        }
+        if (pendingCount < 4) {
+            if (i == n) {
+                return 0;   // the rest of the group is still to come
+            }
+            written = decodePartial(group, pendingCount, out);
+            pendingCount = 0;
+            done = true;
+            return written;
+        }
+        written += decodePartial(group, 4, out);
+        pendingCount = 0;
+    }
+    i += decodeGroups(in + i, n - i, out + written, written);
+    while (i < n && pr2six[in[i]] <= 63) {
+        pending[pendingCount++] = in[i++];
+    }
+    if (i < n) {
+        written += decodePartial(group, pendingCount, out + written);
+        pendingCount = 0;
+        done = true;
+    }
+    return written;
+}
+
+int Decoder::finish(char* dst) {
+    int written = decodePartial((unsigned char*) pending, pendingCount, (unsigned char*) dst);
+    pendingCount = 0;
+    done = false;
+    return written;
+}
+
+bool Decoder::isDone() const {
+    return done;
+}
 }
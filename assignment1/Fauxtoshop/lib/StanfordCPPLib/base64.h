@@ -6,6 +6,10 @@
  * http://en.wikipedia.org/wiki/Base64
  *
  * @author Marty Stepp, based upon open-source Apache Base64 en/decoder
+ * @version 2026/10/18
+ * - added functions that encode and decode into caller-supplied buffers,
+ *   and the Encoder and Decoder classes for data that arrives in chunks
+ * - encoding and decoding use SSSE3 or AVX2 instructions when available
  * @version 2014/08/03
  * @since 2014/08/03
  */
@@ -27,6 +31,8 @@ int Base64decode(char* plain_dst, const char* coded_src);
 #ifdef __cplusplus
 }
 
+#include <istream>
+#include <ostream>
 #include <string>
 
 namespace Base64 {
@@ -37,9 +43,110 @@ std::string encode(const std::string& s);
 
 /*
  * Decodes the given Base64-encoded string and returns the decoded
- * original contents.
+ * original contents.  Decoding stops at the first character that is not
+ * part of the Base64 alphabet, such as the '=' padding at the end.
  */
 std::string decode(const std::string& s);
+
+/*
+ * Returns the number of characters encode produces for n bytes.
+ */
+int encodedLength(int n);
+
+/*
+ * Returns the largest number of bytes decode can produce from n
+ * characters.
+ */
+int maxDecodedLength(int n);
+
+/*
+ * Encodes the n bytes at src into dst, which must have room for
+ * encodedLength(n) characters, and returns the number of characters
+ * written.  No terminating null character is written.
+ */
+int encode(const char* src, int n, char* dst);
+
+/*
+ * Decodes the n characters at src into dst, which must have room for
+ * maxDecodedLength(n) bytes, and returns the number of bytes written.
+ * As with the string version, decoding stops at the first character that
+ * is not part of the Base64 alphabet.
+ */
+int decode(const char* src, int n, char* dst);
+
+/*
+ * Encodes or decodes everything remaining in the input stream to the
+ * output stream, a block at a time, so that neither the whole input nor
+ * the whole output is ever held in memory.
+ */
+void encode(std::istream& input, std::ostream& output);
+void decode(std::istream& input, std::ostream& output);
+
+/*
+ * Class: Encoder
+ * --------------
+ * Encodes data that arrives in pieces.  Each call to encode writes the
+ * characters for as many whole 3-byte groups as are available and keeps
+ * the rest for the next call; finish writes the final, padded group.
+ * The output is the same as encoding all of the data at once.
+ */
+class Encoder {
+public:
+    Encoder();
+
+    /*
+     * Encodes the next n bytes into dst, which must have room for
+     * encodedLength(n + 2) characters, and returns the number of
+     * characters written.
+     */
+    int encode(const char* src, int n, char* dst);
+
+    /*
+     * Writes the last characters, at most 4, into dst and returns how many
+     * were written.  The encoder can then be used for new data.
+     */
+    int finish(char* dst);
+
+private:
+    unsigned char pending[2];
+    int pendingCount;
+};
+
+/*
+ * Class: Decoder
+ * --------------
+ * Decodes data that arrives in pieces, with the same result as decoding
+ * all of it at once.  Once a character outside the Base64 alphabet has
+ * been seen, the decoder is done and ignores the rest of its input.
+ */
+class Decoder {
+public:
+    Decoder();
+
+    /*
+     * Decodes the next n characters into dst, which must have room for
+     * maxDecodedLength(n + 3) bytes, and returns the number of bytes
+     * written.
+     */
+    int decode(const char* src, int n, char* dst);
+
+    /*
+     * Writes the bytes of a final, unpadded group, at most 2, into dst and
+     * returns how many were written.  The decoder can then be used for new
+     * data.
+     */
+    int finish(char* dst);
+
+    /*
+     * Returns true if the decoder has reached the end of its data.
+     */
+    bool isDone() const;
+
+private:
+    char pending[4];
+    int pendingCount;
+    bool done;
+};
 }
 #endif
 
@@ -7,6 +7,10 @@
  * how a client properly uses these classes.
  *
  * @author Keith Schwarz, Eric Roberts, Marty Stepp
+ * @version 2026/10/18
+ * - readBit/writeBit use a 64-bit bit buffer instead of calling tellg/get
+ *   and tellp/seekp/put for every bit
+ * - added readBits, peekBits, readBytes, writeBits and writeBytes
  * @version 2014/10/08
  * - removed 'using namespace' statement
  * 2014/01/23
@@ -20,16 +24,6 @@
 #include "error.h"
 #include "strlib.h"
 
-static const int NUM_BITS_IN_BYTE = 8;
-
-inline int GetNthBit(int n, int fromByte) {
-    return ((fromByte & (1 << n)) != 0);
-}
-
-inline void SetNthBit(int n, int & inByte) {
-    inByte |= (1 << n);
-}
-
 /*
  * Returns a printable string for the given character.
  */
@@ -61,23 +55,27 @@ static std::string toPrintable(int ch) {
 
 /* Constructor ibitstream::ibitstream
  * ----------------------------------
- * Each ibitstream tracks 3 integers as private data.
- * "lastTell" is streampos of the last byte that was read (this is used
- * to detect when other non-readBit activity has changed the tell)
- * "curByte" contains contents of byte currently being read
- * "pos" is the bit position within curByte that is next to read
- * We set initial state for lastTell and curByte to 0, then pos is
- * set at 8 so that next readBit will trigger a fresh read.
+ * Each ibitstream reads through its own BitBuffer, which passes requests
+ * on to the real buffer that a subclass attaches.
+ * "bits" holds bits that have been taken from the real buffer but not yet
+ * returned by readBit or readBits, with the next bit in the lowest place,
+ * and "bitCount" says how many there are.  Bytes are taken from the real
+ * buffer a chunk at a time.  Whenever the client uses the stream in some
+ * other way, the real buffer is moved back over the bytes that were read
+ * ahead, so it is positioned just after the byte currently being read, as
+ * it was when every bit was read with get.  This relies on the real
+ * buffer being able to seek, which file and string buffers can.
  */
-ibitstream::ibitstream() : std::istream(NULL), lastTell(0), curByte(0), pos(NUM_BITS_IN_BYTE) {
-    this->fake = false;
+ibitstream::ibitstream() : std::istream(NULL), bits(0), bitCount(0),
+        chunkPos(0), chunkEnd(0), fake(false) {
+    buffer.real = NULL;
+    buffer.owner = this;
 }
 
 /* Member function ibitstream::readBit
  * -----------------------------------
- * If bits remain in curByte, retrieve next and increment pos
- * Else if end of curByte (or some other read happened), then read next byte
- * and start reading from bit position 0 of that byte.
+ * If bits remain from the current byte, return the next one.
+ * Otherwise read the next byte from the stream and start on its lowest bit.
  * If read byte from file at EOF, return EOF.
  */
 int ibitstream::readBit() {
@@ -93,21 +91,123 @@ int ibitstream::readBit() {
             return 1;
         }
     } else {
-        // if just finished bits from curByte or if data read from stream after last readBit()
-        if (lastTell != tellg() || pos == NUM_BITS_IN_BYTE) {
-            if ((curByte = get()) == EOF) {
-                // read next single byte from file
-                return EOF;
-            }
-            pos = 0; // start reading from first bit of new byte
-            lastTell = tellg();
+        if (bitCount == 0 && !fillBits(1)) {
+            setstate(std::ios::eofbit | std::ios::failbit);
+            return EOF;
         }
-        int result = GetNthBit(pos, curByte);
-        pos++;   // advance bit position for next call to readBit
+        int result = (int) (bits & 1);
+        bits >>= 1;
+        bitCount--;
         return result;
     }
 }
 
+/* Member function ibitstream::readBits
+ * ------------------------------------
+ * Makes sure at least n bits are buffered, then takes the lowest n.  Reads
+ * of more than 57 bits are split in two so the buffer never overflows.
+ */
+unsigned long long ibitstream::readBits(int n) {
+    if (!is_open()) {
+        error("ibitstream::readBits: Cannot read bits from a stream that is not open.");
+    }
+    if (n < 0 || n > 64) {
+        error("ibitstream::readBits: number of bits must be between 0 and 64, but was "
+              + integerToString(n));
+    }
+
+    if (n > 57) {
+        unsigned long long low = readBits(32);
+        return low | (readBits(n - 32) << 32);
+    }
+    if (this->fake) {
+        unsigned long long value = 0;
+        for (int i = 0; i < n; i++) {
+            int bit = readBit();
+            if (bit == EOF) {
+                break;
+            }
+            value |= (unsigned long long) bit << i;
+        }
+        return value;
+    }
+    if (bitCount < n && !fillBits(n)) {
+        setstate(std::ios::eofbit | std::ios::failbit);
+        n = bitCount;
+    }
+    unsigned long long value = bits & ((1ULL << n) - 1);
+    bits >>= n;
+    bitCount -= n;
+    return value;
+}
+
+/* Member function ibitstream::peekBits
+ * ------------------------------------
+ * Buffers enough bits to cover n, reading whole bytes ahead if needed.
+ * Bits past the end are zero because the buffer is zero above bitCount.
+ */
+unsigned long long ibitstream::peekBits(int n) {
+    if (!is_open()) {
+        error("ibitstream::peekBits: Cannot read bits from a stream that is not open.");
+    }
+    if (n < 0 || n > 57) {
+        error("ibitstream::peekBits: number of bits must be between 0 and 57, but was "
+              + integerToString(n));
+    }
+    if (this->fake) {
+        error("ibitstream::peekBits: cannot peek in fake mode");
+    }
+    fillBits(n);
+    return bits & ((1ULL << n) - 1);
+}
+
+/* Member function ibitstream::readBytes
+ * -------------------------------------
+ * On a byte boundary, hands out any whole bytes read ahead and then copies
+ * the rest straight from the real buffer.  Otherwise every byte straddles
+ * two bytes of the stream and is assembled from the bit buffer.
+ */
+int ibitstream::readBytes(char* out, int n) {
+    if (!is_open()) {
+        error("ibitstream::readBytes: Cannot read bytes from a stream that is not open.");
+    }
+    int count = 0;
+    if (this->fake) {
+        for (; count < n; count++) {
+            unsigned long long value = readBits(8);
+            if (fail()) {
+                break;
+            }
+            out[count] = (char) value;
+        }
+    } else if (bitCount % 8 == 0) {
+        for (; count < n && bitCount > 0; count++) {
+            out[count] = (char) bits;
+            bits >>= 8;
+            bitCount -= 8;
+        }
+        for (; count < n && chunkPos < chunkEnd; count++) {
+            out[count] = chunk[chunkPos++];
+        }
+        if (count < n && buffer.real != NULL && good()) {
+            count += (int) buffer.real->sgetn(out + count, n - count);
+        }
+    } else {
+        for (; count < n; count++) {
+            if (bitCount < 8 && !fillBits(8)) {
+                break;
+            }
+            out[count] = (char) bits;
+            bits >>= 8;
+            bitCount -= 8;
+        }
+    }
+    if (count < n) {
+        setstate(std::ios::eofbit | std::ios::failbit);
+    }
+    return count;
+}
+
 /* Member function ibitstream::rewind
  * ----------------------------------
  * Simply seeks back to beginning of file, so reading begins again
@@ -129,17 +229,21 @@ void ibitstream::setFake(bool fake) {
  * --------------------------------
  * Seek to file end and use tell to retrieve position.
  * In order to not disrupt reading, we also record cur streampos and
- * re-seek to there before returning.
+ * re-seek to there before returning.  This works on the real buffer so
+ * that the rest of a partly read byte is kept.
  */
 long ibitstream::size() {
     if (!is_open()) {
         error("ibitstream::size: Cannot get size of stream which is not open.");
     }
     clear();					// clear any error state
-    streampos cur = tellg();	// save current streampos
-    seekg(0, std::ios::end);			// seek to end
-    streampos end = tellg();	// get offset
-    seekg(cur);					// seek back to original pos
+    if (buffer.real == NULL) {
+        return 0;
+    }
+    returnReadAhead();
+    std::streampos cur = buffer.real->pubseekoff(0, std::ios::cur, std::ios::in);
+    std::streampos end = buffer.real->pubseekoff(0, std::ios::end, std::ios::in);
+    buffer.real->pubseekpos(cur, std::ios::in);
     return long(end);
 }
 
@@ -152,29 +256,149 @@ bool ibitstream::is_open() {
     return true;
 }
 
+void ibitstream::attach(std::streambuf* sb) {
+    buffer.real = sb;
+    resetBits();
+    init(&buffer);
+}
+
+void ibitstream::resetBits() {
+    bits = 0;
+    bitCount = 0;
+    chunkPos = 0;
+    chunkEnd = 0;
+}
+
+/*
+ * Reads whole bytes from the real buffer until at least n bits (at most 57)
+ * are buffered.  Returns false if the stream ends first.  Like get, this
+ * reads nothing once the stream is in a failed or end-of-file state.
+ */
+bool ibitstream::fillBits(int n) {
+    if (bitCount >= n) {
+        return true;
+    }
+    if (buffer.real == NULL || !good()) {
+        return false;
+    }
+    while (bitCount < n) {
+        if (chunkPos == chunkEnd) {
+            chunkPos = 0;
+            chunkEnd = (int) buffer.real->sgetn(chunk, CHUNK_SIZE);
+            if (chunkEnd <= 0) {
+                chunkEnd = 0;
+                return false;
+            }
+        }
+        // take as many whole bytes as fit, not just as many as needed
+        while (bitCount <= 56 && chunkPos < chunkEnd) {
+            bits |= (unsigned long long) (unsigned char) chunk[chunkPos++] << bitCount;
+            bitCount += 8;
+        }
+    }
+    return true;
+}
+
+/*
+ * Puts the whole bytes that were read ahead back into the real buffer by
+ * seeking back over them, keeping the rest of the current byte.
+ */
+void ibitstream::returnReadAhead() {
+    int wholeBytes = bitCount / 8 + (chunkEnd - chunkPos);
+    if (wholeBytes > 0) {
+        buffer.real->pubseekoff(-wholeBytes, std::ios::cur, std::ios::in);
+        bitCount %= 8;
+        bits &= (1ULL << bitCount) - 1;
+        chunkPos = 0;
+        chunkEnd = 0;
+    }
+}
+
+/*
+ * Called before another kind of read: like the old tellg check, this
+ * makes the next readBit start on a fresh byte.
+ */
+void ibitstream::dropBits() {
+    returnReadAhead();
+    resetBits();
+}
+
+ibitstream::BitBuffer::int_type ibitstream::BitBuffer::underflow() {
+    owner->returnReadAhead();
+    return real->sgetc();
+}
+
+ibitstream::BitBuffer::int_type ibitstream::BitBuffer::uflow() {
+    owner->dropBits();
+    return real->sbumpc();
+}
+
+std::streamsize ibitstream::BitBuffer::xsgetn(char* s, std::streamsize n) {
+    if (n <= 0) {
+        return 0;
+    }
+    owner->dropBits();
+    return real->sgetn(s, n);
+}
+
+ibitstream::BitBuffer::int_type ibitstream::BitBuffer::pbackfail(int_type ch) {
+    owner->dropBits();
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return real->sungetc();
+    } else {
+        return real->sputbackc(traits_type::to_char_type(ch));
+    }
+}
+
+std::streamsize ibitstream::BitBuffer::showmanyc() {
+    owner->returnReadAhead();
+    return real->in_avail();
+}
+
+ibitstream::BitBuffer::pos_type ibitstream::BitBuffer::seekoff(off_type off,
+                                                               std::ios_base::seekdir dir,
+                                                               std::ios_base::openmode which) {
+    if (off == 0 && dir == std::ios::cur) {
+        owner->returnReadAhead();   // just asking where we are
+    } else {
+        owner->dropBits();
+    }
+    return real->pubseekoff(off, dir, which);
+}
+
+ibitstream::BitBuffer::pos_type ibitstream::BitBuffer::seekpos(pos_type pos,
+                                                               std::ios_base::openmode which) {
+    owner->dropBits();
+    return real->pubseekpos(pos, which);
+}
+
+int ibitstream::BitBuffer::sync() {
+    return real->pubsync();
+}
+
 /* Constructor obitstream::obitstream
  * ----------------------------------
- * Each obitstream tracks 3 integers as private data.
- * "lastTell" is streampos of the last byte that was written (this is used
- * to detect when other non-writeBit activity has changed the tell)
- * "curByte" contains contents of byte currently being written
- * "pos" is the bit position within curByte that is next to write
- * We set initial state for lastTell and curByte to 0, then pos is
- * set at 8 so that next writeBit will start a new byte.
+ * Each obitstream writes through its own BitBuffer, which passes requests
+ * on to the real buffer that a subclass attaches.
+ * "bits" holds the bits of the last, unfinished byte and "bitCount" says
+ * how many there are; finished bytes are collected in "chunk" and passed
+ * to the real buffer a chunk at a time.
+ * The pending bytes and the unfinished byte, padded with zeros, are
+ * written out when the client
+ * uses the stream in any other way, so that mixing writeBit with put and
+ * << gives the same file as before.  "partialWritten" records that the
+ * byte has been written early, so the next bit must overwrite it.
  */
-obitstream::obitstream() : std::ostream(NULL), lastTell(0), curByte(0), pos(NUM_BITS_IN_BYTE) {
-    this->fake = false;
+obitstream::obitstream() : std::ostream(NULL), bits(0), bitCount(0),
+        chunkLength(0), partialWritten(false), fake(false) {
+    buffer.real = NULL;
+    buffer.owner = this;
 }
 
 /* Member function obitstream::writeBit
  * ------------------------------------
- * If bits remain to be written in curByte, add bit into byte and increment pos
- * Else if end of curByte (or some other write happened), then start a fresh
- * byte at position 0.
- * We write the byte out for each bit (backing up to overwrite as needed), rather
- * than waiting for 8 bits.	 This is because the client might make
- * 3 writeBit calls and then start using << so we can't wait til full-byte
- * boundary to flush any partial-byte bits.
+ * Adds the bit to the unfinished byte, which is written once it is full
+ * or when the stream is used in some other way.
  */
 void obitstream::writeBit(int bit) {
     if (bit != 0 && bit != 1) {
@@ -188,26 +412,60 @@ void obitstream::writeBit(int bit) {
     if (this->fake) {
         put(bit == 1 ? '1' : '0');
     } else {
-        // if just filled curByte or if data written to stream after last writeBit()
-        if (lastTell != tellp() || pos == NUM_BITS_IN_BYTE) {
-            curByte = 0;   // zero out byte for next writes
-            pos = 0;	   // start writing to first bit of new byte
-        }
+        putBits(bit, 1);
+    }
+}
 
-        if (bit) {
-            // only need to change if bit needs to be 1 (byte starts already zeroed)
-            SetNthBit(pos, curByte);
-        }
+/* Member function obitstream::writeBits
+ * -------------------------------------
+ * Masks the value to n bits and adds them after the bits already in the
+ * unfinished byte.  Writes of more than 56 bits are split in two so the
+ * buffer never overflows.
+ */
+void obitstream::writeBits(unsigned long long value, int n) {
+    if (n < 0 || n > 64) {
+        error("obitstream::writeBits: number of bits must be between 0 and 64, but was "
+              + integerToString(n));
+    }
+    if (!is_open()) {
+        error("obitstream::writeBits: stream is not open");
+    }
 
-        if (pos == 0 || bit) {   // only write if first bit in byte or changing 0 to 1
-            if (pos != 0) {
-                seekp(-1, std::ios::cur);   // back up to overwite if pos > 0
-            }
-            put(curByte);
+    if (n < 64) {
+        value &= (1ULL << n) - 1;
+    }
+    if (this->fake) {
+        for (int i = 0; i < n; i++) {
+            put(((value >> i) & 1) ? '1' : '0');
         }
+    } else if (n > 56) {
+        putBits(value & 0xffffffffULL, 32);
+        putBits(value >> 32, n - 32);
+    } else {
+        putBits(value, n);
+    }
+}
 
-        pos++; // advance to next bit position for next write
-        lastTell = tellp();
+/* Member function obitstream::writeBytes
+ * --------------------------------------
+ * On a byte boundary the bytes are copied straight to the real buffer;
+ * otherwise each one is written as 8 bits.
+ */
+void obitstream::writeBytes(const char* data, int n) {
+    if (!is_open()) {
+        error("obitstream::writeBytes: stream is not open");
+    }
+    if (this->fake || bitCount != 0) {
+        for (int i = 0; i < n; i++) {
+            writeBits((unsigned char) data[i], 8);
+        }
+    } else if (buffer.real == NULL) {
+        setstate(std::ios::badbit);
+    } else {
+        flushChunk();
+        if (buffer.real->sputn(data, n) != n) {
+            setstate(std::ios::badbit);
+        }
     }
 }
 
@@ -219,17 +477,21 @@ void obitstream::setFake(bool fake) {
  * --------------------------------
  * Seek to file end and use tell to retrieve position.
  * In order to not disrupt writing, we also record cur streampos and
- * re-seek to there before returning.
+ * re-seek to there before returning.  The unfinished byte is written
+ * first so that it is counted, but later bits still go into it.
  */
 long obitstream::size() {
     if (!is_open()) {
         error("obitstream::size: stream is not open");
     }
     clear();					// clear any error state
-    streampos cur = tellp();	// save current streampos
-    seekp(0, std::ios::end);			// seek to end
-    streampos end = tellp();	// get offset
-    seekp(cur);					// seek back to original pos
+    if (buffer.real == NULL) {
+        return 0;
+    }
+    showPartialByte();
+    std::streampos cur = buffer.real->pubseekoff(0, std::ios::cur, std::ios::out);
+    std::streampos end = buffer.real->pubseekoff(0, std::ios::end, std::ios::out);
+    buffer.real->pubseekpos(cur, std::ios::out);
     return long(end);
 }
 
@@ -242,13 +504,112 @@ bool obitstream::is_open() {
     return true;
 }
 
+void obitstream::attach(std::streambuf* sb) {
+    buffer.real = sb;
+    bits = 0;
+    bitCount = 0;
+    chunkLength = 0;
+    partialWritten = false;
+    init(&buffer);
+}
+
+void obitstream::finishByte() {
+    showPartialByte();
+    bits = 0;
+    bitCount = 0;
+    partialWritten = false;
+}
+
+void obitstream::showPartialByte() {
+    flushChunk();
+    if (bitCount > 0 && !partialWritten && buffer.real != NULL) {
+        buffer.real->sputc((char) bits);
+        partialWritten = true;
+    }
+}
+
+/*
+ * Passes the finished bytes collected so far to the real buffer.
+ */
+void obitstream::flushChunk() {
+    if (chunkLength > 0 && buffer.real != NULL) {
+        if (buffer.real->sputn(chunk, chunkLength) != chunkLength) {
+            setstate(std::ios::badbit);
+        }
+    }
+    chunkLength = 0;
+}
+
+/*
+ * Adds n bits (at most 56) of an already masked value to the stream.
+ */
+void obitstream::putBits(unsigned long long value, int n) {
+    if (buffer.real == NULL) {
+        setstate(std::ios::badbit);
+        return;
+    }
+    if (partialWritten) {
+        // back up to overwrite the padded byte written earlier
+        buffer.real->pubseekoff(-1, std::ios::cur, std::ios::out);
+        partialWritten = false;
+    }
+    bits |= value << bitCount;
+    bitCount += n;
+    while (bitCount >= 8) {
+        if (chunkLength == CHUNK_SIZE) {
+            flushChunk();
+        }
+        chunk[chunkLength++] = (char) bits;
+        bits >>= 8;
+        bitCount -= 8;
+    }
+}
+
+obitstream::BitBuffer::int_type obitstream::BitBuffer::overflow(int_type ch) {
+    owner->finishByte();
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return traits_type::not_eof(ch);
+    }
+    return real->sputc(traits_type::to_char_type(ch));
+}
+
+std::streamsize obitstream::BitBuffer::xsputn(const char* s, std::streamsize n) {
+    if (n <= 0) {
+        return 0;
+    }
+    owner->finishByte();
+    return real->sputn(s, n);
+}
+
+obitstream::BitBuffer::pos_type obitstream::BitBuffer::seekoff(off_type off,
+                                                               std::ios_base::seekdir dir,
+                                                               std::ios_base::openmode which) {
+    if (off == 0 && dir == std::ios::cur) {
+        owner->showPartialByte();   // just asking where we are
+    } else {
+        owner->finishByte();
+    }
+    return real->pubseekoff(off, dir, which);
+}
+
+obitstream::BitBuffer::pos_type obitstream::BitBuffer::seekpos(pos_type pos,
+                                                               std::ios_base::openmode which) {
+    owner->finishByte();
+    return real->pubseekpos(pos, which);
+}
+
+int obitstream::BitBuffer::sync() {
+    owner->showPartialByte();
+    return real->pubsync();
+}
+
 /* Constructor ifbitstream::ifbitstream
  * ------------------------------------
  * Wires up the stream class so that it knows to read data
  * from disk.
  */
 ifbitstream::ifbitstream() {
-    init(&fb);
+    attach(&fb);
 }
 
 /* Constructor ifbitstream::ifbitstream
@@ -257,11 +618,11 @@ ifbitstream::ifbitstream() {
  * from disk, then opens the given file.
  */
 ifbitstream::ifbitstream(const char* filename) {
-    init(&fb);
+    attach(&fb);
     open(filename);
 }
 ifbitstream::ifbitstream(const std::string& filename) {
-    init(&fb);
+    attach(&fb);
     open(filename);
 }
 
@@ -271,6 +632,7 @@ ifbitstream::ifbitstream(const std::string& filename) {
  * to do so.
  */
 void ifbitstream::open(const char* filename) {
+    resetBits();
     if (!fb.open(filename, std::ios::in | std::ios::binary)) {
         setstate(std::ios::failbit);
     }
@@ -293,6 +655,7 @@ bool ifbitstream::is_open() {
  * Closes the file stream, if one is open.
  */
 void ifbitstream::close() {
+    resetBits();
     if (!fb.close()) {
         setstate(std::ios::failbit);
     }
@@ -304,7 +667,7 @@ void ifbitstream::close() {
  * to disk.
  */
 ofbitstream::ofbitstream() {
-    init(&fb);
+    attach(&fb);
 }
 
 /* Constructor ofbitstream::ofbitstream
@@ -313,15 +676,26 @@ ofbitstream::ofbitstream() {
  * to disk, then opens the given file.
  */
 ofbitstream::ofbitstream(const char* filename) {
-    init(&fb);
+    attach(&fb);
     open(filename);
 }
 
 ofbitstream::ofbitstream(const std::string& filename) {
-    init(&fb);
+    attach(&fb);
     open(filename);
 }
 
+/* Destructor ofbitstream::~ofbitstream
+ * ------------------------------------
+ * Writes out an unfinished last byte while the file buffer still exists;
+ * the file buffer closes the file itself.
+ */
+ofbitstream::~ofbitstream() {
+    if (fb.is_open()) {
+        finishByte();
+    }
+}
+
 /* Member function ofbitstream::open
  * ---------------------------------
  * Attempts to open the specified file, failing if unable
@@ -360,6 +734,7 @@ bool ofbitstream::is_open() {
  * Closes the given file.
  */
 void ofbitstream::close() {
+    finishByte();
     if (!fb.close()) {
         setstate(std::ios::failbit);
     }
@@ -371,7 +746,7 @@ void ofbitstream::close() {
  * the initial string to the specified value.
  */
 istringbitstream::istringbitstream(const std::string& s) {
-    init(&sb);
+    attach(&sb);
     sb.str(s);
 }
 
@@ -381,6 +756,7 @@ istringbitstream::istringbitstream(const std::string& s) {
  * specified string.
  */
 void istringbitstream::str(const std::string& s) {
+    resetBits();
     sb.str(s);
 }
 
@@ -389,7 +765,7 @@ void istringbitstream::str(const std::string& s) {
  * Sets the stream to use the string buffer.
  */
 ostringbitstream::ostringbitstream() {
-    init(&sb);
+    attach(&sb);
 }
 
 /* Member function ostringbitstream::str
@@ -397,5 +773,6 @@ ostringbitstream::ostringbitstream() {
  * Retrives the underlying string data.
  */
 std::string ostringbitstream::str() {
+    showPartialByte();
     return sb.str();
 }
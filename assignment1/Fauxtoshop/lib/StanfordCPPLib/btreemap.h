@@ -0,0 +1,1297 @@
+/*
+ * File: btreemap.h
+ * ----------------
+ * This file exports the template class <code>BTreeMap</code>, which
+ * maintains an ordered collection of <i>key</i>-<i>value</i> pairs in a
+ * B+ tree.
+ *
+ * @version 2026/10/18
+ * - initial version
+ */
+
+#ifndef _btreemap_h
+#define _btreemap_h
+
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <utility>
+#include "compare.h"
+#include "error.h"
+#include "hashcode.h"
+#include "vector.h"
+
+/*
+ * Returns how many entries of the given size fit in a B-tree node of the
+ * given size, kept between 8 and 64 so that large keys still give a
+ * shallow tree and small ones do not make binary searches long.
+ */
+constexpr int btreeSlots(int nodeBytes, int entryBytes) {
+    return nodeBytes / entryBytes < 8 ? 8
+         : nodeBytes / entryBytes > 64 ? 64
+         : nodeBytes / entryBytes;
+}
+
+/*
+ * Class: BTreeMap<KeyType,ValueType,Compare>
+ * ------------------------------------------
+ * This class maintains an association between <b><i>keys</i></b> and
+ * <b><i>values</i></b>, iterated in ascending order of the keys.  It has
+ * the same interface as the <a href="Map-class.html"><code>Map</code></a>
+ * class and can be used in its place, but it stores many entries per
+ * node instead of one, so a large map takes a fraction of the memory and
+ * a lookup touches a handful of nodes instead of one per tree level.
+ * The optional <code>Compare</code> type orders the keys; it defaults to
+ * the key type's <code>&lt;</code> operator.
+ */
+template <typename KeyType, typename ValueType, typename Compare = std::less<KeyType> >
+class BTreeMap {
+public:
+    /*
+     * Constructor: BTreeMap
+     * Usage: BTreeMap<KeyType,ValueType> map;
+     *        BTreeMap<KeyType,ValueType,Compare> map(cmp);
+     * ----------------------------------------------------
+     * Initializes a new empty map that associates keys and values of the
+     * specified types, ordering the keys with the given comparison
+     * function object.  An empty map allocates no memory.
+     */
+    BTreeMap();
+    explicit BTreeMap(Compare cmp);
+
+    /*
+     * Destructor: ~BTreeMap
+     * ---------------------
+     * Frees any heap storage associated with this map.
+     */
+    virtual ~BTreeMap();
+
+    /*
+     * Method: add
+     * Usage: map.add(key, value);
+     * ---------------------------
+     * Associates <code>key</code> with <code>value</code> in this map.
+     * A synonym for the put method.
+     */
+    void add(const KeyType& key, const ValueType& value);
+
+    /*
+     * Method: clear
+     * Usage: map.clear();
+     * -------------------
+     * Removes all entries from this map.
+     */
+    void clear();
+
+    /*
+     * Method: containsKey
+     * Usage: if (map.containsKey(key)) ...
+     * ------------------------------------
+     * Returns <code>true</code> if there is an entry for <code>key</code>
+     * in this map.
+     */
+    bool containsKey(const KeyType& key) const;
+
+    /*
+     * Method: equals
+     * Usage: if (map.equals(map2)) ...
+     * --------------------------------
+     * Returns <code>true</code> if the two maps contain exactly the same
+     * key/value pairs, and <code>false</code> otherwise.
+     */
+    bool equals(const BTreeMap& map2) const;
+
+    /*
+     * Method: get
+     * Usage: ValueType value = map.get(key);
+     * --------------------------------------
+     * Returns the value associated with <code>key</code> in this map.
+     * If <code>key</code> is not found, <code>get</code> returns the
+     * default value for <code>ValueType</code>.
+     */
+    ValueType get(const KeyType& key) const;
+
+    /*
+     * Method: isEmpty
+     * Usage: if (map.isEmpty()) ...
+     * -----------------------------
+     * Returns <code>true</code> if this map contains no entries.
+     */
+    bool isEmpty() const;
+
+    /*
+     * Method: keys
+     * Usage: Vector<KeyType> keys = map.keys();
+     * -----------------------------------------
+     * Returns a collection containing all keys in this map, in ascending
+     * order.
+     */
+    Vector<KeyType> keys() const;
+
+    /*
+     * Method: mapAll
+     * Usage: map.mapAll(fn);
+     * ----------------------
+     * Iterates through the map entries and calls <code>fn(key, value)</code>
+     * for each one.  The keys are processed in ascending order, as defined
+     * by the comparison function.
+     */
+    void mapAll(void (*fn)(KeyType, ValueType)) const;
+    void mapAll(void (*fn)(const KeyType&, const ValueType&)) const;
+
+    template <typename FunctorType>
+    void mapAll(FunctorType fn) const;
+
+    /*
+     * Method: put
+     * Usage: map.put(key, value);
+     * ---------------------------
+     * Associates <code>key</code> with <code>value</code> in this map.
+     * Any previous value associated with <code>key</code> is replaced
+     * by the new value.
+     */
+    void put(const KeyType& key, const ValueType& value);
+
+    /*
+     * Method: putAll
+     * Usage: map.putAll(map2);
+     * ---------------------------
+     * Adds all key/value pairs from the given map to this map.
+     * If both maps contain a pair for the same key, the one from map2 will
+     * replace the one from this map.
+     * Returns a reference to this map.
+     */
+    BTreeMap& putAll(const BTreeMap& map2);
+
+    /*
+     * Method: remove
+     * Usage: map.remove(key);
+     * -----------------------
+     * Removes any entry for <code>key</code> from this map.
+     */
+    void remove(const KeyType& key);
+
+    /*
+     * Method: removeAll
+     * Usage: map.removeAll(map2);
+     * ---------------------------
+     * Removes all key/value pairs from this map that are contained in the given map.
+     * If both maps contain the same key but it maps to different values, that
+     * mapping will not be removed.
+     * Returns a reference to this map.
+     */
+    BTreeMap& removeAll(const BTreeMap& map2);
+
+    /*
+     * Method: retainAll
+     * Usage: map.retainAll(map2);
+     * ---------------------------
+     * Removes all key/value pairs from this map that are not contained in the given map.
+     * If both maps contain the same key but it maps to different values, that
+     * mapping will be removed.
+     * Returns a reference to this map.
+     */
+    BTreeMap& retainAll(const BTreeMap& map2);
+
+    /*
+     * Method: size
+     * Usage: int nEntries = map.size();
+     * ---------------------------------
+     * Returns the number of entries in this map.
+     */
+    int size() const;
+
+    /*
+     * Returns an STL map object with the same elements as this map.
+     */
+    std::map<KeyType, ValueType> toStlMap() const;
+
+    /*
+     * Method: toString
+     * Usage: string str = map.toString();
+     * -----------------------------------
+     * Converts the map to a printable string representation.
+     */
+    std::string toString() const;
+
+    /*
+     * Method: values
+     * Usage: Vector<ValueType> values = map.values();
+     * -----------------------------------------------
+     * Returns a collection containing all values in this map, in the
+     * order of their keys.
+     */
+    Vector<ValueType> values() const;
+
+    /*
+     * Operator: []
+     * Usage: map[key]
+     * ---------------
+     * Selects the value associated with <code>key</code>.  If
+     * <code>key</code> is already present in the map, this function
+     * returns a reference to its associated value.  If key is not present
+     * in the map, a new entry is created whose value is set to the default
+     * for the value type.  The reference is valid until the next entry is
+     * added or removed, since either one can move other entries between
+     * nodes.
+     */
+    ValueType& operator [](const KeyType& key);
+    ValueType operator [](const KeyType& key) const;
+
+    /*
+     * Operator: ==
+     * Usage: if (map1 == map2) ...
+     * ----------------------------
+     * Compares two maps for equality.
+     */
+    bool operator ==(const BTreeMap& map2) const;
+
+    /*
+     * Operator: !=
+     * Usage: if (map1 != map2) ...
+     * ----------------------------
+     * Compares two maps for inequality.
+     */
+    bool operator !=(const BTreeMap& map2) const;
+
+    /*
+     * Operators: <, <=, >, >=
+     * Usage: if (map1 < map2) ...
+     * ---------------------------
+     * Relational operators to compare two maps.
+     * The <, >, <=, >= operators require that the ValueType has a < operator
+     * so that the elements can be compared pairwise.
+     */
+    bool operator <(const BTreeMap& map2) const;
+    bool operator <=(const BTreeMap& map2) const;
+    bool operator >(const BTreeMap& map2) const;
+    bool operator >=(const BTreeMap& map2) const;
+
+    /*
+     * Operator: +
+     * Usage: map1 + map2
+     * ------------------
+     * Returns the union of the two maps, equivalent to a copy of the first map
+     * with addAll called on it passing the second map as a parameter.
+     * If the two maps both contain a mapping for the same key, the mapping
+     * from the second map is favored.
+     */
+    BTreeMap operator +(const BTreeMap& map2) const;
+
+    /*
+     * Operator: +=
+     * Usage: map1 += map2;
+     * --------------------
+     * Adds all key/value pairs from the given map to this map.
+     * Equivalent to calling addAll(map2).
+     */
+    BTreeMap& operator +=(const BTreeMap& map2);
+
+    /*
+     * Operator: -
+     * Usage: map1 - map2
+     * ------------------
+     * Returns the difference of the two maps, equivalent to a copy of the first map
+     * with removeAll called on it passing the second map as a parameter.
+     */
+    BTreeMap operator -(const BTreeMap& map2) const;
+
+    /*
+     * Operator: -=
+     * Usage: map1 -= map2;
+     * --------------------
+     * Removes all key/value pairs from the given map to this map.
+     * Equivalent to calling removeAll(map2).
+     */
+    BTreeMap& operator -=(const BTreeMap& map2);
+
+    /*
+     * Operator: *
+     * Usage: map1 * map2
+     * ------------------
+     * Returns the intersection of the two maps, equivalent to a copy of the first map
+     * with retainAll called on it passing the second map as a parameter.
+     */
+    BTreeMap operator *(const BTreeMap& map2) const;
+
+    /*
+     * Operator: *=
+     * Usage: map1 *= map2;
+     * ---------------------
+     * Removes all key/value pairs that are not found in the given map from this map.
+     * Equivalent to calling retainAll(map2).
+     */
+    BTreeMap& operator *=(const BTreeMap& map2);
+
+    /*
+     * Additional BTreeMap operations
+     * ------------------------------
+     * In addition to the methods listed in this interface, the BTreeMap
+     * class supports the following operations:
+     *
+     *   - Stream I/O using the << and >> operators
+     *   - Deep copying for the copy constructor and assignment operator
+     *   - Iteration using the range-based for statement and STL iterators
+     *
+     * All iteration is guaranteed to proceed in the order established by
+     * the comparison function, which ordinarily matches the order of the
+     * key type.
+     */
+
+    /* Private section */
+
+    /**********************************************************************/
+    /* Note: Everything below this point in the file is logically part    */
+    /* of the implementation and should not be of interest to clients.    */
+    /**********************************************************************/
+
+    /*
+     * Implementation notes:
+     * ---------------------
+     * The map is a B+ tree.  All entries live in leaves, which hold up to
+     * LEAF_SLOTS sorted entries each and are linked left to right, so
+     * iteration is a walk along the leaf list.  Inner nodes hold up to
+     * INNER_SLOTS separator keys; every key in children[i] is less than
+     * keys[i], and every key in children[i + 1] is at least keys[i].  The
+     * slot counts are chosen so that a node's keys span about NODE_BYTES
+     * bytes, a few cache lines, and every node but the root stays at least
+     * half full.  Nodes have one spare slot so that an insertion can
+     * overfill a node before splitting it.
+     */
+private:
+    /* Constant definitions */
+    static const int NODE_BYTES = 256;
+    static const int LEAF_SLOTS = btreeSlots(NODE_BYTES, sizeof(KeyType) + sizeof(ValueType));
+    static const int INNER_SLOTS = btreeSlots(NODE_BYTES, sizeof(KeyType) + sizeof(void*));
+
+    /* Type definitions for the nodes of the tree */
+    struct Node {
+        bool leaf;               /* Whether this node is a Leaf         */
+        int count;               /* Number of keys in the node          */
+    };
+
+    struct Leaf : Node {
+        Leaf* next;                            /* Leaf to the right   */
+        KeyType keys[LEAF_SLOTS + 1];
+        ValueType values[LEAF_SLOTS + 1];
+
+        Leaf() : next(NULL) {
+            this->leaf = true;
+            this->count = 0;
+        }
+    };
+
+    struct Inner : Node {
+        KeyType keys[INNER_SLOTS + 1];
+        Node* children[INNER_SLOTS + 2];
+
+        Inner() {
+            this->leaf = false;
+            this->count = 0;
+        }
+    };
+
+    /* Instance variables */
+    Node* root;                     /* Root of the tree, or NULL       */
+    Leaf* first;                    /* Leftmost leaf, or NULL          */
+    int nodeCount;                  /* Number of entries in the map    */
+    Compare cmp;                    /* Orders the keys                 */
+
+    /* Private methods */
+
+    /*
+     * Implementation notes: lowerBound, upperBound
+     * --------------------------------------------
+     * Binary searches of a node's sorted keys for the first key that is
+     * not less than key, and the first key that is greater than key.
+     */
+    int lowerBound(const KeyType* keys, int count, const KeyType& key) const {
+        int lo = 0;
+        int hi = count;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (cmp(keys[mid], key)) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    int upperBound(const KeyType* keys, int count, const KeyType& key) const {
+        int lo = 0;
+        int hi = count;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (cmp(key, keys[mid])) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        return lo;
+    }
+
+    static int minCount(const Node* node) {
+        return node->leaf ? LEAF_SLOTS / 2 : INNER_SLOTS / 2;
+    }
+
+    /*
+     * Implementation notes: findValue(key)
+     * ------------------------------------
+     * Descends to the leaf that would hold key and returns a pointer to
+     * its value, or NULL if the key is not in the map.
+     */
+    ValueType* findValue(const KeyType& key) const {
+        if (root == NULL) {
+            return NULL;
+        }
+        Node* node = root;
+        while (!node->leaf) {
+            Inner* inner = static_cast<Inner*>(node);
+            node = inner->children[upperBound(inner->keys, inner->count, key)];
+        }
+        Leaf* leaf = static_cast<Leaf*>(node);
+        int i = lowerBound(leaf->keys, leaf->count, key);
+        if (i < leaf->count && !cmp(key, leaf->keys[i])) {
+            return &leaf->values[i];
+        }
+        return NULL;
+    }
+
+    /*
+     * Implementation notes: insert(node, key, split, separator)
+     * ---------------------------------------------------------
+     * Adds key with a default value to the subtree rooted at node, unless
+     * it is already there, and returns a pointer to its value.  If node
+     * overflows, it is split in two: split is set to the new right half
+     * and separator to the smallest key under it.  Otherwise split is set
+     * to NULL.
+     */
+    ValueType* insert(Node* node, const KeyType& key, Node*& split, KeyType& separator) {
+        split = NULL;
+        if (node->leaf) {
+            Leaf* leaf = static_cast<Leaf*>(node);
+            int i = lowerBound(leaf->keys, leaf->count, key);
+            if (i < leaf->count && !cmp(key, leaf->keys[i])) {
+                return &leaf->values[i];
+            }
+            for (int j = leaf->count; j > i; j--) {
+                leaf->keys[j] = std::move(leaf->keys[j - 1]);
+                leaf->values[j] = std::move(leaf->values[j - 1]);
+            }
+            leaf->keys[i] = key;
+            leaf->values[i] = ValueType();
+            leaf->count++;
+            nodeCount++;
+            if (leaf->count <= LEAF_SLOTS) {
+                return &leaf->values[i];
+            }
+            Leaf* right = splitLeaf(leaf);
+            split = right;
+            separator = right->keys[0];
+            return i < leaf->count ? &leaf->values[i] : &right->values[i - leaf->count];
+        }
+
+        Inner* inner = static_cast<Inner*>(node);
+        int c = upperBound(inner->keys, inner->count, key);
+        Node* childSplit;
+        KeyType childSeparator;
+        ValueType* vp = insert(inner->children[c], key, childSplit, childSeparator);
+        if (childSplit != NULL) {
+            for (int j = inner->count; j > c; j--) {
+                inner->keys[j] = std::move(inner->keys[j - 1]);
+                inner->children[j + 1] = inner->children[j];
+            }
+            inner->keys[c] = std::move(childSeparator);
+            inner->children[c + 1] = childSplit;
+            inner->count++;
+            if (inner->count > INNER_SLOTS) {
+                split = splitInner(inner, separator);
+            }
+        }
+        return vp;
+    }
+
+    /*
+     * Moves the upper half of an overfull leaf into a new leaf, which is
+     * linked in after it and returned.
+     */
+    Leaf* splitLeaf(Leaf* leaf) {
+        Leaf* right = new Leaf;
+        int keep = leaf->count / 2;
+        for (int j = keep; j < leaf->count; j++) {
+            right->keys[j - keep] = std::move(leaf->keys[j]);
+            right->values[j - keep] = std::move(leaf->values[j]);
+        }
+        right->count = leaf->count - keep;
+        leaf->count = keep;
+        right->next = leaf->next;
+        leaf->next = right;
+        return right;
+    }
+
+    /*
+     * Moves the upper half of an overfull inner node into a new node,
+     * which is returned.  The middle key moves up to the parent as the
+     * separator.
+     */
+    Inner* splitInner(Inner* inner, KeyType& separator) {
+        Inner* right = new Inner;
+        int mid = inner->count / 2;
+        separator = std::move(inner->keys[mid]);
+        for (int j = mid + 1; j < inner->count; j++) {
+            right->keys[j - mid - 1] = std::move(inner->keys[j]);
+        }
+        for (int j = mid + 1; j <= inner->count; j++) {
+            right->children[j - mid - 1] = inner->children[j];
+        }
+        right->count = inner->count - mid - 1;
+        inner->count = mid;
+        return right;
+    }
+
+    /*
+     * Implementation notes: erase(node, key)
+     * --------------------------------------
+     * Removes key from the subtree rooted at node and returns whether it
+     * was there.  A child left less than half full is refilled from a
+     * sibling or merged with one, so only the root can underflow.
+     */
+    bool erase(Node* node, const KeyType& key) {
+        if (node->leaf) {
+            Leaf* leaf = static_cast<Leaf*>(node);
+            int i = lowerBound(leaf->keys, leaf->count, key);
+            if (i == leaf->count || cmp(key, leaf->keys[i])) {
+                return false;
+            }
+            for (int j = i + 1; j < leaf->count; j++) {
+                leaf->keys[j - 1] = std::move(leaf->keys[j]);
+                leaf->values[j - 1] = std::move(leaf->values[j]);
+            }
+            leaf->count--;
+            // release what the vacated slot holds, such as string storage
+            leaf->keys[leaf->count] = KeyType();
+            leaf->values[leaf->count] = ValueType();
+            return true;
+        }
+
+        Inner* inner = static_cast<Inner*>(node);
+        int c = upperBound(inner->keys, inner->count, key);
+        if (!erase(inner->children[c], key)) {
+            return false;
+        }
+        if (inner->children[c]->count < minCount(inner->children[c])) {
+            rebalance(inner, c);
+        }
+        return true;
+    }
+
+    /*
+     * Refills the underfull child c of parent by borrowing an entry from
+     * a sibling that can spare one, or else merges it with a sibling.
+     */
+    void rebalance(Inner* parent, int c) {
+        Node* left = c > 0 ? parent->children[c - 1] : NULL;
+        Node* right = c < parent->count ? parent->children[c + 1] : NULL;
+        if (left != NULL && left->count > minCount(left)) {
+            borrowFromLeft(parent, c);
+        } else if (right != NULL && right->count > minCount(right)) {
+            borrowFromRight(parent, c);
+        } else if (left != NULL) {
+            merge(parent, c - 1);
+        } else {
+            merge(parent, c);
+        }
+    }
+
+    void borrowFromLeft(Inner* parent, int c) {
+        if (parent->children[c]->leaf) {
+            Leaf* child = static_cast<Leaf*>(parent->children[c]);
+            Leaf* left = static_cast<Leaf*>(parent->children[c - 1]);
+            for (int j = child->count; j > 0; j--) {
+                child->keys[j] = std::move(child->keys[j - 1]);
+                child->values[j] = std::move(child->values[j - 1]);
+            }
+            left->count--;
+            child->keys[0] = std::move(left->keys[left->count]);
+            child->values[0] = std::move(left->values[left->count]);
+            child->count++;
+            parent->keys[c - 1] = child->keys[0];
+        } else {
+            Inner* child = static_cast<Inner*>(parent->children[c]);
+            Inner* left = static_cast<Inner*>(parent->children[c - 1]);
+            for (int j = child->count; j > 0; j--) {
+                child->keys[j] = std::move(child->keys[j - 1]);
+            }
+            for (int j = child->count + 1; j > 0; j--) {
+                child->children[j] = child->children[j - 1];
+            }
+            child->keys[0] = std::move(parent->keys[c - 1]);
+            child->children[0] = left->children[left->count];
+            child->count++;
+            left->count--;
+            parent->keys[c - 1] = std::move(left->keys[left->count]);
+        }
+    }
+
+    void borrowFromRight(Inner* parent, int c) {
+        if (parent->children[c]->leaf) {
+            Leaf* child = static_cast<Leaf*>(parent->children[c]);
+            Leaf* right = static_cast<Leaf*>(parent->children[c + 1]);
+            child->keys[child->count] = std::move(right->keys[0]);
+            child->values[child->count] = std::move(right->values[0]);
+            child->count++;
+            for (int j = 1; j < right->count; j++) {
+                right->keys[j - 1] = std::move(right->keys[j]);
+                right->values[j - 1] = std::move(right->values[j]);
+            }
+            right->count--;
+            parent->keys[c] = right->keys[0];
+        } else {
+            Inner* child = static_cast<Inner*>(parent->children[c]);
+            Inner* right = static_cast<Inner*>(parent->children[c + 1]);
+            child->keys[child->count] = std::move(parent->keys[c]);
+            child->children[child->count + 1] = right->children[0];
+            child->count++;
+            parent->keys[c] = std::move(right->keys[0]);
+            for (int j = 1; j < right->count; j++) {
+                right->keys[j - 1] = std::move(right->keys[j]);
+            }
+            for (int j = 1; j <= right->count; j++) {
+                right->children[j - 1] = right->children[j];
+            }
+            right->count--;
+        }
+    }
+
+    /*
+     * Merges child i + 1 of parent into child i and removes separator i.
+     */
+    void merge(Inner* parent, int i) {
+        if (parent->children[i]->leaf) {
+            Leaf* left = static_cast<Leaf*>(parent->children[i]);
+            Leaf* right = static_cast<Leaf*>(parent->children[i + 1]);
+            for (int j = 0; j < right->count; j++) {
+                left->keys[left->count + j] = std::move(right->keys[j]);
+                left->values[left->count + j] = std::move(right->values[j]);
+            }
+            left->count += right->count;
+            left->next = right->next;
+            delete right;
+        } else {
+            Inner* left = static_cast<Inner*>(parent->children[i]);
+            Inner* right = static_cast<Inner*>(parent->children[i + 1]);
+            left->keys[left->count] = std::move(parent->keys[i]);
+            for (int j = 0; j < right->count; j++) {
+                left->keys[left->count + 1 + j] = std::move(right->keys[j]);
+            }
+            for (int j = 0; j <= right->count; j++) {
+                left->children[left->count + 1 + j] = right->children[j];
+            }
+            left->count += right->count + 1;
+            delete right;
+        }
+        for (int j = i + 1; j < parent->count; j++) {
+            parent->keys[j - 1] = std::move(parent->keys[j]);
+            parent->children[j] = parent->children[j + 1];
+        }
+        parent->count--;
+    }
+
+    static void deleteTree(Node* node) {
+        if (node == NULL) {
+            return;
+        }
+        if (node->leaf) {
+            delete static_cast<Leaf*>(node);
+        } else {
+            Inner* inner = static_cast<Inner*>(node);
+            for (int i = 0; i <= inner->count; i++) {
+                deleteTree(inner->children[i]);
+            }
+            delete inner;
+        }
+    }
+
+    /*
+     * Copies the subtree rooted at node, linking each copied leaf after
+     * lastLeaf.
+     */
+    Node* copyTree(const Node* node, Leaf*& lastLeaf) {
+        if (node->leaf) {
+            const Leaf* src = static_cast<const Leaf*>(node);
+            Leaf* leaf = new Leaf;
+            for (int i = 0; i < src->count; i++) {
+                leaf->keys[i] = src->keys[i];
+                leaf->values[i] = src->values[i];
+            }
+            leaf->count = src->count;
+            if (lastLeaf == NULL) {
+                first = leaf;
+            } else {
+                lastLeaf->next = leaf;
+            }
+            lastLeaf = leaf;
+            return leaf;
+        }
+        const Inner* src = static_cast<const Inner*>(node);
+        Inner* inner = new Inner;
+        for (int i = 0; i < src->count; i++) {
+            inner->keys[i] = src->keys[i];
+        }
+        for (int i = 0; i <= src->count; i++) {
+            inner->children[i] = copyTree(src->children[i], lastLeaf);
+        }
+        inner->count = src->count;
+        return inner;
+    }
+
+    void deepCopy(const BTreeMap& other) {
+        root = NULL;
+        first = NULL;
+        nodeCount = other.nodeCount;
+        cmp = other.cmp;
+        if (other.root != NULL) {
+            Leaf* lastLeaf = NULL;
+            root = copyTree(other.root, lastLeaf);
+        }
+    }
+
+public:
+    /*
+     * Hidden features
+     * ---------------
+     * The remainder of this file consists of the code required to
+     * support deep copying and iteration.  Including these methods in
+     * the public portion of the interface would make that interface more
+     * difficult to understand for the average client.
+     */
+
+    /*
+     * Implementation notes: compareKeys(k1, k2)
+     * -----------------------------------------
+     * Compares the keys k1 and k2 and returns an integer (-1, 0, or +1)
+     * depending on whether k1 < k2, k1 == k2, or k1 > k2, respectively.
+     */
+    int compareKeys(const KeyType& k1, const KeyType& k2) const {
+        if (cmp(k1, k2)) {
+            return -1;
+        } else if (cmp(k2, k1)) {
+            return +1;
+        } else {
+            return 0;
+        }
+    }
+
+    /*
+     * Deep copying support
+     * --------------------
+     * This copy constructor and operator= are defined to make a
+     * deep copy, making it possible to pass/return maps by value
+     * and assign from one map to another.
+     */
+    BTreeMap& operator =(const BTreeMap& src) {
+        if (this != &src) {
+            clear();
+            deepCopy(src);
+        }
+        return *this;
+    }
+
+    BTreeMap(const BTreeMap& src) {
+        deepCopy(src);
+    }
+
+    /*
+     * Iterator support
+     * ----------------
+     * The classes in the StanfordCPPLib collection implement input
+     * iterators so that they work symmetrically with respect to the
+     * corresponding STL classes.
+     */
+    class iterator : public std::iterator<std::input_iterator_tag, KeyType> {
+    private:
+        const BTreeMap* mp;          /* Pointer to the map          */
+        Leaf* leaf;                  /* Current leaf, NULL at end   */
+        int index;                   /* Index of entry in the leaf  */
+
+    public:
+        iterator() : mp(NULL), leaf(NULL), index(0) {
+            /* Empty */
+        }
+
+        iterator(const BTreeMap* mp, bool end) {
+            this->mp = mp;
+            leaf = end ? NULL : mp->first;
+            index = 0;
+        }
+
+        iterator& operator ++() {
+            index++;
+            if (index == leaf->count) {
+                leaf = leaf->next;
+                index = 0;
+            }
+            return *this;
+        }
+
+        iterator operator ++(int) {
+            iterator copy(*this);
+            operator++();
+            return copy;
+        }
+
+        bool operator ==(const iterator& rhs) {
+            return mp == rhs.mp && leaf == rhs.leaf && index == rhs.index;
+        }
+
+        bool operator !=(const iterator& rhs) {
+            return !(*this == rhs);
+        }
+
+        KeyType& operator *() {
+            return leaf->keys[index];
+        }
+
+        KeyType* operator ->() {
+            return &leaf->keys[index];
+        }
+
+        friend class BTreeMap;
+    };
+
+    /*
+     * Returns an iterator positioned at the first key of the map.
+     */
+    iterator begin() const {
+        return iterator(this, /* end */ false);
+    }
+
+    /*
+     * Returns an iterator positioned at the last key of the map.
+     */
+    iterator end() const {
+        return iterator(this, /* end */ true);
+    }
+};
+
+template <typename KeyType, typename ValueType, typename Compare>
+BTreeMap<KeyType, ValueType, Compare>::BTreeMap()
+        : root(NULL), first(NULL), nodeCount(0), cmp() {
+    /* Empty */
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+BTreeMap<KeyType, ValueType, Compare>::BTreeMap(Compare cmp)
+        : root(NULL), first(NULL), nodeCount(0), cmp(cmp) {
+    /* Empty */
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+BTreeMap<KeyType, ValueType, Compare>::~BTreeMap() {
+    clear();
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+void BTreeMap<KeyType, ValueType, Compare>::add(const KeyType& key,
+                                                const ValueType& value) {
+    put(key, value);
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+void BTreeMap<KeyType, ValueType, Compare>::clear() {
+    deleteTree(root);
+    root = NULL;
+    first = NULL;
+    nodeCount = 0;
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+bool BTreeMap<KeyType, ValueType, Compare>::containsKey(const KeyType& key) const {
+    return findValue(key) != NULL;
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+bool BTreeMap<KeyType, ValueType, Compare>::equals(const BTreeMap& map2) const {
+    if (this == &map2) {
+        return true;
+    }
+    if (size() != map2.size()) {
+        return false;
+    }
+
+    // both maps are sorted by the same comparator, so equal maps hold
+    // the same entries at the same positions of their leaf lists
+    Leaf* leaf1 = first;
+    Leaf* leaf2 = map2.first;
+    int i1 = 0;
+    int i2 = 0;
+    while (leaf1 != NULL) {
+        if (compareKeys(leaf1->keys[i1], leaf2->keys[i2]) != 0
+                || leaf1->values[i1] != leaf2->values[i2]) {
+            return false;
+        }
+        if (++i1 == leaf1->count) {
+            leaf1 = leaf1->next;
+            i1 = 0;
+        }
+        if (++i2 == leaf2->count) {
+            leaf2 = leaf2->next;
+            i2 = 0;
+        }
+    }
+    return true;
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+ValueType BTreeMap<KeyType, ValueType, Compare>::get(const KeyType& key) const {
+    ValueType* vp = findValue(key);
+    if (vp == NULL) {
+        return ValueType();
+    }
+    return *vp;
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+bool BTreeMap<KeyType, ValueType, Compare>::isEmpty() const {
+    return nodeCount == 0;
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+Vector<KeyType> BTreeMap<KeyType, ValueType, Compare>::keys() const {
+    Vector<KeyType> keyset;
+    for (Leaf* leaf = first; leaf != NULL; leaf = leaf->next) {
+        for (int i = 0; i < leaf->count; i++) {
+            keyset.add(leaf->keys[i]);
+        }
+    }
+    return keyset;
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+void BTreeMap<KeyType, ValueType, Compare>::mapAll(void (*fn)(KeyType, ValueType)) const {
+    for (Leaf* leaf = first; leaf != NULL; leaf = leaf->next) {
+        for (int i = 0; i < leaf->count; i++) {
+            fn(leaf->keys[i], leaf->values[i]);
+        }
+    }
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+void BTreeMap<KeyType, ValueType, Compare>::mapAll(void (*fn)(const KeyType&,
+                                                             const ValueType&)) const {
+    for (Leaf* leaf = first; leaf != NULL; leaf = leaf->next) {
+        for (int i = 0; i < leaf->count; i++) {
+            fn(leaf->keys[i], leaf->values[i]);
+        }
+    }
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+template <typename FunctorType>
+void BTreeMap<KeyType, ValueType, Compare>::mapAll(FunctorType fn) const {
+    for (Leaf* leaf = first; leaf != NULL; leaf = leaf->next) {
+        for (int i = 0; i < leaf->count; i++) {
+            fn(leaf->keys[i], leaf->values[i]);
+        }
+    }
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+void BTreeMap<KeyType, ValueType, Compare>::put(const KeyType& key,
+                                                const ValueType& value) {
+    ValueType* vp = findValue(key);
+    if (vp != NULL) {
+        *vp = value;
+        return;
+    }
+    // value may refer to an entry of this map, which inserting can move
+    ValueType copy(value);
+    (*this)[key] = std::move(copy);
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+BTreeMap<KeyType, ValueType, Compare>&
+BTreeMap<KeyType, ValueType, Compare>::putAll(const BTreeMap& map2) {
+    map2.mapAll([this](const KeyType& key, const ValueType& value) {
+        put(key, value);
+    });
+    return *this;
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+void BTreeMap<KeyType, ValueType, Compare>::remove(const KeyType& key) {
+    if (root == NULL || !erase(root, key)) {
+        return;
+    }
+    nodeCount--;
+    if (root->leaf) {
+        if (root->count == 0) {
+            delete static_cast<Leaf*>(root);
+            root = NULL;
+            first = NULL;
+        }
+    } else if (root->count == 0) {
+        // the root's last two children were merged; its one child takes over
+        Inner* oldRoot = static_cast<Inner*>(root);
+        root = oldRoot->children[0];
+        delete oldRoot;
+    }
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+BTreeMap<KeyType, ValueType, Compare>&
+BTreeMap<KeyType, ValueType, Compare>::removeAll(const BTreeMap& map2) {
+    // collect the keys first, since removing can free nodes of map2 if it
+    // is this map
+    Vector<KeyType> toRemove;
+    map2.mapAll([&](const KeyType& key, const ValueType& value) {
+        ValueType* vp = findValue(key);
+        if (vp != NULL && *vp == value) {
+            toRemove.add(key);
+        }
+    });
+    for (const KeyType& key : toRemove) {
+        remove(key);
+    }
+    return *this;
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+BTreeMap<KeyType, ValueType, Compare>&
+BTreeMap<KeyType, ValueType, Compare>::retainAll(const BTreeMap& map2) {
+    Vector<KeyType> toRemove;
+    mapAll([&](const KeyType& key, const ValueType& value) {
+        ValueType* vp = map2.findValue(key);
+        if (vp == NULL || *vp != value) {
+            toRemove.add(key);
+        }
+    });
+    for (const KeyType& key : toRemove) {
+        remove(key);
+    }
+    return *this;
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+int BTreeMap<KeyType, ValueType, Compare>::size() const {
+    return nodeCount;
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+std::map<KeyType, ValueType> BTreeMap<KeyType, ValueType, Compare>::toStlMap() const {
+    std::map<KeyType, ValueType> result;
+    mapAll([&result](const KeyType& key, const ValueType& value) {
+        result[key] = value;
+    });
+    return result;
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+std::string BTreeMap<KeyType, ValueType, Compare>::toString() const {
+    std::ostringstream os;
+    os << *this;
+    return os.str();
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+Vector<ValueType> BTreeMap<KeyType, ValueType, Compare>::values() const {
+    Vector<ValueType> values;
+    for (Leaf* leaf = first; leaf != NULL; leaf = leaf->next) {
+        for (int i = 0; i < leaf->count; i++) {
+            values.add(leaf->values[i]);
+        }
+    }
+    return values;
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+ValueType& BTreeMap<KeyType, ValueType, Compare>::operator [](const KeyType& key) {
+    if (root == NULL) {
+        first = new Leaf;
+        root = first;
+    }
+    Node* split;
+    KeyType separator;
+    ValueType* vp = insert(root, key, split, separator);
+    if (split != NULL) {
+        // the root overflowed, so the tree grows a level
+        Inner* newRoot = new Inner;
+        newRoot->keys[0] = std::move(separator);
+        newRoot->children[0] = root;
+        newRoot->children[1] = split;
+        newRoot->count = 1;
+        root = newRoot;
+    }
+    return *vp;
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+ValueType BTreeMap<KeyType, ValueType, Compare>::operator [](const KeyType& key) const {
+    return get(key);
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+BTreeMap<KeyType, ValueType, Compare>
+BTreeMap<KeyType, ValueType, Compare>::operator +(const BTreeMap& map2) const {
+    BTreeMap<KeyType, ValueType, Compare> result = *this;
+    return result.putAll(map2);
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+BTreeMap<KeyType, ValueType, Compare>&
+BTreeMap<KeyType, ValueType, Compare>::operator +=(const BTreeMap& map2) {
+    return putAll(map2);
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+BTreeMap<KeyType, ValueType, Compare>
+BTreeMap<KeyType, ValueType, Compare>::operator -(const BTreeMap& map2) const {
+    BTreeMap<KeyType, ValueType, Compare> result = *this;
+    return result.removeAll(map2);
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+BTreeMap<KeyType, ValueType, Compare>&
+BTreeMap<KeyType, ValueType, Compare>::operator -=(const BTreeMap& map2) {
+    return removeAll(map2);
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+BTreeMap<KeyType, ValueType, Compare>
+BTreeMap<KeyType, ValueType, Compare>::operator *(const BTreeMap& map2) const {
+    BTreeMap<KeyType, ValueType, Compare> result = *this;
+    return result.retainAll(map2);
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+BTreeMap<KeyType, ValueType, Compare>&
+BTreeMap<KeyType, ValueType, Compare>::operator *=(const BTreeMap& map2) {
+    return retainAll(map2);
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+bool BTreeMap<KeyType, ValueType, Compare>::operator ==(const BTreeMap& map2) const {
+    return equals(map2);
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+bool BTreeMap<KeyType, ValueType, Compare>::operator !=(const BTreeMap& map2) const {
+    return !equals(map2);
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+bool BTreeMap<KeyType, ValueType, Compare>::operator <(const BTreeMap& map2) const {
+    return compare::compare(*this, map2) < 0;
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+bool BTreeMap<KeyType, ValueType, Compare>::operator <=(const BTreeMap& map2) const {
+    return compare::compare(*this, map2) <= 0;
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+bool BTreeMap<KeyType, ValueType, Compare>::operator >(const BTreeMap& map2) const {
+    return compare::compare(*this, map2) > 0;
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+bool BTreeMap<KeyType, ValueType, Compare>::operator >=(const BTreeMap& map2) const {
+    return compare::compare(*this, map2) >= 0;
+}
+
+/*
+ * Implementation notes: << and >>
+ * -------------------------------
+ * The insertion and extraction operators use the template facilities in
+ * strlib.h to read and write generic values in a way that treats strings
+ * specially.
+ */
+template <typename KeyType, typename ValueType, typename Compare>
+std::ostream& operator <<(std::ostream& os,
+                          const BTreeMap<KeyType, ValueType, Compare>& map) {
+    os << "{";
+    bool first = true;
+    map.mapAll([&](const KeyType& key, const ValueType& value) {
+        if (!first) {
+            os << ", ";
+        }
+        first = false;
+        writeGenericValue(os, key, /* forceQuotes */ true);
+        os << ":";
+        writeGenericValue(os, value, /* forceQuotes */ true);
+    });
+    return os << "}";
+}
+
+template <typename KeyType, typename ValueType, typename Compare>
+std::istream& operator >>(std::istream& is,
+                          BTreeMap<KeyType, ValueType, Compare>& map) {
+    char ch = '\0';
+    is >> ch;
+    if (ch != '{') {
+        error("BTreeMap::operator >>: Missing {");
+    }
+    map.clear();
+    is >> ch;
+    if (ch != '}') {
+        is.unget();
+        while (true) {
+            KeyType key;
+            readGenericValue(is, key);
+            is >> ch;
+            if (ch != ':') {
+                error("BTreeMap::operator >>: Missing colon after key");
+            }
+            ValueType value;
+            readGenericValue(is, value);
+            map[key] = value;
+            is >> ch;
+            if (ch == '}') {
+                break;
+            }
+            if (ch != ',') {
+                error(std::string("BTreeMap::operator >>: Unexpected character ") + ch);
+            }
+        }
+    }
+    return is;
+}
+
+/*
+ * Template hash function for B-tree maps.
+ * Requires the key and value types in the BTreeMap to have a hashCode function.
+ */
+template <typename K, typename V, typename C>
+int hashCode(const BTreeMap<K, V, C>& map) {
+    int code = hashSeed();
+    map.mapAll([&code](const K& k, const V& v) {
+        code = hashMultiplier() * code + hashCode(k);
+        code = hashMultiplier() * code + hashCode(v);
+    });
+    return int(code & hashMask());
+}
+
+/*
+ * Function: randomKey
+ * Usage: element = randomKey(map);
+ * --------------------------------
+ * Returns a randomly chosen key of the given map.
+ * Throws an error if the map is empty.
+ */
+template <typename K, typename V, typename C>
+const K& randomKey(const BTreeMap<K, V, C>& map) {
+    if (map.isEmpty()) {
+        error("randomKey: empty map was passed");
+    }
+    int index = randomInteger(0, map.size() - 1);
+    typename BTreeMap<K, V, C>::iterator it = map.begin();
+    for (int i = 0; i < index; i++) {
+        ++it;
+    }
+    return *it;
+}
+
+#endif
@@ -6,6 +6,8 @@
  * must be included in the source file that contains the <code>main</code>
  * method, although it may be included in other source files as well.
  * 
+ * @version 2026/10/18
+ * - added getCommandLineArguments and isHeadless for running without a GUI
  * @version 2015/06/20
  * - added recursionIndent() function for pretty-printing indented recursive calls
  * @version 2015/04/25
@@ -23,6 +25,7 @@
 #define _console_h
 
 #include <string>
+#include <vector>
 
 enum ConsoleCloseOperation {
     CONSOLE_DO_NOTHING_ON_CLOSE = 0,
@@ -39,6 +42,15 @@ enum ConsoleCloseOperation {
  */
 void clearConsole();
 
+/*
+ * Function: getCommandLineArguments
+ * Usage: std::vector<std::string> args = getCommandLineArguments();
+ * -----------------------------------------------------------------
+ * Returns the arguments the program was given on the command line,
+ * not including the program's own name.
+ */
+std::vector<std::string> getCommandLineArguments();
+
 /*
  * Function: getConsoleClearEnabled
  * Usage: bool mode = getConsoleClearEnabled();
@@ -103,6 +115,18 @@ bool getConsolePrintExceptions();
  */
 bool getConsoleSettingsLocked();
 
+/*
+ * Function: isHeadless
+ * Usage: if (isHeadless()) { ... }
+ * --------------------------------
+ * Returns true if the program is running without the Java back-end, so that
+ * no console or graphics windows are available and cin/cout are the plain
+ * operating system streams.  This is the case when the program was run with
+ * a --headless command-line argument or with the NOCONSOLE environment
+ * variable set to true.
+ */
+bool isHeadless();
+
 /*
  * Function: setConsoleClearEnabled
  * Usage: setConsoleClearEnabled(true);
@@ -15,6 +15,10 @@
  * The DAWG builder code is quite a bit more intricate, see Julie Zelenski
  * if you need it.
  * 
+ * @version 2026/10/18
+ * - added mapBinaryFile, which maps the binary file with mmap
+ * - edges stay in file byte order and are decoded when read
+ * - fixed binary files read through addWordsFromFile(istream) failing
  * @version 2015/07/05
  * - using global hashing functions rather than global variables
  * @version 2014/11/13
@@ -40,8 +44,12 @@
 #include "error.h"
 #include "hashcode.h"
 #include "strlib.h"
-
-static uint32_t my_ntohl(uint32_t arg);
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 /*
  * The DAWG is stored as an array of edges. Each edge is represented by
@@ -51,24 +59,33 @@ static uint32_t my_ntohl(uint32_t arg);
  * "lastEdge" bit marks this as the last edge in a sequence of childeren.
  * The bulk of the bits (24) are used for the index within the edge array for
  * the children of this node. The children are laid out contiguously in
- * alphabetical order.  Since we read edges as binary bits from a file in
- * a big-endian format, we have to swap the struct order for little-endian
- * machines.
+ * alphabetical order.  The edges are stored in big-endian byte order in the
+ * file, and edgeAt decodes them in that order as they are read, so the
+ * file's bytes can be used as they are, even when mapped read-only.
  */
 
 DawgLexicon::DawgLexicon() {
-    edges = start = NULL;
+    edgeData = ownedData = NULL;
+    mapping = NULL;
+    mappingLength = 0;
+    start = -1;
     numEdges = numDawgWords = 0;
 }
 
 DawgLexicon::DawgLexicon(std::istream& input) {
-    edges = start = NULL;
+    edgeData = ownedData = NULL;
+    mapping = NULL;
+    mappingLength = 0;
+    start = -1;
     numEdges = numDawgWords = 0;
     addWordsFromFile(input);
 }
 
 DawgLexicon::DawgLexicon(const std::string& filename) {
-    edges = start = NULL;
+    edgeData = ownedData = NULL;
+    mapping = NULL;
+    mappingLength = 0;
+    start = -1;
     numEdges = numDawgWords = 0;
     addWordsFromFile(filename);
 }
@@ -78,7 +95,7 @@ DawgLexicon::DawgLexicon(const DawgLexicon& src) {
 }
 
 DawgLexicon::~DawgLexicon() {
-    if (edges) delete[] edges;
+    releaseEdges();
 }
 
 void DawgLexicon::add(const std::string& word) {
@@ -100,9 +117,10 @@ void DawgLexicon::addWordsFromFile(std::istream& input) {
     }
     input.read(firstFour, 4);
     if (strncmp(firstFour, expected, 4) == 0) {
-        if (otherWords.size() != 0) {
+        if (otherWords.size() != 0 || edgeData != NULL) {
             error("DawgLexicon::addWordsFromFile: Binary files require an empty lexicon");
         }
+        input.seekg(0);
         readBinaryFile(input);
     } else {
         // plain text file
@@ -128,19 +146,54 @@ void DawgLexicon::addWordsFromFile(const std::string& filename) {
 }
 
 void DawgLexicon::clear() {
-    if (edges) {
-        delete[] edges;
-    }
-    edges = start = NULL;
-    numEdges = numDawgWords = 0;
+    releaseEdges();
     otherWords.clear();
 }
 
+void DawgLexicon::mapBinaryFile(const std::string& filename) {
+    if (otherWords.size() != 0 || edgeData != NULL) {
+        error("DawgLexicon::mapBinaryFile: Binary files require an empty lexicon");
+    }
+#ifdef _WIN32
+    readBinaryFile(filename);
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error("DawgLexicon::mapBinaryFile: Couldn't open lexicon file " + filename);
+    }
+    struct stat info;
+    void* addr = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        addr = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (addr == MAP_FAILED) {
+        error("DawgLexicon::mapBinaryFile: Couldn't map lexicon file " + filename);
+    }
+    mapping = addr;
+    mappingLength = (size_t) info.st_size;
+
+    // parse the text header from a copy of its first bytes
+    const unsigned char* bytes = (const unsigned char*) addr;
+    std::istringstream header(std::string((const char*) bytes,
+                                          std::min(mappingLength, (size_t) 64)));
+    long startIndex, numBytes;
+    readBinaryHeader(header, startIndex, numBytes);
+    std::streamoff headerLength = header.tellg();
+    if (header.fail() || numBytes > (long) (mappingLength - (size_t) headerLength)) {
+        releaseEdges();
+        error("DawgLexicon::mapBinaryFile: Improperly formed lexicon file " + filename);
+    }
+    edgeData = bytes + headerLength;
+    setEdges(startIndex, numBytes);
+#endif
+}
+
 bool DawgLexicon::contains(const std::string& word) const {
     std::string copy = word;
     toLowerCaseInPlace(copy);
-    Edge* lastEdge = traceToLastEdge(copy);
-    if (lastEdge && lastEdge->accept) {
+    int lastEdge = traceToLastEdge(copy);
+    if (lastEdge >= 0 && edgeAccepts(edgeAt(lastEdge))) {
         return true;
     }
     return otherWords.contains(copy);
@@ -150,7 +203,7 @@ bool DawgLexicon::containsPrefix(const std::string& prefix) const {
     if (prefix.empty()) return true;
     std::string copy = prefix;
     toLowerCaseInPlace(copy);
-    if (traceToLastEdge(copy)) return true;
+    if (traceToLastEdge(copy) >= 0) return true;
     for (std::string word : otherWords) {
         if (startsWith(word, copy)) return true;
         if (copy < word) return false;
@@ -186,6 +239,9 @@ void DawgLexicon::mapAll(void (*fn)(const std::string &)) const {
 }
 
 int DawgLexicon::size() const {
+    if (numDawgWords < 0) {
+        numDawgWords = (start < 0) ? 0 : countDawgWords(start);
+    }
     return numDawgWords + otherWords.size();
 }
 
@@ -234,29 +290,32 @@ bool DawgLexicon::operator >=(const DawgLexicon& lex2) const {
  * Private methods
  */
 
-int DawgLexicon::countDawgWords(Edge* ep) const {
+int DawgLexicon::countDawgWords(int ep) const {
     int count = 0;
     while (true) {
-        if (ep->accept) count++;
-        if (ep->children != 0) {
-            count += countDawgWords(&edges[ep->children]);
+        unsigned int edge = edgeAt(ep);
+        if (edgeAccepts(edge)) count++;
+        if (edgeChildren(edge) != 0) {
+            count += countDawgWords(edgeChildren(edge));
         }
-        if (ep->lastEdge) break;
+        if (edgeIsLast(edge)) break;
         ep++;
     }
     return count;
 }
 
 void DawgLexicon::deepCopy(const DawgLexicon& src) {
-    if (src.edges == NULL) {
-        edges = NULL;
-        start = NULL;
-    } else {
-        numEdges = src.numEdges;
-        edges = new Edge[src.numEdges];
-        memcpy(edges, src.edges, sizeof(Edge)*src.numEdges);
-        start = edges + (src.start - src.edges);
+    // a copy always owns its edges, even if the source is mapped
+    edgeData = ownedData = NULL;
+    mapping = NULL;
+    mappingLength = 0;
+    if (src.edgeData != NULL) {
+        ownedData = new unsigned char[4 * src.numEdges];
+        memcpy(ownedData, src.edgeData, 4 * src.numEdges);
+        edgeData = ownedData;
     }
+    start = src.start;
+    numEdges = src.numEdges;
     numDawgWords = src.numDawgWords;
     otherWords = src.otherWords;
 }
@@ -265,33 +324,32 @@ void DawgLexicon::deepCopy(const DawgLexicon& src) {
  * Implementation notes: findEdgeForChar
  * -------------------------------------
  * Iterate over sequence of children to find one that
- * matches the given char.  Returns NULL if we get to
+ * matches the given char.  Returns -1 if we get to
  * last child without finding a match (thus no such
  * child edge exists).
  */
-DawgLexicon::Edge* DawgLexicon::findEdgeForChar(Edge* children, char ch) const {
-    Edge* curEdge = children;
+int DawgLexicon::findEdgeForChar(int children, char ch) const {
+    int curEdge = children;
+    unsigned int ord = charToOrd(ch);
     while (true) {
-        if (curEdge->letter == charToOrd(ch)) {
+        unsigned int edge = edgeAt(curEdge);
+        if (edgeLetter(edge) == ord) {
             return curEdge;
         }
-        if (curEdge->lastEdge) return NULL;
+        if (edgeIsLast(edge)) return -1;
         curEdge++;
     }
 }
 
 /*
- * Implementation notes: readBinaryFile
- * ------------------------------------
+ * Implementation notes: readBinaryHeader
+ * --------------------------------------
  * The binary lexicon file format must follow this pattern:
  * DAWG:<startnode index>:<num bytes>:<num bytes block of edge data>
+ * This reads everything up to the edge data.
  */
-void DawgLexicon::readBinaryFile(std::istream& input) {
-    long startIndex, numBytes;
+void DawgLexicon::readBinaryHeader(std::istream& input, long& startIndex, long& numBytes) {
     char firstFour[4], expected[] = "DAWG";
-    if (input.fail()) {
-        error("DawgLexicon::addWordsFromFile: Couldn't read input");
-    }
     input.read(firstFour, 4);
     input.get();
     input >> startIndex;
@@ -300,24 +358,49 @@ void DawgLexicon::readBinaryFile(std::istream& input) {
     input.get();
     if (input.fail() || strncmp(firstFour, expected, 4) != 0
             || startIndex < 0 || numBytes < 0) {
-        error("DawgLexicon::addWordsFromFile: Improperly formed lexicon file");
+        input.setstate(std::ios::failbit);
     }
-    numEdges = numBytes / sizeof(Edge);
-    edges = new Edge[numEdges];
-    start = &edges[startIndex];
-    input.read((char*) edges, numBytes);
-    if (input.fail() && !input.eof()) {
+}
+
+/*
+ * Implementation notes: setEdges
+ * ------------------------------
+ * Finishes loading once edgeData holds the edges from the file.  The
+ * words are not counted until size() is called, so loading does not
+ * need to visit the edges.
+ */
+void DawgLexicon::setEdges(long startIndex, long numBytes) {
+    numEdges = (int) (numBytes / 4);
+    if (startIndex >= numEdges) {
+        releaseEdges();
         error("DawgLexicon::addWordsFromFile: Improperly formed lexicon file");
     }
+    start = (int) startIndex;
+    numDawgWords = -1;
+}
 
-#if defined(BYTE_ORDER) && BYTE_ORDER == LITTLE_ENDIAN
-    uint32_t *cur = (uint32_t *) edges;
-    for (int i = 0; i < numEdges; i++, cur++) {
-        *cur = my_ntohl(*cur);
+/*
+ * Implementation notes: readBinaryFile
+ * ------------------------------------
+ * Reads the edges of a binary lexicon file into memory.
+ */
+void DawgLexicon::readBinaryFile(std::istream& input) {
+    long startIndex, numBytes;
+    if (input.fail()) {
+        error("DawgLexicon::addWordsFromFile: Couldn't read input");
     }
-#endif
-
-    numDawgWords = countDawgWords(start);
+    readBinaryHeader(input, startIndex, numBytes);
+    if (input.fail()) {
+        error("DawgLexicon::addWordsFromFile: Improperly formed lexicon file");
+    }
+    ownedData = new unsigned char[numBytes];
+    edgeData = ownedData;
+    input.read((char*) ownedData, numBytes);
+    if (input.fail() && !input.eof()) {
+        releaseEdges();
+        error("DawgLexicon::addWordsFromFile: Improperly formed lexicon file");
+    }
+    setEdges(startIndex, numBytes);
 }
 
 /*
@@ -339,33 +422,52 @@ void DawgLexicon::readBinaryFile(const std::string& filename) {
     input.close();
 }
 
+/*
+ * Implementation notes: releaseEdges
+ * ----------------------------------
+ * Frees or unmaps the DAWG, leaving only the words in otherWords.
+ */
+void DawgLexicon::releaseEdges() {
+    if (ownedData != NULL) {
+        delete[] ownedData;
+    }
+#ifndef _WIN32
+    if (mapping != NULL) {
+        munmap(mapping, mappingLength);
+    }
+#endif
+    edgeData = ownedData = NULL;
+    mapping = NULL;
+    mappingLength = 0;
+    start = -1;
+    numEdges = numDawgWords = 0;
+}
+
 /*
  * Implementation notes: traceToLastEdge
  * -------------------------------------
  * Given a string, trace out path through the DAWG edge-by-edge.
- * If a path exists, return last edge; otherwise return NULL.
+ * If a path exists, return last edge; otherwise return -1.
  */
 
-DawgLexicon::Edge* DawgLexicon::traceToLastEdge(const std::string& s) const {
-    if (!start) {
-        return NULL;
+int DawgLexicon::traceToLastEdge(const std::string& s) const {
+    if (start < 0) {
+        return -1;
     }
-    Edge* curEdge = findEdgeForChar(start, s[0]);
+    int curEdge = findEdgeForChar(start, s[0]);
     int len = (int) s.length();
     for (int i = 1; i < len; i++) {
-        if (!curEdge || !curEdge->children) {
-            return NULL;
+        if (curEdge < 0 || edgeChildren(edgeAt(curEdge)) == 0) {
+            return -1;
         }
-        curEdge = findEdgeForChar(&edges[curEdge->children], s[i]);
+        curEdge = findEdgeForChar(edgeChildren(edgeAt(curEdge)), s[i]);
     }
     return curEdge;
 }
 
 DawgLexicon& DawgLexicon::operator =(const DawgLexicon& src) {
     if (this != &src) {
-        if (edges != NULL) {
-            delete[] edges;
-        }
+        releaseEdges();
         deepCopy(src);
     }
     return *this;
@@ -381,32 +483,33 @@ void DawgLexicon::iterator::advanceToNextWordInSet() {
 }
 
 void DawgLexicon::iterator::advanceToNextEdge() {
-    Edge *ep = edgePtr;
-    if (ep->children == 0) {
-        while (ep != NULL && ep->lastEdge) {
+    int ep = edge;
+    unsigned int bits = lp->edgeAt(ep);
+    if (edgeChildren(bits) == 0) {
+        while (edgeIsLast(lp->edgeAt(ep))) {
             if (stack.isEmpty()) {
-                edgePtr = NULL;
+                edge = -1;
                 return;
             } else {
                 ep = stack.pop();
                 currentDawgPrefix.resize(currentDawgPrefix.length() - 1);
             }
         }
-        edgePtr = ep + 1;
+        edge = ep + 1;
     } else {
         stack.push(ep);
-        currentDawgPrefix.push_back(lp->ordToChar(ep->letter));
-        edgePtr = &lp->edges[ep->children];
+        currentDawgPrefix.push_back(lp->ordToChar(edgeLetter(bits)));
+        edge = edgeChildren(bits);
     }
 }
 
 void DawgLexicon::iterator::advanceToNextWordInDawg() {
-    if (edgePtr == NULL) {
-        edgePtr = lp->start;
+    if (edge < 0) {
+        edge = lp->start;
     } else {
         advanceToNextEdge();
     }
-    while (edgePtr != NULL && !edgePtr->accept) {
+    while (edge >= 0 && !edgeAccepts(lp->edgeAt(edge))) {
         advanceToNextEdge();
     }
 }
@@ -433,14 +536,3 @@ int hashCode(const DawgLexicon& lex) {
     }
     return int(code & hashMask());
 }
-
-/*
- * Swaps a 4-byte long from big to little endian byte order
- */
-static uint32_t my_ntohl(uint32_t arg) {
-    uint32_t result = ((arg & 0xff000000) >> 24) |
-            ((arg & 0x00ff0000) >> 8) |
-            ((arg & 0x0000ff00) << 8) |
-            ((arg & 0x000000ff) << 24);
-    return result;
-}
@@ -4,6 +4,10 @@
  * This file exports the <code>DawgLexicon</code> class, which is a
  * compact structure for storing a list of words.
  * 
+ * @version 2026/10/18
+ * - added mapBinaryFile to use a binary lexicon file in place
+ * - edges are kept in file byte order and decoded on access
+ * - word count is computed on first use instead of at load time
  * @version 2014/11/13
  * - added comparison operators <, >=, etc.
  * - added hashCode function
@@ -118,6 +122,20 @@ public:
      */
     void clear();
     
+    /*
+     * Method: mapBinaryFile
+     * Usage: lex.mapBinaryFile(filename);
+     * -----------------------------------
+     * Loads a lexicon file in the precompiled binary format by mapping the
+     * file into memory instead of reading it.  Lookups then read the file's
+     * pages directly, so loading takes the same short time for any size of
+     * lexicon, and processes that map the same file share one copy of it.
+     * The lexicon must be empty, and the file must not change while the
+     * lexicon uses it.  On systems without memory mapping the file is read
+     * in as by <code>addWordsFromFile</code>.
+     */
+    void mapBinaryFile(const std::string& filename);
+    
     /*
      * Method: contains
      * Usage: if (lex.contains(word)) ...
@@ -239,34 +257,45 @@ public:
     /* of the implementation and should not be of interest to clients.    */
     /**********************************************************************/
 private:
-#ifdef _WIN32
-#define LITTLE_ENDIAN 1
-#define BYTE_ORDER LITTLE_ENDIAN
-#endif
-
-#pragma pack(1)
-    struct Edge {
-#if defined(BYTE_ORDER) && BYTE_ORDER == LITTLE_ENDIAN
-        unsigned long letter:5;
-        unsigned long lastEdge:1;
-        unsigned long accept:1;
-        unsigned long unused:1;
-        unsigned long children:24;
-#else
-        unsigned long children:24;
-        unsigned long unused:1;
-        unsigned long accept:1;
-        unsigned long lastEdge:1;
-        unsigned long letter:5;
-#endif
-    };
-#pragma pack()
-    Edge* edges;
-    Edge* start;
+    /*
+     * Implementation notes: edges
+     * ---------------------------
+     * The DAWG is an array of 32-bit edges, kept in the big-endian byte
+     * order of the binary file so that a mapped file can be used without
+     * converting it.  Edges are referred to by their index in the array,
+     * with -1 meaning no edge, and decoded with the edge* methods below.
+     */
+    const unsigned char* edgeData;  /* numEdges edges in file byte order  */
+    unsigned char* ownedData;       /* edgeData, if it was read in        */
+    void* mapping;                  /* mapped file, if it was mapped      */
+    size_t mappingLength;           /* length of the mapped file          */
+    int start;                      /* index of the first root edge or -1 */
     int numEdges;
-    int numDawgWords;
+    mutable int numDawgWords;       /* -1 until counted                   */
     Set<std::string> otherWords;
 
+    unsigned int edgeAt(int index) const {
+        const unsigned char* p = edgeData + 4 * index;
+        return ((unsigned int) p[0] << 24) | ((unsigned int) p[1] << 16)
+                | ((unsigned int) p[2] << 8) | (unsigned int) p[3];
+    }
+
+    static unsigned int edgeLetter(unsigned int edge) {
+        return edge & 0x1f;
+    }
+
+    static bool edgeIsLast(unsigned int edge) {
+        return (edge >> 5) & 1;
+    }
+
+    static bool edgeAccepts(unsigned int edge) {
+        return (edge >> 6) & 1;
+    }
+
+    static int edgeChildren(unsigned int edge) {
+        return (int) (edge >> 8);
+    }
+
 public:
     /*
      * Deep copying support
@@ -296,8 +325,8 @@ public:
         std::string currentDawgPrefix;
         std::string currentSetWord;
         std::string tmpWord;
-        Edge* edgePtr;
-        Stack<Edge*> stack;
+        int edge;
+        Stack<int> stack;
         Set<std::string>::iterator setIterator;
         Set<std::string>::iterator setEnd;
 
@@ -306,7 +335,7 @@ public:
         void advanceToNextEdge();
 
     public:
-        iterator() : lp(NULL), index(0), edgePtr(NULL) {
+        iterator() : lp(NULL), index(0), edge(-1) {
             /* empty */
         }
 
@@ -316,7 +345,7 @@ public:
                 index = lp->size();
             } else {
                 index = 0;
-                edgePtr = NULL;
+                edge = -1;
                 setIterator = lp->otherWords.begin();
                 setEnd = lp->otherWords.end();
                 currentDawgPrefix = "";
@@ -326,18 +355,8 @@ public:
             }
         }
 
-        iterator(const iterator& it) {
-            lp = it.lp;
-            index = it.index;
-            currentDawgPrefix = it.currentDawgPrefix;
-            currentSetWord = it.currentSetWord;
-            edgePtr = it.edgePtr;
-            stack = it.stack;
-            setIterator = it.setIterator;
-        }
-
         iterator& operator ++() {
-            if (edgePtr == NULL) {
+            if (edge < 0) {
                 advanceToNextWordInSet();
             } else {
                 if (currentSetWord == "" || currentDawgPrefix < currentSetWord) {
@@ -365,22 +384,22 @@ public:
         }
 
         std::string operator *() {
-            if (edgePtr == NULL) {
+            if (edge < 0) {
                 return currentSetWord;
             }
             if (currentSetWord == "" || currentDawgPrefix < currentSetWord) {
-                return currentDawgPrefix + lp->ordToChar(edgePtr->letter);
+                return currentDawgPrefix + lp->ordToChar(edgeLetter(lp->edgeAt(edge)));
             } else {
                 return currentSetWord;
             }
         }
 
         std::string* operator ->() {
-            if (edgePtr == NULL) {
+            if (edge < 0) {
                 return &currentSetWord;
             }
             if (currentSetWord == "" || currentDawgPrefix < currentSetWord) {
-                tmpWord = currentDawgPrefix + lp->ordToChar(edgePtr->letter);
+                tmpWord = currentDawgPrefix + lp->ordToChar(edgeLetter(lp->edgeAt(edge)));
                 return &tmpWord;
             } else {
                 return &currentSetWord;
@@ -397,12 +416,15 @@ public:
     }
 
 private:
-    Edge* findEdgeForChar(Edge* children, char ch) const;
-    Edge* traceToLastEdge(const std::string& s) const;
+    int findEdgeForChar(int children, char ch) const;
+    int traceToLastEdge(const std::string& s) const;
+    static void readBinaryHeader(std::istream& input, long& startIndex, long& numBytes);
     void readBinaryFile(std::istream& input);
     void readBinaryFile(const std::string& filename);
+    void setEdges(long startIndex, long numBytes);
+    void releaseEdges();
     void deepCopy(const DawgLexicon& src);
-    int countDawgWords(Edge* start) const;
+    int countDawgWords(int start) const;
 
     unsigned int charToOrd(char ch) const {
         return ((unsigned int)(tolower(ch) - 'a' + 1));
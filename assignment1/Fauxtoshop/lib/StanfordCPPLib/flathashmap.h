@@ -0,0 +1,1072 @@
+/*
+ * File: flathashmap.h
+ * -------------------
+ * This file exports the <code>FlatHashMap</code> class, which stores
+ * a set of <i>key</i>-<i>value</i> pairs in a flat open-addressing
+ * hash table.
+ *
+ * @version 2026/10/18
+ * - initial version
+ */
+
+#ifndef _flathashmap_h
+#define _flathashmap_h
+
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <utility>
+#include "error.h"
+#include "hashcode.h"
+#include "vector.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Class: FlatHashMap<KeyType,ValueType>
+ * -------------------------------------
+ * This class implements an efficient association between
+ * <b><i>keys</i></b> and <b><i>values</i></b>.  It has exactly the same
+ * interface as the <a href="HashMap-class.html"><code>HashMap</code></a>
+ * class and can be used in its place, but it stores its entries in one
+ * contiguous array instead of a linked list of cells per bucket, so
+ * adding an entry does not allocate memory (except when the table grows)
+ * and looking up a key usually touches a single cache line.  Like
+ * <code>HashMap</code>, its iterator returns the keys in a seemingly
+ * random order.
+ */
+template <typename KeyType, typename ValueType>
+class FlatHashMap {
+public:
+    /*
+     * Constructor: FlatHashMap
+     * Usage: FlatHashMap<KeyType,ValueType> map;
+     * ------------------------------------------
+     * Initializes a new empty map that associates keys and values of
+     * the specified types.  As for <code>HashMap</code>, the key type must
+     * define the <code>==</code> operator and have a <code>hashCode</code>
+     * function.  An empty map allocates no memory.
+     */
+    FlatHashMap();
+
+    /*
+     * Destructor: ~FlatHashMap
+     * ------------------------
+     * Frees any heap storage associated with this map.
+     */
+    virtual ~FlatHashMap();
+
+    /*
+     * Method: add
+     * Usage: map.add(key, value);
+     * ---------------------------
+     * Associates <code>key</code> with <code>value</code> in this map.
+     * A synonym for the put method.
+     */
+    void add(const KeyType& key, const ValueType& value);
+
+    /*
+     * Method: clear
+     * Usage: map.clear();
+     * -------------------
+     * Removes all entries from this map.
+     */
+    void clear();
+
+    /*
+     * Method: containsKey
+     * Usage: if (map.containsKey(key)) ...
+     * ------------------------------------
+     * Returns <code>true</code> if there is an entry for <code>key</code>
+     * in this map.
+     */
+    bool containsKey(const KeyType& key) const;
+
+    /*
+     * Method: equals
+     * Usage: if (map.equals(map2)) ...
+     * --------------------------------
+     * Returns <code>true</code> if the two maps contain exactly the same
+     * key/value pairs, and <code>false</code> otherwise.
+     */
+    bool equals(const FlatHashMap& map2) const;
+
+    /*
+     * Method: get
+     * Usage: ValueType value = map.get(key);
+     * --------------------------------------
+     * Returns the value associated with <code>key</code> in this map.
+     * If <code>key</code> is not found, <code>get</code> returns the
+     * default value for <code>ValueType</code>.
+     */
+    ValueType get(const KeyType& key) const;
+
+    /*
+     * Method: isEmpty
+     * Usage: if (map.isEmpty()) ...
+     * -----------------------------
+     * Returns <code>true</code> if this map contains no entries.
+     */
+    bool isEmpty() const;
+
+    /*
+     * Method: keys
+     * Usage: Vector<KeyType> keys = map.keys();
+     * -----------------------------------------
+     * Returns a collection containing all keys in this map.
+     * Note that this implementation makes a deep copy of the keys,
+     * so it is inefficient to call on large maps.
+     */
+    Vector<KeyType> keys() const;
+
+    /*
+     * Method: mapAll
+     * Usage: map.mapAll(fn);
+     * ----------------------
+     * Iterates through the map entries and calls <code>fn(key, value)</code>
+     * for each one.  The keys are processed in an undetermined order.
+     */
+    void mapAll(void (*fn)(KeyType, ValueType)) const;
+    void mapAll(void (*fn)(const KeyType&, const ValueType&)) const;
+
+    template <typename FunctorType>
+    void mapAll(FunctorType fn) const;
+
+    /*
+     * Method: put
+     * Usage: map.put(key, value);
+     * ---------------------------
+     * Associates <code>key</code> with <code>value</code> in this map.
+     * Any previous value associated with <code>key</code> is replaced
+     * by the new value.
+     */
+    void put(const KeyType& key, const ValueType& value);
+
+    /*
+     * Method: putAll
+     * Usage: map.putAll(map2);
+     * ---------------------------
+     * Adds all key/value pairs from the given map to this map.
+     * If both maps contain a pair for the same key, the one from map2 will
+     * replace the one from this map.
+     * Returns a reference to this map.
+     */
+    FlatHashMap& putAll(const FlatHashMap& map2);
+
+    /*
+     * Method: remove
+     * Usage: map.remove(key);
+     * -----------------------
+     * Removes any entry for <code>key</code> from this map.
+     * If the given key is not found, has no effect.
+     */
+    void remove(const KeyType& key);
+
+    /*
+     * Method: removeAll
+     * Usage: map.removeAll(map2);
+     * ---------------------------
+     * Removes all key/value pairs from this map that are contained in the given map.
+     * If both maps contain the same key but it maps to different values, that
+     * mapping will not be removed.
+     * Returns a reference to this map.
+     */
+    FlatHashMap& removeAll(const FlatHashMap& map2);
+
+    /*
+     * Method: retainAll
+     * Usage: map.retainAll(map2);
+     * ---------------------------
+     * Removes all key/value pairs from this map that are not contained in the given map.
+     * If both maps contain the same key but it maps to different values, that
+     * mapping will be removed.
+     * Returns a reference to this map.
+     */
+    FlatHashMap& retainAll(const FlatHashMap& map2);
+
+    /*
+     * Method: size
+     * Usage: int nEntries = map.size();
+     * ---------------------------------
+     * Returns the number of entries in this map.
+     */
+    int size() const;
+
+    /*
+     * Method: toString
+     * Usage: string str = map.toString();
+     * -----------------------------------
+     * Converts the map to a printable string representation.
+     */
+    std::string toString() const;
+
+    /*
+     * Method: values
+     * Usage: Vector<ValueType> values = map.values();
+     * -----------------------------------------------
+     * Returns a collection containing all values in this map.
+     * Note that this implementation makes a deep copy of the values,
+     * so it is inefficient to call on large maps.
+     */
+    Vector<ValueType> values() const;
+
+    /*
+     * Operator: []
+     * Usage: map[key]
+     * ---------------
+     * Selects the value associated with <code>key</code>.  If
+     * <code>key</code> is already present in the map, this function
+     * returns a reference to its associated value.  If key is not present
+     * in the map, a new entry is created whose value is set to the default
+     * for the value type.  The reference is valid until the next entry is
+     * added, since adding can move every entry of the table.
+     */
+    ValueType& operator [](const KeyType& key);
+    ValueType operator [](const KeyType& key) const;
+
+    /*
+     * Operator: ==
+     * Usage: if (map1 == map2) ...
+     * ----------------------------
+     * Compares two maps for equality.
+     */
+    bool operator ==(const FlatHashMap& map2) const;
+
+    /*
+     * Operator: !=
+     * Usage: if (map1 != map2) ...
+     * ----------------------------
+     * Compares two maps for inequality.
+     */
+    bool operator !=(const FlatHashMap& map2) const;
+
+    /*
+     * Operator: +
+     * Usage: map1 + map2
+     * ------------------
+     * Returns the union of the two maps, equivalent to a copy of the first map
+     * with addAll called on it passing the second map as a parameter.
+     * If the two maps both contain a mapping for the same key, the mapping
+     * from the second map is favored.
+     */
+    FlatHashMap operator +(const FlatHashMap& map2) const;
+
+    /*
+     * Operator: +=
+     * Usage: map1 += map2;
+     * --------------------
+     * Adds all key/value pairs from the given map to this map.
+     * Equivalent to calling addAll(map2).
+     */
+    FlatHashMap& operator +=(const FlatHashMap& map2);
+
+    /*
+     * Operator: -
+     * Usage: map1 - map2
+     * ------------------
+     * Returns the difference of the two maps, equivalent to a copy of the first map
+     * with removeAll called on it passing the second map as a parameter.
+     */
+    FlatHashMap operator -(const FlatHashMap& map2) const;
+
+    /*
+     * Operator: -=
+     * Usage: map1 -= map2;
+     * --------------------
+     * Removes all key/value pairs from the given map to this map.
+     * Equivalent to calling removeAll(map2).
+     */
+    FlatHashMap& operator -=(const FlatHashMap& map2);
+
+    /*
+     * Operator: *
+     * Usage: map1 * map2
+     * ------------------
+     * Returns the intersection of the two maps, equivalent to a copy of the first map
+     * with retainAll called on it passing the second map as a parameter.
+     */
+    FlatHashMap operator *(const FlatHashMap& map2) const;
+
+    /*
+     * Operator: *=
+     * Usage: map1 *= map2;
+     * ---------------------
+     * Removes all key/value pairs that are not found in the given map from this map.
+     * Equivalent to calling retainAll(map2).
+     */
+    FlatHashMap& operator *=(const FlatHashMap& map2);
+
+    /*
+     * Additional FlatHashMap operations
+     * ---------------------------------
+     * In addition to the methods listed in this interface, the FlatHashMap
+     * class supports the following operations:
+     *
+     *   - Stream I/O using the << and >> operators
+     *   - Deep copying for the copy constructor and assignment operator
+     *   - Iteration using the range-based for statement and STL iterators
+     *
+     * The FlatHashMap class makes no guarantees about the order of iteration.
+     */
+
+    /* Private section */
+
+    /**********************************************************************/
+    /* Note: Everything below this point in the file is logically part    */
+    /* of the implementation and should not be of interest to clients.    */
+    /**********************************************************************/
+
+    /*
+     * Implementation notes:
+     * ---------------------
+     * The FlatHashMap class is a "Swiss table": an open-addressing hash
+     * table whose slots are paired with one control byte each.  A control
+     * byte is CTRL_EMPTY, CTRL_DELETED (a tombstone left by remove), or, for
+     * a full slot, 7 bits of the key's hash.  Lookups probe the control bytes
+     * a group of 16 at a time; with SSE2 one compare instruction finds every
+     * slot in the group whose 7 hash bits match, so the keys themselves are
+     * compared only for likely matches.  The first GROUP_SIZE control bytes
+     * are mirrored past the end of the array so that a group starting near
+     * the end can be loaded without wrapping around.
+     */
+private:
+    /* Constant definitions */
+    static const int GROUP_SIZE = 16;
+    static const int MIN_CAPACITY = 16;
+    static const signed char CTRL_EMPTY = -128;
+    static const signed char CTRL_DELETED = -2;
+
+    /* Type definition for the slots of the table */
+    struct Slot {
+        KeyType key;
+        ValueType value;
+    };
+
+    /* Instance variables */
+    signed char* ctrl;     /* capacity + GROUP_SIZE control bytes           */
+    Slot* slots;           /* raw storage; only full slots are constructed  */
+    int capacity;          /* number of slots; 0 or a power of two          */
+    int numEntries;        /* number of full slots                          */
+    int growthLeft;        /* empty slots that may still be filled          */
+
+    /* Private methods */
+
+    /*
+     * Private method: matchByte
+     * Usage: unsigned bits = matchByte(group, value);
+     * -----------------------------------------------
+     * Returns a mask with bit i set for each of the GROUP_SIZE control
+     * bytes starting at group[0] that equals value.
+     */
+    static unsigned matchByte(const signed char* group, signed char value) {
+#ifdef __SSE2__
+        __m128i bytes = _mm_loadu_si128((const __m128i*) group);
+        return (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(value)));
+#else
+        unsigned bits = 0;
+        for (int i = 0; i < GROUP_SIZE; i++) {
+            if (group[i] == value) {
+                bits |= 1u << i;
+            }
+        }
+        return bits;
+#endif
+    }
+
+    /*
+     * Private method: matchFree
+     * Usage: unsigned bits = matchFree(group);
+     * ----------------------------------------
+     * Returns a mask of the control bytes in the group that are empty or
+     * deleted, which are exactly the negative ones.
+     */
+    static unsigned matchFree(const signed char* group) {
+#ifdef __SSE2__
+        return (unsigned) _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) group));
+#else
+        unsigned bits = 0;
+        for (int i = 0; i < GROUP_SIZE; i++) {
+            if (group[i] < 0) {
+                bits |= 1u << i;
+            }
+        }
+        return bits;
+#endif
+    }
+
+    /*
+     * Private method: lowestBit
+     * Usage: int i = lowestBit(bits);
+     * -------------------------------
+     * Returns the index of the lowest set bit of a nonzero mask.
+     */
+    static int lowestBit(unsigned bits) {
+#ifdef __GNUC__
+        return __builtin_ctz(bits);
+#else
+        int i = 0;
+        while ((bits & 1) == 0) {
+            bits >>= 1;
+            i++;
+        }
+        return i;
+#endif
+    }
+
+    /*
+     * Private method: hashOf
+     * Usage: unsigned long long h = hashOf(key);
+     * ------------------------------------------
+     * Spreads the key's hashCode over 64 bits.  hashCode is often the key
+     * itself (as for int), so it is mixed before its low 7 bits become the
+     * control byte and the rest pick the starting slot.
+     */
+    static unsigned long long hashOf(const KeyType& key) {
+        unsigned long long h = (unsigned long long) (unsigned) hashCode(key)
+                * 0x9E3779B97F4A7C15ULL;
+        return h ^ (h >> 32);
+    }
+
+    /*
+     * Private method: setCtrl
+     * Usage: setCtrl(index, value);
+     * -----------------------------
+     * Sets a control byte, and its mirror copy if it has one.
+     */
+    void setCtrl(int index, signed char value) {
+        ctrl[index] = value;
+        if (index < GROUP_SIZE) {
+            ctrl[capacity + index] = value;
+        }
+    }
+
+    /*
+     * Private method: findIndex
+     * Usage: int index = findIndex(key);
+     * ----------------------------------
+     * Returns the index of the slot holding key, or -1 if there is none.
+     * The probe visits groups at triangular-number offsets, which covers
+     * the whole table since the capacity is a power of two; it stops at
+     * the first group with an empty slot, since an insertion of the key
+     * would have used that slot.
+     */
+    int findIndex(const KeyType& key) const {
+        if (numEntries == 0) {
+            return -1;
+        }
+        unsigned long long h = hashOf(key);
+        signed char tag = (signed char) (h & 0x7f);
+        int mask = capacity - 1;
+        int pos = (int) (h >> 7) & mask;
+        for (int step = GROUP_SIZE; ; step += GROUP_SIZE) {
+            const signed char* group = ctrl + pos;
+            for (unsigned bits = matchByte(group, tag); bits != 0; bits &= bits - 1) {
+                int index = (pos + lowestBit(bits)) & mask;
+                if (slots[index].key == key) {
+                    return index;
+                }
+            }
+            if (matchByte(group, CTRL_EMPTY) != 0) {
+                return -1;
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+
+    /*
+     * Private method: findFreeIndex
+     * Usage: int index = findFreeIndex(h);
+     * ------------------------------------
+     * Returns the first empty or deleted slot on the probe sequence for
+     * the given hash.
+     */
+    int findFreeIndex(unsigned long long h) const {
+        int mask = capacity - 1;
+        int pos = (int) (h >> 7) & mask;
+        for (int step = GROUP_SIZE; ; step += GROUP_SIZE) {
+            unsigned bits = matchFree(ctrl + pos);
+            if (bits != 0) {
+                return (pos + lowestBit(bits)) & mask;
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+
+    /*
+     * Private method: nextFull
+     * Usage: int index = nextFull(start);
+     * -----------------------------------
+     * Returns the index of the first full slot at or after start, or
+     * capacity if there is none.
+     */
+    int nextFull(int start) const {
+        for (int i = start; i < capacity; i += GROUP_SIZE) {
+            unsigned bits = ~matchFree(ctrl + i) & 0xffff;
+            if (bits != 0) {
+                int index = i + lowestBit(bits);
+                return index < capacity ? index : capacity;
+            }
+        }
+        return capacity;
+    }
+
+    /*
+     * Private method: allocate
+     * Usage: allocate(capacity);
+     * --------------------------
+     * Sets up empty storage for the given number of slots, which must be
+     * 0 or a power of two of at least MIN_CAPACITY.  The table is allowed
+     * to fill to 7/8 of its capacity, counting tombstones.
+     */
+    void allocate(int capacity) {
+        this->capacity = capacity;
+        numEntries = 0;
+        if (capacity == 0) {
+            ctrl = NULL;
+            slots = NULL;
+            growthLeft = 0;
+            return;
+        }
+        ctrl = new signed char[capacity + GROUP_SIZE];
+        for (int i = 0; i < capacity + GROUP_SIZE; i++) {
+            ctrl[i] = CTRL_EMPTY;
+        }
+        slots = static_cast<Slot*>(::operator new(capacity * sizeof(Slot)));
+        growthLeft = capacity - capacity / 8;
+    }
+
+    /*
+     * Private method: deallocate
+     * Usage: deallocate();
+     * --------------------
+     * Destroys every entry and frees the storage.
+     */
+    void deallocate() {
+        for (int i = 0; i < capacity; i++) {
+            if (ctrl[i] >= 0) {
+                slots[i].~Slot();
+            }
+        }
+        delete[] ctrl;
+        ::operator delete(slots);
+        ctrl = NULL;
+        slots = NULL;
+        capacity = 0;
+        numEntries = 0;
+        growthLeft = 0;
+    }
+
+    /*
+     * Private method: rehash
+     * Usage: rehash(newCapacity);
+     * ---------------------------
+     * Moves every entry into a fresh table of the given capacity, which
+     * also drops all tombstones.  This is the only O(N) operation, and it
+     * moves the entries rather than copying them.
+     */
+    void rehash(int newCapacity) {
+        signed char* oldCtrl = ctrl;
+        Slot* oldSlots = slots;
+        int oldCapacity = capacity;
+        int oldEntries = numEntries;
+        allocate(newCapacity);
+        for (int i = 0; i < oldCapacity; i++) {
+            if (oldCtrl[i] >= 0) {
+                unsigned long long h = hashOf(oldSlots[i].key);
+                int index = findFreeIndex(h);
+                new (&slots[index]) Slot(std::move(oldSlots[i]));
+                setCtrl(index, (signed char) (h & 0x7f));
+                oldSlots[i].~Slot();
+            }
+        }
+        numEntries = oldEntries;
+        growthLeft -= oldEntries;
+        delete[] oldCtrl;
+        ::operator delete(oldSlots);
+    }
+
+    void deepCopy(const FlatHashMap& src) {
+        // copy the slots into the same positions so that the copy iterates
+        // (and therefore hashes) exactly like the original
+        allocate(src.capacity);
+        if (capacity == 0) {
+            return;
+        }
+        for (int i = 0; i < capacity + GROUP_SIZE; i++) {
+            ctrl[i] = src.ctrl[i];
+        }
+        for (int i = 0; i < capacity; i++) {
+            if (ctrl[i] >= 0) {
+                new (&slots[i]) Slot(src.slots[i]);
+            }
+        }
+        numEntries = src.numEntries;
+        growthLeft = src.growthLeft;
+    }
+
+public:
+    /*
+     * Hidden features
+     * ---------------
+     * The remainder of this file consists of the code required to
+     * support deep copying and iteration.  Including these methods
+     * in the public interface would make that interface more
+     * difficult to understand for the average client.
+     */
+
+    /*
+     * Deep copying support
+     * --------------------
+     * This copy constructor and operator= are defined to make a
+     * deep copy, making it possible to pass/return maps by value
+     * and assign from one map to another.
+     */
+    FlatHashMap& operator =(const FlatHashMap& src) {
+        if (this != &src) {
+            deallocate();
+            deepCopy(src);
+        }
+        return *this;
+    }
+
+    FlatHashMap(const FlatHashMap& src) {
+        deepCopy(src);
+    }
+
+    /*
+     * Iterator support
+     * ----------------
+     * The classes in the StanfordCPPLib collection implement input
+     * iterators so that they work symmetrically with respect to the
+     * corresponding STL classes.
+     */
+    class iterator : public std::iterator<std::input_iterator_tag, KeyType> {
+    private:
+        const FlatHashMap* mp;       /* Pointer to the map           */
+        int index;                   /* Index of the current slot    */
+
+    public:
+        iterator() : mp(NULL), index(0) {
+            /* Empty */
+        }
+
+        iterator(const FlatHashMap* mp, bool end) {
+            this->mp = mp;
+            index = end ? mp->capacity : mp->nextFull(0);
+        }
+
+        iterator& operator ++() {
+            index = mp->nextFull(index + 1);
+            return *this;
+        }
+
+        iterator operator ++(int) {
+            iterator copy(*this);
+            operator++();
+            return copy;
+        }
+
+        bool operator ==(const iterator& rhs) {
+            return mp == rhs.mp && index == rhs.index;
+        }
+
+        bool operator !=(const iterator& rhs) {
+            return !(*this == rhs);
+        }
+
+        KeyType& operator *() {
+            return mp->slots[index].key;
+        }
+
+        KeyType* operator ->() {
+            return &mp->slots[index].key;
+        }
+
+        friend class FlatHashMap;
+    };
+
+    /*
+     * Returns an iterator positioned at the first key of the map.
+     */
+    iterator begin() const {
+        return iterator(this, /* end */ false);
+    }
+
+    /*
+     * Returns an iterator positioned at the last key of the map.
+     */
+    iterator end() const {
+        return iterator(this, /* end */ true);
+    }
+};
+
+template <typename KeyType, typename ValueType>
+FlatHashMap<KeyType, ValueType>::FlatHashMap() {
+    allocate(0);
+}
+
+template <typename KeyType, typename ValueType>
+FlatHashMap<KeyType, ValueType>::~FlatHashMap() {
+    deallocate();
+}
+
+template <typename KeyType, typename ValueType>
+void FlatHashMap<KeyType, ValueType>::add(const KeyType& key, const ValueType& value) {
+    put(key, value);
+}
+
+template <typename KeyType, typename ValueType>
+void FlatHashMap<KeyType, ValueType>::clear() {
+    // keep the storage, as HashMap keeps its buckets
+    for (int i = 0; i < capacity; i++) {
+        if (ctrl[i] >= 0) {
+            slots[i].~Slot();
+        }
+    }
+    for (int i = 0; i < capacity + GROUP_SIZE && ctrl != NULL; i++) {
+        ctrl[i] = CTRL_EMPTY;
+    }
+    numEntries = 0;
+    growthLeft = capacity - capacity / 8;
+}
+
+template <typename KeyType, typename ValueType>
+bool FlatHashMap<KeyType, ValueType>::containsKey(const KeyType& key) const {
+    return findIndex(key) >= 0;
+}
+
+template <typename KeyType, typename ValueType>
+bool FlatHashMap<KeyType, ValueType>::equals(const FlatHashMap<KeyType, ValueType>& map2) const {
+    // optimization: if literally same map, stop
+    if (this == &map2) {
+        return true;
+    }
+
+    if (size() != map2.size()) {
+        return false;
+    }
+
+    // with equal sizes, every key of this map being in map2 with the same
+    // value means the maps are equal
+    for (int i = 0; i < capacity; i++) {
+        if (ctrl[i] >= 0) {
+            int index = map2.findIndex(slots[i].key);
+            if (index < 0 || !(map2.slots[index].value == slots[i].value)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename KeyType, typename ValueType>
+ValueType FlatHashMap<KeyType, ValueType>::get(const KeyType& key) const {
+    int index = findIndex(key);
+    if (index < 0) {
+        return ValueType();
+    }
+    return slots[index].value;
+}
+
+template <typename KeyType, typename ValueType>
+bool FlatHashMap<KeyType, ValueType>::isEmpty() const {
+    return size() == 0;
+}
+
+template <typename KeyType, typename ValueType>
+Vector<KeyType> FlatHashMap<KeyType, ValueType>::keys() const {
+    Vector<KeyType> keyset;
+    for (KeyType key : *this) {
+        keyset.add(key);
+    }
+    return keyset;
+}
+
+template <typename KeyType, typename ValueType>
+void FlatHashMap<KeyType, ValueType>::mapAll(void (*fn)(KeyType, ValueType)) const {
+    for (int i = 0; i < capacity; i++) {
+        if (ctrl[i] >= 0) {
+            fn(slots[i].key, slots[i].value);
+        }
+    }
+}
+
+template <typename KeyType, typename ValueType>
+void FlatHashMap<KeyType, ValueType>::mapAll(void (*fn)(const KeyType&,
+                                                       const ValueType&)) const {
+    for (int i = 0; i < capacity; i++) {
+        if (ctrl[i] >= 0) {
+            fn(slots[i].key, slots[i].value);
+        }
+    }
+}
+
+template <typename KeyType, typename ValueType>
+template <typename FunctorType>
+void FlatHashMap<KeyType, ValueType>::mapAll(FunctorType fn) const {
+    for (int i = 0; i < capacity; i++) {
+        if (ctrl[i] >= 0) {
+            fn(slots[i].key, slots[i].value);
+        }
+    }
+}
+
+template <typename KeyType, typename ValueType>
+void FlatHashMap<KeyType, ValueType>::put(const KeyType& key, const ValueType& value) {
+    int index = findIndex(key);
+    if (index >= 0) {
+        slots[index].value = value;
+        return;
+    }
+    // value may refer to an entry of this map, which inserting can move
+    ValueType copy(value);
+    (*this)[key] = std::move(copy);
+}
+
+template <typename KeyType, typename ValueType>
+FlatHashMap<KeyType, ValueType>& FlatHashMap<KeyType, ValueType>::putAll(const FlatHashMap& map2) {
+    map2.mapAll([this](const KeyType& key, const ValueType& value) {
+        put(key, value);
+    });
+    return *this;
+}
+
+template <typename KeyType, typename ValueType>
+void FlatHashMap<KeyType, ValueType>::remove(const KeyType& key) {
+    int index = findIndex(key);
+    if (index >= 0) {
+        // leave a tombstone so that probes for other keys keep going;
+        // the slot is reused by a later insertion or dropped by a rehash
+        slots[index].~Slot();
+        setCtrl(index, CTRL_DELETED);
+        numEntries--;
+    }
+}
+
+template <typename KeyType, typename ValueType>
+FlatHashMap<KeyType, ValueType>& FlatHashMap<KeyType, ValueType>::removeAll(const FlatHashMap& map2) {
+    for (int i = 0; i < map2.capacity; i++) {
+        if (map2.ctrl[i] >= 0) {
+            int index = findIndex(map2.slots[i].key);
+            if (index >= 0 && slots[index].value == map2.slots[i].value) {
+                slots[index].~Slot();
+                setCtrl(index, CTRL_DELETED);
+                numEntries--;
+            }
+        }
+    }
+    return *this;
+}
+
+template <typename KeyType, typename ValueType>
+FlatHashMap<KeyType, ValueType>& FlatHashMap<KeyType, ValueType>::retainAll(const FlatHashMap& map2) {
+    // removing never moves other entries, so this can be done in one pass
+    for (int i = 0; i < capacity; i++) {
+        if (ctrl[i] >= 0) {
+            int index = map2.findIndex(slots[i].key);
+            if (index < 0 || !(map2.slots[index].value == slots[i].value)) {
+                slots[i].~Slot();
+                setCtrl(i, CTRL_DELETED);
+                numEntries--;
+            }
+        }
+    }
+    return *this;
+}
+
+template <typename KeyType, typename ValueType>
+int FlatHashMap<KeyType, ValueType>::size() const {
+    return numEntries;
+}
+
+template <typename KeyType, typename ValueType>
+std::string FlatHashMap<KeyType, ValueType>::toString() const {
+    std::ostringstream os;
+    os << *this;
+    return os.str();
+}
+
+template <typename KeyType, typename ValueType>
+Vector<ValueType> FlatHashMap<KeyType, ValueType>::values() const {
+    Vector<ValueType> values;
+    for (int i = 0; i < capacity; i++) {
+        if (ctrl[i] >= 0) {
+            values.add(slots[i].value);
+        }
+    }
+    return values;
+}
+
+template <typename KeyType, typename ValueType>
+ValueType& FlatHashMap<KeyType, ValueType>::operator [](const KeyType& key) {
+    int index = findIndex(key);
+    if (index >= 0) {
+        return slots[index].value;
+    }
+    if (growthLeft == 0) {
+        // grow if the table is mostly live entries; otherwise it is mostly
+        // tombstones, and rehashing at the same size is enough
+        if (capacity == 0) {
+            rehash(MIN_CAPACITY);
+        } else if (numEntries >= (capacity - capacity / 8) / 2) {
+            rehash(capacity * 2);
+        } else {
+            rehash(capacity);
+        }
+    }
+    unsigned long long h = hashOf(key);
+    index = findFreeIndex(h);
+    if (ctrl[index] == CTRL_EMPTY) {
+        growthLeft--;   // reusing a tombstone does not use up an empty slot
+    }
+    Slot* slot = &slots[index];
+    new (&slot->key) KeyType(key);
+    new (&slot->value) ValueType();
+    setCtrl(index, (signed char) (h & 0x7f));
+    numEntries++;
+    return slot->value;
+}
+
+template <typename KeyType, typename ValueType>
+ValueType FlatHashMap<KeyType, ValueType>::operator [](const KeyType& key) const {
+    return get(key);
+}
+
+template <typename KeyType, typename ValueType>
+FlatHashMap<KeyType, ValueType> FlatHashMap<KeyType, ValueType>::operator +(const FlatHashMap& map2) const {
+    FlatHashMap<KeyType, ValueType> result = *this;
+    return result.putAll(map2);
+}
+
+template <typename KeyType, typename ValueType>
+FlatHashMap<KeyType, ValueType>& FlatHashMap<KeyType, ValueType>::operator +=(const FlatHashMap& map2) {
+    return putAll(map2);
+}
+
+template <typename KeyType, typename ValueType>
+FlatHashMap<KeyType, ValueType> FlatHashMap<KeyType, ValueType>::operator -(const FlatHashMap& map2) const {
+    FlatHashMap<KeyType, ValueType> result = *this;
+    return result.removeAll(map2);
+}
+
+template <typename KeyType, typename ValueType>
+FlatHashMap<KeyType, ValueType>& FlatHashMap<KeyType, ValueType>::operator -=(const FlatHashMap& map2) {
+    return removeAll(map2);
+}
+
+template <typename KeyType, typename ValueType>
+FlatHashMap<KeyType, ValueType> FlatHashMap<KeyType, ValueType>::operator *(const FlatHashMap& map2) const {
+    FlatHashMap<KeyType, ValueType> result = *this;
+    return result.retainAll(map2);
+}
+
+template <typename KeyType, typename ValueType>
+FlatHashMap<KeyType, ValueType>& FlatHashMap<KeyType, ValueType>::operator *=(const FlatHashMap& map2) {
+    return retainAll(map2);
+}
+
+template <typename KeyType, typename ValueType>
+bool FlatHashMap<KeyType, ValueType>::operator ==(const FlatHashMap& map2) const {
+    return equals(map2);
+}
+
+template <typename KeyType, typename ValueType>
+bool FlatHashMap<KeyType, ValueType>::operator !=(const FlatHashMap& map2) const {
+    return !equals(map2);
+}
+
+/*
+ * Implementation notes: << and >>
+ * -------------------------------
+ * The insertion and extraction operators use the template facilities in
+ * strlib.h to read and write generic values in a way that treats strings
+ * specially.
+ */
+template <typename KeyType, typename ValueType>
+std::ostream& operator <<(std::ostream& os,
+                          const FlatHashMap<KeyType, ValueType>& map) {
+    os << "{";
+    bool first = true;
+    map.mapAll([&](const KeyType& key, const ValueType& value) {
+        if (!first) {
+            os << ", ";
+        }
+        first = false;
+        writeGenericValue(os, key, /* forceQuotes */ true);
+        os << ":";
+        writeGenericValue(os, value, /* forceQuotes */ true);
+    });
+    return os << "}";
+}
+
+template <typename KeyType, typename ValueType>
+std::istream& operator >>(std::istream& is,
+                          FlatHashMap<KeyType, ValueType>& map) {
+    char ch = '\0';
+    is >> ch;
+    if (ch != '{') {
+        error("FlatHashMap::operator >>: Missing {");
+    }
+    map.clear();
+    is >> ch;
+    if (ch != '}') {
+        is.unget();
+        while (true) {
+            KeyType key;
+            readGenericValue(is, key);
+            is >> ch;
+            if (ch != ':') {
+                error("FlatHashMap::operator >>: Missing colon after key");
+            }
+            ValueType value;
+            readGenericValue(is, value);
+            map[key] = value;
+            is >> ch;
+            if (ch == '}') {
+                break;
+            }
+            if (ch != ',') {
+                error(std::string("FlatHashMap::operator >>: Unexpected character ") + ch);
+            }
+        }
+    }
+    return is;
+}
+
+/*
+ * Template hash function for flat hash maps.
+ * Requires the key and value types in the FlatHashMap to have a hashCode function.
+ */
+template <typename K, typename V>
+int hashCode(const FlatHashMap<K, V>& map) {
+    int code = hashSeed();
+    map.mapAll([&code](const K& k, const V& v) {
+        code = hashMultiplier() * code + hashCode(k);
+        code = hashMultiplier() * code + hashCode(v);
+    });
+    return int(code & hashMask());
+}
+
+/*
+ * Function: randomKey
+ * Usage: element = randomKey(map);
+ * --------------------------------
+ * Returns a randomly chosen key of the given map.
+ * Throws an error if the map is empty.
+ */
+template <typename K, typename V>
+const K& randomKey(const FlatHashMap<K, V>& map) {
+    if (map.isEmpty()) {
+        error("randomKey: empty hash map was passed");
+    }
+    int index = randomInteger(0, map.size() - 1);
+    typename FlatHashMap<K, V>::iterator it = map.begin();
+    for (int i = 0; i < index; i++) {
+        ++it;
+    }
+    return *it;
+}
+
+#endif
@@ -5,6 +5,20 @@
  * See that file for documentation of each member.
  *
  * @author Marty Stepp
+ * @version 2026/10/18
+ * - load and save now decode/encode PNG, JPEG, GIF, and PPM files natively
+ *   via imagecodec.h; the Java back-end is only used for other formats, and
+ *   a natively decoded image reaches it with the next batched flush
+ * - fromGrid builds its pixel bytes in place instead of one stream write each
+ * - setRGB and fromGrid track changed pixels and send them as batched runs;
+ *   added flush
+ * - full updates are Base64-encoded a chunk at a time instead of from a
+ *   complete copy of the pixel bytes
+ * - fromGrid moves a temporary grid into the image instead of copying it
+ * - the pixel grid is only read through const references and changed with
+ *   set, fill and resize, so it can stay shared with grids returned by
+ *   toGrid or passed to fromGrid
+ * - fillRegion changes only the pixel grid's elements in the region
  * @version 2015/10/08
  * - bug fixes and refactoring for pixel-based functions such as fromGrid, load
  *   to help fix bugs with Base64 encoding/decoding
@@ -26,11 +40,15 @@
  */
 
 #include "gbufferedimage.h"
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <iomanip>
+#include <utility>
 #include "base64.h"
 #include "filelib.h"
 #include "gwindow.h"
+#include "imagecodec.h"
 #include "platform.h"
 #include "strlib.h"
 
@@ -38,6 +56,11 @@
 
 const int GBufferedImage::WIDTH_HEIGHT_MAX = 65535;
 
+// sending one run of changed pixels costs about as much as sending this many
+// pixels as part of a whole-image update, which is base64 text of 4 characters
+// per pixel; a run's setRGB/fillRegion command is roughly 60 characters long
+static const int FULL_UPDATE_PIXELS_PER_RUN = 16;
+
 int GBufferedImage::createRgbPixel(int red, int green, int blue) {
     if (red < 0 || red > 255 || green < 0 || green > 255 || blue < 0 || blue > 255) {
         error("RGB values must be between 0-255");
@@ -67,7 +90,9 @@ GBufferedImage::GBufferedImage()
         : GInteractor(),
           m_width(1),
           m_height(1),
-          m_backgroundColor(0) {
+          m_backgroundColor(0),
+          m_allDirty(false),
+          m_flushScheduled(false) {
     init(/* x */ 0, /* y */ 0, /* width */ 1, /* height */ 1, 0x000000);
 }
 
@@ -76,7 +101,9 @@ GBufferedImage::GBufferedImage(double width, double height,
     : GInteractor(),
       m_width(1),
       m_height(1),
-      m_backgroundColor(rgbBackground) {
+      m_backgroundColor(rgbBackground),
+      m_allDirty(false),
+      m_flushScheduled(false) {
     init(0, 0, width, height, rgbBackground);
 }
 
@@ -85,7 +112,9 @@ GBufferedImage::GBufferedImage(double x, double y, double width, double height,
     : GInteractor(),
       m_width(width),
       m_height(height),
-      m_backgroundColor(rgbBackground) {
+      m_backgroundColor(rgbBackground),
+      m_allDirty(false),
+      m_flushScheduled(false) {
     init(x, y, width, height, rgbBackground);
 }
 
@@ -94,10 +123,44 @@ GBufferedImage::GBufferedImage(double x, double y, double width, double height,
     : GInteractor(),
       m_width(width),
       m_height(height),
-      m_backgroundColor(0) {
+      m_backgroundColor(0),
+      m_allDirty(false),
+      m_flushScheduled(false) {
     init(x, y, width, height, convertColorToRGB(rgbBackground));
 }
 
+GBufferedImage::GBufferedImage(const GBufferedImage& other)
+    : GInteractor(other),
+      m_width(other.m_width),
+      m_height(other.m_height),
+      m_backgroundColor(other.m_backgroundColor),
+      m_pixels(other.m_pixels),
+      m_dirtyPixels(other.m_dirtyPixels),
+      m_allDirty(other.m_allDirty),
+      m_flushScheduled(false) {
+    scheduleFlush();
+}
+
+GBufferedImage& GBufferedImage::operator =(const GBufferedImage& other) {
+    if (this != &other) {
+        GInteractor::operator =(other);
+        m_width = other.m_width;
+        m_height = other.m_height;
+        m_backgroundColor = other.m_backgroundColor;
+        m_pixels = other.m_pixels;
+        m_dirtyPixels = other.m_dirtyPixels;
+        m_allDirty = other.m_allDirty;
+        scheduleFlush();   // keeps this image's own m_flushScheduled
+    }
+    return *this;
+}
+
+GBufferedImage::~GBufferedImage() {
+    if (m_flushScheduled) {
+        getPlatform()->gbufferedimage_cancelUpdate(this);
+    }
+}
+
 GRectangle GBufferedImage::getBounds() const {
     return GRectangle(x, y, m_width, m_height);
 }
@@ -129,7 +192,7 @@ int GBufferedImage::countDiffPixels(GBufferedImage& image) const {
     for (int y = 0; y < hmin; y++) {
         for (int x = 0; x < wmin; x++) {
             int px1 = m_pixels[y][x];
-            int px2 = image.m_pixels[y][x];
+            int px2 = image.constPixels()[y][x];
             if (px1 != px2) {
                 diffPxCount++;
             }
@@ -160,20 +223,22 @@ GBufferedImage* GBufferedImage::diff(GBufferedImage& image, int diffPixelColor)
     for (int y = 0; y < hmin; y++) {
         for (int x = 0; x < wmin; x++) {
             int px1 = m_pixels[y][x];
-            int px2 = image.m_pixels[y][x];
+            int px2 = image.constPixels()[y][x];
             if (px1 != px2) {
                 resultGrid[y][x] = diffPixelColor;
             }
         }
     }
     GBufferedImage* result = new GBufferedImage(wmax, hmax);
-    result->fromGrid(resultGrid);
+    result->fromGrid(std::move(resultGrid));
     return result;
 }
 
 void GBufferedImage::fill(int rgb) {
     checkColor("fill", rgb);
     m_pixels.fill(rgb);
+    m_dirtyPixels.clear();   // every pending change is overwritten anyway
+    m_allDirty = false;
     getPlatform()->gbufferedimage_fill(this, rgb);
 }
 
@@ -185,9 +250,13 @@ void GBufferedImage::fillRegion(double x, double y, double width, double height,
     checkIndex("fillRegion", x, y);
     checkIndex("fillRegion", x + width - 1, y + height - 1);
     checkColor("fillRegion", rgb);
-    for (int r = (int) y; r < y + height; r++) {
-        for (int c = (int) x; c < x + width; c++) {
-            m_pixels[r][c] = rgb;
+    int row = (int) y;
+    int col = (int) x;
+    int rows = std::max(0, (int) std::ceil(y + height) - row);
+    int cols = std::max(0, (int) std::ceil(x + width) - col);
+    for (int r = row; r < row + rows; r++) {
+        for (int c = col; c < col + cols; c++) {
+            m_pixels.set(r, c, rgb);
         }
     }
     getPlatform()->gbufferedimage_fillRegion(this, x, y, width, height, rgb);
@@ -198,34 +267,98 @@ void GBufferedImage::fillRegion(double x, double y, double width, double height,
 }
 
 void GBufferedImage::fromGrid(const Grid<int>& grid) {
-    checkSize("fromGrid", grid.width(), grid.height());
+    markChangedPixels(grid);
     m_pixels = grid;
-    m_width = grid.width();
-    m_height = grid.height();
-    
-    // output a base64-encoded version of the image pixels
-    std::ostringstream out;
+    flush();
+}
+
+void GBufferedImage::fromGrid(Grid<int>&& grid) {
+    markChangedPixels(grid);
+    m_pixels = std::move(grid);
+    flush();
+}
+
+void GBufferedImage::flush() {
+    if (m_flushScheduled) {
+        getPlatform()->gbufferedimage_cancelUpdate(this);
+        m_flushScheduled = false;
+    }
+    if (m_allDirty) {
+        m_allDirty = false;
+        m_dirtyPixels.clear();
+        sendAllPixels();
+        return;
+    }
+    if (m_dirtyPixels.empty()) {
+        return;
+    }
+
+    // merge the changed pixels into horizontal runs of one color, as
+    // (x, y, length, rgb) quadruples
+    std::sort(m_dirtyPixels.begin(), m_dirtyPixels.end());
+    m_dirtyPixels.erase(std::unique(m_dirtyPixels.begin(), m_dirtyPixels.end()),
+                        m_dirtyPixels.end());
+    int w = (int) m_width;
+    const int* pixels = &*constPixels().begin();
+    std::vector<int> runs;
+    size_t count = m_dirtyPixels.size();
+    for (size_t i = 0; i < count; ) {
+        int start = m_dirtyPixels[i];
+        int rgb = pixels[start];
+        int length = 1;
+        while (i + length < count && m_dirtyPixels[i + length] == start + length
+               && (start + length) % w != 0 && pixels[start + length] == rgb) {
+            length++;
+        }
+        runs.push_back(start % w);
+        runs.push_back(start / w);
+        runs.push_back(length);
+        runs.push_back(rgb);
+        i += length;
+    }
+    m_dirtyPixels.clear();
+
+    if ((int) (runs.size() / 4) * FULL_UPDATE_PIXELS_PER_RUN >= w * (int) m_height) {
+        sendAllPixels();
+    } else {
+        getPlatform()->gbufferedimage_updatePixels(this, runs);
+    }
+}
+
+void GBufferedImage::sendAllPixels() {
+    // output a base64-encoded version of the image pixels, encoding them a
+    // chunk at a time so the raw bytes are never built up in full
+    int w = (int) m_width;
+    int h = (int) m_height;
+    std::string encoded(Base64::encodedLength(4 + 3 * w * h), '\0');
+    char* dst = &encoded[0];
+    Base64::Encoder encoder;
+    char chunk[3 * 1024];
+    char* out = chunk;
     
     // output width as 2 bytes, then height as 2 bytes
-    out << (char) (((((int) m_width) & 0x0000ff00) >> 8) & 0x000000ff);
-    out << (char)  ((((int) m_width) & 0x000000ff));
-    out << (char) (((((int) m_height) & 0x0000ff00) >> 8) & 0x000000ff);
-    out << (char)  ((((int) m_height) & 0x000000ff));
+    *out++ = (char) ((w >> 8) & 0xff);
+    *out++ = (char)  (w & 0xff);
+    *out++ = (char) ((h >> 8) & 0xff);
+    *out++ = (char)  (h & 0xff);
     
-    // output each pixel as 3 bytes (R,G,B)
-    for (int row = 0; row < m_height; row++) {
-        for (int col = 0; col < m_width; col++) {
-            int rgb = grid[row][col];
-            out << (char) (((rgb & 0x00ff0000) >> 16) & 0x000000ff);
-            out << (char) (((rgb & 0x0000ff00) >> 8) & 0x000000ff);
-            out << (char)   (rgb & 0x000000ff);
+    // output each pixel as 3 bytes (R,G,B), reading the grid's row-major
+    // storage directly rather than through bounds-checked indexing
+    if (w > 0 && h > 0) {
+        const int* pixels = &*constPixels().begin();
+        for (int i = 0; i < w * h; i++) {
+            if (out + 3 > chunk + sizeof(chunk)) {
+                dst += encoder.encode(chunk, out - chunk, dst);
+                out = chunk;
+            }
+            int rgb = pixels[i];
+            *out++ = (char) ((rgb >> 16) & 0xff);
+            *out++ = (char) ((rgb >> 8) & 0xff);
+            *out++ = (char)  (rgb & 0xff);
         }
     }
-
-    // encode the bytes into a base64 string so it can go through
-    // the process pipe to the Java back-end
-    std::string result = out.str();
-    std::string encoded = Base64::encode(result);
+    dst += encoder.encode(chunk, out - chunk, dst);
+    encoder.finish(dst);
     
     // update the back-end with all of the pretty new pixels
     getPlatform()->gbufferedimage_updateAllPixels(this, encoded);
@@ -258,8 +391,26 @@ void GBufferedImage::load(const std::string& filename) {
     if (!fileExists(filename)) {
         error("GBufferedImage::load: file not found: " + filename);
     }
-    
-    // read Base64-compressed pixel data from Java back-end
+    // decode the file in C++ if we can; the pixels then go to the back-end
+    // with the next batched flush rather than in a blocking round trip
+    Grid<int> pixels;
+    if (imagecodec::readImage(filename, pixels)) {
+        if (m_width == 0 || m_height == 0) {
+            // an empty image has no back-end counterpart to update yet
+            resize(pixels.width(), pixels.height(), /* retain */ false);
+        }
+        m_width = pixels.width();
+        m_height = pixels.height();
+        m_pixels = std::move(pixels);
+        m_dirtyPixels.clear();   // every pending change is overwritten anyway
+        m_allDirty = true;
+        scheduleFlush();
+        return;
+    }
+
+    flush();   // pending changes refer to the current size
+
+    // otherwise read Base64-compressed pixel data from Java back-end
     std::string result = getPlatform()->gbufferedimage_load(this, filename);
     std::string decoded = Base64::decode(result);
     
@@ -287,11 +438,11 @@ void GBufferedImage::load(const std::string& filename) {
     for (int y = 0; y < m_height; y++) {
         for (int x = 0; x < m_width; x++) {
             if (i + 2 < actualLength) {
-                m_pixels[y][x] = 
+                m_pixels.set(y, x,
                          ((((decoded[i]   & 0x000000ff) << 16) & 0x00ff0000)   // red
                         | (((decoded[i+1] & 0x000000ff) <<  8) & 0x0000ff00)   // green
                         | (decoded[i+2]   & 0x000000ff))                       // blue
-                        & 0x00ffffff;                                          // alpha mask
+                        & 0x00ffffff);                                         // alpha mask
                 i += 3;
             }
         }
@@ -300,6 +451,7 @@ void GBufferedImage::load(const std::string& filename) {
 
 void GBufferedImage::resize(double width, double height, bool retain) {
     checkSize("resize", width, height);
+    flush();   // pending changes refer to the old size
     bool wasZero = (this->m_width == 0 && this->m_height == 0);
     this->m_width = width;
     this->m_height = height;
@@ -318,14 +470,18 @@ void GBufferedImage::resize(double width, double height, bool retain) {
 }
 
 void GBufferedImage::save(const std::string& filename) const {
+    // our own copy of the pixels is always current, so encode it directly
+    if (m_width > 0 && m_height > 0 && imagecodec::writeImage(filename, m_pixels)) {
+        return;
+    }
     getPlatform()->gbufferedimage_save(this, filename);
 }
 
 void GBufferedImage::setRGB(double x, double y, int rgb) {
     checkIndex("setRGB", x, y);
     checkColor("setRGB", rgb);
-    m_pixels[(int) y][(int) x] = rgb;
-    getPlatform()->gbufferedimage_setRGB(this, x, y, rgb);
+    m_pixels.set((int) y, (int) x, rgb);
+    markDirty((int) y * (int) m_width + (int) x);
 }
 
 void GBufferedImage::setRGB(double x, double y, std::string rgb) {
@@ -341,6 +497,47 @@ void GBufferedImage::toGrid(Grid<int>& grid) const {
 }
 
 
+void GBufferedImage::markDirty(int index) {
+    if (!m_allDirty) {
+        m_dirtyPixels.push_back(index);
+        // past this many runs a whole-image update is cheaper, so stop
+        // tracking individual pixels
+        if ((int) m_dirtyPixels.size() * FULL_UPDATE_PIXELS_PER_RUN
+                >= (int) m_width * (int) m_height) {
+            m_allDirty = true;
+            std::vector<int>().swap(m_dirtyPixels);
+        }
+    }
+    scheduleFlush();
+}
+
+void GBufferedImage::scheduleFlush() {
+    if (!m_flushScheduled && (m_allDirty || !m_dirtyPixels.empty())) {
+        getPlatform()->gbufferedimage_deferUpdate(this);
+        m_flushScheduled = true;
+    }
+}
+
+void GBufferedImage::markChangedPixels(const Grid<int>& grid) {
+    checkSize("fromGrid", grid.width(), grid.height());
+    if (grid.width() != m_width || grid.height() != m_height || grid.isEmpty()) {
+        m_width = grid.width();
+        m_height = grid.height();
+        m_dirtyPixels.clear();
+        m_allDirty = true;
+    } else {
+        // only the pixels that differ from what is displayed need to be sent
+        const int* oldPixels = &*constPixels().begin();
+        const int* newPixels = &*grid.begin();
+        int count = grid.width() * grid.height();
+        for (int i = 0; i < count && !m_allDirty; i++) {
+            if (oldPixels[i] != newPixels[i]) {
+                markDirty(i);
+            }
+        }
+    }
+}
+
 void GBufferedImage::checkColor(std::string member, int rgb) const {
     if (rgb < 0x0 || rgb > 0xffffff) {
         error("GBufferedImage::" + member
@@ -4,6 +4,14 @@
  * This file exports the GBufferedImage class for per-pixel graphics.
  *
  * @author Marty Stepp
+ * @version 2026/10/18
+ * - load and save handle PNG, JPEG, GIF, and PPM files natively in C++
+ * - setRGB and fromGrid send only changed pixels to the back-end, in batches;
+ *   added flush method
+ * - added fromGrid overload that takes over a temporary grid's pixels
+ * - toGrid and fromGrid share the pixel grid instead of copying it; see grid.h
+ * - added a copy constructor and assignment operator that schedule the
+ *   copy's own pending pixel changes
  * @version 2015/10/08
  * - bug fixes and refactoring for pixel-based functions such as fromGrid, load
  *   to help fix bugs with Base64 encoding/decoding
@@ -22,6 +30,7 @@
 #ifndef _gbufferedimage_h
 #define _gbufferedimage_h
 
+#include <vector>
 #include "grid.h"
 #include "ginteractors.h"
 #include "gobjects.h"
@@ -130,6 +139,19 @@ public:
                    int rgbBackground = 0x000000);
     GBufferedImage(double x, double y, double width, double height,
                    std::string rgbBackground);
+
+    /*
+     * Copies an image, including any pixel changes not yet sent.  The copy
+     * arranges for its own changes to be sent rather than relying on the
+     * original's.
+     */
+    GBufferedImage(const GBufferedImage& other);
+    GBufferedImage& operator =(const GBufferedImage& other);
+
+    /*
+     * Frees the image, discarding any pixel changes not yet sent.
+     */
+    virtual ~GBufferedImage();
     
     /* Prototypes for the virtual methods */
     virtual GRectangle getBounds() const;
@@ -177,14 +199,28 @@ public:
     void fillRegion(double x, double y, double width, double height, int rgb);
     void fillRegion(double x, double y, double width, double height,
                     std::string rgb);
+
+    /*
+     * Sends any pixel changes made by setRGB that have not yet been shown
+     * to the graphical back-end.
+     * This happens automatically before the next command of any kind goes
+     * to the back-end (such as a pause or a mouse click wait), so you only
+     * need to call it to show changes in the middle of a long computation.
+     */
+    void flush();
     
     /*
      * Replaces the entire contents of this image with the contents of the
      * given grid of RGB pixel values.
      * If this image is not the same size as the grid, the image is resized.
      * Any existing contents of the image are lost.
+     * If the size is unchanged, only the pixels that differ from the current
+     * contents are sent to the graphical back-end.
+     * A grid passed as a temporary, such as the result of a filter, is
+     * moved into the image instead of copied.
      */
     void fromGrid(const Grid<int>& grid);
+    void fromGrid(Grid<int>&& grid);
 
     /*
      * Returns the height of the image in pixels.
@@ -221,6 +257,8 @@ public:
     
     /*
      * Reads the image's contents from the given image file.
+     * PNG, JPEG, GIF, and PBM/PGM/PPM files are decoded directly in C++;
+     * other formats are passed to the Java back-end.
      * Throws an error if the given file is not a valid image file.
      */
     void load(const std::string& filename);
@@ -239,6 +277,8 @@ public:
     
     /*
      * Saves the image's contents to the given image file.
+     * The format is chosen by the file's extension; PNG, JPEG, GIF, and PPM
+     * files are encoded directly in C++, others by the Java back-end.
      * Throws an error if the given file is not writeable.
      */
     void save(const std::string& filename) const;
@@ -246,10 +286,11 @@ public:
     /*
      * Sets the color of the pixel at the given x/y coordinates of the image
      * to the given value.
-     * Implementation/performance note: Each call to this method produces a
-     * call to the Java graphical back-end.  Calling this method many times
-     * in a tight loop can lead to poor performance.  If you need to fill a
-     * large rectangular region, consider calling fill or fillRegion instead.
+     * Implementation/performance note: Changed pixels are collected and sent
+     * to the Java graphical back-end together, as runs of equal colors, the
+     * next time anything else is sent (or when flush is called).  Once so
+     * many pixels have changed that this would be slower than resending the
+     * whole image, the whole image is resent instead.
      * Throws an error if the given x/y values are out of bounds.
      * Throws an error if the given rgb value is not a valid color.
      */
@@ -262,6 +303,8 @@ public:
      * is the column or x-index.
      * So for example, grid[y][x] returns the RGB int value at that pixel.
      * The grid can either be returned or filled by reference.
+     * The grid shares the image's pixels until either one is changed, so
+     * this takes constant time.
      */
     Grid<int> toGrid() const;
     void toGrid(Grid<int>& grid) const;
@@ -271,6 +314,9 @@ private:
     double m_height;
     int m_backgroundColor;
     Grid<int> m_pixels;      // row-major; [y][x]
+    std::vector<int> m_dirtyPixels;   // y * width + x of each change not yet sent
+    bool m_allDirty;         // true if the whole image needs to be resent
+    bool m_flushScheduled;   // true if the platform will call flush for us
 
     /*
      * Throws an error if the given rgb value is not a valid color.
@@ -287,6 +333,39 @@ private:
      */
     void checkSize(std::string member, double width, double height) const;
 
+    /*
+     * Records that the pixel at the given index has changed and arranges
+     * for it to be sent to the back-end.
+     */
+    void markDirty(int index);
+
+    /*
+     * Asks the platform to call flush for this image if it has pixel
+     * changes that are not yet sent and has not asked already.
+     */
+    void scheduleFlush();
+
+    /*
+     * Marks the pixels that fromGrid is about to replace with the given
+     * grid's as changed, resizing the image if the grid's size differs.
+     */
+    void markChangedPixels(const Grid<int>& grid);
+
+    /*
+     * Sends every pixel of the image to the back-end.
+     */
+    void sendAllPixels();
+
+    /*
+     * Returns the pixel grid for reading.  Reading through a const grid
+     * leaves it shared with any copies made by toGrid or fromGrid, where
+     * non-const [][] access would first give the image its own copy and
+     * make every later copy a full one.
+     */
+    const Grid<int>& constPixels() const {
+        return m_pixels;
+    }
+
     /*
      * Initializes private member variables; called by all constructors.
      */
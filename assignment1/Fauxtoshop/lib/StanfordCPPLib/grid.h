@@ -4,6 +4,18 @@
  * This file exports the <code>Grid</code> class, which offers a
  * convenient abstraction for representing a two-dimensional array.
  *
+ * @version 2026/10/18
+ * - added move constructor and assignment, and a set overload that moves
+ *   its value
+ * - copy, fill, equals and resize work on the whole array at once, which
+ *   for simple types such as int compiles down to memmove/memset
+ * - fixed resize(true) retaining the wrong elements of a non-square grid
+ * - copies of a grid share their elements until one of them is modified;
+ *   a grid that has handed out a reference to an element is copied eagerly
+ * - begin and end on a const grid return a const_iterator
+ * - added a Layout template parameter: RowMajorLayout (the default),
+ *   PaddedRowLayout or TiledLayout; every grid's array is 64-byte aligned
+ * - mapAll and mapAllColumnMajor no longer check the bounds of each element
  * @version 2015/07/05
  * - using global hashing functions rather than global variables
  * @version 2014/11/20
@@ -25,15 +37,115 @@
 #ifndef _grid_h
 #define _grid_h
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <new>
 #include <string>
 #include <sstream>
+#include <type_traits>
+#include <utility>
 #include "error.h"
 #include "hashcode.h"
 #include "random.h"
 #include "strlib.h"
 #include "vector.h"
 
+/*
+ * Constant: GRID_ALIGNMENT
+ * ------------------------
+ * The array of every grid starts at an address that is a multiple of this
+ * many bytes, the size of a cache line and of the widest vector loads.
+ */
+const int GRID_ALIGNMENT = 64;
+
+/* Forward reference */
+template <typename ValueType>
+class GridView;
+
+/*
+ * Grid layouts
+ * ------------
+ * The optional second template parameter of Grid chooses where each
+ * element is stored in the grid's array:
+ *
+ *   - RowMajorLayout, the default, stores the rows one after another with
+ *     nothing between them, so element (row, col) is at
+ *     row * numCols() + col.  Code that walks the array of a Grid with a
+ *     pointer relies on this layout.
+ *
+ *   - PaddedRowLayout also stores each row contiguously, but pads it so
+ *     that every row, not only the first, starts on a GRID_ALIGNMENT
+ *     boundary, for vector code that works a row at a time.
+ *
+ *   - TiledLayout stores the grid as square tiles of TILE_SIZE x TILE_SIZE
+ *     elements, each tile contiguous and the tiles in row-major order, so
+ *     that a walk down a column touches one cache line per TILE_SIZE rows
+ *     instead of one per row.  This suits grids that are traversed by
+ *     columns as much as by rows, such as with mapAllColumnMajor.
+ *
+ * Each layout describes itself with a row step, computed from the number
+ * of columns when the grid is sized, from which the array's capacity and
+ * each element's offset follow.  The [][] operator, get, set, iteration
+ * and all other Grid operations work the same for every layout.
+ */
+struct RowMajorLayout {
+    static const bool CONTIGUOUS_ROWS = true;
+
+    static int rowStep(int nCols, int /* elementSize */) {
+        return nCols;
+    }
+
+    static int capacity(int nRows, int rowStep) {
+        return nRows * rowStep;
+    }
+
+    static int offset(int row, int col, int rowStep) {
+        return row * rowStep + col;
+    }
+};
+
+struct PaddedRowLayout {
+    static const bool CONTIGUOUS_ROWS = true;
+
+    static int rowStep(int nCols, int elementSize) {
+        if (GRID_ALIGNMENT % elementSize != 0) {
+            return nCols;   // no whole number of elements fills a line
+        }
+        int perLine = GRID_ALIGNMENT / elementSize;
+        return (nCols + perLine - 1) / perLine * perLine;
+    }
+
+    static int capacity(int nRows, int rowStep) {
+        return nRows * rowStep;
+    }
+
+    static int offset(int row, int col, int rowStep) {
+        return row * rowStep + col;
+    }
+};
+
+struct TiledLayout {
+    static const bool CONTIGUOUS_ROWS = false;
+    static const int TILE_SIZE = 8;
+
+    /* the row step is the number of tiles across the grid */
+    static int rowStep(int nCols, int /* elementSize */) {
+        return (nCols + TILE_SIZE - 1) / TILE_SIZE;
+    }
+
+    static int capacity(int nRows, int rowStep) {
+        return (nRows + TILE_SIZE - 1) / TILE_SIZE * rowStep * TILE_SIZE * TILE_SIZE;
+    }
+
+    static int offset(int row, int col, int rowStep) {
+        int tile = row / TILE_SIZE * rowStep + col / TILE_SIZE;
+        return (tile * TILE_SIZE + row % TILE_SIZE) * TILE_SIZE + col % TILE_SIZE;
+    }
+};
+
 /*
  * Class: Grid<ValueType>
  * ----------------------
@@ -50,9 +162,13 @@
  *       return matrix;
  *    }
  *</pre>
+ *
+ * A second template argument chooses how the elements are laid out in
+ * memory, as in <code>Grid&lt;double, TiledLayout&gt;</code>; see the
+ * layouts above.
  */
 
-template <typename ValueType>
+template <typename ValueType, typename Layout = RowMajorLayout>
 class Grid {
 public:
     /* Forward reference */
@@ -77,6 +193,16 @@ public:
     Grid(int nRows, int nCols);
     Grid(int nRows, int nCols, const ValueType& value);
 
+    /*
+     * Constructor: Grid
+     * Usage: Grid<ValueType, TiledLayout> tiled(grid);
+     * ------------------------------------------------
+     * Initializes a new grid with the size and elements of a grid that
+     * has a different layout.
+     */
+    template <typename OtherLayout>
+    explicit Grid(const Grid<ValueType, OtherLayout>& src);
+
     /*
      * Destructor: ~Grid
      * -----------------
@@ -92,7 +218,7 @@ public:
      * values as the given other grid.
      * Identical in behavior to the == operator.
      */
-    bool equals(const Grid<ValueType>& grid2) const;
+    bool equals(const Grid& grid2) const;
     
     /*
      * Method: fill
@@ -209,6 +335,7 @@ public:
      * the grid boundaries.
      */
     void set(int row, int col, const ValueType& value);
+    void set(int row, int col, ValueType&& value);
     
     /*
      * Method: toString
@@ -265,7 +392,8 @@ public:
      * class supports the following operations:
      *
      *   - Stream I/O using the << and >> operators
-     *   - Deep copying for the copy constructor and assignment operator
+     *   - Copying for the copy constructor and assignment operator, which
+     *     is deferred until one of the copies is modified
      *   - Iteration using the range-based for statement and STL iterators
      *
      * The iteration forms process the grid in row-major order.
@@ -312,16 +440,57 @@ public:
      * -----------------------------------------
      * The Grid is internally managed as a dynamic array of elements.
      * The array itself is one-dimensional, the logical separation into
-     * rows and columns is done by arithmetic computation.  The layout
-     * is in row-major order, which is to say that the entire first row
-     * is laid out contiguously, followed by the entire second row,
-     * and so on.
+     * rows and columns is done by arithmetic computation.  The default
+     * layout is in row-major order, which is to say that the entire first
+     * row is laid out contiguously, followed by the entire second row,
+     * and so on; the Layout parameter can pad the rows or store the array
+     * in tiles instead, and every element access goes through its offset
+     * function.  Slots that padding adds to the array hold default values
+     * and are never seen by clients.
+     *
+     * The array is allocated together with a small header holding the
+     * count described below, in one block of raw memory, and starts at
+     * the first GRID_ALIGNMENT boundary after the header.
+     *
+     * Copies of a grid share the same array, along with a count of how
+     * many grids are sharing it, until one of them is about to change an
+     * element.  At that point set, fill and resize give that grid its own
+     * array.  Copying a grid therefore takes constant time.  A grid taken
+     * from a GBufferedImage uses no memory of its own until one of the
+     * two is changed.  The count is atomic, so copies may be made and
+     * destroyed on different threads.
+     *
+     * The [][] operator, the iterators and the views of a non-const grid
+     * hand out references through which an element can change later, so
+     * they also mark the array as UNSHAREABLE, in the count's place.
+     * Copies of a grid in that state get their own array at once, which
+     * keeps every reference tied to a single grid.  The mark stays until
+     * the array is replaced by resize or an assignment.  Reading through
+     * get or a const reference to the grid never copies or marks it.
+     * Other threads may read a grid that shares its array, but not while
+     * its first [][] access or iterator copies the array.
      */
 
+    /*
+     * The header at the start of the block that holds an array.
+     */
+    struct ArrayHeader {
+        std::atomic<int> refCount;   /* The number of grids sharing the array,
+                                        or UNSHAREABLE                      */
+        int capacity;                /* The number of elements in the array   */
+    };
+
+    /*
+     * The count of an array that only its own grid may use.
+     */
+    static const int UNSHAREABLE = -1;
+
     /* Instance variables */
-    ValueType* elements;  /* A dynamic array of the elements   */
-    int nRows;            /* The number of rows in the grid    */
-    int nCols;            /* The number of columns in the grid */
+    ValueType* elements;     /* A dynamic array of the elements               */
+    ArrayHeader* header;     /* The header of the block holding 'elements'    */
+    int nRows;               /* The number of rows in the grid                */
+    int nCols;               /* The number of columns in the grid             */
+    int rowStep;             /* The layout's row step for this number of cols */
 
     /* Private method prototypes */
 
@@ -338,49 +507,150 @@ public:
                       std::string prefix) const;
     int gridCompare(const Grid& grid2) const;
 
+    /*
+     * Returns the offset in the array of element (row, col), or of the
+     * element at the given position in row-major order.
+     */
+    int offset(int row, int col) const {
+        return Layout::offset(row, col, rowStep);
+    }
+
+    int offset(int index) const {
+        if (std::is_same<Layout, RowMajorLayout>::value
+                || (Layout::CONTIGUOUS_ROWS && rowStep == nCols)) {
+            return index;
+        }
+        return Layout::offset(index / nCols, index % nCols, rowStep);
+    }
+
+    /*
+     * Gives this grid a new, unshared array sized for its current
+     * dimensions, in which every element is a copy of 'value' or, in the
+     * second form, of the element at the same offset in 'src', an array
+     * of the same size.  The old array must already have been released.
+     */
+    void allocate(const ValueType& value);
+    void allocate(const ValueType* src);
+
+    /*
+     * Gets a block of memory for an array of n elements with its header,
+     * and frees one.
+     */
+    static ArrayHeader* allocateBlock(int n);
+    static void freeBlock(ArrayHeader* header);
+    static ValueType* elementsOf(ArrayHeader* header);
+
+    /*
+     * Drops this grid's reference to its array, freeing the array if no
+     * other grid shares it, and leaves the grid without an array.
+     */
+    void release();
+
+    /*
+     * Returns true if other grids share this grid's array.
+     */
+    bool isShared() const;
+
+    /*
+     * Adds a grid to those sharing the array with the given header,
+     * returning false if the array is UNSHAREABLE.
+     */
+    static bool share(ArrayHeader* header);
+
+    /*
+     * Gives this grid its own copy of its array if other grids share it,
+     * which must be done before any element is changed.
+     */
+    void detach();
+
+    /*
+     * Detaches this grid and marks its array UNSHAREABLE, which must be
+     * done before a reference to an element is handed out.
+     */
+    void unshare();
+
+    template <typename OtherValueType, typename OtherLayout>
+    friend class Grid;
+
+    template <typename ViewValueType>
+    friend class GridView;
+
     /*
      * Hidden features
      * ---------------
      * The remainder of this file consists of the code required to
-     * support deep copying and iteration.  Including these methods
+     * support copying and iteration.  Including these methods
      * in the public interface would make that interface more
      * difficult to understand for the average client.
      */
 
+public:
     /*
-     * Deep copying support
-     * --------------------
-     * This copy constructor and operator= are defined to make a
-     * deep copy, making it possible to pass/return grids by value
-     * and assign from one grid to another.  The entire contents of
-     * the grid, including all elements, are copied.  Each grid
-     * element is copied from the original grid to the copy using
-     * assignment (operator=).  Making copies is generally avoided
-     * because of the expense and thus, grids are typically passed
-     * by reference, however, when a copy is needed, these operations
-     * are supported.
+     * Copying support
+     * ---------------
+     * This copy constructor and operator= make it possible to pass/return
+     * grids by value and assign from one grid to another.  The copy
+     * behaves as an independent grid, but it shares the original's array
+     * of elements until one of the two is modified, at which point the
+     * modified grid copies the elements into an array of its own (see
+     * the implementation notes on the Grid data structure above).
      */
-    void deepCopy(const Grid& grid) {
-        int n = grid.nRows * grid.nCols;
-        elements = new ValueType[n];
-        for (int i = 0; i < n; i++) {
-            elements[i] = grid.elements[i];
-        }
-        nRows = grid.nRows;
-        nCols = grid.nCols;
-    }
-
-public:
     Grid& operator =(const Grid& src) {
         if (this != &src) {
-            delete[] elements;
-            deepCopy(src);
+            Grid copy(src);
+            *this = std::move(copy);
         }
         return *this;
     }
 
-    Grid(const Grid& src) {
-        deepCopy(src);
+    Grid(const Grid& src)
+            : elements(NULL),
+              header(NULL),
+              nRows(src.nRows),
+              nCols(src.nCols),
+              rowStep(src.rowStep) {
+        if (src.header == NULL) {
+            // empty grid; nothing to share
+        } else if (share(src.header)) {
+            elements = src.elements;
+            header = src.header;
+        } else {
+            allocate(src.elements);
+        }
+    }
+
+    /*
+     * Move support
+     * ------------
+     * The move constructor and move assignment operator take over the
+     * source grid's array instead of copying it, leaving the source an
+     * empty 0x0 grid, so that a grid returned by value from a function
+     * such as a filter is never copied.
+     */
+    Grid(Grid&& src) noexcept
+            : elements(src.elements),
+              header(src.header),
+              nRows(src.nRows),
+              nCols(src.nCols),
+              rowStep(src.rowStep) {
+        src.elements = NULL;
+        src.header = NULL;
+        src.nRows = src.nCols = src.rowStep = 0;
+    }
+
+    Grid& operator =(Grid&& src) noexcept {
+        if (this != &src) {
+            release();
+            elements = src.elements;
+            header = src.header;
+            nRows = src.nRows;
+            nCols = src.nCols;
+            rowStep = src.rowStep;
+            src.elements = NULL;
+            src.header = NULL;
+            src.nRows = src.nCols = src.rowStep = 0;
+        }
+        return *this;
     }
 
     /*
@@ -388,11 +658,15 @@ public:
      * ----------------
      * The classes in the StanfordCPPLib collection implement input
      * iterators so that they work symmetrically with respect to the
-     * corresponding STL classes.
+     * corresponding STL classes.  Since an iterator can be used to change
+     * elements, begin and end on a non-const grid give the grid its own
+     * array first and mark it UNSHAREABLE; a const grid hands out a
+     * const_iterator instead, so iterate over a const reference to a
+     * shared grid to read it without copying.
      */
     class iterator : public std::iterator<std::input_iterator_tag, ValueType> {
     public:
-        iterator(const Grid* gp, int index) {
+        iterator(Grid* gp, int index) {
             this->gp = gp;
             this->index = index;
         }
@@ -422,11 +696,55 @@ public:
         }
 
         ValueType& operator *() {
-            return gp->elements[index];
+            return gp->elements[gp->offset(index)];
         }
 
         ValueType* operator ->() {
-            return &gp->elements[index];
+            return &gp->elements[gp->offset(index)];
+        }
+
+    private:
+        Grid* gp;
+        int index;
+    };
+
+    class const_iterator : public std::iterator<std::input_iterator_tag, ValueType> {
+    public:
+        const_iterator(const Grid* gp, int index) {
+            this->gp = gp;
+            this->index = index;
+        }
+
+        const_iterator(const const_iterator& it) {
+            this->gp = it.gp;
+            this->index = it.index;
+        }
+
+        const_iterator& operator ++() {
+            index++;
+            return *this;
+        }
+
+        const_iterator operator ++(int) {
+            const_iterator copy(*this);
+            operator++();
+            return copy;
+        }
+
+        bool operator ==(const const_iterator& rhs) {
+            return gp == rhs.gp && index == rhs.index;
+        }
+
+        bool operator !=(const const_iterator& rhs) {
+            return !(*this == rhs);
+        }
+
+        const ValueType& operator *() {
+            return gp->elements[gp->offset(index)];
+        }
+
+        const ValueType* operator ->() {
+            return &gp->elements[gp->offset(index)];
         }
 
     private:
@@ -434,11 +752,21 @@ public:
         int index;
     };
 
-    iterator begin() const {
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, nRows * nCols);
+    }
+
+    iterator begin() {
+        unshare();
         return iterator(this, 0);
     }
 
-    iterator end() const {
+    iterator end() {
+        unshare();
         return iterator(this, nRows * nCols);
     }
 
@@ -456,12 +784,13 @@ public:
 
         ValueType& operator [](int col) {
             gp->checkIndexes(row, col, gp->nRows-1, gp->nCols-1, "operator [][]");
-            return gp->elements[(row * gp->nCols) + col];
+            gp->unshare();
+            return gp->elements[gp->offset(row, col)];
         }
 
         ValueType operator [](int col) const {
             gp->checkIndexes(row, col, gp->nRows-1, gp->nCols-1, "operator [][]");
-            return gp->elements[(row * gp->nCols) + col];
+            return gp->elements[gp->offset(row, col)];
         }
 
         int size() const {
@@ -488,7 +817,7 @@ public:
 
         const ValueType operator [](int col) const {
             gp->checkIndexes(row, col, gp->nRows-1, gp->nCols-1, "operator [][]");
-            return gp->elements[(row * gp->nCols) + col];
+            return gp->elements[gp->offset(row, col)];
         }
 
         int size() const {
@@ -505,41 +834,65 @@ public:
     friend class GridRowConst;
 };
 
-template <typename ValueType>
-Grid<ValueType>::Grid()
+template <typename ValueType, typename Layout>
+Grid<ValueType, Layout>::Grid()
         : elements(NULL),
+          header(NULL),
           nRows(0),
-          nCols(0) {
+          nCols(0),
+          rowStep(0) {
     // empty
 }
 
-template <typename ValueType>
-Grid<ValueType>::Grid(int nRows, int nCols)
+template <typename ValueType, typename Layout>
+Grid<ValueType, Layout>::Grid(int nRows, int nCols)
     : elements(NULL),
+      header(NULL),
       nRows(0),
-      nCols(0) {
+      nCols(0),
+      rowStep(0) {
     resize(nRows, nCols);
 }
 
-template <typename ValueType>
-Grid<ValueType>::Grid(int nRows, int nCols, const ValueType& value)
+template <typename ValueType, typename Layout>
+Grid<ValueType, Layout>::Grid(int nRows, int nCols, const ValueType& value)
     : elements(NULL),
+      header(NULL),
       nRows(0),
-      nCols(0) {
+      nCols(0),
+      rowStep(0) {
     resize(nRows, nCols);
     fill(value);
 }
 
-template <typename ValueType>
-Grid<ValueType>::~Grid() {
-    if (elements != NULL) {
-        delete[] elements;
-        elements = NULL;
+template <typename ValueType, typename Layout>
+template <typename OtherLayout>
+Grid<ValueType, Layout>::Grid(const Grid<ValueType, OtherLayout>& src)
+    : elements(NULL),
+      header(NULL),
+      nRows(0),
+      nCols(0),
+      rowStep(0) {
+    resize(src.nRows, src.nCols);
+    for (int row = 0; row < nRows; row++) {
+        if (Layout::CONTIGUOUS_ROWS && OtherLayout::CONTIGUOUS_ROWS) {
+            const ValueType* from = src.elements + src.offset(row, 0);
+            std::copy(from, from + nCols, elements + offset(row, 0));
+        } else {
+            for (int col = 0; col < nCols; col++) {
+                elements[offset(row, col)] = src.elements[src.offset(row, col)];
+            }
+        }
     }
 }
 
-template <typename ValueType>
-bool Grid<ValueType>::equals(const Grid<ValueType>& grid2) const {
+template <typename ValueType, typename Layout>
+Grid<ValueType, Layout>::~Grid() {
+    release();
+}
+
+template <typename ValueType, typename Layout>
+bool Grid<ValueType, Layout>::equals(const Grid& grid2) const {
     // optimization: if literally same grid, stop
     if (this == &grid2) {
         return true;
@@ -548,9 +901,17 @@ bool Grid<ValueType>::equals(const Grid<ValueType>& grid2) const {
     if (nRows != grid2.nRows || nCols != grid2.nCols) {
         return false;
     }
+    if (elements == grid2.elements) {
+        return true;   // copies that still share their elements
+    }
+    if (std::is_same<Layout, RowMajorLayout>::value
+            || (Layout::CONTIGUOUS_ROWS && rowStep == nCols)) {
+        return std::equal(elements, elements + nRows * nCols, grid2.elements);
+    }
+    // padding slots may differ, so only the elements themselves are compared
     for (int row = 0; row < nRows; row++) {
         for (int col = 0; col < nCols; col++) {
-            if (get(row, col) != grid2.get(row, col)) {
+            if (!(elements[offset(row, col)] == grid2.elements[offset(row, col)])) {
                 return false;
             }
         }
@@ -558,110 +919,112 @@ bool Grid<ValueType>::equals(const Grid<ValueType>& grid2) const {
     return true;
 }
 
-template <typename ValueType>
-void Grid<ValueType>::fill(const ValueType& value) {
-    for (int row = 0; row < nRows; row++) {
-        for (int col = 0; col < nCols; col++) {
-            set(row, col, value);
-        }
+template <typename ValueType, typename Layout>
+void Grid<ValueType, Layout>::fill(const ValueType& value) {
+    if (isShared()) {
+        // every element is replaced, so there is no need to copy them first
+        release();
+        allocate(value);
+    } else if (header != NULL) {
+        std::fill(elements, elements + header->capacity, value);
     }
 }
 
-template <typename ValueType>
-ValueType Grid<ValueType>::get(int row, int col) {
+template <typename ValueType, typename Layout>
+ValueType Grid<ValueType, Layout>::get(int row, int col) {
     checkIndexes(row, col, nRows-1, nCols-1, "get");
-    return elements[(row * nCols) + col];
+    return elements[offset(row, col)];
 }
 
-template <typename ValueType>
-const ValueType& Grid<ValueType>::get(int row, int col) const {
+template <typename ValueType, typename Layout>
+const ValueType& Grid<ValueType, Layout>::get(int row, int col) const {
     checkIndexes(row, col, nRows-1, nCols-1, "get");
-    return elements[(row * nCols) + col];
+    return elements[offset(row, col)];
 }
 
-template <typename ValueType>
-int Grid<ValueType>::height() const {
+template <typename ValueType, typename Layout>
+int Grid<ValueType, Layout>::height() const {
     return nRows;
 }
 
-template <typename ValueType>
-bool Grid<ValueType>::inBounds(int row, int col) const {
+template <typename ValueType, typename Layout>
+bool Grid<ValueType, Layout>::inBounds(int row, int col) const {
     return row >= 0 && col >= 0 && row < nRows && col < nCols;
 }
 
-template <typename ValueType>
-bool Grid<ValueType>::isEmpty() const {
+template <typename ValueType, typename Layout>
+bool Grid<ValueType, Layout>::isEmpty() const {
     return nRows == 0 || nCols == 0;
 }
 
-template <typename ValueType>
-void Grid<ValueType>::mapAll(void (*fn)(ValueType value)) const {
+template <typename ValueType, typename Layout>
+void Grid<ValueType, Layout>::mapAll(void (*fn)(ValueType value)) const {
     for (int i = 0; i < nRows; i++) {
         for (int j = 0; j < nCols; j++) {
-            fn(get(i, j));
+            fn(elements[offset(i, j)]);
         }
     }
 }
 
-template <typename ValueType>
-void Grid<ValueType>::mapAll(void (*fn)(const ValueType & value)) const {
+template <typename ValueType, typename Layout>
+void Grid<ValueType, Layout>::mapAll(void (*fn)(const ValueType & value)) const {
     for (int i = 0; i < nRows; i++) {
         for (int j = 0; j < nCols; j++) {
-            fn(get(i, j));
+            fn(elements[offset(i, j)]);
         }
     }
 }
 
-template <typename ValueType>
+template <typename ValueType, typename Layout>
 template <typename FunctorType>
-void Grid<ValueType>::mapAll(FunctorType fn) const {
+void Grid<ValueType, Layout>::mapAll(FunctorType fn) const {
     for (int i = 0; i < nRows; i++) {
         for (int j = 0; j < nCols; j++) {
-            fn(get(i, j));
+            fn(elements[offset(i, j)]);
         }
     }
 }
 
-template <typename ValueType>
-void Grid<ValueType>::mapAllColumnMajor(void (*fn)(ValueType value)) const {
+template <typename ValueType, typename Layout>
+void Grid<ValueType, Layout>::mapAllColumnMajor(void (*fn)(ValueType value)) const {
     for (int j = 0; j < nCols; j++) {
         for (int i = 0; i < nRows; i++) {
-            fn(get(i, j));
+            fn(elements[offset(i, j)]);
         }
     }
 }
 
-template <typename ValueType>
-void Grid<ValueType>::mapAllColumnMajor(void (*fn)(const ValueType& value)) const {
+template <typename ValueType, typename Layout>
+void Grid<ValueType, Layout>::mapAllColumnMajor(void (*fn)(const ValueType& value)) const {
     for (int j = 0; j < nCols; j++) {
         for (int i = 0; i < nRows; i++) {
-            fn(get(i, j));
+            fn(elements[offset(i, j)]);
         }
     }
 }
 
-template <typename ValueType>
+template <typename ValueType, typename Layout>
 template <typename FunctorType>
-void Grid<ValueType>::mapAllColumnMajor(FunctorType fn) const {
+void Grid<ValueType, Layout>::mapAllColumnMajor(FunctorType fn) const {
     for (int j = 0; j < nCols; j++) {
         for (int i = 0; i < nRows; i++) {
-            fn(get(i, j));
+            fn(elements[offset(i, j)]);
         }
     }
 }
 
-template <typename ValueType>
-int Grid<ValueType>::numCols() const {
+template <typename ValueType, typename Layout>
+int Grid<ValueType, Layout>::numCols() const {
     return nCols;
 }
 
-template <typename ValueType>
-int Grid<ValueType>::numRows() const {
+template <typename ValueType, typename Layout>
+int Grid<ValueType, Layout>::numRows() const {
     return nRows;
 }
 
-template <typename ValueType>
-void Grid<ValueType>::resize(int nRows, int nCols, bool retain) {
+template <typename ValueType, typename Layout>
+void Grid<ValueType, Layout>::resize(int nRows, int nCols, bool retain) {
     if (nRows < 0 || nCols < 0) {
         std::ostringstream out;
         out << "Grid::resize: Attempt to resize grid to invalid size ("
@@ -669,54 +1032,81 @@ void Grid<ValueType>::resize(int nRows, int nCols, bool retain) {
         error(out.str());
     }
     
-    // save backup of old array/size
-    ValueType* oldElements = this->elements;
-    int oldnRows = this->nRows;
-    int oldnCols = this->nCols;
+    // save backup of old array/size; the old array is kept alive by a
+    // temporary grid that shares it
+    Grid old;
+    std::swap(old.elements, this->elements);
+    std::swap(old.header, this->header);
+    old.nRows = this->nRows;
+    old.nCols = this->nCols;
+    old.rowStep = this->rowStep;
+    bool oldShared = old.isShared();
     
-    // create new empty array and set new size
+    // create new array of empty/default elements and set new size
     this->nRows = nRows;
     this->nCols = nCols;
-    this->elements = new ValueType[nRows * nCols];
-    
-    // initialize to empty/default state
-    ValueType value = ValueType();
-    for (int i = 0; i < nRows * nCols; i++) {
-        this->elements[i] = value;
-    }
+    this->rowStep = Layout::rowStep(nCols, sizeof(ValueType));
+    allocate(ValueType());
     
-    // possibly retain old contents
+    // possibly retain old contents, one row's overlap at a time; the old
+    // elements can be moved unless another grid still shares them
     if (retain) {
-        int minRows = oldnRows < nRows ? oldnRows : nRows;
-        int minCols = oldnCols < nCols ? oldnCols : nCols;
+        int minRows = old.nRows < nRows ? old.nRows : nRows;
+        int minCols = old.nCols < nCols ? old.nCols : nCols;
         for (int row = 0; row < minRows; row++) {
-            for (int col = 0; col < minCols; col++) {
-                this->elements[(row * nCols) + col] = oldElements[(row * oldnRows) + col];
+            if (Layout::CONTIGUOUS_ROWS) {
+                ValueType* oldRow = old.elements + old.offset(row, 0);
+                ValueType* newRow = this->elements + offset(row, 0);
+                if (oldShared) {
+                    std::copy(oldRow, oldRow + minCols, newRow);
+                } else {
+                    std::move(oldRow, oldRow + minCols, newRow);
+                }
+            } else {
+                for (int col = 0; col < minCols; col++) {
+                    ValueType& oldElement = old.elements[old.offset(row, col)];
+                    if (oldShared) {
+                        this->elements[offset(row, col)] = oldElement;
+                    } else {
+                        this->elements[offset(row, col)] = std::move(oldElement);
+                    }
+                }
             }
         }
     }
     
-    // free old array memory
-    if (oldElements != NULL) {
-        delete[] oldElements;
+    // the old array is released when 'old' goes out of scope
+}
+
+template <typename ValueType, typename Layout>
+void Grid<ValueType, Layout>::set(int row, int col, const ValueType& value) {
+    checkIndexes(row, col, nRows-1, nCols-1, "set");
+    if (isShared()) {
+        // value may be an element of the array about to be unshared
+        ValueType copy(value);
+        detach();
+        elements[offset(row, col)] = std::move(copy);
+    } else {
+        elements[offset(row, col)] = value;
     }
 }
 
-template <typename ValueType>
-void Grid<ValueType>::set(int row, int col, const ValueType& value) {
+template <typename ValueType, typename Layout>
+void Grid<ValueType, Layout>::set(int row, int col, ValueType&& value) {
     checkIndexes(row, col, nRows-1, nCols-1, "set");
-    elements[(row * nCols) + col] = value;
+    detach();
+    elements[offset(row, col)] = std::move(value);
 }
 
-template <typename ValueType>
-std::string Grid<ValueType>::toString() const {
+template <typename ValueType, typename Layout>
+std::string Grid<ValueType, Layout>::toString() const {
     std::ostringstream os;
     os << *this;
     return os.str();
 }
 
-template <typename ValueType>
-std::string Grid<ValueType>::toString2D(
+template <typename ValueType, typename Layout>
+std::string Grid<ValueType, Layout>::toString2D(
         std::string rowStart, std::string rowEnd,
         std::string colSeparator, std::string rowSeparator) const {
     std::ostringstream os;
@@ -740,54 +1130,54 @@ std::string Grid<ValueType>::toString2D(
     return os.str();
 }
 
-template <typename ValueType>
-int Grid<ValueType>::width() const {
+template <typename ValueType, typename Layout>
+int Grid<ValueType, Layout>::width() const {
     return nCols;
 }
 
-template <typename ValueType>
-typename Grid<ValueType>::GridRow Grid<ValueType>::operator [](int row) {
+template <typename ValueType, typename Layout>
+typename Grid<ValueType, Layout>::GridRow Grid<ValueType, Layout>::operator [](int row) {
     return GridRow(this, row);
 }
 
-template <typename ValueType>
-const typename Grid<ValueType>::GridRowConst
-Grid<ValueType>::operator [](int row) const {
+template <typename ValueType, typename Layout>
+const typename Grid<ValueType, Layout>::GridRowConst
+Grid<ValueType, Layout>::operator [](int row) const {
     return GridRowConst(const_cast<Grid*>(this), row);
 }
 
-template <typename ValueType>
-bool Grid<ValueType>::operator ==(const Grid& grid2) const {
+template <typename ValueType, typename Layout>
+bool Grid<ValueType, Layout>::operator ==(const Grid& grid2) const {
     return equals(grid2);
 }
 
-template <typename ValueType>
-bool Grid<ValueType>::operator !=(const Grid& grid2) const {
+template <typename ValueType, typename Layout>
+bool Grid<ValueType, Layout>::operator !=(const Grid& grid2) const {
     return !equals(grid2);
 }
 
-template <typename ValueType>
-bool Grid<ValueType>::operator <(const Grid& grid2) const {
+template <typename ValueType, typename Layout>
+bool Grid<ValueType, Layout>::operator <(const Grid& grid2) const {
     return gridCompare(grid2) < 0;
 }
 
-template <typename ValueType>
-bool Grid<ValueType>::operator <=(const Grid& grid2) const {
+template <typename ValueType, typename Layout>
+bool Grid<ValueType, Layout>::operator <=(const Grid& grid2) const {
     return gridCompare(grid2) <= 0;
 }
 
-template <typename ValueType>
-bool Grid<ValueType>::operator >(const Grid& grid2) const {
+template <typename ValueType, typename Layout>
+bool Grid<ValueType, Layout>::operator >(const Grid& grid2) const {
     return gridCompare(grid2) > 0;
 }
 
-template <typename ValueType>
-bool Grid<ValueType>::operator >=(const Grid& grid2) const {
+template <typename ValueType, typename Layout>
+bool Grid<ValueType, Layout>::operator >=(const Grid& grid2) const {
     return gridCompare(grid2) >= 0;
 }
 
-template <typename ValueType>
-void Grid<ValueType>::checkIndexes(int row, int col,
+template <typename ValueType, typename Layout>
+void Grid<ValueType, Layout>::checkIndexes(int row, int col,
                                    int rowMax, int colMax,
                                    std::string prefix) const {
     const int rowMin = 0;
@@ -807,8 +1197,131 @@ void Grid<ValueType>::checkIndexes(int row, int col,
     }
 }
 
-template <typename ValueType>
-int Grid<ValueType>::gridCompare(const Grid& grid2) const {
+/*
+ * Implementation notes: allocate, release, detach, unshare
+ * --------------------------------------------------------
+ * The last grid to release an array frees it.  The acquire/release
+ * ordering on the count makes every write to the array made before a
+ * grid let go of it visible to whichever grid frees or copies it.
+ * A block is raw memory, so the elements are constructed in it and
+ * destroyed before it is freed.  operator new only guarantees the
+ * alignment of the largest built-in type, so each block has
+ * GRID_ALIGNMENT - 1 spare bytes from which the array's start is chosen.
+ */
+template <typename ValueType, typename Layout>
+typename Grid<ValueType, Layout>::ArrayHeader*
+Grid<ValueType, Layout>::allocateBlock(int n) {
+    void* block = ::operator new(sizeof(ArrayHeader) + GRID_ALIGNMENT - 1
+                                 + (size_t) n * sizeof(ValueType));
+    ArrayHeader* header = new (block) ArrayHeader;
+    header->refCount.store(1, std::memory_order_relaxed);
+    header->capacity = n;
+    return header;
+}
+
+template <typename ValueType, typename Layout>
+void Grid<ValueType, Layout>::freeBlock(ArrayHeader* header) {
+    header->~ArrayHeader();
+    ::operator delete(header);
+}
+
+template <typename ValueType, typename Layout>
+ValueType* Grid<ValueType, Layout>::elementsOf(ArrayHeader* header) {
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(header + 1);
+    address = (address + GRID_ALIGNMENT - 1) / GRID_ALIGNMENT * GRID_ALIGNMENT;
+    return reinterpret_cast<ValueType*>(address);
+}
+
+template <typename ValueType, typename Layout>
+void Grid<ValueType, Layout>::allocate(const ValueType& value) {
+    int n = Layout::capacity(nRows, rowStep);
+    ArrayHeader* block = allocateBlock(n);
+    try {
+        std::uninitialized_fill_n(elementsOf(block), n, value);
+    } catch (...) {
+        freeBlock(block);
+        throw;
+    }
+    header = block;
+    elements = elementsOf(block);
+}
+
+template <typename ValueType, typename Layout>
+void Grid<ValueType, Layout>::allocate(const ValueType* src) {
+    int n = Layout::capacity(nRows, rowStep);
+    ArrayHeader* block = allocateBlock(n);
+    try {
+        std::uninitialized_copy(src, src + n, elementsOf(block));
+    } catch (...) {
+        freeBlock(block);
+        throw;
+    }
+    header = block;
+    elements = elementsOf(block);
+}
+
+template <typename ValueType, typename Layout>
+void Grid<ValueType, Layout>::release() {
+    // an UNSHAREABLE array has no other grid to wait for
+    if (header != NULL
+            && (header->refCount.load(std::memory_order_relaxed) == UNSHAREABLE
+                || header->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)) {
+        for (int i = 0; i < header->capacity; i++) {
+            elements[i].~ValueType();
+        }
+        freeBlock(header);
+    }
+    elements = NULL;
+    header = NULL;
+}
+
+template <typename ValueType, typename Layout>
+bool Grid<ValueType, Layout>::isShared() const {
+    return header != NULL && header->refCount.load(std::memory_order_acquire) > 1;
+}
+
+template <typename ValueType, typename Layout>
+bool Grid<ValueType, Layout>::share(ArrayHeader* header) {
+    int count = header->refCount.load(std::memory_order_relaxed);
+    while (count != UNSHAREABLE) {
+        if (header->refCount.compare_exchange_weak(count, count + 1,
+                                                   std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename ValueType, typename Layout>
+void Grid<ValueType, Layout>::detach() {
+    if (isShared()) {
+        Grid shared(*this);
+        release();
+        allocate(shared.elements);
+    }
+}
+
+template <typename ValueType, typename Layout>
+void Grid<ValueType, Layout>::unshare() {
+    if (header == NULL) {
+        return;
+    }
+    // a grid copied meanwhile makes the exchange fail, so the loop
+    // detaches from it and tries again
+    int count = header->refCount.load(std::memory_order_acquire);
+    while (count != UNSHAREABLE) {
+        if (count == 1) {
+            header->refCount.compare_exchange_weak(count, UNSHAREABLE,
+                                                   std::memory_order_acq_rel);
+        } else {
+            detach();
+            count = header->refCount.load(std::memory_order_acquire);
+        }
+    }
+}
+
+template <typename ValueType, typename Layout>
+int Grid<ValueType, Layout>::gridCompare(const Grid& grid2) const {
     int h1 = height();
     int w1 = width();
     int h2 = grid2.height();
@@ -846,8 +1359,8 @@ int Grid<ValueType>::gridCompare(const Grid& grid2) const {
  * strlib.h to read and write generic values in a way that treats strings
  * specially.
  */
-template <typename ValueType>
-std::ostream& operator <<(std::ostream& os, const Grid<ValueType>& grid) {
+template <typename ValueType, typename Layout>
+std::ostream& operator <<(std::ostream& os, const Grid<ValueType, Layout>& grid) {
     os << "{";
     int nRows = grid.numRows();
     int nCols = grid.numCols();
@@ -867,8 +1380,8 @@ std::ostream& operator <<(std::ostream& os, const Grid<ValueType>& grid) {
     return os << "}";
 }
 
-template <typename ValueType>
-std::istream& operator >>(std::istream& is, Grid<ValueType>& grid) {
+template <typename ValueType, typename Layout>
+std::istream& operator >>(std::istream& is, Grid<ValueType, Layout>& grid) {
     Vector<Vector<ValueType> > vec2d;
     is >> vec2d;
     int nRows = vec2d.size();
@@ -886,10 +1399,10 @@ std::istream& operator >>(std::istream& is, Grid<ValueType>& grid) {
  * Template hash function for grids.
  * Requires the element type in the Grid to have a hashCode function.
  */
-template <typename T>
-int hashCode(const Grid<T>& g) {
+template <typename T, typename Layout>
+int hashCode(const Grid<T, Layout>& g) {
     int code = hashSeed();
-    for (T n : g) {
+    for (const T& n : g) {
         code = hashMultiplier() * code + hashCode(n);
     }
     return int(code & hashMask());
@@ -902,8 +1415,8 @@ int hashCode(const Grid<T>& g) {
  * Returns a randomly chosen element of the given grid.
  * Throws an error if the grid is empty.
  */
-template <typename T>
-const T& randomElement(const Grid<T>& grid) {
+template <typename T, typename Layout>
+const T& randomElement(const Grid<T, Layout>& grid) {
     if (grid.isEmpty()) {
         error("randomElement: empty grid was passed");
     }
@@ -915,8 +1428,8 @@ const T& randomElement(const Grid<T>& grid) {
 /*
  * Randomly rearranges the elements of the given grid.
  */
-template <typename T>
-void shuffle(Grid<T>& grid) {
+template <typename T, typename Layout>
+void shuffle(Grid<T, Layout>& grid) {
     int rows = grid.numRows();
     int cols = grid.numCols();
     int length = rows * cols;
@@ -927,9 +1440,7 @@ void shuffle(Grid<T>& grid) {
             int c1 = i % cols;
             int r2 = j / cols;
             int c2 = j % cols;
-            T temp = grid[r1][c1];
-            grid[r1][c1] = grid[r2][c2];
-            grid[r2][c2] = temp;
+            std::swap(grid[r1][c1], grid[r2][c2]);
         }
     }
 }
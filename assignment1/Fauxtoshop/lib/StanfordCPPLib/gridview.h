@@ -0,0 +1,526 @@
+/*
+ * File: gridview.h
+ * ----------------
+ * This file exports the <code>GridView</code> class, which looks at a
+ * rectangular part of a <code>Grid</code>, or of any other row-major
+ * array, without owning or copying its elements.
+ *
+ * @version 2026/10/18
+ * - initial version
+ * - views of grids with padded rows
+ */
+
+#ifndef _gridview_h
+#define _gridview_h
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include "error.h"
+#include "grid.h"
+
+/*
+ * Class: GridView<ValueType>
+ * --------------------------
+ * A view is a pointer to its element (0, 0) plus its numbers of rows and
+ * columns and two strides: how many elements apart in memory consecutive
+ * rows and consecutive columns are.  Taking a sub-rectangle of a view,
+ * transposing it or flipping it only changes those numbers, so it takes
+ * constant time and copies no elements.  A <code>GridView&lt;const
+ * T&gt;</code> can only read its elements, and any view converts to one.
+ *
+ * The following code, for example, copies a 10x10 square from one grid
+ * into the lower-right corner of another, upside down:
+ *
+ *<pre>
+ *    GridView&lt;int&gt; to(dest);
+ *    to.subView(to.numRows() - 10, to.numCols() - 10, 10, 10)
+ *      .copyFrom(GridView&lt;const int&gt;(src).subView(0, 0, 10, 10)
+ *                                           .flippedRows());
+ *</pre>
+ *
+ * A view does not keep its grid alive and does not know when the grid's
+ * elements move.  It must not be used after the grid is destroyed or
+ * resized.  Since copies of a grid share their elements until one of
+ * them is modified, a view that can change the elements of a grid gives
+ * the grid its own array when it is made, and later copies of the grid
+ * get arrays of their own, so writing through the view changes only
+ * that grid.
+ */
+
+template <typename ValueType>
+class GridView {
+public:
+    /*
+     * Type: ElementType
+     * -----------------
+     * The element type of the grids this view can look at, which is
+     * <code>ValueType</code> without any <code>const</code>.
+     */
+    typedef typename std::remove_const<ValueType>::type ElementType;
+
+    /*
+     * Constructor: GridView
+     * Usage: GridView<ValueType> view;
+     *        GridView<ValueType> view(grid);
+     *        GridView<ValueType> view(data, nRows, nCols, rowStride, colStride);
+     * --------------------------------------------------------------------------
+     * Initializes a new view.  The default constructor makes an empty
+     * view.  The second form views all of the given grid; only a view of
+     * <code>const</code> elements can be made from a <code>const</code>
+     * grid.  The grid may have padded rows but may not be tiled.  The
+     * last form views <code>nRows</code> by <code>nCols</code>
+     * elements of an array, the element at (row, col) being
+     * <code>data[row * rowStride + col * colStride]</code>.
+     */
+    GridView();
+
+    template <typename Layout, typename T = ValueType,
+              typename std::enable_if<!std::is_const<T>::value, int>::type = 0>
+    GridView(Grid<ElementType, Layout>& grid);
+
+    template <typename Layout, typename T = ValueType,
+              typename std::enable_if<std::is_const<T>::value, int>::type = 0>
+    GridView(const Grid<ElementType, Layout>& grid);
+
+    GridView(ValueType* data, int nRows, int nCols, int rowStride, int colStride = 1);
+
+    /*
+     * Constructor: GridView
+     * Usage: GridView<const ValueType> constView = view;
+     * --------------------------------------------------
+     * Makes a read-only view of the same elements as a writable view.
+     */
+    template <typename T = ValueType,
+              typename std::enable_if<std::is_const<T>::value, int>::type = 0>
+    GridView(const GridView<ElementType>& view);
+
+    /*
+     * Method: numRows, numCols, height, width
+     * Usage: int nRows = view.numRows();
+     * ----------------------------------
+     * Return the number of rows or columns in this view.  As in Grid,
+     * height is the number of rows and width the number of columns.
+     */
+    int numRows() const;
+    int numCols() const;
+    int height() const;
+    int width() const;
+
+    /*
+     * Method: rowStride, colStride
+     * Usage: int step = view.rowStride();
+     * -----------------------------------
+     * Return how many elements apart in memory consecutive rows, or
+     * consecutive columns, of this view are.  Either may be negative.
+     */
+    int rowStride() const;
+    int colStride() const;
+
+    /*
+     * Method: isEmpty
+     * Usage: if (view.isEmpty()) ...
+     * ------------------------------
+     * Returns <code>true</code> if this view has no rows or no columns.
+     */
+    bool isEmpty() const;
+
+    /*
+     * Method: inBounds
+     * Usage: if (view.inBounds(row, col)) ...
+     * ---------------------------------------
+     * Returns <code>true</code> if the specified row and column position
+     * is inside the bounds of this view.
+     */
+    bool inBounds(int row, int col) const;
+
+    /*
+     * Method: get
+     * Usage: ValueType value = view.get(row, col);
+     * --------------------------------------------
+     * Returns the element at the given position of this view.  Signals an
+     * error if the position is out of bounds.
+     */
+    ValueType& get(int row, int col) const;
+
+    /*
+     * Method: set
+     * Usage: view.set(row, col, value);
+     * ---------------------------------
+     * Replaces the element at the given position of this view.  Signals an
+     * error if the position is out of bounds.
+     */
+    void set(int row, int col, const ElementType& value) const;
+
+    /*
+     * Operator: ()
+     * Usage: view(row, col)
+     * ---------------------
+     * Returns the element at the given position of this view without
+     * checking the bounds, for inner loops whose bounds are known to be
+     * right.
+     */
+    ValueType& operator ()(int row, int col) const {
+        return origin[row * rowStep + col * colStep];
+    }
+
+    /*
+     * Method: hasContiguousRows
+     * Usage: if (view.hasContiguousRows()) ...
+     * ----------------------------------------
+     * Returns <code>true</code> if the elements of each row of this view
+     * are next to each other in memory, left to right, which is what
+     * <code>rowPointer</code> requires.  A view of a whole grid or of a
+     * sub-rectangle of one has contiguous rows; a transposed view or one
+     * with its columns flipped does not.
+     */
+    bool hasContiguousRows() const;
+
+    /*
+     * Method: rowPointer
+     * Usage: ValueType* p = view.rowPointer(row);
+     * -------------------------------------------
+     * Returns a pointer to the first element of the given row, the rest of
+     * the row following it directly, so that <code>p[col]</code> is
+     * element (row, col).  Signals an error if the row is out of bounds or
+     * if the view does not have contiguous rows.
+     */
+    ValueType* rowPointer(int row) const;
+
+    /*
+     * Method: subView
+     * Usage: GridView<ValueType> part = view.subView(row, col, nRows, nCols);
+     * -----------------------------------------------------------------------
+     * Returns a view of the <code>nRows</code> by <code>nCols</code>
+     * rectangle of this view whose upper-left corner is at (row, col).
+     * Signals an error if the rectangle does not lie within this view.
+     */
+    GridView subView(int row, int col, int nRows, int nCols) const;
+
+    /*
+     * Method: transposed
+     * Usage: GridView<ValueType> t = view.transposed();
+     * -------------------------------------------------
+     * Returns a view of the same elements in which element (row, col) is
+     * element (col, row) of this view.
+     */
+    GridView transposed() const;
+
+    /*
+     * Method: flippedRows, flippedCols
+     * Usage: GridView<ValueType> upsideDown = view.flippedRows();
+     * -----------------------------------------------------------
+     * Return a view of the same elements with the rows, or the columns,
+     * in reverse order.
+     */
+    GridView flippedRows() const;
+    GridView flippedCols() const;
+
+    /*
+     * Method: fill
+     * Usage: view.fill(value);
+     * ------------------------
+     * Stores the given value in every element of this view.
+     */
+    void fill(const ElementType& value) const;
+
+    /*
+     * Method: copyFrom
+     * Usage: view.copyFrom(source);
+     * -----------------------------
+     * Copies the elements of the given view, which must have the same
+     * dimensions, into this view.  The two views must not overlap unless
+     * they are the same.  Signals an error if the dimensions differ.
+     */
+    void copyFrom(const GridView<const ElementType>& source) const;
+
+    /*
+     * Method: toGrid
+     * Usage: Grid<ElementType> grid = view.toGrid();
+     * ----------------------------------------------
+     * Returns a new grid holding a copy of the elements of this view.
+     */
+    Grid<ElementType> toGrid() const;
+
+    /*
+     * Method: toString
+     * Usage: string str = view.toString();
+     * ------------------------------------
+     * Converts the view to a printable string representation, the same
+     * one a grid of its elements would have.
+     */
+    std::string toString() const;
+
+    /* Private section */
+
+    /**********************************************************************/
+    /* Note: Everything below this point in the file is logically part    */
+    /* of the implementation and should not be of interest to clients.    */
+    /**********************************************************************/
+
+    /*
+     * Implementation notes: GridView data structure
+     * ---------------------------------------------
+     * Element (row, col) is origin[row * rowStep + col * colStep].  A
+     * flipped view starts at the last row or column of the original and
+     * steps backward, so both steps can be negative.  The operations on
+     * whole views go a row at a time; when the columns of a row are
+     * contiguous, a row is handed to std::fill or std::copy, which for
+     * simple types such as int compile down to memset and memmove.
+     */
+
+private:
+    /* Instance variables */
+    ValueType* origin;   /* The address of element (0, 0)            */
+    int nRows;           /* The number of rows in the view           */
+    int nCols;           /* The number of columns in the view        */
+    int rowStep;         /* The distance between consecutive rows    */
+    int colStep;         /* The distance between consecutive columns */
+
+    void checkIndexes(int row, int col, std::string prefix) const;
+
+    template <typename T>
+    friend class GridView;
+};
+
+template <typename ValueType>
+GridView<ValueType>::GridView()
+        : origin(NULL), nRows(0), nCols(0), rowStep(0), colStep(1) {
+    /* Empty */
+}
+
+template <typename ValueType>
+template <typename Layout, typename T,
+          typename std::enable_if<!std::is_const<T>::value, int>::type>
+GridView<ValueType>::GridView(Grid<ElementType, Layout>& grid)
+        : origin(NULL), nRows(grid.nRows), nCols(grid.nCols),
+          rowStep(grid.rowStep), colStep(1) {
+    static_assert(Layout::CONTIGUOUS_ROWS, "GridView: cannot view a grid with this layout");
+    if (!grid.isEmpty()) {
+        grid.unshare();
+        origin = grid.elements;
+    }
+}
+
+template <typename ValueType>
+template <typename Layout, typename T,
+          typename std::enable_if<std::is_const<T>::value, int>::type>
+GridView<ValueType>::GridView(const Grid<ElementType, Layout>& grid)
+        : origin(NULL), nRows(grid.nRows), nCols(grid.nCols),
+          rowStep(grid.rowStep), colStep(1) {
+    static_assert(Layout::CONTIGUOUS_ROWS, "GridView: cannot view a grid with this layout");
+    if (!grid.isEmpty()) {
+        origin = grid.elements;
+    }
+}
+
+template <typename ValueType>
+GridView<ValueType>::GridView(ValueType* data, int nRows, int nCols,
+                              int rowStride, int colStride)
+        : origin(data), nRows(nRows), nCols(nCols),
+          rowStep(rowStride), colStep(colStride) {
+    if (nRows < 0 || nCols < 0) {
+        error("GridView::constructor: Attempt to create view with negative dimensions");
+    }
+}
+
+template <typename ValueType>
+template <typename T, typename std::enable_if<std::is_const<T>::value, int>::type>
+GridView<ValueType>::GridView(const GridView<ElementType>& view)
+        : origin(view.origin), nRows(view.nRows), nCols(view.nCols),
+          rowStep(view.rowStep), colStep(view.colStep) {
+    /* Empty */
+}
+
+template <typename ValueType>
+int GridView<ValueType>::numRows() const {
+    return nRows;
+}
+
+template <typename ValueType>
+int GridView<ValueType>::numCols() const {
+    return nCols;
+}
+
+template <typename ValueType>
+int GridView<ValueType>::height() const {
+    return nRows;
+}
+
+template <typename ValueType>
+int GridView<ValueType>::width() const {
+    return nCols;
+}
+
+template <typename ValueType>
+int GridView<ValueType>::rowStride() const {
+    return rowStep;
+}
+
+template <typename ValueType>
+int GridView<ValueType>::colStride() const {
+    return colStep;
+}
+
+template <typename ValueType>
+bool GridView<ValueType>::isEmpty() const {
+    return nRows == 0 || nCols == 0;
+}
+
+template <typename ValueType>
+bool GridView<ValueType>::inBounds(int row, int col) const {
+    return row >= 0 && col >= 0 && row < nRows && col < nCols;
+}
+
+template <typename ValueType>
+ValueType& GridView<ValueType>::get(int row, int col) const {
+    checkIndexes(row, col, "get");
+    return (*this)(row, col);
+}
+
+template <typename ValueType>
+void GridView<ValueType>::set(int row, int col, const ElementType& value) const {
+    checkIndexes(row, col, "set");
+    (*this)(row, col) = value;
+}
+
+template <typename ValueType>
+bool GridView<ValueType>::hasContiguousRows() const {
+    return colStep == 1 || nCols <= 1;
+}
+
+template <typename ValueType>
+ValueType* GridView<ValueType>::rowPointer(int row) const {
+    if (row < 0 || row >= nRows) {
+        std::ostringstream out;
+        out << "GridView::rowPointer: row " << row
+            << " is outside of valid range [0.." << nRows - 1 << "]";
+        error(out.str());
+    }
+    if (!hasContiguousRows()) {
+        error("GridView::rowPointer: the columns of this view are not contiguous");
+    }
+    return origin + row * rowStep;
+}
+
+template <typename ValueType>
+GridView<ValueType> GridView<ValueType>::subView(int row, int col,
+                                                 int nRows, int nCols) const {
+    if (nRows < 0 || nCols < 0 || row < 0 || col < 0
+            || row > this->nRows - nRows || col > this->nCols - nCols) {
+        std::ostringstream out;
+        out << "GridView::subView: " << nRows << "x" << nCols << " rectangle at ("
+            << row << ", " << col << ") does not fit in a "
+            << this->nRows << "x" << this->nCols << " view";
+        error(out.str());
+    }
+    if (nRows == 0 || nCols == 0) {
+        return GridView(NULL, nRows, nCols, rowStep, colStep);
+    }
+    return GridView(origin + row * rowStep + col * colStep, nRows, nCols, rowStep, colStep);
+}
+
+template <typename ValueType>
+GridView<ValueType> GridView<ValueType>::transposed() const {
+    return GridView(origin, nCols, nRows, colStep, rowStep);
+}
+
+template <typename ValueType>
+GridView<ValueType> GridView<ValueType>::flippedRows() const {
+    if (isEmpty()) {
+        return *this;
+    }
+    return GridView(origin + (nRows - 1) * rowStep, nRows, nCols, -rowStep, colStep);
+}
+
+template <typename ValueType>
+GridView<ValueType> GridView<ValueType>::flippedCols() const {
+    if (isEmpty()) {
+        return *this;
+    }
+    return GridView(origin + (nCols - 1) * colStep, nRows, nCols, rowStep, -colStep);
+}
+
+template <typename ValueType>
+void GridView<ValueType>::fill(const ElementType& value) const {
+    if (isEmpty()) {
+        return;
+    }
+    for (int row = 0; row < nRows; row++) {
+        ValueType* p = origin + row * rowStep;
+        if (hasContiguousRows()) {
+            std::fill(p, p + nCols, value);
+        } else {
+            for (int col = 0; col < nCols; col++) {
+                p[col * colStep] = value;
+            }
+        }
+    }
+}
+
+template <typename ValueType>
+void GridView<ValueType>::copyFrom(const GridView<const ElementType>& source) const {
+    if (source.nRows != nRows || source.nCols != nCols) {
+        std::ostringstream out;
+        out << "GridView::copyFrom: cannot copy a " << source.nRows << "x"
+            << source.nCols << " view into a " << nRows << "x" << nCols << " view";
+        error(out.str());
+    }
+    if (isEmpty() || (source.origin == origin && source.rowStep == rowStep
+                      && source.colStep == colStep)) {
+        return;
+    }
+    bool contiguous = hasContiguousRows() && source.hasContiguousRows();
+    for (int row = 0; row < nRows; row++) {
+        const ElementType* from = source.origin + row * source.rowStep;
+        ValueType* to = origin + row * rowStep;
+        if (contiguous) {
+            std::copy(from, from + nCols, to);
+        } else {
+            for (int col = 0; col < nCols; col++) {
+                to[col * colStep] = from[col * source.colStep];
+            }
+        }
+    }
+}
+
+template <typename ValueType>
+Grid<typename GridView<ValueType>::ElementType> GridView<ValueType>::toGrid() const {
+    Grid<ElementType> grid(nRows, nCols);
+    GridView<ElementType>(grid).copyFrom(*this);
+    return grid;
+}
+
+template <typename ValueType>
+std::string GridView<ValueType>::toString() const {
+    return toGrid().toString();
+}
+
+template <typename ValueType>
+void GridView<ValueType>::checkIndexes(int row, int col, std::string prefix) const {
+    if (!inBounds(row, col)) {
+        std::ostringstream out;
+        out << "GridView::" << prefix << ": (" << row << ", " << col << ")"
+            << " is outside of valid range [";
+        if (nRows > 0 && nCols > 0) {
+            out << "(0, 0)..(" << nRows - 1 << ", " << nCols - 1 << ")";
+        }
+        out << "]";
+        error(out.str());
+    }
+}
+
+/*
+ * Function: operator <<
+ * Usage: cout << view;
+ * --------------------
+ * Writes the elements of the view to the stream as a grid of them would
+ * be written.
+ */
+template <typename ValueType>
+std::ostream& operator <<(std::ostream& os, const GridView<ValueType>& view) {
+    return os << view.toGrid();
+}
+
+#endif
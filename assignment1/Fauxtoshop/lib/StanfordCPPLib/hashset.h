@@ -4,6 +4,8 @@
  * This file exports the <code>HashSet</code> class, which
  * implements an efficient abstraction for storing sets of values.
  * 
+ * @version 2026/10/18
+ * - added MapType template parameter and FlatHashSet
  * @version 2015/07/05
  * - using global hashing functions rather than global variables
  * @version 2014/11/13
@@ -18,6 +20,7 @@
 #include <iostream>
 #include "error.h"
 #include "hashcode.h"
+#include "flathashmap.h"
 #include "hashmap.h"
 #include "vector.h"
 
@@ -32,8 +35,13 @@
  * time for the <code>Set</code> class.  The disadvantage of
  * <code>HashSet</code> is that iterators return the values in a
  * seemingly random order.
+ *
+ * The optional <code>MapType</code> parameter selects the map that stores
+ * the elements; it must have the interface of <code>HashMap</code>.
+ * <code>FlatHashSet</code>, below, is a <code>HashSet</code> stored in a
+ * <code>FlatHashMap</code>.
  */
-template <typename ValueType>
+template <typename ValueType, typename MapType = HashMap<ValueType, bool> >
 class HashSet {
 public:
     /*
@@ -69,7 +77,7 @@ public:
      * Returns a reference to this set.
      * Identical in behavior to the += operator.
      */
-    HashSet<ValueType>& addAll(const HashSet<ValueType>& set);
+    HashSet& addAll(const HashSet& set);
     
     /*
      * Method: clear
@@ -95,7 +103,7 @@ public:
      * as the given other set.
      * Identical in behavior to the == operator.
      */
-    bool equals(const HashSet<ValueType>& set2) const;
+    bool equals(const HashSet& set2) const;
     
     /*
      * Method: first
@@ -166,7 +174,7 @@ public:
      * Returns a reference to this set.
      * Identical in behavior to the -= operator.
      */
-    HashSet<ValueType>& removeAll(const HashSet<ValueType>& set);
+    HashSet& removeAll(const HashSet& set);
     
     /*
      * Method: retainAll
@@ -176,7 +184,7 @@ public:
      * other set. Returns a reference to this set.
      * Identical in behavior to the *= operator.
      */
-    HashSet<ValueType>& retainAll(const HashSet<ValueType>& set);
+    HashSet& retainAll(const HashSet& set);
 
     /*
      * Method: size
@@ -317,7 +325,7 @@ public:
     /**********************************************************************/
 
 private:
-    HashMap<ValueType, bool> map;        /* Map used to store the element     */
+    MapType map;                         /* Map used to store the element     */
     bool removeFlag;                     /* Flag to differentiate += and -=   */
 
 public:
@@ -347,14 +355,14 @@ public:
      */
     class iterator : public std::iterator<std::input_iterator_tag,ValueType> {
     private:
-        typename HashMap<ValueType,bool>::iterator mapit;
+        typename MapType::iterator mapit;
 
     public:
         iterator() {
             /* Empty */
         }
 
-        iterator(typename HashMap<ValueType, bool>::iterator it) : mapit(it) {
+        iterator(typename MapType::iterator it) : mapit(it) {
             /* Empty */
         }
 
@@ -399,41 +407,51 @@ public:
     }
 };
 
+/*
+ * Type: FlatHashSet<ValueType>
+ * ----------------------------
+ * A <code>HashSet</code> stored in a <code>FlatHashMap</code>, which is
+ * faster and uses less memory for small element types such as
+ * <code>int</code>.
+ */
 template <typename ValueType>
-HashSet<ValueType>::HashSet() : removeFlag(false) {
+using FlatHashSet = HashSet<ValueType, FlatHashMap<ValueType, bool> >;
+
+template <typename ValueType, typename MapType>
+HashSet<ValueType, MapType>::HashSet() : removeFlag(false) {
     /* Empty */
 }
 
-template <typename ValueType>
-HashSet<ValueType>::~HashSet() {
+template <typename ValueType, typename MapType>
+HashSet<ValueType, MapType>::~HashSet() {
     /* Empty */
 }
 
-template <typename ValueType>
-void HashSet<ValueType>::add(const ValueType& value) {
+template <typename ValueType, typename MapType>
+void HashSet<ValueType, MapType>::add(const ValueType& value) {
     map.put(value, true);
 }
 
-template <typename ValueType>
-HashSet<ValueType>& HashSet<ValueType>::addAll(const HashSet& set2) {
+template <typename ValueType, typename MapType>
+HashSet<ValueType, MapType>& HashSet<ValueType, MapType>::addAll(const HashSet& set2) {
     for (ValueType value : set2) {
         this->add(value);
     }
     return *this;
 }
 
-template <typename ValueType>
-void HashSet<ValueType>::clear() {
+template <typename ValueType, typename MapType>
+void HashSet<ValueType, MapType>::clear() {
     map.clear();
 }
 
-template <typename ValueType>
-bool HashSet<ValueType>::contains(const ValueType& value) const {
+template <typename ValueType, typename MapType>
+bool HashSet<ValueType, MapType>::contains(const ValueType& value) const {
     return map.containsKey(value);
 }
 
-template <typename ValueType>
-bool HashSet<ValueType>::equals(const HashSet<ValueType>& set2) const {
+template <typename ValueType, typename MapType>
+bool HashSet<ValueType, MapType>::equals(const HashSet<ValueType, MapType>& set2) const {
     // optimization: if literally same set, stop
     if (this == &set2) {
         return true;
@@ -446,26 +464,26 @@ bool HashSet<ValueType>::equals(const HashSet<ValueType>& set2) const {
     return isSubsetOf(set2) && set2.isSubsetOf(*this);
 }
 
-template <typename ValueType>
-ValueType HashSet<ValueType>::first() const {
+template <typename ValueType, typename MapType>
+ValueType HashSet<ValueType, MapType>::first() const {
     if (isEmpty()) {
         error("HashSet::first: set is empty");
     }
     return *begin();
 }
 
-template <typename ValueType>
-void HashSet<ValueType>::insert(const ValueType& value) {
+template <typename ValueType, typename MapType>
+void HashSet<ValueType, MapType>::insert(const ValueType& value) {
     map.put(value, true);
 }
 
-template <typename ValueType>
-bool HashSet<ValueType>::isEmpty() const {
+template <typename ValueType, typename MapType>
+bool HashSet<ValueType, MapType>::isEmpty() const {
     return map.isEmpty();
 }
 
-template <typename ValueType>
-bool HashSet<ValueType>::isSubsetOf(const HashSet& set2) const {
+template <typename ValueType, typename MapType>
+bool HashSet<ValueType, MapType>::isSubsetOf(const HashSet& set2) const {
     iterator it = begin();
     iterator end = this->end();
     while (it != end) {
@@ -477,29 +495,29 @@ bool HashSet<ValueType>::isSubsetOf(const HashSet& set2) const {
     return true;
 }
 
-template <typename ValueType>
-void HashSet<ValueType>::mapAll(void (*fn)(ValueType)) const {
+template <typename ValueType, typename MapType>
+void HashSet<ValueType, MapType>::mapAll(void (*fn)(ValueType)) const {
     map.mapAll(fn);
 }
 
-template <typename ValueType>
-void HashSet<ValueType>::mapAll(void (*fn)(const ValueType&)) const {
+template <typename ValueType, typename MapType>
+void HashSet<ValueType, MapType>::mapAll(void (*fn)(const ValueType&)) const {
     map.mapAll(fn);
 }
 
-template <typename ValueType>
+template <typename ValueType, typename MapType>
 template <typename FunctorType>
-void HashSet<ValueType>::mapAll(FunctorType fn) const {
+void HashSet<ValueType, MapType>::mapAll(FunctorType fn) const {
     map.mapAll(fn);
 }
 
-template <typename ValueType>
-void HashSet<ValueType>::remove(const ValueType& value) {
+template <typename ValueType, typename MapType>
+void HashSet<ValueType, MapType>::remove(const ValueType& value) {
     map.remove(value);
 }
 
-template <typename ValueType>
-HashSet<ValueType>& HashSet<ValueType>::removeAll(const HashSet& set2) {
+template <typename ValueType, typename MapType>
+HashSet<ValueType, MapType>& HashSet<ValueType, MapType>::removeAll(const HashSet& set2) {
     Vector<ValueType> toRemove;
     for (ValueType value : *this) {
         if (set2.map.containsKey(value)) {
@@ -512,8 +530,8 @@ HashSet<ValueType>& HashSet<ValueType>::removeAll(const HashSet& set2) {
     return *this;
 }
 
-template <typename ValueType>
-HashSet<ValueType>& HashSet<ValueType>::retainAll(const HashSet& set2) {
+template <typename ValueType, typename MapType>
+HashSet<ValueType, MapType>& HashSet<ValueType, MapType>::retainAll(const HashSet& set2) {
     Vector<ValueType> toRemove;
     for (ValueType value : *this) {
         if (!set2.map.containsKey(value)) {
@@ -526,13 +544,13 @@ HashSet<ValueType>& HashSet<ValueType>::retainAll(const HashSet& set2) {
     return *this;
 }
 
-template <typename ValueType>
-int HashSet<ValueType>::size() const {
+template <typename ValueType, typename MapType>
+int HashSet<ValueType, MapType>::size() const {
     return map.size();
 }
 
-template <typename ValueType>
-std::string HashSet<ValueType>::toString() const {
+template <typename ValueType, typename MapType>
+std::string HashSet<ValueType, MapType>::toString() const {
     std::ostringstream os;
     os << *this;
     return os.str();
@@ -544,82 +562,82 @@ std::string HashSet<ValueType>::toString() const {
  * The implementations for the set operators use iteration to walk
  * over the elements in one or both sets.
  */
-template <typename ValueType>
-bool HashSet<ValueType>::operator ==(const HashSet& set2) const {
+template <typename ValueType, typename MapType>
+bool HashSet<ValueType, MapType>::operator ==(const HashSet& set2) const {
     return equals(set2);
 }
 
-template <typename ValueType>
-bool HashSet<ValueType>::operator !=(const HashSet& set2) const {
+template <typename ValueType, typename MapType>
+bool HashSet<ValueType, MapType>::operator !=(const HashSet& set2) const {
     return !equals(set2);
 }
 
-template <typename ValueType>
-HashSet<ValueType> HashSet<ValueType>::operator +(const HashSet& set2) const {
-    HashSet<ValueType> set = *this;
+template <typename ValueType, typename MapType>
+HashSet<ValueType, MapType> HashSet<ValueType, MapType>::operator +(const HashSet& set2) const {
+    HashSet<ValueType, MapType> set = *this;
     set.addAll(set2);
     return set;
 }
 
-template <typename ValueType>
-HashSet<ValueType>
-HashSet<ValueType>::operator +(const ValueType& element) const {
-    HashSet<ValueType> set = *this;
+template <typename ValueType, typename MapType>
+HashSet<ValueType, MapType>
+HashSet<ValueType, MapType>::operator +(const ValueType& element) const {
+    HashSet<ValueType, MapType> set = *this;
     set.add(element);
     return set;
 }
 
-template <typename ValueType>
-HashSet<ValueType> HashSet<ValueType>::operator *(const HashSet& set2) const {
-    HashSet<ValueType> set = *this;
+template <typename ValueType, typename MapType>
+HashSet<ValueType, MapType> HashSet<ValueType, MapType>::operator *(const HashSet& set2) const {
+    HashSet<ValueType, MapType> set = *this;
     return set.retainAll(set2);
 }
 
-template <typename ValueType>
-HashSet<ValueType> HashSet<ValueType>::operator -(const HashSet& set2) const {
-    HashSet<ValueType> set = *this;
+template <typename ValueType, typename MapType>
+HashSet<ValueType, MapType> HashSet<ValueType, MapType>::operator -(const HashSet& set2) const {
+    HashSet<ValueType, MapType> set = *this;
     return set.removeAll(set2);
 }
 
-template <typename ValueType>
-HashSet<ValueType>
-HashSet<ValueType>::operator -(const ValueType& element) const {
-    HashSet<ValueType> set = *this;
+template <typename ValueType, typename MapType>
+HashSet<ValueType, MapType>
+HashSet<ValueType, MapType>::operator -(const ValueType& element) const {
+    HashSet<ValueType, MapType> set = *this;
     set.remove(element);
     return set;
 }
 
-template <typename ValueType>
-HashSet<ValueType>& HashSet<ValueType>::operator +=(const HashSet& set2) {
+template <typename ValueType, typename MapType>
+HashSet<ValueType, MapType>& HashSet<ValueType, MapType>::operator +=(const HashSet& set2) {
     return addAll(set2);
 }
 
-template <typename ValueType>
-HashSet<ValueType>& HashSet<ValueType>::operator +=(const ValueType& value) {
+template <typename ValueType, typename MapType>
+HashSet<ValueType, MapType>& HashSet<ValueType, MapType>::operator +=(const ValueType& value) {
     add(value);
     removeFlag = false;
     return *this;
 }
 
-template <typename ValueType>
-HashSet<ValueType>& HashSet<ValueType>::operator *=(const HashSet& set2) {
+template <typename ValueType, typename MapType>
+HashSet<ValueType, MapType>& HashSet<ValueType, MapType>::operator *=(const HashSet& set2) {
     return retainAll(set2);
 }
 
-template <typename ValueType>
-HashSet<ValueType>& HashSet<ValueType>::operator -=(const HashSet& set2) {
+template <typename ValueType, typename MapType>
+HashSet<ValueType, MapType>& HashSet<ValueType, MapType>::operator -=(const HashSet& set2) {
     return removeAll(set2);
 }
 
-template <typename ValueType>
-HashSet<ValueType>& HashSet<ValueType>::operator -=(const ValueType& value) {
+template <typename ValueType, typename MapType>
+HashSet<ValueType, MapType>& HashSet<ValueType, MapType>::operator -=(const ValueType& value) {
     remove(value);
     removeFlag = true;
     return *this;
 }
 
-template <typename ValueType>
-std::ostream& operator <<(std::ostream& os, const HashSet<ValueType>& set) {
+template <typename ValueType, typename MapType>
+std::ostream& operator <<(std::ostream& os, const HashSet<ValueType, MapType>& set) {
     os << "{";
     bool started = false;
     for (ValueType value : set) {
@@ -633,8 +651,8 @@ std::ostream& operator <<(std::ostream& os, const HashSet<ValueType>& set) {
     return os;
 }
 
-template <typename ValueType>
-std::istream& operator >>(std::istream& is, HashSet<ValueType>& set) {
+template <typename ValueType, typename MapType>
+std::istream& operator >>(std::istream& is, HashSet<ValueType, MapType>& set) {
     char ch = '\0';
     is >> ch;
     if (ch != '{') {
@@ -664,8 +682,8 @@ std::istream& operator >>(std::istream& is, HashSet<ValueType>& set) {
  * Template hash function for hash sets.
  * Requires the element type in the HashSet to have a hashCode function.
  */
-template <typename T>
-int hashCode(const HashSet<T>& s) {
+template <typename T, typename M>
+int hashCode(const HashSet<T, M>& s) {
     int code = hashSeed();
     for (T n : s) {
         code = hashMultiplier() * code + hashCode(n);
@@ -680,8 +698,8 @@ int hashCode(const HashSet<T>& s) {
  * Returns a randomly chosen element of the given set.
  * Throws an error if the set is empty.
  */
-template <typename T>
-const T& randomElement(const HashSet<T>& set) {
+template <typename T, typename M>
+const T& randomElement(const HashSet<T, M>& set) {
     if (set.isEmpty()) {
         error("randomElement: empty hash set was passed");
     }
@@ -0,0 +1,413 @@
+/*
+ * File: huffmancode.cpp
+ * ---------------------
+ * This file implements the huffmancode.h interface.
+ *
+ * @version 2026/10/18
+ * - initial version
+ */
+
+#include "huffmancode.h"
+#include <algorithm>
+#include <cstdio>
+#include "error.h"
+#include "strlib.h"
+
+/*
+ * Implementation notes: code lengths
+ * ----------------------------------
+ * The optimal lengths come from the two-queue form of Huffman's
+ * algorithm: the symbols are sorted by frequency once, and since the
+ * merged nodes are created in order of weight, the two lightest nodes
+ * are always at the front of one of the two queues.  If the code is
+ * deeper than allowed, the frequencies are flattened and the code is
+ * rebuilt, as the deflate encoder in imagecodec.cpp does; this gives up
+ * very little compression and always ends, because equal weights give a
+ * balanced tree.
+ */
+static void buildCodeLengths(const std::vector<unsigned long long>& frequencies,
+                             int maxLength, std::vector<unsigned char>& lengths) {
+    std::vector<unsigned long long> weights(frequencies);
+    std::vector<int> used;
+    for (int i = 0; i < (int) weights.size(); i++) {
+        if (weights[i] > 0) {
+            used.push_back(i);
+        }
+    }
+    lengths.assign(weights.size(), 0);
+    if (used.size() == 1) {
+        lengths[used[0]] = 1;
+        return;
+    }
+    int m = used.size();
+    std::vector<unsigned long long> nodeWeight(2 * m - 1);
+    std::vector<int> parent(2 * m - 1);
+    std::vector<int> depth(2 * m - 1);
+    while (true) {
+        std::sort(used.begin(), used.end(), [&weights](int a, int b) {
+            return weights[a] < weights[b] || (weights[a] == weights[b] && a < b);
+        });
+        // nodes 0..m-1 are the sorted leaves; merged nodes follow them
+        for (int i = 0; i < m; i++) {
+            nodeWeight[i] = weights[used[i]];
+        }
+        int nextLeaf = 0;
+        int nextMerged = m;
+        for (int node = m; node < 2 * m - 1; node++) {
+            int pair[2];
+            for (int k = 0; k < 2; k++) {
+                if (nextLeaf < m && (nextMerged == node
+                                     || nodeWeight[nextLeaf] <= nodeWeight[nextMerged])) {
+                    pair[k] = nextLeaf++;
+                } else {
+                    pair[k] = nextMerged++;
+                }
+            }
+            nodeWeight[node] = nodeWeight[pair[0]] + nodeWeight[pair[1]];
+            parent[pair[0]] = node;
+            parent[pair[1]] = node;
+        }
+        // a parent always comes after its children, so one backward pass
+        // sets every depth
+        depth[2 * m - 2] = 0;
+        int deepest = 0;
+        for (int node = 2 * m - 3; node >= 0; node--) {
+            depth[node] = depth[parent[node]] + 1;
+            deepest = std::max(deepest, depth[node]);
+        }
+        if (deepest <= maxLength) {
+            for (int i = 0; i < m; i++) {
+                lengths[used[i]] = (unsigned char) depth[i];
+            }
+            return;
+        }
+        for (int i = 0; i < m; i++) {
+            weights[used[i]] = (weights[used[i]] >> 1) | 1;
+        }
+    }
+}
+
+HuffmanCode::HuffmanCode() : longest(0) {
+    // empty
+}
+
+HuffmanCode::HuffmanCode(const std::vector<unsigned long long>& frequencies, int maxLength) {
+    if (frequencies.empty() || (int) frequencies.size() > MAX_SYMBOLS) {
+        error("HuffmanCode::constructor: alphabet must have between 1 and "
+              + integerToString(MAX_SYMBOLS) + " symbols");
+    }
+    if (maxLength < 1 || maxLength > MAX_CODE_LENGTH) {
+        error("HuffmanCode::constructor: maximum code length must be between 1 and "
+              + integerToString(MAX_CODE_LENGTH));
+    }
+    long used = 0;
+    for (size_t i = 0; i < frequencies.size(); i++) {
+        if (frequencies[i] > 0) {
+            used++;
+        }
+    }
+    if (used == 0) {
+        error("HuffmanCode::constructor: no symbol has a nonzero frequency");
+    }
+    if (used > (1L << maxLength)) {
+        error("HuffmanCode::constructor: " + longToString(used)
+              + " symbols do not fit in codes of " + integerToString(maxLength) + " bits");
+    }
+    buildCodeLengths(frequencies, maxLength, lengths);
+    buildFromLengths();
+}
+
+int HuffmanCode::symbolCount() const {
+    return lengths.size();
+}
+
+int HuffmanCode::codeLength(int symbol) const {
+    if (symbol < 0 || symbol >= (int) lengths.size()) {
+        return 0;
+    }
+    return lengths[symbol];
+}
+
+void HuffmanCode::encode(obitstream& out, int symbol) const {
+    encodeAll(out, &symbol, 1);
+}
+
+void HuffmanCode::encode(obitstream& out, const int* symbols, int n) const {
+    encodeAll(out, symbols, n);
+}
+
+void HuffmanCode::encode(obitstream& out, const unsigned char* symbols, int n) const {
+    encodeAll(out, symbols, n);
+}
+
+int HuffmanCode::decode(ibitstream& in) const {
+    int symbol;
+    return decodeAll(in, &symbol, 1) == 1 ? symbol : EOF;
+}
+
+int HuffmanCode::decode(ibitstream& in, int* symbols, int n) const {
+    return decodeAll(in, symbols, n);
+}
+
+int HuffmanCode::decode(ibitstream& in, unsigned char* symbols, int n) const {
+    if (lengths.size() > 256) {
+        error("HuffmanCode::decode: alphabet of " + integerToString(lengths.size())
+              + " symbols does not fit in bytes");
+    }
+    return decodeAll(in, symbols, n);
+}
+
+void HuffmanCode::writeTable(obitstream& out) const {
+    if (lengths.empty()) {
+        error("HuffmanCode::writeTable: code is empty");
+    }
+    out.writeBits(lengths.size() - 1, MAX_CODE_LENGTH);
+    for (size_t i = 0; i < lengths.size(); i++) {
+        out.writeBits(lengths[i], 5);
+    }
+}
+
+void HuffmanCode::readTable(ibitstream& in) {
+    int n = (int) in.readBits(MAX_CODE_LENGTH) + 1;
+    std::vector<unsigned char> newLengths(n);
+    for (int i = 0; i < n; i++) {
+        newLengths[i] = (unsigned char) in.readBits(5);
+        if (newLengths[i] > MAX_CODE_LENGTH) {
+            error("HuffmanCode::readTable: code length "
+                  + integerToString(newLengths[i]) + " is too long");
+        }
+    }
+    if (in.fail()) {
+        error("HuffmanCode::readTable: stream ended in the middle of a code table");
+    }
+    lengths.swap(newLengths);
+    buildFromLengths();
+}
+
+/*
+ * Implementation notes: buildFromLengths
+ * --------------------------------------
+ * Canonical codes are assigned as in deflate and stored bit-reversed, so
+ * that the first bit of a code is its lowest bit, as readBits and
+ * writeBits expect.  The decoding table is built in two steps: first
+ * each index is mapped to the single symbol whose code starts it, then
+ * each entry follows that symbol with the ones whose codes fill the rest
+ * of the index.  An index whose remaining bits are unknown still finds
+ * the right symbol, because a symbol's entries cover every value of the
+ * bits that follow its code.
+ */
+void HuffmanCode::buildFromLengths() {
+    for (int len = 0; len <= MAX_CODE_LENGTH; len++) {
+        lengthCount[len] = 0;
+    }
+    for (size_t i = 0; i < lengths.size(); i++) {
+        lengthCount[lengths[i]]++;
+    }
+    lengthCount[0] = 0;
+    long left = 1;
+    longest = 0;
+    for (int len = 1; len <= MAX_CODE_LENGTH; len++) {
+        left = (left << 1) - lengthCount[len];
+        if (left < 0) {
+            lengths.clear();
+            error("HuffmanCode: code lengths are over-subscribed");
+        }
+        if (lengthCount[len] > 0) {
+            longest = len;
+        }
+    }
+    if (longest == 0) {
+        lengths.clear();
+        error("HuffmanCode: code has no symbols");
+    }
+
+    int code = 0;
+    int index = 0;
+    firstCode[0] = 0;
+    firstIndex[0] = 0;
+    for (int len = 1; len <= MAX_CODE_LENGTH; len++) {
+        code = (code + lengthCount[len - 1]) << 1;
+        firstCode[len] = code;
+        firstIndex[len] = index;
+        index += lengthCount[len];
+    }
+
+    int nextCode[MAX_CODE_LENGTH + 1];
+    int nextIndex[MAX_CODE_LENGTH + 1];
+    std::copy(firstCode, firstCode + MAX_CODE_LENGTH + 1, nextCode);
+    std::copy(firstIndex, firstIndex + MAX_CODE_LENGTH + 1, nextIndex);
+    codes.assign(lengths.size(), 0);
+    sorted.assign(index, 0);
+    std::vector<int> single(1 << TABLE_BITS, -1);
+    for (size_t i = 0; i < lengths.size(); i++) {
+        int len = lengths[i];
+        if (len == 0) continue;
+        sorted[nextIndex[len]++] = (unsigned short) i;
+        int c = nextCode[len]++;
+        unsigned int reversed = 0;
+        for (int b = 0; b < len; b++) {
+            reversed |= ((c >> b) & 1) << (len - 1 - b);
+        }
+        codes[i] = reversed;
+        if (len <= TABLE_BITS) {
+            for (int fill = reversed; fill < (1 << TABLE_BITS); fill += (1 << len)) {
+                single[fill] = i;
+            }
+        }
+    }
+
+    table.resize(1 << TABLE_BITS);
+    for (int i = 0; i < (1 << TABLE_BITS); i++) {
+        TableEntry& entry = table[i];
+        entry.count = 0;
+        entry.length = 0;
+        int rest = i;
+        while (entry.count < 3) {
+            int symbol = single[rest];
+            if (symbol < 0 || entry.length + lengths[symbol] > TABLE_BITS) {
+                break;
+            }
+            entry.symbols[entry.count++] = (unsigned short) symbol;
+            entry.length += lengths[symbol];
+            rest >>= lengths[symbol];
+        }
+    }
+}
+
+/*
+ * Decodes one symbol whose code is too long for the table, by checking
+ * the next 1, 2, ... bits against the range of canonical codes of each
+ * length.  Returns EOF if the stream ends.
+ */
+int HuffmanCode::decodeLong(ibitstream& in) const {
+    unsigned int bits = (unsigned int) in.peekBits(longest);
+    int code = 0;
+    for (int len = 1; len <= longest; len++) {
+        code = (code << 1) | ((bits >> (len - 1)) & 1);
+        int offset = code - firstCode[len];
+        if (offset >= 0 && offset < lengthCount[len]) {
+            in.readBits(len);
+            return in.fail() ? EOF : sorted[firstIndex[len] + offset];
+        }
+    }
+    error("HuffmanCode::decode: stream holds an invalid code");
+    return EOF;
+}
+
+/*
+ * Writes the codes of the given symbols, collecting them into words of
+ * 48 bits or more so that writeBits is called once per several codes.
+ */
+template <typename SymbolType>
+void HuffmanCode::encodeAll(obitstream& out, const SymbolType* symbols, int n) const {
+    unsigned long long buffer = 0;
+    int bitCount = 0;
+    for (int i = 0; i < n; i++) {
+        int symbol = symbols[i];
+        if (symbol < 0 || symbol >= (int) lengths.size() || lengths[symbol] == 0) {
+            error("HuffmanCode::encode: symbol " + integerToString(symbol) + " has no code");
+        }
+        buffer |= (unsigned long long) codes[symbol] << bitCount;
+        bitCount += lengths[symbol];
+        if (bitCount >= 64 - MAX_CODE_LENGTH) {
+            out.writeBits(buffer, bitCount);
+            buffer = 0;
+            bitCount = 0;
+        }
+    }
+    if (bitCount > 0) {
+        out.writeBits(buffer, bitCount);
+    }
+}
+
+/*
+ * Reads up to n symbols, taking all of a table entry's symbols at once
+ * unless fewer are wanted.
+ */
+template <typename SymbolType>
+int HuffmanCode::decodeAll(ibitstream& in, SymbolType* symbols, int n) const {
+    if (table.empty()) {
+        error("HuffmanCode::decode: code is empty");
+    }
+    int count = 0;
+    while (count < n) {
+        const TableEntry& entry = table[in.peekBits(TABLE_BITS)];
+        if (entry.count == 0) {
+            int symbol = decodeLong(in);
+            if (symbol == EOF) {
+                break;
+            }
+            symbols[count++] = (SymbolType) symbol;
+            continue;
+        }
+        int take = entry.count;
+        int length = entry.length;
+        if (take > n - count) {
+            take = n - count;
+            length = 0;
+            for (int i = 0; i < take; i++) {
+                length += lengths[entry.symbols[i]];
+            }
+        }
+        in.readBits(length);
+        if (in.fail()) {
+            break;
+        }
+        for (int i = 0; i < take; i++) {
+            symbols[count++] = (SymbolType) entry.symbols[i];
+        }
+    }
+    return count;
+}
+
+/*
+ * Implementation notes: huffmanCompress, huffmanDecompress
+ * --------------------------------------------------------
+ * The compressed data is a sequence of blocks, each made up of its
+ * length in bytes as a 32-bit number, the table of its Huffman code,
+ * and the codes of its bytes.  A length of 0 ends the data.
+ */
+void huffmanCompress(std::istream& input, obitstream& output, int blockSize) {
+    if (blockSize < 1 || blockSize > HUFFMAN_MAX_BLOCK_SIZE) {
+        error("huffmanCompress: block size must be between 1 and "
+              + integerToString(HUFFMAN_MAX_BLOCK_SIZE));
+    }
+    std::vector<char> block(blockSize);
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&block[0]);
+    while (input.read(&block[0], blockSize) || input.gcount() > 0) {
+        int n = (int) input.gcount();
+        std::vector<unsigned long long> frequencies(256, 0);
+        for (int i = 0; i < n; i++) {
+            frequencies[bytes[i]]++;
+        }
+        HuffmanCode code(frequencies);
+        output.writeBits(n, 32);
+        code.writeTable(output);
+        code.encode(output, bytes, n);
+    }
+    output.writeBits(0, 32);
+}
+
+void huffmanDecompress(ibitstream& input, std::ostream& output) {
+    std::vector<unsigned char> block;
+    HuffmanCode code;
+    while (true) {
+        unsigned long long n = input.readBits(32);
+        if (input.fail()) {
+            error("huffmanDecompress: compressed data is truncated");
+        } else if (n == 0) {
+            break;
+        } else if (n > (unsigned long long) HUFFMAN_MAX_BLOCK_SIZE) {
+            error("huffmanDecompress: compressed data is corrupt");
+        }
+        code.readTable(input);
+        if (code.symbolCount() > 256) {
+            error("huffmanDecompress: compressed data is corrupt");
+        }
+        block.resize(n);
+        if (code.decode(input, &block[0], (int) n) != (int) n) {
+            error("huffmanDecompress: compressed data is truncated");
+        }
+        output.write(reinterpret_cast<const char*>(&block[0]), n);
+    }
+}
@@ -0,0 +1,229 @@
+/*
+ * File: huffmancode.h
+ * -------------------
+ * This file exports the <code>HuffmanCode</code> class, a canonical
+ * Huffman code that encodes symbols to an <code>obitstream</code> and
+ * decodes them from an <code>ibitstream</code>, along with the functions
+ * <code>huffmanCompress</code> and <code>huffmanDecompress</code>, which
+ * compress whole streams with it.
+ *
+ * Unlike the tree of nodes built in the Huffman assignment, a canonical
+ * code is described completely by the length of each symbol's code, so
+ * it can be stored in a few bytes, and it is decoded by table lookups
+ * instead of walking a tree one bit at a time.
+ *
+ * @version 2026/10/18
+ * - initial version
+ */
+
+#ifndef _huffmancode_h
+#define _huffmancode_h
+
+#include <istream>
+#include <ostream>
+#include <vector>
+#include "bitstream.h"
+
+/*
+ * Class: HuffmanCode
+ * ------------------
+ * This class represents a prefix code for the symbols 0 through
+ * <code>symbolCount() - 1</code> in which no code is longer than
+ * <code>MAX_CODE_LENGTH</code> bits.  Codes are assigned canonically:
+ * shorter codes come first and codes of the same length are in symbol
+ * order, so the lengths alone determine the code.
+ *
+ * Codes are written with <code>obitstream::writeBits</code>, first bit
+ * first, which is the order deflate uses.  Decoding looks up the next
+ * <code>TABLE_BITS</code> bits of the stream in a table that gives all
+ * of the symbols (up to three) whose codes fit in those bits, so
+ * <code>decode</code> usually returns several symbols per lookup.
+ */
+class HuffmanCode {
+public:
+    /*
+     * Constant: MAX_CODE_LENGTH
+     * -------------------------
+     * The longest code this class will build or read, in bits.
+     */
+    static const int MAX_CODE_LENGTH = 16;
+
+    /*
+     * Constant: MAX_SYMBOLS
+     * ---------------------
+     * The largest alphabet a code may have.
+     */
+    static const int MAX_SYMBOLS = 1 << MAX_CODE_LENGTH;
+
+    /*
+     * Constant: TABLE_BITS
+     * --------------------
+     * The number of bits resolved by one decoding table lookup.  Codes
+     * longer than this are decoded by a slower canonical search.
+     */
+    static const int TABLE_BITS = 11;
+
+    /*
+     * Constructor: HuffmanCode
+     * Usage: HuffmanCode code;
+     *        HuffmanCode code(frequencies);
+     *        HuffmanCode code(frequencies, maxLength);
+     * ------------------------------------------------
+     * Initializes a new Huffman code.  The default constructor makes an
+     * empty code that can be filled in with <code>readTable</code>.  The
+     * other builds an optimal code for symbols that occur with the given
+     * frequencies, where <code>frequencies[i]</code> is the number of
+     * times symbol <code>i</code> occurs, with no code longer than
+     * <code>maxLength</code> bits.  Symbols with a frequency of 0 get no
+     * code.  Raises an error if no symbol has a nonzero frequency or if
+     * the symbols cannot all have codes of at most <code>maxLength</code>
+     * bits.
+     */
+    HuffmanCode();
+    HuffmanCode(const std::vector<unsigned long long>& frequencies,
+                int maxLength = MAX_CODE_LENGTH);
+
+    /*
+     * Method: symbolCount
+     * Usage: int n = code.symbolCount();
+     * ----------------------------------
+     * Returns the number of symbols in this code's alphabet, including
+     * those that have no code.
+     */
+    int symbolCount() const;
+
+    /*
+     * Method: codeLength
+     * Usage: int bits = code.codeLength(symbol);
+     * ------------------------------------------
+     * Returns the length in bits of the given symbol's code, or 0 if the
+     * symbol has no code.
+     */
+    int codeLength(int symbol) const;
+
+    /*
+     * Method: encode
+     * Usage: code.encode(out, symbol);
+     *        code.encode(out, symbols, n);
+     * ------------------------------------
+     * Writes the code for the given symbol, or for the first
+     * <code>n</code> symbols of the given array, to the output stream.
+     * Raises an error if a symbol has no code.
+     */
+    void encode(obitstream& out, int symbol) const;
+    void encode(obitstream& out, const int* symbols, int n) const;
+    void encode(obitstream& out, const unsigned char* symbols, int n) const;
+
+    /*
+     * Method: decode
+     * Usage: int symbol = code.decode(in);
+     *        int count = code.decode(in, symbols, n);
+     * -----------------------------------------------
+     * Reads one symbol, or up to <code>n</code> symbols into the given
+     * array, from the input stream.  The first form returns the symbol,
+     * or <code>EOF</code> at the end of the stream; the second returns
+     * the number of symbols read, which is less than <code>n</code> only
+     * at the end of the stream.  The <code>unsigned char</code> form
+     * requires an alphabet of at most 256 symbols.
+     * Since the last byte of a stream is padded with 0 bits, which may
+     * look like more codes, a client should know how many symbols to
+     * read or end its data with a symbol such as <code>PSEUDO_EOF</code>.
+     * Raises an error if the stream holds a bit sequence that is not a
+     * code.
+     */
+    int decode(ibitstream& in) const;
+    int decode(ibitstream& in, int* symbols, int n) const;
+    int decode(ibitstream& in, unsigned char* symbols, int n) const;
+
+    /*
+     * Method: writeTable
+     * Usage: code.writeTable(out);
+     * ----------------------------
+     * Writes a description of this code to the output stream, from which
+     * <code>readTable</code> can rebuild it.  This takes 5 bits per symbol
+     * of the alphabet.
+     */
+    void writeTable(obitstream& out) const;
+
+    /*
+     * Method: readTable
+     * Usage: code.readTable(in);
+     * --------------------------
+     * Replaces this code with one read from the input stream, as written
+     * by <code>writeTable</code>.  Raises an error if the stream ends early
+     * or does not hold a valid code.
+     */
+    void readTable(ibitstream& in);
+
+private:
+    /*
+     * One entry of the decoding table: the symbols whose codes make up
+     * the first 'length' bits of the entry's index.  A count of 0 means
+     * the index starts with a code longer than TABLE_BITS.
+     */
+    struct TableEntry {
+        unsigned short symbols[3];
+        unsigned char count;
+        unsigned char length;
+    };
+
+    std::vector<unsigned char> lengths;    // code length of each symbol
+    std::vector<unsigned int> codes;       // code of each symbol, first bit lowest
+    std::vector<TableEntry> table;         // indexed by the next TABLE_BITS bits
+    std::vector<unsigned short> sorted;    // symbols in canonical code order
+    int longest;                           // length of the longest code
+    int firstCode[MAX_CODE_LENGTH + 1];    // first canonical code of each length
+    int firstIndex[MAX_CODE_LENGTH + 1];   // its position in 'sorted'
+    int lengthCount[MAX_CODE_LENGTH + 1];  // number of codes of each length
+
+    void buildFromLengths();
+    int decodeLong(ibitstream& in) const;
+
+    template <typename SymbolType>
+    void encodeAll(obitstream& out, const SymbolType* symbols, int n) const;
+
+    template <typename SymbolType>
+    int decodeAll(ibitstream& in, SymbolType* symbols, int n) const;
+};
+
+/*
+ * Constant: HUFFMAN_BLOCK_SIZE
+ * ----------------------------
+ * The default number of bytes <code>huffmanCompress</code> codes with
+ * one Huffman code.
+ */
+const int HUFFMAN_BLOCK_SIZE = 1 << 20;
+
+/*
+ * Constant: HUFFMAN_MAX_BLOCK_SIZE
+ * --------------------------------
+ * The largest block size <code>huffmanCompress</code> accepts, which
+ * bounds the memory <code>huffmanDecompress</code> needs.
+ */
+const int HUFFMAN_MAX_BLOCK_SIZE = 1 << 24;
+
+/*
+ * Function: huffmanCompress
+ * Usage: huffmanCompress(input, output);
+ *        huffmanCompress(input, output, blockSize);
+ * -------------------------------------------------
+ * Compresses the rest of the input stream to the output stream.  The
+ * input is read in blocks of <code>blockSize</code> bytes, each coded
+ * with its own Huffman code, so the input can be larger than memory
+ * and need not be seekable.  The output stream is not closed, so other
+ * data may be written after the compressed data.
+ */
+void huffmanCompress(std::istream& input, obitstream& output,
+                     int blockSize = HUFFMAN_BLOCK_SIZE);
+
+/*
+ * Function: huffmanDecompress
+ * Usage: huffmanDecompress(input, output);
+ * ----------------------------------------
+ * Reads data written by <code>huffmanCompress</code> from the input
+ * stream and writes the original bytes to the output stream, one block
+ * at a time.  Raises an error if the input is truncated or corrupt.
+ */
+void huffmanDecompress(ibitstream& input, std::ostream& output);
+
+#endif
@@ -0,0 +1,2565 @@
+/*
+ * File: imagecodec.cpp
+ * --------------------
+ * This file implements the imagecodec.h interface.
+ * See that file for documentation of each function.
+ *
+ * The decoders follow the published specifications:
+ * PNG (ISO/IEC 15948) with zlib/deflate (RFC 1950/1951),
+ * JPEG (ITU T.81), GIF (89a), and Netpbm.
+ * Everything is decoded into memory in one pass; no back-end is involved.
+ *
+ * @version 2026/10/18
+ * @since 2026/10/18
+ */
+
+#include "imagecodec.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdint.h>
+#include <vector>
+#include "error.h"
+#include "filelib.h"
+#include "strlib.h"
+
+namespace imagecodec {
+
+/*
+ * Thrown internally when a file uses a feature of its format that this codec
+ * does not implement; caught by decode, which then returns false.
+ */
+struct UnsupportedFeature {
+};
+
+/*
+ * The largest number of pixels a decoded image may have, about 67 million;
+ * a header's size is checked against it before anything is allocated.
+ */
+static const size_t MAX_IMAGE_PIXELS = (size_t) 1 << 26;
+
+/*
+ * The most bytes deflate can produce from one byte of compressed data.
+ */
+static const size_t MAX_DEFLATE_RATIO = 1032;
+
+/*
+ * Signals an error if a header's image size is empty or too large.
+ */
+static void checkImageSize(int w, int h) {
+    if (w <= 0 || h <= 0 || w > 65535 || h > 65535
+            || (size_t) w * h > MAX_IMAGE_PIXELS) {
+        error("imagecodec::decode: invalid image size "
+              + integerToString(w) + "x" + integerToString(h));
+    }
+}
+
+/*
+ * A decoded image as a flat row-major array of 0xRRGGBB pixels.
+ */
+struct Image {
+    int width;
+    int height;
+    std::vector<int> pixels;
+
+    Image() : width(0), height(0) {}
+
+    void resize(int w, int h) {
+        checkImageSize(w, h);
+        width = w;
+        height = h;
+        pixels.assign((size_t) w * h, 0);
+    }
+};
+
+static inline int rgb(int red, int green, int blue) {
+    return (red << 16) | (green << 8) | blue;
+}
+
+static inline int clampByte(int value) {
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+static inline uint32_t readBigEndian32(const uint8_t* p) {
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+static inline int readBigEndian16(const uint8_t* p) {
+    return (p[0] << 8) | p[1];
+}
+
+static inline int readLittleEndian16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static void appendBigEndian32(std::string& out, uint32_t value) {
+    out += (char) ((value >> 24) & 0xff);
+    out += (char) ((value >> 16) & 0xff);
+    out += (char) ((value >> 8) & 0xff);
+    out += (char) (value & 0xff);
+}
+
+static void appendBigEndian16(std::string& out, int value) {
+    out += (char) ((value >> 8) & 0xff);
+    out += (char) (value & 0xff);
+}
+
+static void appendLittleEndian16(std::string& out, int value) {
+    out += (char) (value & 0xff);
+    out += (char) ((value >> 8) & 0xff);
+}
+
+/*
+ * Returns the number of bytes remaining at 'pos' in a buffer of the given
+ * length, or signals an error naming the format if fewer than 'needed' remain.
+ */
+static void checkAvailable(size_t pos, size_t needed, size_t length, const char* format) {
+    if (pos > length || length - pos < needed) {
+        error(std::string("imagecodec::decode: ") + format + " data is truncated");
+    }
+}
+
+
+/* ===================== checksums ===================== */
+
+struct Crc32Table {
+    uint32_t entries[256];
+
+    Crc32Table() {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? (0xedb88320u ^ (c >> 1)) : (c >> 1);
+            }
+            entries[n] = c;
+        }
+    }
+};
+
+static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+    static const Crc32Table table;
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = table.entries[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static uint32_t adler32(const uint8_t* data, size_t length) {
+    uint32_t a = 1, b = 0;
+    while (length > 0) {
+        // 5552 is the largest n such that the sums cannot overflow 32 bits
+        size_t n = std::min(length, (size_t) 5552);
+        length -= n;
+        while (n-- > 0) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+
+/* ===================== inflate (RFC 1950/1951) ===================== */
+
+static const int INFLATE_LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const int INFLATE_LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const int INFLATE_DIST_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const int INFLATE_DIST_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+static const int CODE_LENGTH_ORDER[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+/*
+ * Reads a deflate stream's bits least-significant first through a 64-bit
+ * buffer.  Reading past the end supplies zero bits, which is detected by
+ * checkOverrun once the caller has consumed them.
+ */
+class InflateBitReader {
+public:
+    InflateBitReader(const uint8_t* data, size_t length)
+        : p(data), end(data + length), buffer(0), count(0), padding(0) {
+        refill();
+    }
+
+    void refill() {
+        while (count <= 56) {
+            uint64_t b = 0;
+            if (p < end) {
+                b = *p++;
+            } else {
+                padding++;
+            }
+            buffer |= b << count;
+            count += 8;
+        }
+    }
+
+    uint32_t peek(int n) {
+        if (count < n) refill();
+        return (uint32_t) (buffer & ((1ull << n) - 1));
+    }
+
+    void consume(int n) {
+        buffer >>= n;
+        count -= n;
+    }
+
+    uint32_t getBits(int n) {
+        if (n == 0) return 0;
+        uint32_t value = peek(n);
+        consume(n);
+        return value;
+    }
+
+    void alignToByte() {
+        consume(count & 7);
+    }
+
+    /*
+     * Copies n whole bytes from the (byte-aligned) stream to out.
+     */
+    void copyBytes(std::vector<uint8_t>& out, size_t n) {
+        while (n > 0 && count >= 8) {
+            out.push_back((uint8_t) getBits(8));
+            n--;
+        }
+        // buffer is now empty; rewind past any padding and copy directly
+        if (n > (size_t) (end - p)) {
+            error("imagecodec::decode: deflate data is truncated");
+        }
+        out.insert(out.end(), p, p + n);
+        p += n;
+        buffer = 0;
+        count = 0;
+        refill();
+    }
+
+    void checkOverrun() const {
+        if ((int) padding * 8 > count) {
+            error("imagecodec::decode: deflate data is truncated");
+        }
+    }
+
+    size_t bytesConsumed(const uint8_t* start) const {
+        return (p - start) - (count / 8) + padding;
+    }
+
+private:
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t buffer;
+    int count;
+    int padding;
+};
+
+/*
+ * A canonical Huffman decoding table as used by deflate.
+ * Codes up to FAST_BITS long are resolved by one table lookup; longer codes
+ * fall back to a bit-at-a-time canonical search.
+ */
+class InflateHuffman {
+public:
+    static const int FAST_BITS = 10;
+    static const int MAX_BITS = 15;
+
+    void build(const uint8_t* lengths, int n) {
+        std::memset(counts, 0, sizeof(counts));
+        std::memset(fast, 0, sizeof(fast));
+        for (int i = 0; i < n; i++) {
+            counts[lengths[i]]++;
+        }
+        counts[0] = 0;
+        int left = 1;
+        for (int len = 1; len <= MAX_BITS; len++) {
+            left = (left << 1) - counts[len];
+            if (left < 0) {
+                error("imagecodec::decode: deflate data has an over-subscribed Huffman code");
+            }
+        }
+        int offsets[MAX_BITS + 2];
+        offsets[1] = 0;
+        for (int len = 1; len <= MAX_BITS; len++) {
+            offsets[len + 1] = offsets[len] + counts[len];
+        }
+        int nextCode[MAX_BITS + 1];
+        int code = 0;
+        for (int len = 1; len <= MAX_BITS; len++) {
+            code = (code + counts[len - 1]) << 1;
+            nextCode[len] = code;
+        }
+        for (int i = 0; i < n; i++) {
+            int len = lengths[i];
+            if (len == 0) continue;
+            symbols[offsets[len]++] = (uint16_t) i;
+            int c = nextCode[len]++;
+            if (len <= FAST_BITS) {
+                // deflate packs Huffman codes starting with their most-significant bit
+                int reversed = 0;
+                for (int b = 0; b < len; b++) {
+                    reversed |= ((c >> b) & 1) << (len - 1 - b);
+                }
+                for (int fill = reversed; fill < (1 << FAST_BITS); fill += (1 << len)) {
+                    fast[fill] = (uint16_t) ((i << 4) | len);
+                }
+            }
+        }
+    }
+
+    int decode(InflateBitReader& in) const {
+        uint16_t entry = fast[in.peek(FAST_BITS)];
+        if (entry != 0) {
+            in.consume(entry & 15);
+            return entry >> 4;
+        }
+        int code = 0, first = 0, index = 0;
+        for (int len = 1; len <= MAX_BITS; len++) {
+            code |= in.getBits(1);
+            int count = counts[len];
+            if (code - first < count) {
+                return symbols[index + (code - first)];
+            }
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+        error("imagecodec::decode: deflate data has an invalid Huffman code");
+        return -1;
+    }
+
+private:
+    uint16_t fast[1 << FAST_BITS];
+    uint16_t counts[MAX_BITS + 1];
+    uint16_t symbols[288];
+};
+
+static void inflateBlock(InflateBitReader& in, std::vector<uint8_t>& out,
+                         const InflateHuffman& litlen, const InflateHuffman& dist) {
+    while (true) {
+        in.checkOverrun();
+        int symbol = litlen.decode(in);
+        if (symbol < 256) {
+            out.push_back((uint8_t) symbol);
+        } else if (symbol == 256) {
+            return;
+        } else {
+            symbol -= 257;
+            if (symbol >= 29) {
+                error("imagecodec::decode: deflate data has an invalid length code");
+            }
+            int length = INFLATE_LENGTH_BASE[symbol] + in.getBits(INFLATE_LENGTH_EXTRA[symbol]);
+            int distSymbol = dist.decode(in);
+            if (distSymbol >= 30) {
+                error("imagecodec::decode: deflate data has an invalid distance code");
+            }
+            size_t distance = INFLATE_DIST_BASE[distSymbol] + in.getBits(INFLATE_DIST_EXTRA[distSymbol]);
+            if (distance > out.size()) {
+                error("imagecodec::decode: deflate data refers before start of output");
+            }
+            size_t from = out.size() - distance;
+            for (int i = 0; i < length; i++) {
+                out.push_back(out[from + i]);
+            }
+        }
+    }
+}
+
+/*
+ * Decompresses a zlib stream, appending the result to out.
+ */
+static void zlibInflate(const uint8_t* data, size_t length, std::vector<uint8_t>& out) {
+    checkAvailable(0, 2, length, "zlib");
+    if ((data[0] & 0x0f) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20)) {
+        error("imagecodec::decode: invalid zlib header");
+    }
+    size_t start = out.size();
+    InflateBitReader in(data + 2, length - 2);
+    InflateHuffman litlen, dist;
+    bool last = false;
+    while (!last) {
+        last = in.getBits(1);
+        int type = in.getBits(2);
+        if (type == 0) {
+            in.alignToByte();
+            int len = in.getBits(16);
+            int nlen = in.getBits(16);
+            if ((len ^ 0xffff) != nlen) {
+                error("imagecodec::decode: deflate stored block has a bad length");
+            }
+            in.copyBytes(out, len);
+        } else if (type == 1) {
+            uint8_t lengths[288 + 32];
+            std::fill(lengths, lengths + 144, 8);
+            std::fill(lengths + 144, lengths + 256, 9);
+            std::fill(lengths + 256, lengths + 280, 7);
+            std::fill(lengths + 280, lengths + 288, 8);
+            std::fill(lengths + 288, lengths + 320, 5);
+            litlen.build(lengths, 288);
+            dist.build(lengths + 288, 32);
+            inflateBlock(in, out, litlen, dist);
+        } else if (type == 2) {
+            int nlit = in.getBits(5) + 257;
+            int ndist = in.getBits(5) + 1;
+            int ncode = in.getBits(4) + 4;
+            uint8_t codeLengths[19] = {0};
+            for (int i = 0; i < ncode; i++) {
+                codeLengths[CODE_LENGTH_ORDER[i]] = (uint8_t) in.getBits(3);
+            }
+            InflateHuffman codeLengthCode;
+            codeLengthCode.build(codeLengths, 19);
+            uint8_t lengths[288 + 32] = {0};
+            int n = 0;
+            while (n < nlit + ndist) {
+                in.checkOverrun();
+                int symbol = codeLengthCode.decode(in);
+                if (symbol < 16) {
+                    lengths[n++] = (uint8_t) symbol;
+                    continue;
+                }
+                int repeat = 0;
+                uint8_t value = 0;
+                if (symbol == 16) {
+                    if (n == 0) {
+                        error("imagecodec::decode: deflate data repeats a missing length");
+                    }
+                    value = lengths[n - 1];
+                    repeat = 3 + in.getBits(2);
+                } else if (symbol == 17) {
+                    repeat = 3 + in.getBits(3);
+                } else {
+                    repeat = 11 + in.getBits(7);
+                }
+                if (n + repeat > nlit + ndist) {
+                    error("imagecodec::decode: deflate data has too many code lengths");
+                }
+                while (repeat-- > 0) {
+                    lengths[n++] = value;
+                }
+            }
+            litlen.build(lengths, nlit);
+            dist.build(lengths + nlit, ndist);
+            inflateBlock(in, out, litlen, dist);
+        } else {
+            error("imagecodec::decode: deflate data has an invalid block type");
+        }
+    }
+    in.checkOverrun();
+    in.alignToByte();
+    size_t used = in.bytesConsumed(data + 2) + 2;
+    if (used + 4 <= length) {
+        uint32_t expected = readBigEndian32(data + used);
+        if (expected != adler32(&out[0] + start, out.size() - start)) {
+            error("imagecodec::decode: zlib checksum mismatch");
+        }
+    }
+}
+
+
+/* ===================== deflate (RFC 1950/1951) ===================== */
+
+/*
+ * Writes bits least-significant first, as deflate requires.
+ */
+class DeflateBitWriter {
+public:
+    DeflateBitWriter(std::string& out) : out(out), buffer(0), count(0) {}
+
+    void putBits(uint32_t value, int n) {
+        buffer |= (uint64_t) value << count;
+        count += n;
+        while (count >= 8) {
+            out += (char) (buffer & 0xff);
+            buffer >>= 8;
+            count -= 8;
+        }
+    }
+
+    void flush() {
+        if (count > 0) {
+            out += (char) (buffer & 0xff);
+        }
+        buffer = 0;
+        count = 0;
+    }
+
+private:
+    std::string& out;
+    uint64_t buffer;
+    int count;
+};
+
+/*
+ * Computes Huffman code lengths for the given symbol frequencies, limited to
+ * maxBits.  If the optimal code is too deep, the frequencies are flattened
+ * and the code rebuilt until it fits.
+ */
+static void buildCodeLengths(const std::vector<uint32_t>& freqs, int maxBits,
+                             std::vector<uint8_t>& lengths) {
+    int n = freqs.size();
+    lengths.assign(n, 0);
+    std::vector<uint32_t> weights(freqs);
+    int used = 0;
+    for (int i = 0; i < n; i++) {
+        if (weights[i] > 0) used++;
+    }
+    // every table gets at least two codes so that decoders see a complete code
+    for (int i = 0; used < 2 && i < n; i++) {
+        if (weights[i] == 0) {
+            weights[i] = 1;
+            used++;
+        }
+    }
+    while (true) {
+        // nodes 0..n-1 are leaves; internal nodes are appended after them
+        std::vector<uint64_t> nodeWeight;
+        std::vector<int> parent(n, -1);
+        std::vector<std::pair<uint64_t, int> > heap;
+        for (int i = 0; i < n; i++) {
+            nodeWeight.push_back(weights[i]);
+            if (weights[i] > 0) {
+                heap.push_back(std::make_pair(weights[i], i));
+            }
+        }
+        std::greater<std::pair<uint64_t, int> > order;
+        std::make_heap(heap.begin(), heap.end(), order);
+        while (heap.size() > 1) {
+            std::pop_heap(heap.begin(), heap.end(), order);
+            std::pair<uint64_t, int> a = heap.back();
+            heap.pop_back();
+            std::pop_heap(heap.begin(), heap.end(), order);
+            std::pair<uint64_t, int> b = heap.back();
+            heap.pop_back();
+            int node = nodeWeight.size();
+            nodeWeight.push_back(a.first + b.first);
+            parent.push_back(-1);
+            parent[a.second] = node;
+            parent[b.second] = node;
+            heap.push_back(std::make_pair(a.first + b.first, node));
+            std::push_heap(heap.begin(), heap.end(), order);
+        }
+        int deepest = 0;
+        for (int i = 0; i < n; i++) {
+            if (weights[i] == 0) continue;
+            int depth = 0;
+            for (int node = i; parent[node] >= 0; node = parent[node]) {
+                depth++;
+            }
+            lengths[i] = (uint8_t) depth;
+            deepest = std::max(deepest, depth);
+        }
+        if (deepest <= maxBits) {
+            return;
+        }
+        for (int i = 0; i < n; i++) {
+            if (weights[i] > 0) {
+                weights[i] = (weights[i] >> 1) | 1;
+            }
+        }
+    }
+}
+
+/*
+ * Assigns canonical codes for the given lengths, bit-reversed for deflate.
+ */
+static void buildReversedCodes(const std::vector<uint8_t>& lengths, std::vector<uint16_t>& codes) {
+    int counts[16] = {0};
+    for (size_t i = 0; i < lengths.size(); i++) {
+        counts[lengths[i]]++;
+    }
+    counts[0] = 0;
+    int nextCode[16];
+    int code = 0;
+    for (int len = 1; len < 16; len++) {
+        code = (code + counts[len - 1]) << 1;
+        nextCode[len] = code;
+    }
+    codes.assign(lengths.size(), 0);
+    for (size_t i = 0; i < lengths.size(); i++) {
+        int len = lengths[i];
+        if (len == 0) continue;
+        int c = nextCode[len]++;
+        int reversed = 0;
+        for (int b = 0; b < len; b++) {
+            reversed |= ((c >> b) & 1) << (len - 1 - b);
+        }
+        codes[i] = (uint16_t) reversed;
+    }
+}
+
+static int lengthSymbol(int length) {
+    int symbol = 28;
+    while (INFLATE_LENGTH_BASE[symbol] > length) symbol--;
+    return symbol;
+}
+
+static int distanceSymbol(int distance) {
+    int symbol = 29;
+    while (INFLATE_DIST_BASE[symbol] > distance) symbol--;
+    return symbol;
+}
+
+/*
+ * One LZ77 token: a literal byte (distance 0) or a back-reference.
+ */
+struct DeflateToken {
+    uint16_t value;     // literal byte or match length
+    uint16_t distance;  // 0 for a literal
+};
+
+static void writeDynamicBlock(DeflateBitWriter& out, const std::vector<DeflateToken>& tokens, bool last) {
+    std::vector<uint32_t> litFreqs(286, 0), distFreqs(30, 0);
+    for (size_t i = 0; i < tokens.size(); i++) {
+        if (tokens[i].distance == 0) {
+            litFreqs[tokens[i].value]++;
+        } else {
+            litFreqs[257 + lengthSymbol(tokens[i].value)]++;
+            distFreqs[distanceSymbol(tokens[i].distance)]++;
+        }
+    }
+    litFreqs[256] = 1;
+    std::vector<uint8_t> litLengths, distLengths;
+    buildCodeLengths(litFreqs, 15, litLengths);
+    buildCodeLengths(distFreqs, 15, distLengths);
+    std::vector<uint16_t> litCodes, distCodes;
+    buildReversedCodes(litLengths, litCodes);
+    buildReversedCodes(distLengths, distCodes);
+
+    int nlit = 286;
+    while (nlit > 257 && litLengths[nlit - 1] == 0) nlit--;
+    int ndist = 30;
+    while (ndist > 1 && distLengths[ndist - 1] == 0) ndist--;
+
+    // run-length encode the concatenated code lengths with symbols 16/17/18
+    std::vector<uint8_t> all(litLengths.begin(), litLengths.begin() + nlit);
+    all.insert(all.end(), distLengths.begin(), distLengths.begin() + ndist);
+    std::vector<int> rle;   // (symbol << 8) | extra bits value
+    for (size_t i = 0; i < all.size();) {
+        size_t run = 1;
+        while (i + run < all.size() && all[i + run] == all[i]) run++;
+        if (all[i] == 0 && run >= 3) {
+            run = std::min(run, (size_t) 138);
+            rle.push_back(run >= 11 ? (18 << 8) | (int) (run - 11) : (17 << 8) | (int) (run - 3));
+        } else if (all[i] != 0 && run >= 4) {
+            run = std::min(run, (size_t) 7);
+            rle.push_back(all[i] << 8);
+            rle.push_back((16 << 8) | (int) (run - 4));
+        } else {
+            run = 1;
+            rle.push_back(all[i] << 8);
+        }
+        i += run;
+    }
+    std::vector<uint32_t> clFreqs(19, 0);
+    for (size_t i = 0; i < rle.size(); i++) {
+        clFreqs[rle[i] >> 8]++;
+    }
+    std::vector<uint8_t> clLengths;
+    buildCodeLengths(clFreqs, 7, clLengths);
+    std::vector<uint16_t> clCodes;
+    buildReversedCodes(clLengths, clCodes);
+    int ncode = 19;
+    while (ncode > 4 && clLengths[CODE_LENGTH_ORDER[ncode - 1]] == 0) ncode--;
+
+    out.putBits(last ? 1 : 0, 1);
+    out.putBits(2, 2);
+    out.putBits(nlit - 257, 5);
+    out.putBits(ndist - 1, 5);
+    out.putBits(ncode - 4, 4);
+    for (int i = 0; i < ncode; i++) {
+        out.putBits(clLengths[CODE_LENGTH_ORDER[i]], 3);
+    }
+    for (size_t i = 0; i < rle.size(); i++) {
+        int symbol = rle[i] >> 8;
+        out.putBits(clCodes[symbol], clLengths[symbol]);
+        if (symbol == 16) out.putBits(rle[i] & 0xff, 2);
+        else if (symbol == 17) out.putBits(rle[i] & 0xff, 3);
+        else if (symbol == 18) out.putBits(rle[i] & 0xff, 7);
+    }
+
+    for (size_t i = 0; i < tokens.size(); i++) {
+        const DeflateToken& token = tokens[i];
+        if (token.distance == 0) {
+            out.putBits(litCodes[token.value], litLengths[token.value]);
+        } else {
+            int ls = lengthSymbol(token.value);
+            out.putBits(litCodes[257 + ls], litLengths[257 + ls]);
+            out.putBits(token.value - INFLATE_LENGTH_BASE[ls], INFLATE_LENGTH_EXTRA[ls]);
+            int ds = distanceSymbol(token.distance);
+            out.putBits(distCodes[ds], distLengths[ds]);
+            out.putBits(token.distance - INFLATE_DIST_BASE[ds], INFLATE_DIST_EXTRA[ds]);
+        }
+    }
+    out.putBits(litCodes[256], litLengths[256]);
+}
+
+/*
+ * Compresses the given bytes into a zlib stream using greedy LZ77 matching
+ * over hash chains and a dynamic Huffman code per block.
+ */
+static std::string zlibDeflate(const uint8_t* data, size_t length) {
+    static const int WINDOW = 32768;
+    static const int HASH_SIZE = 1 << 15;
+    static const int MAX_CHAIN = 16;
+    static const size_t TOKENS_PER_BLOCK = 1 << 16;
+
+    std::string result;
+    result += (char) 0x78;
+    result += (char) 0x5e;
+    DeflateBitWriter out(result);
+    std::vector<int> head(HASH_SIZE, -1);
+    std::vector<int> prev(WINDOW, -1);
+    std::vector<DeflateToken> tokens;
+    tokens.reserve(TOKENS_PER_BLOCK);
+
+    size_t pos = 0;
+    while (pos < length) {
+        int bestLength = 0, bestDistance = 0;
+        if (pos + 3 <= length) {
+            int hash = ((data[pos] << 10) ^ (data[pos + 1] << 5) ^ data[pos + 2]) & (HASH_SIZE - 1);
+            int candidate = head[hash];
+            int maxLength = (int) std::min((size_t) 258, length - pos);
+            for (int chain = 0; candidate >= 0 && chain < MAX_CHAIN; chain++) {
+                int distance = (int) (pos - candidate);
+                if (distance > WINDOW - 1) break;
+                if (data[candidate + bestLength] == data[pos + bestLength]) {
+                    int len = 0;
+                    while (len < maxLength && data[candidate + len] == data[pos + len]) len++;
+                    if (len > bestLength) {
+                        bestLength = len;
+                        bestDistance = distance;
+                        if (len == maxLength) break;
+                    }
+                }
+                int next = prev[candidate & (WINDOW - 1)];
+                if (next >= candidate) break;
+                candidate = next;
+            }
+        }
+        int advance = 1;
+        DeflateToken token;
+        if (bestLength >= 3) {
+            token.value = (uint16_t) bestLength;
+            token.distance = (uint16_t) bestDistance;
+            advance = bestLength;
+        } else {
+            token.value = data[pos];
+            token.distance = 0;
+        }
+        tokens.push_back(token);
+        for (int i = 0; i < advance; i++, pos++) {
+            if (pos + 3 <= length) {
+                int hash = ((data[pos] << 10) ^ (data[pos + 1] << 5) ^ data[pos + 2]) & (HASH_SIZE - 1);
+                prev[pos & (WINDOW - 1)] = head[hash];
+                head[hash] = (int) pos;
+            }
+        }
+        if (tokens.size() >= TOKENS_PER_BLOCK) {
+            writeDynamicBlock(out, tokens, pos >= length);
+            tokens.clear();
+        }
+    }
+    if (!tokens.empty() || length == 0) {
+        writeDynamicBlock(out, tokens, true);
+    }
+    out.flush();
+    appendBigEndian32(result, adler32(data, length));
+    return result;
+}
+
+
+/* ===================== PNG ===================== */
+
+static const uint8_t PNG_SIGNATURE[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+
+static inline int paethPredictor(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    if (pb <= pc) return b;
+    return c;
+}
+
+/*
+ * Reverses the PNG filter on one scanline in place, given the previous
+ * (already unfiltered) scanline or NULL for the first line.
+ */
+static void unfilterScanline(int filter, uint8_t* line, const uint8_t* prior, int length, int bpp) {
+    switch (filter) {
+    case 0:
+        break;
+    case 1:
+        for (int i = bpp; i < length; i++) line[i] += line[i - bpp];
+        break;
+    case 2:
+        if (prior) for (int i = 0; i < length; i++) line[i] += prior[i];
+        break;
+    case 3:
+        for (int i = 0; i < length; i++) {
+            int left = i >= bpp ? line[i - bpp] : 0;
+            int up = prior ? prior[i] : 0;
+            line[i] += (uint8_t) ((left + up) >> 1);
+        }
+        break;
+    case 4:
+        for (int i = 0; i < length; i++) {
+            int left = i >= bpp ? line[i - bpp] : 0;
+            int up = prior ? prior[i] : 0;
+            int upLeft = (prior && i >= bpp) ? prior[i - bpp] : 0;
+            line[i] += (uint8_t) paethPredictor(left, up, upLeft);
+        }
+        break;
+    default:
+        error("imagecodec::decode: PNG data has an invalid filter type");
+    }
+}
+
+static inline int pngSample(const uint8_t* line, int index, int depth) {
+    if (depth == 8) return line[index];
+    if (depth == 16) return line[index * 2];   // keep the most significant byte
+    int bitPos = index * depth;
+    return (line[bitPos >> 3] >> (8 - depth - (bitPos & 7))) & ((1 << depth) - 1);
+}
+
+static void decodePng(const uint8_t* data, size_t length, Image& image) {
+    checkAvailable(0, 8, length, "PNG");
+    if (std::memcmp(data, PNG_SIGNATURE, 8) != 0) {
+        error("imagecodec::decode: invalid PNG signature");
+    }
+    size_t pos = 8;
+    int width = 0, height = 0, depth = 0, colorType = -1, interlace = 0;
+    std::vector<int> palette;
+    std::string idat;
+    bool sawHeader = false, sawEnd = false;
+    while (!sawEnd) {
+        checkAvailable(pos, 12, length, "PNG");
+        uint32_t chunkLength = readBigEndian32(data + pos);
+        std::string type((const char*) data + pos + 4, 4);
+        pos += 8;
+        checkAvailable(pos, (size_t) chunkLength + 4, length, "PNG");
+        const uint8_t* chunk = data + pos;
+        if (type == "IHDR") {
+            if (chunkLength < 13) error("imagecodec::decode: PNG header is too short");
+            width = (int) readBigEndian32(chunk);
+            height = (int) readBigEndian32(chunk + 4);
+            depth = chunk[8];
+            colorType = chunk[9];
+            interlace = chunk[12];
+            if (chunk[10] != 0 || chunk[11] != 0 || interlace > 1) {
+                throw UnsupportedFeature();
+            }
+            sawHeader = true;
+        } else if (type == "PLTE") {
+            for (uint32_t i = 0; i + 2 < chunkLength; i += 3) {
+                palette.push_back(rgb(chunk[i], chunk[i + 1], chunk[i + 2]));
+            }
+        } else if (type == "IDAT") {
+            idat.append((const char*) chunk, chunkLength);
+        } else if (type == "IEND") {
+            sawEnd = true;
+        } else if (!(type[0] & 0x20)) {
+            // an unknown chunk that is marked critical
+            throw UnsupportedFeature();
+        }
+        pos += chunkLength + 4;   // skip data and CRC
+    }
+    if (!sawHeader) {
+        error("imagecodec::decode: PNG data has no header");
+    }
+
+    int channels;
+    bool validDepth;
+    switch (colorType) {
+    case 0: channels = 1; validDepth = depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16; break;
+    case 2: channels = 3; validDepth = depth == 8 || depth == 16; break;
+    case 3: channels = 1; validDepth = depth == 1 || depth == 2 || depth == 4 || depth == 8; break;
+    case 4: channels = 2; validDepth = depth == 8 || depth == 16; break;
+    case 6: channels = 4; validDepth = depth == 8 || depth == 16; break;
+    default: channels = 0; validDepth = false; break;
+    }
+    if (!validDepth) {
+        error("imagecodec::decode: PNG data has an invalid color type/bit depth");
+    }
+    if (colorType == 3 && palette.empty()) {
+        error("imagecodec::decode: PNG data is missing its palette");
+    }
+    checkImageSize(width, height);
+    size_t rawBits = (size_t) width * height * channels * depth;
+    if (idat.size() * MAX_DEFLATE_RATIO < rawBits / 8) {
+        error("imagecodec::decode: PNG data is truncated");
+    }
+    image.resize(width, height);
+
+    std::vector<uint8_t> raw;
+    raw.reserve((size_t) height * ((size_t) width * channels * depth / 8 + 2));
+    zlibInflate((const uint8_t*) idat.data(), idat.size(), raw);
+
+    static const int X_START[7] = {0, 4, 0, 2, 0, 1, 0};
+    static const int Y_START[7] = {0, 0, 4, 0, 2, 0, 1};
+    static const int X_STEP[7]  = {8, 8, 4, 4, 2, 2, 1};
+    static const int Y_STEP[7]  = {8, 8, 8, 4, 4, 2, 2};
+    int passes = interlace ? 7 : 1;
+    int bpp = std::max(1, channels * depth / 8);
+    int grayMax = (1 << std::min(depth, 8)) - 1;
+    size_t offset = 0;
+    for (int pass = 0; pass < passes; pass++) {
+        int x0 = interlace ? X_START[pass] : 0;
+        int y0 = interlace ? Y_START[pass] : 0;
+        int dx = interlace ? X_STEP[pass] : 1;
+        int dy = interlace ? Y_STEP[pass] : 1;
+        int passWidth = width > x0 ? (width - x0 + dx - 1) / dx : 0;
+        int passHeight = height > y0 ? (height - y0 + dy - 1) / dy : 0;
+        if (passWidth == 0 || passHeight == 0) continue;
+        int lineBytes = (int) (((size_t) passWidth * channels * depth + 7) / 8);
+        const uint8_t* prior = NULL;
+        for (int py = 0; py < passHeight; py++) {
+            if (offset + 1 + lineBytes > raw.size()) {
+                error("imagecodec::decode: PNG image data is truncated");
+            }
+            uint8_t* line = &raw[offset + 1];
+            unfilterScanline(raw[offset], line, prior, lineBytes, bpp);
+            prior = line;
+            offset += 1 + lineBytes;
+
+            int* outRow = &image.pixels[(size_t) (y0 + py * dy) * width];
+            for (int px = 0, x = x0; px < passWidth; px++, x += dx) {
+                int value;
+                if (colorType == 0 || colorType == 4) {
+                    int gray = pngSample(line, px * channels, depth);
+                    if (depth < 8) gray = gray * 255 / grayMax;
+                    value = rgb(gray, gray, gray);
+                } else if (colorType == 3) {
+                    int index = pngSample(line, px, depth);
+                    value = index < (int) palette.size() ? palette[index] : 0;
+                } else {
+                    value = rgb(pngSample(line, px * channels, depth),
+                                pngSample(line, px * channels + 1, depth),
+                                pngSample(line, px * channels + 2, depth));
+                }
+                outRow[x] = value;
+            }
+        }
+    }
+}
+
+static void appendPngChunk(std::string& out, const char* type, const std::string& data) {
+    appendBigEndian32(out, data.size());
+    std::string typeAndData = std::string(type, 4) + data;
+    out += typeAndData;
+    appendBigEndian32(out, crc32((const uint8_t*) typeAndData.data(), typeAndData.size()));
+}
+
+static std::string encodePng(const Image& image) {
+    int width = image.width, height = image.height;
+    size_t lineBytes = (size_t) width * 3;
+    std::vector<uint8_t> raw((lineBytes + 1) * height);
+    std::vector<uint8_t> current(lineBytes), previous(lineBytes, 0), candidate(lineBytes);
+    for (int y = 0; y < height; y++) {
+        const int* row = &image.pixels[(size_t) y * width];
+        for (int x = 0; x < width; x++) {
+            current[3 * x] = (uint8_t) (row[x] >> 16);
+            current[3 * x + 1] = (uint8_t) (row[x] >> 8);
+            current[3 * x + 2] = (uint8_t) row[x];
+        }
+        // choose the filter with the smallest sum of absolute residuals
+        uint8_t* dest = &raw[y * (lineBytes + 1)];
+        long bestScore = -1;
+        for (int filter = 0; filter < 5; filter++) {
+            long score = 0;
+            for (size_t i = 0; i < lineBytes; i++) {
+                int left = i >= 3 ? current[i - 3] : 0;
+                int up = y > 0 ? previous[i] : 0;
+                int upLeft = (y > 0 && i >= 3) ? previous[i - 3] : 0;
+                int predicted = 0;
+                switch (filter) {
+                case 1: predicted = left; break;
+                case 2: predicted = up; break;
+                case 3: predicted = (left + up) >> 1; break;
+                case 4: predicted = paethPredictor(left, up, upLeft); break;
+                }
+                candidate[i] = (uint8_t) (current[i] - predicted);
+                score += (int8_t) candidate[i] < 0 ? -(int8_t) candidate[i] : candidate[i];
+            }
+            if (bestScore < 0 || score < bestScore) {
+                bestScore = score;
+                dest[0] = (uint8_t) filter;
+                if (lineBytes > 0) std::memcpy(dest + 1, &candidate[0], lineBytes);
+            }
+        }
+        previous.swap(current);
+    }
+
+    std::string out((const char*) PNG_SIGNATURE, 8);
+    std::string header;
+    appendBigEndian32(header, width);
+    appendBigEndian32(header, height);
+    header += (char) 8;   // bit depth
+    header += (char) 2;   // color type: RGB
+    header += (char) 0;   // compression
+    header += (char) 0;   // filter method
+    header += (char) 0;   // no interlace
+    appendPngChunk(out, "IHDR", header);
+    appendPngChunk(out, "IDAT", zlibDeflate(&raw[0], raw.size()));
+    appendPngChunk(out, "IEND", "");
+    return out;
+}
+
+
+/* ===================== JPEG ===================== */
+
+// maps zig-zag order index to natural (row-major) coefficient index
+static const int JPEG_ZIGZAG[64 + 16] = {
+     0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+    // extra entries so that corrupt run lengths cannot index out of bounds
+    63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63
+};
+
+// scale factors of the AAN (Arai, Agui, Nakajima) DCT
+static const float JPEG_AAN_SCALE[8] = {
+    1.0f, 1.387039845f, 1.306562965f, 1.175875602f,
+    1.0f, 0.785694958f, 0.541196100f, 0.275899379f
+};
+
+/*
+ * A Huffman decoding table for JPEG entropy-coded data.
+ */
+struct JpegHuffman {
+    static const int FAST_BITS = 9;
+    uint8_t fastLength[1 << FAST_BITS];   // 0 if the code is longer
+    uint8_t fastSymbol[1 << FAST_BITS];
+    int maxCode[18];       // largest code of each length, left-aligned in 16 bits
+    int valueOffset[17];   // index in values of the first code of each length
+    int firstCode[17];
+    uint8_t values[256];
+    bool defined;
+
+    JpegHuffman() : defined(false) {}
+
+    void build(const uint8_t* counts, const uint8_t* symbols, int total) {
+        std::memcpy(values, symbols, total);
+        std::memset(fastLength, 0, sizeof(fastLength));
+        int code = 0, k = 0;
+        for (int len = 1; len <= 16; len++) {
+            valueOffset[len] = k;
+            firstCode[len] = code;
+            if (code + counts[len - 1] > (1 << len)) {
+                error("imagecodec::decode: JPEG data has an invalid Huffman table");
+            }
+            for (int i = 0; i < counts[len - 1]; i++, k++, code++) {
+                if (len <= FAST_BITS) {
+                    int shift = FAST_BITS - len;
+                    for (int fill = 0; fill < (1 << shift); fill++) {
+                        fastLength[(code << shift) | fill] = (uint8_t) len;
+                        fastSymbol[(code << shift) | fill] = values[k];
+                    }
+                }
+            }
+            maxCode[len] = counts[len - 1] ? (code - 1) : -1;
+            code <<= 1;
+        }
+        maxCode[17] = 0x7fffffff;
+        defined = true;
+    }
+};
+
+/*
+ * Reads JPEG entropy-coded bits most-significant first, removing stuffed
+ * zero bytes and stopping (by supplying zero bits) at the next marker.
+ */
+class JpegBitReader {
+public:
+    JpegBitReader(const uint8_t* data, size_t length, size_t pos)
+        : data(data), length(length), pos(pos), buffer(0), count(0), atMarker(false) {}
+
+    void refill() {
+        while (count <= 24) {
+            uint32_t b = 0;
+            if (!atMarker && pos < length) {
+                b = data[pos];
+                if (b == 0xff) {
+                    int next = pos + 1 < length ? data[pos + 1] : 0xd9;
+                    if (next == 0) {
+                        pos += 2;
+                    } else {
+                        atMarker = true;
+                        b = 0;
+                    }
+                } else {
+                    pos++;
+                }
+            }
+            buffer |= b << (24 - count);
+            count += 8;
+        }
+    }
+
+    int getBits(int n) {
+        if (n == 0) return 0;
+        if (count < n) refill();
+        int value = (int) (buffer >> (32 - n));
+        buffer <<= n;
+        count -= n;
+        return value;
+    }
+
+    int getBit() {
+        return getBits(1);
+    }
+
+    /*
+     * Reads an n-bit magnitude and sign-extends it as in section F.2.2.1.
+     */
+    int receiveExtend(int n) {
+        if (n == 0) return 0;
+        if (n > 16) {
+            error("imagecodec::decode: JPEG data has an invalid coefficient size");
+        }
+        int value = getBits(n);
+        return value < (1 << (n - 1)) ? value - (1 << n) + 1 : value;
+    }
+
+    int decode(const JpegHuffman& table) {
+        if (!table.defined) {
+            error("imagecodec::decode: JPEG scan uses an undefined Huffman table");
+        }
+        if (count < 16) refill();
+        int peek = (int) (buffer >> (32 - JpegHuffman::FAST_BITS));
+        int len = table.fastLength[peek];
+        if (len) {
+            buffer <<= len;
+            count -= len;
+            return table.fastSymbol[peek];
+        }
+        int code16 = (int) (buffer >> 16);
+        for (len = JpegHuffman::FAST_BITS + 1; len <= 16; len++) {
+            int code = code16 >> (16 - len);
+            if (code <= table.maxCode[len]) {
+                buffer <<= len;
+                count -= len;
+                return table.values[table.valueOffset[len] + code - table.firstCode[len]];
+            }
+        }
+        error("imagecodec::decode: JPEG data has an invalid Huffman code");
+        return 0;
+    }
+
+    /*
+     * Discards buffered bits and skips the restart marker that must follow.
+     */
+    void restart() {
+        buffer = 0;
+        count = 0;
+        atMarker = false;
+        while (pos + 1 < length && !(data[pos] == 0xff && data[pos + 1] >= 0xd0 && data[pos + 1] <= 0xd7)) {
+            pos++;
+        }
+        pos += 2;
+    }
+
+    size_t position() const {
+        return pos;
+    }
+
+private:
+    const uint8_t* data;
+    size_t length;
+    size_t pos;
+    uint32_t buffer;
+    int count;
+    bool atMarker;
+};
+
+struct JpegComponent {
+    int id;
+    int h, v;              // sampling factors
+    int quantTable;
+    int dcTable, acTable;
+    int blocksPerLine;     // blocks in the padded (whole-MCU) plane
+    int blocksPerColumn;
+    int width, height;     // samples actually covering the image
+    int dcPredictor;
+    std::vector<int16_t> coefficients;   // 64 per block, natural order
+    std::vector<uint8_t> plane;          // blocksPerLine*8 wide
+};
+
+class JpegDecoder {
+public:
+    JpegDecoder(const uint8_t* data, size_t length)
+        : data(data), length(length), width(0), height(0), progressive(false),
+          restartInterval(0), adobeTransform(-1), sawJfif(false), eobRun(0) {
+        std::memset(quant, 0, sizeof(quant));
+    }
+
+    void decode(Image& image) {
+        checkAvailable(0, 2, length, "JPEG");
+        if (data[0] != 0xff || data[1] != 0xd8) {
+            error("imagecodec::decode: invalid JPEG signature");
+        }
+        size_t pos = 2;
+        bool sawFrame = false, done = false;
+        while (!done) {
+            // find the next marker, skipping any fill bytes
+            while (pos < length && data[pos] != 0xff) pos++;
+            while (pos < length && data[pos] == 0xff) pos++;
+            if (pos >= length) {
+                if (sawFrame) break;   // tolerate a missing EOI
+                error("imagecodec::decode: JPEG data is truncated");
+            }
+            int marker = data[pos++];
+            if (marker == 0xd9) {
+                break;
+            } else if (marker >= 0xd0 && marker <= 0xd7) {
+                continue;   // stray restart marker
+            }
+            checkAvailable(pos, 2, length, "JPEG");
+            int segmentLength = readBigEndian16(data + pos);
+            checkAvailable(pos, segmentLength, length, "JPEG");
+            if (segmentLength < 2) {
+                error("imagecodec::decode: JPEG segment has an invalid length");
+            }
+            const uint8_t* segment = data + pos + 2;
+            int n = segmentLength - 2;
+            switch (marker) {
+            case 0xc0: case 0xc1: case 0xc2:
+                readFrame(segment, n, marker == 0xc2);
+                sawFrame = true;
+                break;
+            case 0xc3: case 0xc5: case 0xc6: case 0xc7:
+            case 0xc9: case 0xca: case 0xcb: case 0xcd: case 0xce: case 0xcf:
+                // lossless, hierarchical, or arithmetic-coded
+                throw UnsupportedFeature();
+            case 0xc4:
+                readHuffmanTables(segment, n);
+                break;
+            case 0xdb:
+                readQuantTables(segment, n);
+                break;
+            case 0xdd:
+                if (n < 2) error("imagecodec::decode: JPEG restart interval is too short");
+                restartInterval = readBigEndian16(segment);
+                break;
+            case 0xda:
+                if (!sawFrame) error("imagecodec::decode: JPEG scan precedes frame header");
+                pos = readScan(segment, n, pos + segmentLength);
+                continue;
+            case 0xe0:
+                if (n >= 5 && std::memcmp(segment, "JFIF\0", 5) == 0) sawJfif = true;
+                break;
+            case 0xee:
+                if (n >= 12 && std::memcmp(segment, "Adobe", 5) == 0) adobeTransform = segment[11];
+                break;
+            default:
+                break;   // APPn, COM, etc.
+            }
+            pos += segmentLength;
+        }
+        if (!sawFrame) {
+            error("imagecodec::decode: JPEG data has no frame header");
+        }
+        if (progressive) {
+            for (size_t c = 0; c < components.size(); c++) {
+                JpegComponent& comp = components[c];
+                for (int row = 0; row < comp.blocksPerColumn; row++) {
+                    for (int col = 0; col < comp.blocksPerLine; col++) {
+                        int16_t* coefs = &comp.coefficients[64 * (row * comp.blocksPerLine + col)];
+                        int block[64];
+                        for (int i = 0; i < 64; i++) {
+                            block[i] = coefs[i] * quant[comp.quantTable][i];
+                        }
+                        idctBlock(block, comp, row, col);
+                    }
+                }
+            }
+        }
+        convertToRgb(image);
+    }
+
+private:
+    const uint8_t* data;
+    size_t length;
+    int width, height;
+    bool progressive;
+    int restartInterval;
+    int adobeTransform;
+    bool sawJfif;
+    int maxH, maxV;
+    int mcusPerLine, mcusPerColumn;
+    int eobRun;
+    std::vector<JpegComponent> components;
+    JpegHuffman dcTables[4];
+    JpegHuffman acTables[4];
+    int quant[4][64];   // natural order
+
+    void readFrame(const uint8_t* p, int n, bool isProgressive) {
+        if (n < 6) error("imagecodec::decode: JPEG frame header is too short");
+        if (p[0] != 8) throw UnsupportedFeature();   // 12-bit precision
+        height = readBigEndian16(p + 1);
+        width = readBigEndian16(p + 3);
+        int count = p[5];
+        if (height == 0) throw UnsupportedFeature();   // height given by DNL marker
+        if (count != 1 && count != 3) throw UnsupportedFeature();   // e.g. CMYK
+        if (n < 6 + 3 * count) error("imagecodec::decode: JPEG frame header is too short");
+        checkImageSize(width, height);
+        progressive = isProgressive;
+        components.resize(count);
+        maxH = maxV = 1;
+        for (int i = 0; i < count; i++) {
+            JpegComponent& comp = components[i];
+            comp.id = p[6 + 3 * i];
+            comp.h = p[7 + 3 * i] >> 4;
+            comp.v = p[7 + 3 * i] & 15;
+            comp.quantTable = p[8 + 3 * i] & 3;
+            if (comp.h < 1 || comp.h > 4 || comp.v < 1 || comp.v > 4) {
+                error("imagecodec::decode: JPEG component has invalid sampling factors");
+            }
+            maxH = std::max(maxH, comp.h);
+            maxV = std::max(maxV, comp.v);
+        }
+        mcusPerLine = (width + 8 * maxH - 1) / (8 * maxH);
+        mcusPerColumn = (height + 8 * maxV - 1) / (8 * maxV);
+        for (int i = 0; i < count; i++) {
+            JpegComponent& comp = components[i];
+            comp.width = (width * comp.h + maxH - 1) / maxH;
+            comp.height = (height * comp.v + maxV - 1) / maxV;
+            comp.blocksPerLine = mcusPerLine * comp.h;
+            comp.blocksPerColumn = mcusPerColumn * comp.v;
+            comp.plane.assign((size_t) comp.blocksPerLine * comp.blocksPerColumn * 64, 0);
+            if (progressive) {
+                comp.coefficients.assign((size_t) comp.blocksPerLine * comp.blocksPerColumn * 64, 0);
+            }
+        }
+    }
+
+    void readHuffmanTables(const uint8_t* p, int n) {
+        int i = 0;
+        while (i + 17 <= n) {
+            int tableClass = p[i] >> 4;
+            int index = p[i] & 3;
+            const uint8_t* counts = p + i + 1;
+            int total = 0;
+            for (int len = 0; len < 16; len++) total += counts[len];
+            if (total > 256 || i + 17 + total > n) {
+                error("imagecodec::decode: JPEG Huffman table is malformed");
+            }
+            JpegHuffman& table = tableClass == 0 ? dcTables[index] : acTables[index];
+            table.build(counts, p + i + 17, total);
+            i += 17 + total;
+        }
+    }
+
+    void readQuantTables(const uint8_t* p, int n) {
+        int i = 0;
+        while (i < n) {
+            int precision = p[i] >> 4;
+            int index = p[i] & 3;
+            i++;
+            if (i + 64 * (precision + 1) > n) {
+                error("imagecodec::decode: JPEG quantization table is malformed");
+            }
+            for (int k = 0; k < 64; k++) {
+                int value = precision ? readBigEndian16(p + i + 2 * k) : p[i + k];
+                quant[index][JPEG_ZIGZAG[k]] = value;
+            }
+            i += 64 * (precision + 1);
+        }
+    }
+
+    /*
+     * Decodes one scan whose header is at p; returns the position just
+     * after its entropy-coded data.
+     */
+    size_t readScan(const uint8_t* p, int n, size_t dataStart) {
+        if (n < 1 || n < 1 + 2 * p[0] + 3) {
+            error("imagecodec::decode: JPEG scan header is too short");
+        }
+        int count = p[0];
+        std::vector<JpegComponent*> scanComps;
+        for (int i = 0; i < count; i++) {
+            int id = p[1 + 2 * i];
+            JpegComponent* comp = NULL;
+            for (size_t c = 0; c < components.size(); c++) {
+                if (components[c].id == id) comp = &components[c];
+            }
+            if (!comp) error("imagecodec::decode: JPEG scan names an unknown component");
+            comp->dcTable = p[2 + 2 * i] >> 4 & 3;
+            comp->acTable = p[2 + 2 * i] & 3;
+            scanComps.push_back(comp);
+        }
+        int spectralStart = p[1 + 2 * count];
+        int spectralEnd = p[2 + 2 * count];
+        int successiveHigh = p[3 + 2 * count] >> 4;
+        int successiveLow = p[3 + 2 * count] & 15;
+        if (!progressive) {
+            spectralStart = 0;
+            spectralEnd = 63;
+        } else if (spectralStart > spectralEnd || spectralEnd > 63
+                   || (spectralStart == 0 && spectralEnd != 0)) {
+            error("imagecodec::decode: JPEG progressive scan has an invalid spectral range");
+        }
+
+        JpegBitReader in(data, length, dataStart);
+        for (size_t c = 0; c < scanComps.size(); c++) {
+            scanComps[c]->dcPredictor = 0;
+        }
+        eobRun = 0;
+
+        int unitsPerLine, unitsPerColumn;
+        if (scanComps.size() == 1) {
+            unitsPerLine = (scanComps[0]->width + 7) / 8;
+            unitsPerColumn = (scanComps[0]->height + 7) / 8;
+        } else {
+            unitsPerLine = mcusPerLine;
+            unitsPerColumn = mcusPerColumn;
+        }
+        int total = unitsPerLine * unitsPerColumn;
+        for (int unit = 0; unit < total; unit++) {
+            if (restartInterval > 0 && unit > 0 && unit % restartInterval == 0) {
+                in.restart();
+                for (size_t c = 0; c < scanComps.size(); c++) {
+                    scanComps[c]->dcPredictor = 0;
+                }
+                eobRun = 0;
+            }
+            int unitRow = unit / unitsPerLine;
+            int unitCol = unit % unitsPerLine;
+            for (size_t c = 0; c < scanComps.size(); c++) {
+                JpegComponent& comp = *scanComps[c];
+                int blocksH = scanComps.size() == 1 ? 1 : comp.h;
+                int blocksV = scanComps.size() == 1 ? 1 : comp.v;
+                for (int by = 0; by < blocksV; by++) {
+                    for (int bx = 0; bx < blocksH; bx++) {
+                        int row = unitRow * blocksV + by;
+                        int col = unitCol * blocksH + bx;
+                        if (progressive) {
+                            int16_t* coefs = &comp.coefficients[64 * (row * comp.blocksPerLine + col)];
+                            if (spectralStart == 0) {
+                                decodeDcProgressive(in, comp, coefs, successiveHigh, successiveLow);
+                            } else if (successiveHigh == 0) {
+                                decodeAcFirst(in, comp, coefs, spectralStart, spectralEnd, successiveLow);
+                            } else {
+                                decodeAcRefine(in, comp, coefs, spectralStart, spectralEnd, successiveLow);
+                            }
+                        } else {
+                            decodeBaselineBlock(in, comp, row, col);
+                        }
+                    }
+                }
+            }
+        }
+        return in.position();
+    }
+
+    void decodeBaselineBlock(JpegBitReader& in, JpegComponent& comp, int row, int col) {
+        int block[64] = {0};
+        const int* q = quant[comp.quantTable];
+        int t = in.decode(dcTables[comp.dcTable]);
+        // coefficients are 16-bit values, so wrap like libjpeg on corrupt data
+        comp.dcPredictor = (int16_t) (comp.dcPredictor + in.receiveExtend(t));
+        block[0] = comp.dcPredictor * q[0];
+        const JpegHuffman& ac = acTables[comp.acTable];
+        for (int k = 1; k < 64;) {
+            int rs = in.decode(ac);
+            int r = rs >> 4, s = rs & 15;
+            if (s == 0) {
+                if (r != 15) break;
+                k += 16;
+                continue;
+            }
+            k += r;
+            int z = JPEG_ZIGZAG[k];
+            block[z] = in.receiveExtend(s) * q[z];
+            k++;
+        }
+        idctBlock(block, comp, row, col);
+    }
+
+    void decodeDcProgressive(JpegBitReader& in, JpegComponent& comp, int16_t* coefs, int high, int low) {
+        if (high == 0) {
+            int t = in.decode(dcTables[comp.dcTable]);
+            // coefficients are 16-bit values, so wrap like libjpeg on corrupt data
+        comp.dcPredictor = (int16_t) (comp.dcPredictor + in.receiveExtend(t));
+            coefs[0] = (int16_t) (comp.dcPredictor * (1 << low));
+        } else if (in.getBit()) {
+            coefs[0] |= (int16_t) (1 << low);
+        }
+    }
+
+    void decodeAcFirst(JpegBitReader& in, JpegComponent& comp, int16_t* coefs, int start, int end, int low) {
+        if (eobRun > 0) {
+            eobRun--;
+            return;
+        }
+        const JpegHuffman& ac = acTables[comp.acTable];
+        for (int k = start; k <= end; k++) {
+            int rs = in.decode(ac);
+            int r = rs >> 4, s = rs & 15;
+            if (s == 0) {
+                if (r < 15) {
+                    eobRun = (1 << r) - 1;
+                    if (r) eobRun += in.getBits(r);
+                    break;
+                }
+                k += 15;
+                continue;
+            }
+            k += r;
+            coefs[JPEG_ZIGZAG[k]] = (int16_t) (in.receiveExtend(s) * (1 << low));
+        }
+    }
+
+    void refineNonZero(JpegBitReader& in, int16_t& coef, int bit) {
+        if (in.getBit() && (coef & bit) == 0) {
+            coef += coef >= 0 ? bit : -bit;
+        }
+    }
+
+    void decodeAcRefine(JpegBitReader& in, JpegComponent& comp, int16_t* coefs, int start, int end, int low) {
+        int bit = 1 << low;
+        int k = start;
+        if (eobRun == 0) {
+            const JpegHuffman& ac = acTables[comp.acTable];
+            for (; k <= end; k++) {
+                int rs = in.decode(ac);
+                int r = rs >> 4, s = rs & 15;
+                int value = 0;
+                if (s) {
+                    value = in.getBit() ? bit : -bit;
+                } else if (r != 15) {
+                    eobRun = 1 << r;
+                    if (r) eobRun += in.getBits(r);
+                    break;
+                }
+                // skip r zero-history coefficients, refining nonzero ones on the way
+                while (k <= end) {
+                    int16_t& coef = coefs[JPEG_ZIGZAG[k]];
+                    if (coef != 0) {
+                        refineNonZero(in, coef, bit);
+                    } else {
+                        if (r == 0) break;
+                        r--;
+                    }
+                    k++;
+                }
+                if (value && k <= end) {
+                    coefs[JPEG_ZIGZAG[k]] = (int16_t) value;
+                }
+            }
+        }
+        if (eobRun > 0) {
+            for (; k <= end; k++) {
+                int16_t& coef = coefs[JPEG_ZIGZAG[k]];
+                if (coef != 0) {
+                    refineNonZero(in, coef, bit);
+                }
+            }
+            eobRun--;
+        }
+    }
+
+    /*
+     * Inverse DCT of one dequantized block (natural order) into the
+     * component's sample plane, using the AAN floating-point algorithm.
+     */
+    void idctBlock(const int* block, JpegComponent& comp, int row, int col) {
+        float work[64];
+        for (int c = 0; c < 8; c++) {
+            const int* in = block + c;
+            if (in[8] == 0 && in[16] == 0 && in[24] == 0 && in[32] == 0
+                    && in[40] == 0 && in[48] == 0 && in[56] == 0) {
+                float dc = in[0] * JPEG_AAN_SCALE[0] * JPEG_AAN_SCALE[c];
+                for (int r = 0; r < 8; r++) work[r * 8 + c] = dc;
+                continue;
+            }
+            float s[8];
+            for (int r = 0; r < 8; r++) {
+                s[r] = in[r * 8] * JPEG_AAN_SCALE[r] * JPEG_AAN_SCALE[c];
+            }
+            idct1d(s);
+            for (int r = 0; r < 8; r++) work[r * 8 + c] = s[r];
+        }
+        int stride = comp.blocksPerLine * 8;
+        uint8_t* out = &comp.plane[(size_t) row * 8 * stride + col * 8];
+        for (int r = 0; r < 8; r++) {
+            float* s = work + r * 8;
+            idct1d(s);
+            for (int c = 0; c < 8; c++) {
+                // descale by 8 and undo the level shift, rounding to nearest
+                out[c] = (uint8_t) clampByte((int) std::floor(s[c] * 0.125f + 128.5f));
+            }
+            out += stride;
+        }
+    }
+
+    static void idct1d(float* s) {
+        float tmp10 = s[0] + s[4];
+        float tmp11 = s[0] - s[4];
+        float tmp13 = s[2] + s[6];
+        float tmp12 = (s[2] - s[6]) * 1.414213562f - tmp13;
+        float tmp0 = tmp10 + tmp13;
+        float tmp3 = tmp10 - tmp13;
+        float tmp1 = tmp11 + tmp12;
+        float tmp2 = tmp11 - tmp12;
+
+        float z13 = s[5] + s[3];
+        float z10 = s[5] - s[3];
+        float z11 = s[1] + s[7];
+        float z12 = s[1] - s[7];
+        float tmp7 = z11 + z13;
+        tmp11 = (z11 - z13) * 1.414213562f;
+        float z5 = (z10 + z12) * 1.847759065f;
+        tmp10 = 1.082392200f * z12 - z5;
+        tmp12 = -2.613125930f * z10 + z5;
+        float tmp6 = tmp12 - tmp7;
+        float tmp5 = tmp11 - tmp6;
+        float tmp4 = tmp10 + tmp5;
+
+        s[0] = tmp0 + tmp7;
+        s[7] = tmp0 - tmp7;
+        s[1] = tmp1 + tmp6;
+        s[6] = tmp1 - tmp6;
+        s[2] = tmp2 + tmp5;
+        s[5] = tmp2 - tmp5;
+        s[4] = tmp3 + tmp4;
+        s[3] = tmp3 - tmp4;
+    }
+
+    /*
+     * Produces one full-resolution row of a component's samples, using the
+     * same 'fancy' triangular upsampling as libjpeg for the common 2x1 and
+     * 2x2 chroma subsampling, and pixel replication otherwise.
+     */
+    void upsampleRow(const JpegComponent& comp, int y, uint8_t* out) const {
+        int stride = comp.blocksPerLine * 8;
+        int hs = maxH / comp.h, vs = maxV / comp.v;
+        bool integral = hs * comp.h == maxH && vs * comp.v == maxV;
+        if (integral && hs == 1 && vs == 1) {
+            std::memcpy(out, &comp.plane[(size_t) y * stride], width);
+        } else if (integral && hs == 2 && (vs == 1 || vs == 2) && comp.width > 1) {
+            int sy = y / vs;
+            const uint8_t* in = &comp.plane[(size_t) sy * stride];
+            int n = comp.width;
+            if (vs == 1) {
+                for (int i = 0; i < n && 2 * i < width; i++) {
+                    int left = in[i > 0 ? i - 1 : 0], mid = in[i], right = in[i < n - 1 ? i + 1 : n - 1];
+                    out[2 * i] = (uint8_t) (i == 0 ? mid : (3 * mid + left + 1) >> 2);
+                    if (2 * i + 1 < width) {
+                        out[2 * i + 1] = (uint8_t) (i == n - 1 ? mid : (3 * mid + right + 2) >> 2);
+                    }
+                }
+            } else {
+                int ny = (y & 1) ? std::min(sy + 1, comp.height - 1) : std::max(sy - 1, 0);
+                const uint8_t* near = &comp.plane[(size_t) ny * stride];
+                for (int i = 0; i < n && 2 * i < width; i++) {
+                    int mid = 3 * in[i] + near[i];
+                    int left = i > 0 ? 3 * in[i - 1] + near[i - 1] : mid;
+                    int right = i < n - 1 ? 3 * in[i + 1] + near[i + 1] : mid;
+                    out[2 * i] = (uint8_t) (i == 0 ? (4 * mid + 8) >> 4 : (3 * mid + left + 8) >> 4);
+                    if (2 * i + 1 < width) {
+                        out[2 * i + 1] = (uint8_t) (i == n - 1 ? (4 * mid + 7) >> 4 : (3 * mid + right + 7) >> 4);
+                    }
+                }
+            }
+        } else {
+            int sy = y * comp.v / maxV;
+            const uint8_t* in = &comp.plane[(size_t) sy * stride];
+            for (int x = 0; x < width; x++) {
+                out[x] = in[x * comp.h / maxH];
+            }
+        }
+    }
+
+    void convertToRgb(Image& image) {
+        image.resize(width, height);
+        bool isRgb = false;
+        if (components.size() == 3) {
+            if (adobeTransform >= 0) {
+                isRgb = adobeTransform == 0;
+            } else if (!sawJfif) {
+                isRgb = components[0].id == 'R' && components[1].id == 'G' && components[2].id == 'B';
+            }
+        }
+
+        // fixed-point YCbCr conversion tables, as in libjpeg's jdcolor.c
+        static const int SCALE_BITS = 16;
+        static const int HALF = 1 << (SCALE_BITS - 1);
+        int crToR[256], cbToB[256], crToG[256], cbToG[256];
+        for (int i = 0; i < 256; i++) {
+            int x = i - 128;
+            crToR[i] = (int) ((91881 * x + HALF) >> SCALE_BITS);   // 1.40200
+            cbToB[i] = (int) ((116130 * x + HALF) >> SCALE_BITS);  // 1.77200
+            crToG[i] = -46802 * x;                                   // 0.71414
+            cbToG[i] = -22554 * x + HALF;                            // 0.34414
+        }
+
+        std::vector<uint8_t> rows(components.size() * width);
+        for (int y = 0; y < height; y++) {
+            for (size_t c = 0; c < components.size(); c++) {
+                upsampleRow(components[c], y, &rows[c * width]);
+            }
+            int* out = &image.pixels[(size_t) y * width];
+            if (components.size() == 1) {
+                for (int x = 0; x < width; x++) {
+                    int g = rows[x];
+                    out[x] = rgb(g, g, g);
+                }
+            } else if (isRgb) {
+                for (int x = 0; x < width; x++) {
+                    out[x] = rgb(rows[x], rows[width + x], rows[2 * width + x]);
+                }
+            } else {
+                const uint8_t* yRow = &rows[0];
+                const uint8_t* cbRow = &rows[width];
+                const uint8_t* crRow = &rows[2 * width];
+                for (int x = 0; x < width; x++) {
+                    int luma = yRow[x], cb = cbRow[x], cr = crRow[x];
+                    out[x] = rgb(clampByte(luma + crToR[cr]),
+                                 clampByte(luma + ((cbToG[cb] + crToG[cr]) >> SCALE_BITS)),
+                                 clampByte(luma + cbToB[cb]));
+                }
+            }
+        }
+    }
+};
+
+static void decodeJpeg(const uint8_t* data, size_t length, Image& image) {
+    JpegDecoder decoder(data, length);
+    decoder.decode(image);
+}
+
+// standard tables from Annex K of the JPEG specification
+static const int JPEG_LUMA_QUANT[64] = {
+    16, 11, 10, 16, 24, 40, 51, 61,
+    12, 12, 14, 19, 26, 58, 60, 55,
+    14, 13, 16, 24, 40, 57, 69, 56,
+    14, 17, 22, 29, 51, 87, 80, 62,
+    18, 22, 37, 56, 68, 109, 103, 77,
+    24, 35, 55, 64, 81, 104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103, 99
+};
+static const int JPEG_CHROMA_QUANT[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,
+    18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,
+    47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99
+};
+static const uint8_t JPEG_DC_LUMA_COUNTS[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+static const uint8_t JPEG_DC_CHROMA_COUNTS[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+static const uint8_t JPEG_DC_VALUES[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+static const uint8_t JPEG_AC_LUMA_COUNTS[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+static const uint8_t JPEG_AC_LUMA_VALUES[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+static const uint8_t JPEG_AC_CHROMA_COUNTS[16] = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+static const uint8_t JPEG_AC_CHROMA_VALUES[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+/*
+ * A Huffman encoding table: code and size for each symbol.
+ */
+struct JpegHuffmanEncoder {
+    uint16_t code[256];
+    uint8_t size[256];
+
+    JpegHuffmanEncoder(const uint8_t* counts, const uint8_t* values) {
+        std::memset(size, 0, sizeof(size));
+        int c = 0, k = 0;
+        for (int len = 1; len <= 16; len++) {
+            for (int i = 0; i < counts[len - 1]; i++, k++) {
+                code[values[k]] = (uint16_t) c++;
+                size[values[k]] = (uint8_t) len;
+            }
+            c <<= 1;
+        }
+    }
+};
+
+/*
+ * Writes JPEG entropy-coded bits most-significant first, stuffing a zero
+ * byte after each 0xFF.
+ */
+class JpegBitWriter {
+public:
+    JpegBitWriter(std::string& out) : out(out), buffer(0), count(0) {}
+
+    void putBits(uint32_t value, int n) {
+        buffer = (buffer << n) | (value & ((1u << n) - 1));
+        count += n;
+        while (count >= 8) {
+            uint8_t b = (uint8_t) (buffer >> (count - 8));
+            out += (char) b;
+            if (b == 0xff) out += (char) 0;
+            count -= 8;
+        }
+    }
+
+    void flush() {
+        if (count > 0) putBits(0x7f, 8 - count);   // pad with one bits
+    }
+
+private:
+    std::string& out;
+    uint32_t buffer;
+    int count;
+};
+
+static void writeJpegSegment(std::string& out, int marker, const std::string& body) {
+    out += (char) 0xff;
+    out += (char) marker;
+    appendBigEndian16(out, body.size() + 2);
+    out += body;
+}
+
+/*
+ * Forward DCT (AAN floating-point) of one 8x8 block, in place.
+ */
+static void fdct1d(float* s, int step) {
+    float tmp0 = s[0] + s[7 * step], tmp7 = s[0] - s[7 * step];
+    float tmp1 = s[step] + s[6 * step], tmp6 = s[step] - s[6 * step];
+    float tmp2 = s[2 * step] + s[5 * step], tmp5 = s[2 * step] - s[5 * step];
+    float tmp3 = s[3 * step] + s[4 * step], tmp4 = s[3 * step] - s[4 * step];
+
+    float tmp10 = tmp0 + tmp3, tmp13 = tmp0 - tmp3;
+    float tmp11 = tmp1 + tmp2, tmp12 = tmp1 - tmp2;
+    s[0] = tmp10 + tmp11;
+    s[4 * step] = tmp10 - tmp11;
+    float z1 = (tmp12 + tmp13) * 0.707106781f;
+    s[2 * step] = tmp13 + z1;
+    s[6 * step] = tmp13 - z1;
+
+    tmp10 = tmp4 + tmp5;
+    tmp11 = tmp5 + tmp6;
+    tmp12 = tmp6 + tmp7;
+    float z5 = (tmp10 - tmp12) * 0.382683433f;
+    float z2 = 0.541196100f * tmp10 + z5;
+    float z4 = 1.306562965f * tmp12 + z5;
+    float z3 = tmp11 * 0.707106781f;
+    float z11 = tmp7 + z3, z13 = tmp7 - z3;
+    s[5 * step] = z13 + z2;
+    s[3 * step] = z13 - z2;
+    s[step] = z11 + z4;
+    s[7 * step] = z11 - z4;
+}
+
+static void encodeJpegBlock(JpegBitWriter& out, float* block, const float* divisors, int& dcPredictor,
+                            const JpegHuffmanEncoder& dc, const JpegHuffmanEncoder& ac) {
+    for (int r = 0; r < 8; r++) fdct1d(block + 8 * r, 1);
+    for (int c = 0; c < 8; c++) fdct1d(block + c, 8);
+    int coefs[64];
+    for (int k = 0; k < 64; k++) {
+        int z = JPEG_ZIGZAG[k];
+        float value = block[z] / divisors[z];
+        coefs[k] = (int) (value < 0 ? value - 0.5f : value + 0.5f);
+    }
+
+    int diff = coefs[0] - dcPredictor;
+    dcPredictor = coefs[0];
+    int magnitude = diff < 0 ? -diff : diff;
+    int bits = 0;
+    while (magnitude >> bits) bits++;
+    out.putBits(dc.code[bits], dc.size[bits]);
+    if (bits) out.putBits(diff < 0 ? diff - 1 : diff, bits);
+
+    int run = 0;
+    for (int k = 1; k < 64; k++) {
+        int value = coefs[k];
+        if (value == 0) {
+            run++;
+            continue;
+        }
+        while (run > 15) {
+            out.putBits(ac.code[0xf0], ac.size[0xf0]);
+            run -= 16;
+        }
+        magnitude = value < 0 ? -value : value;
+        bits = 0;
+        while (magnitude >> bits) bits++;
+        int symbol = (run << 4) | bits;
+        out.putBits(ac.code[symbol], ac.size[symbol]);
+        out.putBits(value < 0 ? value - 1 : value, bits);
+        run = 0;
+    }
+    if (run > 0) {
+        out.putBits(ac.code[0], ac.size[0]);
+    }
+}
+
+/*
+ * Encodes a baseline JPEG with 2x2-subsampled chroma (4:2:0).
+ */
+static std::string encodeJpeg(const Image& image, int quality) {
+    quality = std::max(1, std::min(100, quality));
+    int scale = quality < 50 ? 5000 / quality : 200 - 2 * quality;
+    int lumaQuant[64], chromaQuant[64];
+    float lumaDivisors[64], chromaDivisors[64];
+    for (int i = 0; i < 64; i++) {
+        lumaQuant[i] = std::max(1, std::min(255, (JPEG_LUMA_QUANT[i] * scale + 50) / 100));
+        chromaQuant[i] = std::max(1, std::min(255, (JPEG_CHROMA_QUANT[i] * scale + 50) / 100));
+        float aan = JPEG_AAN_SCALE[i / 8] * JPEG_AAN_SCALE[i % 8] * 8.0f;
+        lumaDivisors[i] = lumaQuant[i] * aan;
+        chromaDivisors[i] = chromaQuant[i] * aan;
+    }
+
+    std::string out;
+    out += (char) 0xff;
+    out += (char) 0xd8;
+    writeJpegSegment(out, 0xe0, std::string("JFIF\0\x01\x01\0\0\x01\0\x01\0\0", 14));
+    std::string dqt;
+    dqt += (char) 0;
+    for (int k = 0; k < 64; k++) dqt += (char) lumaQuant[JPEG_ZIGZAG[k]];
+    dqt += (char) 1;
+    for (int k = 0; k < 64; k++) dqt += (char) chromaQuant[JPEG_ZIGZAG[k]];
+    writeJpegSegment(out, 0xdb, dqt);
+
+    std::string sof;
+    sof += (char) 8;
+    appendBigEndian16(sof, image.height);
+    appendBigEndian16(sof, image.width);
+    sof += (char) 3;
+    sof += std::string("\x01\x22\x00\x02\x11\x01\x03\x11\x01", 9);
+    writeJpegSegment(out, 0xc0, sof);
+
+    std::string dht;
+    const uint8_t* tableCounts[4] = {JPEG_DC_LUMA_COUNTS, JPEG_AC_LUMA_COUNTS, JPEG_DC_CHROMA_COUNTS, JPEG_AC_CHROMA_COUNTS};
+    const uint8_t* tableValues[4] = {JPEG_DC_VALUES, JPEG_AC_LUMA_VALUES, JPEG_DC_VALUES, JPEG_AC_CHROMA_VALUES};
+    const int tableIds[4] = {0x00, 0x10, 0x01, 0x11};
+    for (int t = 0; t < 4; t++) {
+        dht += (char) tableIds[t];
+        int total = 0;
+        for (int i = 0; i < 16; i++) {
+            dht += (char) tableCounts[t][i];
+            total += tableCounts[t][i];
+        }
+        dht.append((const char*) tableValues[t], total);
+    }
+    writeJpegSegment(out, 0xc4, dht);
+    writeJpegSegment(out, 0xda, std::string("\x03\x01\x00\x02\x11\x03\x11\x00\x3f\x00", 10));
+
+    JpegHuffmanEncoder dcLuma(JPEG_DC_LUMA_COUNTS, JPEG_DC_VALUES);
+    JpegHuffmanEncoder acLuma(JPEG_AC_LUMA_COUNTS, JPEG_AC_LUMA_VALUES);
+    JpegHuffmanEncoder dcChroma(JPEG_DC_CHROMA_COUNTS, JPEG_DC_VALUES);
+    JpegHuffmanEncoder acChroma(JPEG_AC_CHROMA_COUNTS, JPEG_AC_CHROMA_VALUES);
+    JpegBitWriter bits(out);
+    int yPred = 0, cbPred = 0, crPred = 0;
+    float ys[256], cbs[256], crs[256];
+    for (int my = 0; my < image.height; my += 16) {
+        for (int mx = 0; mx < image.width; mx += 16) {
+            for (int i = 0; i < 256; i++) {
+                int x = std::min(mx + i % 16, image.width - 1);
+                int y = std::min(my + i / 16, image.height - 1);
+                int p = image.pixels[(size_t) y * image.width + x];
+                float r = (float) ((p >> 16) & 0xff), g = (float) ((p >> 8) & 0xff), b = (float) (p & 0xff);
+                ys[i] = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+                cbs[i] = -0.168736f * r - 0.331264f * g + 0.5f * b;
+                crs[i] = 0.5f * r - 0.418688f * g - 0.081312f * b;
+            }
+            for (int block = 0; block < 4; block++) {
+                float samples[64];
+                int bx = (block & 1) * 8, by = (block >> 1) * 8;
+                for (int i = 0; i < 64; i++) {
+                    samples[i] = ys[(by + i / 8) * 16 + bx + i % 8];
+                }
+                encodeJpegBlock(bits, samples, lumaDivisors, yPred, dcLuma, acLuma);
+            }
+            float cb[64], cr[64];
+            for (int i = 0; i < 64; i++) {
+                int top = (i / 8) * 32 + (i % 8) * 2;
+                cb[i] = (cbs[top] + cbs[top + 1] + cbs[top + 16] + cbs[top + 17]) * 0.25f;
+                cr[i] = (crs[top] + crs[top + 1] + crs[top + 16] + crs[top + 17]) * 0.25f;
+            }
+            encodeJpegBlock(bits, cb, chromaDivisors, cbPred, dcChroma, acChroma);
+            encodeJpegBlock(bits, cr, chromaDivisors, crPred, dcChroma, acChroma);
+        }
+    }
+    bits.flush();
+    out += (char) 0xff;
+    out += (char) 0xd9;
+    return out;
+}
+
+
+/* ===================== GIF ===================== */
+
+static void decodeGif(const uint8_t* data, size_t length, Image& image) {
+    checkAvailable(0, 13, length, "GIF");
+    if (std::memcmp(data, "GIF87a", 6) != 0 && std::memcmp(data, "GIF89a", 6) != 0) {
+        error("imagecodec::decode: invalid GIF signature");
+    }
+    std::vector<int> globalPalette;
+    int flags = data[10];
+    size_t pos = 13;
+    if (flags & 0x80) {
+        int size = 2 << (flags & 7);
+        checkAvailable(pos, 3 * size, length, "GIF");
+        for (int i = 0; i < size; i++, pos += 3) {
+            globalPalette.push_back(rgb(data[pos], data[pos + 1], data[pos + 2]));
+        }
+    }
+    while (true) {
+        checkAvailable(pos, 1, length, "GIF");
+        int block = data[pos++];
+        if (block == 0x21) {
+            // extension: label, then data sub-blocks
+            checkAvailable(pos, 1, length, "GIF");
+            pos++;
+            while (true) {
+                checkAvailable(pos, 1, length, "GIF");
+                int size = data[pos++];
+                if (size == 0) break;
+                pos += size;
+            }
+        } else if (block == 0x2c) {
+            break;
+        } else if (block == 0x3b) {
+            error("imagecodec::decode: GIF data contains no image");
+        } else {
+            error("imagecodec::decode: GIF data has an unknown block type");
+        }
+    }
+
+    checkAvailable(pos, 9, length, "GIF");
+    int width = readLittleEndian16(data + pos + 4);
+    int height = readLittleEndian16(data + pos + 6);
+    int imageFlags = data[pos + 8];
+    pos += 9;
+    std::vector<int> palette = globalPalette;
+    if (imageFlags & 0x80) {
+        int size = 2 << (imageFlags & 7);
+        checkAvailable(pos, 3 * size, length, "GIF");
+        palette.clear();
+        for (int i = 0; i < size; i++, pos += 3) {
+            palette.push_back(rgb(data[pos], data[pos + 1], data[pos + 2]));
+        }
+    }
+    if (palette.empty()) {
+        error("imagecodec::decode: GIF data has no color table");
+    }
+    bool interlaced = (imageFlags & 0x40) != 0;
+
+    checkAvailable(pos, 1, length, "GIF");
+    int minCodeSize = data[pos++];
+    if (minCodeSize < 2 || minCodeSize > 8) {
+        error("imagecodec::decode: GIF data has an invalid LZW code size");
+    }
+    std::vector<uint8_t> lzw;
+    while (pos < length) {
+        int size = data[pos++];
+        if (size == 0) break;
+        size = (int) std::min((size_t) size, length - pos);
+        lzw.insert(lzw.end(), data + pos, data + pos + size);
+        pos += size;
+    }
+
+    // decode LZW codes into palette indexes; a truncated image is padded
+    // below, so only the size cap limits what a short file can claim
+    checkImageSize(width, height);
+    size_t total = (size_t) width * height;
+    std::vector<uint8_t> indexes;
+    indexes.reserve(total);
+    const int clearCode = 1 << minCodeSize;
+    const int endCode = clearCode + 1;
+    uint16_t prefix[4096];
+    uint8_t suffix[4096];
+    uint8_t stack[4097];
+    for (int i = 0; i < clearCode; i++) {
+        prefix[i] = 0;
+        suffix[i] = (uint8_t) i;
+    }
+    int codeSize = minCodeSize + 1;
+    int nextCode = clearCode + 2;
+    int previous = -1;
+    int firstChar = 0;
+    uint32_t buffer = 0;
+    int bitCount = 0;
+    size_t in = 0;
+    while (indexes.size() < total) {
+        while (bitCount < codeSize && in < lzw.size()) {
+            buffer |= (uint32_t) lzw[in++] << bitCount;
+            bitCount += 8;
+        }
+        if (bitCount < codeSize) break;   // out of data
+        int code = buffer & ((1 << codeSize) - 1);
+        buffer >>= codeSize;
+        bitCount -= codeSize;
+
+        if (code == clearCode) {
+            codeSize = minCodeSize + 1;
+            nextCode = clearCode + 2;
+            previous = -1;
+            continue;
+        } else if (code == endCode) {
+            break;
+        } else if (previous < 0) {
+            if (code >= clearCode) {
+                error("imagecodec::decode: GIF data has an invalid LZW code");
+            }
+            indexes.push_back((uint8_t) code);
+            previous = code;
+            firstChar = code;
+            continue;
+        }
+
+        int current = code;
+        int depth = 0;
+        if (code >= nextCode) {
+            if (code > nextCode) {
+                error("imagecodec::decode: GIF data has an invalid LZW code");
+            }
+            stack[depth++] = (uint8_t) firstChar;
+            code = previous;
+        }
+        while (code >= clearCode) {
+            stack[depth++] = suffix[code];
+            code = prefix[code];
+        }
+        firstChar = code;
+        stack[depth++] = (uint8_t) firstChar;
+        if (nextCode < 4096) {
+            prefix[nextCode] = (uint16_t) previous;
+            suffix[nextCode] = (uint8_t) firstChar;
+            nextCode++;
+            if (nextCode == (1 << codeSize) && codeSize < 12) {
+                codeSize++;
+            }
+        }
+        previous = current;
+        while (depth > 0 && indexes.size() < total) {
+            indexes.push_back(stack[--depth]);
+        }
+    }
+    indexes.resize(total, 0);   // tolerate truncated data as GIF viewers do
+
+    image.resize(width, height);
+    std::vector<int> rowOrder;
+    if (interlaced) {
+        static const int START[4] = {0, 4, 2, 1};
+        static const int STEP[4] = {8, 8, 4, 2};
+        for (int pass = 0; pass < 4; pass++) {
+            for (int y = START[pass]; y < height; y += STEP[pass]) rowOrder.push_back(y);
+        }
+    } else {
+        for (int y = 0; y < height; y++) rowOrder.push_back(y);
+    }
+    for (int r = 0; r < height; r++) {
+        int* out = &image.pixels[(size_t) rowOrder[r] * width];
+        const uint8_t* src = &indexes[(size_t) r * width];
+        for (int x = 0; x < width; x++) {
+            out[x] = src[x] < palette.size() ? palette[src[x]] : 0;
+        }
+    }
+}
+
+/*
+ * Writes GIF LZW codes least-significant bit first into 255-byte sub-blocks.
+ */
+class GifCodeWriter {
+public:
+    GifCodeWriter(std::string& out) : out(out), buffer(0), count(0) {}
+
+    void put(int code, int size) {
+        buffer |= (uint32_t) code << count;
+        count += size;
+        while (count >= 8) {
+            pending += (char) (buffer & 0xff);
+            buffer >>= 8;
+            count -= 8;
+            if (pending.size() == 255) flushBlock();
+        }
+    }
+
+    void finish() {
+        if (count > 0) pending += (char) (buffer & 0xff);
+        if (!pending.empty()) flushBlock();
+        out += (char) 0;
+    }
+
+private:
+    std::string& out;
+    std::string pending;
+    uint32_t buffer;
+    int count;
+
+    void flushBlock() {
+        out += (char) pending.size();
+        out += pending;
+        pending.clear();
+    }
+};
+
+/*
+ * Encodes the first frame of a GIF.  Images with at most 256 distinct colors
+ * are stored exactly; others are mapped onto a fixed 6x7x6 color cube.
+ */
+static std::string encodeGif(const Image& image) {
+    size_t total = image.pixels.size();
+    std::vector<uint8_t> indexes(total);
+
+    // try to build an exact palette with a small open-addressing hash table
+    static const int TABLE_SIZE = 1024;
+    int keys[TABLE_SIZE];
+    int slots[TABLE_SIZE];
+    std::fill(keys, keys + TABLE_SIZE, -1);
+    std::vector<int> palette;
+    bool exact = true;
+    for (size_t i = 0; i < total && exact; i++) {
+        int color = image.pixels[i] & 0xffffff;
+        int h = (int) (((uint32_t) color * 2654435761u) >> 22) & (TABLE_SIZE - 1);
+        while (keys[h] != -1 && keys[h] != color) h = (h + 1) & (TABLE_SIZE - 1);
+        if (keys[h] == -1) {
+            if (palette.size() == 256) {
+                exact = false;
+                break;
+            }
+            keys[h] = color;
+            slots[h] = palette.size();
+            palette.push_back(color);
+        }
+        indexes[i] = (uint8_t) slots[h];
+    }
+    if (!exact) {
+        palette.clear();
+        for (int r = 0; r < 6; r++) {
+            for (int g = 0; g < 7; g++) {
+                for (int b = 0; b < 6; b++) {
+                    palette.push_back(rgb(r * 255 / 5, g * 255 / 6, b * 255 / 5));
+                }
+            }
+        }
+        for (size_t i = 0; i < total; i++) {
+            int p = image.pixels[i];
+            int r = (((p >> 16) & 0xff) * 5 + 127) / 255;
+            int g = (((p >> 8) & 0xff) * 6 + 127) / 255;
+            int b = ((p & 0xff) * 5 + 127) / 255;
+            indexes[i] = (uint8_t) ((r * 7 + g) * 6 + b);
+        }
+    }
+    int tableBits = 1;
+    while ((1 << tableBits) < (int) palette.size()) tableBits++;
+    palette.resize(1 << tableBits, 0);
+
+    std::string out("GIF89a");
+    appendLittleEndian16(out, image.width);
+    appendLittleEndian16(out, image.height);
+    out += (char) (0x80 | ((tableBits - 1) << 4) | (tableBits - 1));
+    out += (char) 0;   // background color index
+    out += (char) 0;   // aspect ratio
+    for (size_t i = 0; i < palette.size(); i++) {
+        out += (char) ((palette[i] >> 16) & 0xff);
+        out += (char) ((palette[i] >> 8) & 0xff);
+        out += (char) (palette[i] & 0xff);
+    }
+    out += (char) 0x2c;
+    appendLittleEndian16(out, 0);
+    appendLittleEndian16(out, 0);
+    appendLittleEndian16(out, image.width);
+    appendLittleEndian16(out, image.height);
+    out += (char) 0;
+
+    int minCodeSize = std::max(2, tableBits);
+    out += (char) minCodeSize;
+    const int clearCode = 1 << minCodeSize;
+    const int endCode = clearCode + 1;
+    static const int HASH_SIZE = 8192;
+    std::vector<int> hashKeys(HASH_SIZE), hashCodes(HASH_SIZE);
+    GifCodeWriter codes(out);
+    int codeSize = minCodeSize + 1;
+    int nextCode = clearCode + 2;
+    std::fill(hashKeys.begin(), hashKeys.end(), -1);
+    codes.put(clearCode, codeSize);
+
+    // emits a code, then widens the code size exactly when the decoder will
+    #define GIF_EMIT(code) do { \
+        codes.put((code), codeSize); \
+        if (nextCode >= (1 << codeSize) && codeSize < 12) codeSize++; \
+    } while (0)
+
+    int current = total > 0 ? indexes[0] : 0;
+    for (size_t i = 1; i < total; i++) {
+        int c = indexes[i];
+        int key = (current << 8) | c;
+        int h = (key * 31 + c) & (HASH_SIZE - 1);
+        while (hashKeys[h] != -1 && hashKeys[h] != key) h = (h + 1) & (HASH_SIZE - 1);
+        if (hashKeys[h] == key) {
+            current = hashCodes[h];
+            continue;
+        }
+        GIF_EMIT(current);
+        if (nextCode < 4096) {
+            hashKeys[h] = key;
+            hashCodes[h] = nextCode++;
+        } else {
+            codes.put(clearCode, codeSize);
+            std::fill(hashKeys.begin(), hashKeys.end(), -1);
+            codeSize = minCodeSize + 1;
+            nextCode = clearCode + 2;
+        }
+        current = c;
+    }
+    GIF_EMIT(current);
+    codes.put(endCode, codeSize);
+    #undef GIF_EMIT
+    codes.finish();
+    out += (char) 0x3b;
+    return out;
+}
+
+
+/* ===================== Netpbm (PBM/PGM/PPM) ===================== */
+
+static int readPnmNumber(const uint8_t* data, size_t length, size_t& pos) {
+    while (pos < length) {
+        if (data[pos] == '#') {
+            while (pos < length && data[pos] != '\n' && data[pos] != '\r') pos++;
+        } else if (std::isspace(data[pos])) {
+            pos++;
+        } else {
+            break;
+        }
+    }
+    if (pos >= length || !std::isdigit(data[pos])) {
+        error("imagecodec::decode: PNM data has a malformed header");
+    }
+    long value = 0;
+    while (pos < length && std::isdigit(data[pos])) {
+        value = value * 10 + (data[pos++] - '0');
+        if (value > 0xffffff) error("imagecodec::decode: PNM header value is too large");
+    }
+    return (int) value;
+}
+
+static void decodePnm(const uint8_t* data, size_t length, Image& image) {
+    checkAvailable(0, 2, length, "PNM");
+    int kind = data[1] - '0';
+    if (data[0] != 'P' || kind < 1 || kind > 6) {
+        error("imagecodec::decode: invalid PNM signature");
+    }
+    size_t pos = 2;
+    int width = readPnmNumber(data, length, pos);
+    int height = readPnmNumber(data, length, pos);
+    bool bitmap = kind == 1 || kind == 4;
+    int maxValue = bitmap ? 1 : readPnmNumber(data, length, pos);
+    if (maxValue < 1 || maxValue > 65535) {
+        error("imagecodec::decode: PNM data has an invalid maximum value");
+    }
+    int channels = (kind == 3 || kind == 6) ? 3 : 1;
+    bool ascii = kind <= 3;
+    if (!ascii) {
+        pos++;   // the single whitespace character before the raster
+    }
+    int bytesPerSample = maxValue > 255 ? 2 : 1;
+
+    // every sample takes at least one byte (a digit, in the plain formats),
+    // so the raster's size can be checked before it is allocated
+    checkImageSize(width, height);
+    size_t rasterBytes = kind == 4 ? (size_t) height * ((width + 7) / 8)
+            : (size_t) width * height * channels * (ascii ? 1 : bytesPerSample);
+    checkAvailable(pos, rasterBytes, length, "PNM");
+    image.resize(width, height);
+
+    for (int y = 0; y < height; y++) {
+        int* out = &image.pixels[(size_t) y * width];
+        if (kind == 4) {
+            size_t rowBytes = (width + 7) / 8;
+            checkAvailable(pos, rowBytes, length, "PNM");
+            for (int x = 0; x < width; x++) {
+                bool black = (data[pos + x / 8] >> (7 - x % 8)) & 1;
+                out[x] = black ? 0x000000 : 0xffffff;
+            }
+            pos += rowBytes;
+            continue;
+        }
+        if (!ascii) {
+            checkAvailable(pos, (size_t) width * channels * bytesPerSample, length, "PNM");
+        }
+        for (int x = 0; x < width; x++) {
+            int samples[3];
+            for (int c = 0; c < channels; c++) {
+                int value;
+                if (ascii) {
+                    value = readPnmNumber(data, length, pos);
+                } else if (bytesPerSample == 2) {
+                    value = readBigEndian16(data + pos);
+                    pos += 2;
+                } else {
+                    value = data[pos++];
+                }
+                if (bitmap) {
+                    value = value ? 0 : 255;   // in PBM, 1 means black
+                } else {
+                    value = (std::min(value, maxValue) * 255 + maxValue / 2) / maxValue;
+                }
+                samples[c] = value;
+            }
+            out[x] = channels == 3 ? rgb(samples[0], samples[1], samples[2])
+                                   : rgb(samples[0], samples[0], samples[0]);
+        }
+    }
+}
+
+static std::string encodePnm(const Image& image) {
+    std::string out = "P6\n" + integerToString(image.width) + " "
+            + integerToString(image.height) + "\n255\n";
+    size_t header = out.size();
+    out.resize(header + image.pixels.size() * 3);
+    char* p = &out[header];
+    for (size_t i = 0; i < image.pixels.size(); i++) {
+        int px = image.pixels[i];
+        *p++ = (char) ((px >> 16) & 0xff);
+        *p++ = (char) ((px >> 8) & 0xff);
+        *p++ = (char) (px & 0xff);
+    }
+    return out;
+}
+
+
+/* ===================== public interface ===================== */
+
+ImageFormat formatFromData(const std::string& data) {
+    const uint8_t* p = (const uint8_t*) data.data();
+    size_t n = data.size();
+    if (n >= 8 && std::memcmp(p, PNG_SIGNATURE, 8) == 0) {
+        return FORMAT_PNG;
+    } else if (n >= 3 && p[0] == 0xff && p[1] == 0xd8 && p[2] == 0xff) {
+        return FORMAT_JPEG;
+    } else if (n >= 6 && (std::memcmp(p, "GIF87a", 6) == 0 || std::memcmp(p, "GIF89a", 6) == 0)) {
+        return FORMAT_GIF;
+    } else if (n >= 3 && p[0] == 'P' && p[1] >= '1' && p[1] <= '6' && std::isspace(p[2])) {
+        return FORMAT_PNM;
+    }
+    return FORMAT_UNKNOWN;
+}
+
+ImageFormat formatFromFilename(const std::string& filename) {
+    std::string ext = toLowerCase(getExtension(filename));
+    if (ext == ".png") {
+        return FORMAT_PNG;
+    } else if (ext == ".jpg" || ext == ".jpeg" || ext == ".jpe" || ext == ".jfif") {
+        return FORMAT_JPEG;
+    } else if (ext == ".gif") {
+        return FORMAT_GIF;
+    } else if (ext == ".ppm" || ext == ".pgm" || ext == ".pbm" || ext == ".pnm") {
+        return FORMAT_PNM;
+    }
+    return FORMAT_UNKNOWN;
+}
+
+bool decode(const std::string& data, Grid<int>& pixels) {
+    const uint8_t* p = (const uint8_t*) data.data();
+    Image image;
+    try {
+        switch (formatFromData(data)) {
+        case FORMAT_PNG:  decodePng(p, data.size(), image); break;
+        case FORMAT_JPEG: decodeJpeg(p, data.size(), image); break;
+        case FORMAT_GIF:  decodeGif(p, data.size(), image); break;
+        case FORMAT_PNM:  decodePnm(p, data.size(), image); break;
+        default:          return false;
+        }
+    } catch (const UnsupportedFeature&) {
+        return false;
+    }
+    // set leaves the grid shareable, where writing through an iterator
+    // would make every later copy of it a full one
+    pixels.resize(image.height, image.width);
+    for (int row = 0, i = 0; row < image.height; row++) {
+        for (int col = 0; col < image.width; col++, i++) {
+            pixels.set(row, col, image.pixels[i]);
+        }
+    }
+    return true;
+}
+
+std::string encode(const Grid<int>& pixels, ImageFormat format, int jpegQuality) {
+    if (pixels.isEmpty()) {
+        error("imagecodec::encode: cannot encode an empty image");
+    }
+    Image image;
+    image.resize(pixels.width(), pixels.height());
+    Grid<int>::const_iterator it = pixels.begin();
+    for (size_t i = 0; i < image.pixels.size(); i++, ++it) {
+        image.pixels[i] = *it & 0xffffff;
+    }
+    switch (format) {
+    case FORMAT_PNG:  return encodePng(image);
+    case FORMAT_JPEG: return encodeJpeg(image, jpegQuality);
+    case FORMAT_GIF:  return encodeGif(image);
+    case FORMAT_PNM:  return encodePnm(image);
+    default:
+        error("imagecodec::encode: unknown image format");
+        return "";
+    }
+}
+
+bool readImage(const std::string& filename, Grid<int>& pixels) {
+    std::ifstream input(filename.c_str(), std::ios::in | std::ios::binary);
+    if (input.fail()) {
+        error("imagecodec::readImage: cannot open file: " + filename);
+    }
+    input.seekg(0, std::ios::end);
+    std::streamoff size = input.tellg();
+    input.seekg(0, std::ios::beg);
+    std::string data(size > 0 ? (size_t) size : 0, '\0');
+    if (size > 0 && !input.read(&data[0], size)) {
+        error("imagecodec::readImage: cannot read file: " + filename);
+    }
+    return decode(data, pixels);
+}
+
+bool writeImage(const std::string& filename, const Grid<int>& pixels) {
+    ImageFormat format = formatFromFilename(filename);
+    if (format == FORMAT_UNKNOWN) {
+        return false;
+    }
+    std::string data = encode(pixels, format);
+    std::ofstream output(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (output.fail() || !output.write(data.data(), data.size())) {
+        error("imagecodec::writeImage: cannot write file: " + filename);
+    }
+    return true;
+}
+}
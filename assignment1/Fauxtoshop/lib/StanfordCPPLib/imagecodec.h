@@ -0,0 +1,89 @@
+/*
+ * File: imagecodec.h
+ * ------------------
+ * This file declares a set of functions for reading and writing image files
+ * directly in C++, without a round trip through the Java back-end.
+ * The supported formats are:
+ *
+ * - PNG (all bit depths and color types, interlaced or not);
+ * - JPEG (baseline and progressive Huffman-coded, grayscale or color);
+ * - GIF (the first frame of the file);
+ * - the Netpbm family: PBM, PGM, and PPM, in both ASCII and raw form.
+ *
+ * Pixels are exchanged as a Grid of RGB integers in [y][x] order, the same
+ * representation used by <code>GBufferedImage</code>.  Any alpha channel
+ * in the file is discarded, just as it is by the Java back-end.
+ *
+ * @version 2026/10/18
+ * @since 2026/10/18
+ */
+
+#ifndef _imagecodec_h
+#define _imagecodec_h
+
+#include <string>
+#include "grid.h"
+
+namespace imagecodec {
+/*
+ * The image file formats known to this codec.
+ */
+enum ImageFormat {
+    FORMAT_UNKNOWN,
+    FORMAT_PNG,
+    FORMAT_JPEG,
+    FORMAT_GIF,
+    FORMAT_PNM
+};
+
+/*
+ * Returns the format of an image file's contents based on its leading
+ * 'magic number' bytes, or FORMAT_UNKNOWN if the data is not recognized.
+ */
+ImageFormat formatFromData(const std::string& data);
+
+/*
+ * Returns the format implied by the given file name's extension
+ * (case-insensitive), or FORMAT_UNKNOWN if the extension is not recognized.
+ */
+ImageFormat formatFromFilename(const std::string& filename);
+
+/*
+ * Decodes the given image file contents into the given grid of RGB pixels,
+ * resizing the grid to match the image.
+ * Returns false without modifying the grid if the data is in a format or
+ * format variant that this codec does not support natively (such as an
+ * arithmetic-coded JPEG), in which case the caller may wish to fall back
+ * to the Java back-end.
+ * Throws an error if the data is in a supported format but is corrupt,
+ * including when its header claims more than 2^26 pixels or more pixels
+ * than the rest of the data could hold.
+ */
+bool decode(const std::string& data, Grid<int>& pixels);
+
+/*
+ * Encodes the given grid of RGB pixels as an image file in the given format
+ * and returns the encoded bytes.
+ * JPEG files are written at the given quality from 1 (worst) to 100 (best).
+ * Throws an error if the format is FORMAT_UNKNOWN or the grid is empty.
+ */
+std::string encode(const Grid<int>& pixels, ImageFormat format, int jpegQuality = 90);
+
+/*
+ * Reads the given image file into the given grid of RGB pixels.
+ * Returns false if the file's format is not supported natively; see decode.
+ * Throws an error if the file cannot be read or is corrupt.
+ */
+bool readImage(const std::string& filename, Grid<int>& pixels);
+
+/*
+ * Writes the given grid of RGB pixels to the given image file, choosing
+ * the format from the file name's extension.
+ * Returns false without writing anything if the extension does not name
+ * a format supported natively.
+ * Throws an error if the file cannot be written.
+ */
+bool writeImage(const std::string& filename, const Grid<int>& pixels);
+}
+
+#endif
@@ -15,6 +15,10 @@
  *
  * The original DAWG implementation is retained as dawglexicon.h/cpp.
  * 
+ * @version 2026/10/18
+ * - binary lexicon files are read through DawgLexicon::mapBinaryFile
+ * - added freeze and the compact frozen trie
+ * - fixed remove of a word at a leaf of the trie not updating the size
  * @version 2015/07/05
  * - using global hashing functions rather than global variables
  * @version 2014/11/13
@@ -41,27 +45,33 @@
 #include "strlib.h"
 
 static bool scrub(std::string& str);
+static int countBits(unsigned int bits);
+static int lowestBit(unsigned int bits);
 
 Lexicon::Lexicon() {
     m_root = NULL;
     m_size = 0;
+    m_frozen = false;
 }
 
 Lexicon::Lexicon(std::istream& input) {
     m_root = NULL;
     m_size = 0;
+    m_frozen = false;
     addWordsFromFile(input);
 }
 
 Lexicon::Lexicon(const std::string& filename) {
     m_root = NULL;
     m_size = 0;
+    m_frozen = false;
     addWordsFromFile(filename);
 }
 
 Lexicon::Lexicon(const Lexicon& src) {
     m_root = NULL;
     m_size = 0;
+    m_frozen = false;
     deepCopy(src);
 }
 
@@ -77,6 +87,7 @@ bool Lexicon::add(const std::string& word) {
     if (!scrub(scrubbed)) {
         return false;
     }
+    thaw();
     return addHelper(m_root, scrubbed, /* originalWord */ scrubbed);
 }
 
@@ -101,6 +112,13 @@ void Lexicon::addWordsFromFile(const std::string& filename) {
     if (input.fail()) {
         error("Lexicon::addWordsFromFile: Couldn't read from input file " + filename);
     }
+    if (isDAWGFile(input)) {
+        // map the binary file rather than reading it through the stream
+        input.close();
+        readBinaryFile(filename);
+        return;
+    }
+    rewindStream(input);
     addWordsFromFile(input);
     input.close();
 }
@@ -110,6 +128,43 @@ void Lexicon::clear() {
     m_allWords.clear();
     deleteTree(m_root);
     m_root = NULL;
+    m_frozen = false;
+    std::vector<FrozenNode>().swap(m_frozenNodes);
+}
+
+/*
+ * Implementation notes: freeze
+ * ----------------------------
+ * Numbers the trie's nodes breadth-first, so that the children of each
+ * node get consecutive numbers, and stores them in that order.
+ */
+void Lexicon::freeze() {
+    if (m_frozen) {
+        return;
+    }
+    std::vector<FrozenNode> nodes;
+    if (pruneHelper(m_root)) {
+        std::vector<TrieNode*> queue(1, m_root);
+        for (size_t i = 0; i < queue.size(); i++) {
+            TrieNode* node = queue[i];
+            FrozenNode frozen;
+            frozen.bits = node->isWord() ? WORD_BIT : 0;
+            frozen.firstChild = (unsigned int) queue.size();
+            for (char letter = 'a'; letter <= 'z'; letter++) {
+                if (node->child(letter) != NULL) {
+                    frozen.bits |= 1u << (letter - 'a');
+                    queue.push_back(node->child(letter));
+                }
+            }
+            nodes.push_back(frozen);
+        }
+    }
+    nodes.shrink_to_fit();
+    deleteTree(m_root);
+    m_root = NULL;
+    m_allWords.clear();
+    m_frozenNodes.swap(nodes);
+    m_frozen = true;
 }
 
 bool Lexicon::contains(const std::string& word) const {
@@ -120,6 +175,9 @@ bool Lexicon::contains(const std::string& word) const {
     if (!scrub(scrubbed)) {
         return false;
     }
+    if (m_frozen) {
+        return containsFrozen(scrubbed, /* isPrefix */ false);
+    }
     return containsHelper(m_root, scrubbed, /* isPrefix */ false);
 }
 
@@ -131,6 +189,9 @@ bool Lexicon::containsPrefix(const std::string& prefix) const {
     if (!scrub(scrubbed)) {
         return false;
     }
+    if (m_frozen) {
+        return containsFrozen(scrubbed, /* isPrefix */ true);
+    }
     return containsHelper(m_root, scrubbed, /* isPrefix */ true);
 }
 
@@ -142,21 +203,28 @@ bool Lexicon::equals(const Lexicon& lex2) const {
     if (size() != lex2.size()) {
         return false;
     }
-    return m_allWords == lex2.m_allWords;
+    if (!m_frozen && !lex2.m_frozen) {
+        return m_allWords == lex2.m_allWords;
+    }
+    return compare::compare(*this, lex2) == 0;
 }
 
 bool Lexicon::isEmpty() const {
     return size() == 0;
 }
 
+bool Lexicon::isFrozen() const {
+    return m_frozen;
+}
+
 void Lexicon::mapAll(void (*fn)(std::string)) const {
-    for (std::string word : m_allWords) {
+    for (const std::string& word : *this) {
         fn(word);
     }
 }
 
 void Lexicon::mapAll(void (*fn)(const std::string&)) const {
-    for (std::string word : m_allWords) {
+    for (const std::string& word : *this) {
         fn(word);
     }
 }
@@ -169,6 +237,7 @@ bool Lexicon::remove(const std::string& word) {
     if (!scrub(scrubbed)) {
         return false;
     }
+    thaw();
     return removeHelper(m_root, scrubbed, /* originalWord */ scrubbed, /* isPrefix */ false);
 }
 
@@ -182,7 +251,7 @@ bool Lexicon::removePrefix(const std::string& prefix) {
     if (!scrub(scrubbed)) {
         return false;
     }
-    
+    thaw();
     return removeHelper(m_root, scrubbed, /* originalWord */ scrubbed, /* isPrefix */ true);
 }
 
@@ -198,7 +267,7 @@ std::string Lexicon::toString() const {
 
 std::set<std::string> Lexicon::toStlSet() const {
     std::set<std::string> result;
-    for (std::string word : m_allWords) {
+    for (const std::string& word : *this) {
         result.insert(word);
     }
     return result;
@@ -290,6 +359,10 @@ bool Lexicon::removeHelper(TrieNode*& node, const std::string& word, const std::
         } else {
             // remove / de-word-ify this node only
             if (node->isLeaf()) {
+                if (node->isWord()) {
+                    m_allWords.remove(originalWord);
+                    m_size--;
+                }
                 delete node;
                 node = NULL;
             } else {
@@ -324,11 +397,77 @@ void Lexicon::removeSubtreeHelper(TrieNode*& node, const std::string& originalWo
 }
 
 void Lexicon::deepCopy(const Lexicon& src) {
+    if (src.m_frozen) {
+        m_frozenNodes = src.m_frozenNodes;
+        m_size = src.m_size;
+        m_frozen = true;
+        return;
+    }
     for (std::string word : src.m_allWords) {
         add(word);
     }
 }
 
+// pre: word is scrubbed to contain only lowercase a-z letters
+bool Lexicon::containsFrozen(const std::string& word, bool isPrefix) const {
+    if (m_frozenNodes.empty()) {
+        return false;
+    }
+    int node = 0;
+    for (size_t i = 0; i < word.length(); i++) {
+        node = frozenChild(node, word[i]);
+        if (node < 0) {
+            return false;
+        }
+    }
+    return isPrefix || (m_frozenNodes[node].bits & WORD_BIT) != 0;
+}
+
+// returns the index of the given child of a frozen node, or -1 if none
+int Lexicon::frozenChild(int node, char letter) const {
+    unsigned int bits = m_frozenNodes[node].bits;
+    unsigned int bit = 1u << (letter - 'a');
+    if ((bits & bit) == 0) {
+        return -1;
+    }
+    return (int) m_frozenNodes[node].firstChild + countBits(bits & (bit - 1));
+}
+
+// remove/free the subtrees below node that contain no words;
+// returns whether any word is left at or below node
+bool Lexicon::pruneHelper(TrieNode*& node) {
+    if (node == NULL) {
+        return false;
+    }
+    bool hasWord = node->isWord();
+    for (char letter = 'a'; letter <= 'z'; letter++) {
+        if (pruneHelper(node->child(letter))) {
+            hasWord = true;
+        }
+    }
+    if (!hasWord) {
+        delete node;
+        node = NULL;
+    }
+    return hasWord;
+}
+
+// converts a frozen lexicon back into the mutable trie
+void Lexicon::thaw() {
+    if (!m_frozen) {
+        return;
+    }
+    // the frozen nodes are only read by the loop, so the trie can be
+    // rebuilt while iterating over them; addHelper counts the words again
+    iterator end = this->end();
+    m_size = 0;
+    for (iterator it = begin(); it != end; ++it) {
+        addHelper(m_root, *it, *it);
+    }
+    m_frozen = false;
+    std::vector<FrozenNode>().swap(m_frozenNodes);
+}
+
 void Lexicon::deleteTree(TrieNode* node) {
     if (node != NULL) {
         for (char letter = 'a'; letter <= 'z'; letter++) {
@@ -382,7 +521,8 @@ void Lexicon::readBinaryFile(std::istream& input) {
  * lexicon data file, and then we extract its yummy data into our trie.
  */
 void Lexicon::readBinaryFile(const std::string& filename) {
-    DawgLexicon ldawg(filename);
+    DawgLexicon ldawg;
+    ldawg.mapBinaryFile(filename);
     for (std::string word : ldawg) {
         add(word);
     }
@@ -397,10 +537,67 @@ Lexicon& Lexicon::operator=(const Lexicon& src) {
 }
 
 std::ostream& operator <<(std::ostream& out, const Lexicon& lex) {
-    out << lex.m_allWords;
+    if (!lex.m_frozen) {
+        out << lex.m_allWords;
+        return out;
+    }
+    out << "{";
+    bool first = true;
+    for (const std::string& word : lex) {
+        if (!first) {
+            out << ", ";
+        }
+        first = false;
+        writeGenericValue(out, word, /* forceQuotes */ true);
+    }
+    out << "}";
     return out;
 }
 
+/*
+ * Implementation notes: advanceFrozen
+ * -----------------------------------
+ * Moves to the next word of a frozen lexicon in alphabetical order, which
+ * is the next word node in a depth-first walk that visits each node's
+ * children in letter order.  'path' holds the nodes from the root to the
+ * current one, and 'word' holds their letters.
+ */
+void Lexicon::iterator::advanceFrozen() {
+    const std::vector<FrozenNode>& nodes = lp->m_frozenNodes;
+    while (true) {
+        const FrozenNode& current = nodes[path.peek()];
+        unsigned int children = current.bits & (WORD_BIT - 1);
+        if (children != 0) {
+            // go down to the first child
+            word.push_back((char) ('a' + lowestBit(children)));
+            path.push((int) current.firstChild);
+        } else {
+            // go up until a node has a next sibling, and move to it
+            while (true) {
+                path.pop();
+                if (path.isEmpty()) {
+                    word.clear();
+                    return;
+                }
+                const FrozenNode& parent = nodes[path.peek()];
+                int letter = word[word.length() - 1] - 'a';
+                unsigned int later = parent.bits & (WORD_BIT - 1) & ~((2u << letter) - 1);
+                if (later != 0) {
+                    int next = lowestBit(later);
+                    word[word.length() - 1] = (char) ('a' + next);
+                    path.push((int) parent.firstChild
+                              + countBits(parent.bits & ((1u << next) - 1)));
+                    break;
+                }
+                word.resize(word.length() - 1);
+            }
+        }
+        if (nodes[path.peek()].bits & WORD_BIT) {
+            return;
+        }
+    }
+}
+
 std::istream& operator >>(std::istream& is, Lexicon& lex) {
     char ch;
     is >> ch;
@@ -453,3 +650,28 @@ static bool scrub(std::string& str) {
     }
     return true;
 }
+
+static int countBits(unsigned int bits) {
+#ifdef __GNUC__
+    return __builtin_popcount(bits);
+#else
+    int count = 0;
+    for (; bits != 0; bits &= bits - 1) {
+        count++;
+    }
+    return count;
+#endif
+}
+
+static int lowestBit(unsigned int bits) {
+#ifdef __GNUC__
+    return __builtin_ctz(bits);
+#else
+    int i = 0;
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
@@ -5,6 +5,8 @@
  * compact structure for storing a list of words.
  *
  * @author Marty Stepp
+ * @version 2026/10/18
+ * - added freeze method and compact read-only representation
  * @version 2014/11/13
  * - added comparison operators <, >= etc.
  * - added hashCode function
@@ -19,8 +21,10 @@
 #include <iterator>
 #include <set>
 #include <string>
+#include <vector>
 #include "hashcode.h"
 #include "set.h"
+#include "stack.h"
 
 /*
  * Class: Lexicon
@@ -119,6 +123,19 @@ public:
      */
     void clear();
 
+    /*
+     * Method: freeze
+     * Usage: lex.freeze();
+     * --------------------
+     * Converts the lexicon to a compact read-only form that answers
+     * lookups, prefix queries and iteration in a small fraction of the
+     * memory, which suits a large word list that is loaded once and then
+     * only searched.  Adding or removing a word later converts the
+     * lexicon back to its normal form first, so it is never an error to
+     * change a frozen lexicon, only slower.
+     */
+    void freeze();
+
     /*
      * Method: contains
      * Usage: if (lex.contains(word)) ...
@@ -159,6 +176,15 @@ public:
      */
     bool isEmpty() const;
 
+    /*
+     * Method: isFrozen
+     * Usage: if (lex.isFrozen()) ...
+     * ------------------------------
+     * Returns <code>true</code> if the lexicon is in the compact form made
+     * by <code>freeze</code>.
+     */
+    bool isFrozen() const;
+
     /*
      * Method: mapAll
      * Usage: lexicon.mapAll(fn);
@@ -309,12 +335,32 @@ private:
         TrieNode* m_children[26];   // 0=a, 1=b, 2=c, ..., 25=z
     };
 
+    /*
+     * Implementation notes: FrozenNode
+     * --------------------------------
+     * A frozen lexicon stores its trie as an array of 8-byte nodes with the
+     * root at index 0.  The children of a node are stored next to each other
+     * in letter order, starting at firstChild.  Bit i of 'bits' is set if the
+     * node has a child for letter 'a' + i, so the child for a letter is found
+     * by counting the set bits below it; bit WORD_BIT marks a node that ends
+     * a word.  Only nodes that lead to a word are kept.
+     */
+    struct FrozenNode {
+        unsigned int bits;
+        unsigned int firstChild;
+    };
+
+    static const unsigned int WORD_BIT = 1u << 26;
+
     /*
      * private helper functions, including
      * recursive helpers to implement public add/contains/remove
      */
     bool addHelper(TrieNode*& node, const std::string& word, const std::string& originalWord);
     bool containsHelper(TrieNode* node, const std::string& word, bool isPrefix) const;
+    bool containsFrozen(const std::string& word, bool isPrefix) const;
+    int frozenChild(int node, char letter) const;
+    bool pruneHelper(TrieNode*& node);
     void deepCopy(const Lexicon& src);
     void deleteTree(TrieNode* node);
     bool isDAWGFile(std::istream& input) const;
@@ -323,6 +369,7 @@ private:
     void readBinaryFile(const std::string& filename);
     bool removeHelper(TrieNode*& node, const std::string& word, const std::string& originalWord, bool isPrefix);
     void removeSubtreeHelper(TrieNode*& node, const std::string& originalWord);
+    void thaw();
     
     friend std::ostream& operator <<(std::ostream& os, const Lexicon& lex);
     friend std::istream& operator >>(std::istream& is, Lexicon& lex);
@@ -332,6 +379,8 @@ private:
     int m_size;
     Set<std::string> m_allWords;   // secondary structure of all words for foreach;
                                    // basically a cop-out so I can loop over words
+    bool m_frozen;                 // true if the words are in m_frozenNodes instead
+    std::vector<FrozenNode> m_frozenNodes;
 
 public:
     /*
@@ -355,25 +404,76 @@ public:
      * iterators so that they work symmetrically with respect to the
      * corresponding STL classes.
      */
-    class iterator : public Set<std::string>::iterator {
+    class iterator : public std::iterator<std::input_iterator_tag, std::string> {
+    private:
+        const Lexicon* lp;
+        int index;
+        Set<std::string>::iterator setIterator;   /* if not frozen           */
+        Stack<int> path;                          /* frozen nodes to word    */
+        std::string word;                         /* current word if frozen  */
+
+        void advanceFrozen();
+
     public:
-        iterator() : Set<std::string>::iterator() {}
-        iterator(const iterator& it) : Set<std::string>::iterator(it) {}
-        iterator(const Set<std::string>::iterator& it) : Set<std::string>::iterator(it) {}
+        iterator() : lp(NULL), index(0) {
+            /* empty */
+        }
+
+        iterator(const Lexicon* lp, bool end)
+                : lp(lp),
+                  index(end ? lp->size() : 0),
+                  setIterator(end ? lp->m_allWords.end() : lp->m_allWords.begin()) {
+            if (lp->m_frozen && !end && !lp->m_frozenNodes.empty()) {
+                path.push(0);
+                advanceFrozen();
+            }
+        }
+
+        iterator& operator ++() {
+            if (lp->m_frozen) {
+                advanceFrozen();
+            } else {
+                ++setIterator;
+            }
+            index++;
+            return *this;
+        }
+
+        iterator operator ++(int) {
+            iterator copy(*this);
+            operator++();
+            return copy;
+        }
+
+        bool operator ==(const iterator& rhs) {
+            return lp == rhs.lp && index == rhs.index;
+        }
+
+        bool operator !=(const iterator& rhs) {
+            return !(*this == rhs);
+        }
+
+        const std::string& operator *() {
+            return lp->m_frozen ? word : *setIterator;
+        }
+
+        const std::string* operator ->() {
+            return &**this;
+        }
     };
 
     /*
      * Returns an iterator positioned at the first word in the lexicon.
      */
     iterator begin() const {
-        return iterator(m_allWords.begin());
+        return iterator(this, /* end */ false);
     }
 
     /*
      * Returns an iterator positioned at the last word in the lexicon.
      */
     iterator end() const {
-        return iterator(m_allWords.end());
+        return iterator(this, /* end */ true);
     }
 };
 
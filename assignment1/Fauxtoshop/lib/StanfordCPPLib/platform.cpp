@@ -4,6 +4,14 @@
  * This file implements the platform interface by passing commands to
  * a Java back end that manages the display.
  * 
+ * @version 2026/10/18
+ * - added --headless command-line flag to run without launching the Java
+ *   back-end; added getCommandLineArguments and isHeadless
+ * - buffered the pipe to the Java back-end in both directions, so that a
+ *   command costs one write call and input is no longer read a byte at a time
+ * - GBufferedImage pixel changes can be deferred and are sent, batched, before
+ *   the next command of any other kind, the next event read, or exit
+ * - parseEvent reads the event name as a view instead of a copied string
  * @version 2016/03/16
  * - added functions for HTTP server
  * @version 2015/10/21
@@ -88,6 +96,7 @@ static int pout;
 #include "error.h"
 #include "exceptions.h"
 #include "filelib.h"
+#include "gbufferedimage.h"
 #include "gevents.h"
 #include "gtimer.h"
 #include "gtypes.h"
@@ -106,6 +115,9 @@ static int pout;
 // related: similar constant in Java back-end stanford.spl.SplPipeDecoder.java
 static const size_t PIPE_MAX_COMMAND_LENGTH = 2048;
 
+// size of the buffers for each direction of the pipe to the Java back-end
+static const size_t PIPE_BUFFER_SIZE = 65536;
+
 static std::string getLineConsole();
 static void putConsole(const std::string& str, bool isStderr = false);
 static void endLineConsole(bool isStderr = false);
@@ -274,6 +286,9 @@ static HashMap<std::string, std::string> optionTable;
 static std::string programName;
 static std::ofstream logfile;
 static ConsoleStreambuf* cinout_new_buf = NULL;
+static std::vector<std::string> commandLineArguments;
+static bool headless = false;
+static std::vector<GBufferedImage*> pendingImages;   // have deferred pixel updates
 
 #ifdef _WIN32
 static HANDLE rdFromJBE = NULL;
@@ -288,8 +303,16 @@ static pid_t javaBackEndPid;
 /* Prototypes */
 
 static void initPipe();
-static void putPipe(std::string line);
-static void putPipeLongString(std::string line);
+static void initCommandLine(int argc, char** argv);
+static void putPipe(const std::string& line);
+static void putPipeLongString(const std::string& line);
+static void putPipeLines(const std::string& lines);
+static void flushPendingImages();
+static void writePipe(const char* bytes, size_t length);
+static void writePipeRaw(const char* bytes, size_t length);
+static void flushPipe();
+static bool readPipeLine(std::string& line, size_t maxLength, const char* terminators);
+static long readPipeRaw(char* buffer, size_t length);
 static std::string getJavaCommand();
 static std::string getPipe();
 static std::string getResult(bool consumeAcks = false, const std::string& caller = "");
@@ -1332,11 +1355,48 @@ void Platform::gbufferedimage_setRGB(GObject* gobj, double x, double y,
     putPipe(os.str());
 }
 
+void Platform::gbufferedimage_updatePixels(GObject* gobj, const std::vector<int>& runs) {
+    // each run is (x, y, length, rgb); all of the commands go to the
+    // back-end in one write
+    std::ostringstream os;
+    for (size_t i = 0; i + 3 < runs.size(); i += 4) {
+        if (runs[i + 2] == 1) {
+            os << "GBufferedImage.setRGB(\"" << gobj << "\", " << runs[i] << ", "
+               << runs[i + 1] << ", " << runs[i + 3] << ")\n";
+        } else {
+            os << "GBufferedImage.fillRegion(\"" << gobj << "\", " << runs[i] << ", "
+               << runs[i + 1] << ", " << runs[i + 2] << ", 1, " << runs[i + 3] << ")\n";
+        }
+    }
+    putPipeLines(os.str());
+}
+
+void Platform::gbufferedimage_deferUpdate(GBufferedImage* image) {
+    // changes still pending when the program ends are sent on the way out
+    static bool registered = false;
+    if (!registered) {
+        registered = true;
+        atexit(flushPendingImages);
+    }
+    pendingImages.push_back(image);
+}
+
+void Platform::gbufferedimage_cancelUpdate(GBufferedImage* image) {
+    pendingImages.erase(std::remove(pendingImages.begin(), pendingImages.end(), image),
+                        pendingImages.end());
+}
+
 void Platform::gbufferedimage_updateAllPixels(GObject* gobj,
                                               const std::string& base64) {
+    // the pixel data can run to megabytes, so it is appended to the command
+    // directly rather than copied through the stream
     std::ostringstream os;
-    os << "GBufferedImage.updateAllPixels(\"" << gobj << "\", \"" << base64 << "\")";
-    putPipe(os.str());
+    os << "GBufferedImage.updateAllPixels(\"" << gobj << "\", \"";
+    std::string command = os.str();
+    command.reserve(command.length() + base64.length() + 2);
+    command += base64;
+    command += "\")";
+    putPipe(command);
 }
 
 GDimension Platform::gimage_constructor(GObject* gobj, std::string filename) {
@@ -1749,6 +1809,7 @@ GDimension Platform::glabel_getSize(const GObject* gobj) {
 }
 
 GEvent Platform::gevent_getNextEvent(int mask) {
+    flushPendingImages();   // the user should see the image they react to
     if (eventQueue.isEmpty()) {
         putPipe("GEvent.getNextEvent(" + integerToString(mask) + ")");
         getResult();
@@ -1758,6 +1819,7 @@ GEvent Platform::gevent_getNextEvent(int mask) {
 }
 
 GEvent Platform::gevent_waitForEvent(int mask) {
+    flushPendingImages();   // the user should see the image they react to
     while (eventQueue.isEmpty()) {
         putPipe("GEvent.waitForEvent(" + integerToString(mask) + ")");
 
@@ -1889,16 +1951,121 @@ Platform *getPlatform() {
     return &gp;
 }
 
-static void putPipeLongString(std::string line) {
-    // break into chunks
+/*
+ * The pipe to the Java back-end is buffered in both directions.  Outgoing
+ * text is collected in pipeOut and written with one system call per command,
+ * or per PIPE_BUFFER_SIZE bytes of a long command, instead of separate calls
+ * for each line and its newline.  Incoming text is read into pipeIn in blocks
+ * and split into lines there, instead of with one read call per character.
+ * The text protocol itself is unchanged, since the back-end's decoder
+ * (SplPipeDecoder in spl.jar) only understands newline-separated commands.
+ */
+struct PipeBuffer {
+    char data[PIPE_BUFFER_SIZE];
+    size_t start;   // index of the first byte not yet consumed
+    size_t end;     // index one past the last byte held
+};
+
+static PipeBuffer pipeIn;
+static PipeBuffer pipeOut;
+
+static void putPipeLongString(const std::string& line) {
+    // break into chunks, all of which go out in as few writes as possible
     // precondition: line does not contain substring "LongCommand.end()"
-    putPipe("LongCommand.begin()");
+#ifdef PIPE_DEBUG
+    fprintf(stderr, "putPipeLongString(length %d)\n", (int) line.length());  fflush(stderr);
+#endif // PIPE_DEBUG
+    static const std::string begin = "LongCommand.begin()\n";
+    static const std::string end = "LongCommand.end()\n";
+    writePipe(begin.c_str(), begin.length());
     size_t len = line.length();
     for (size_t i = 0; i < len; i += PIPE_MAX_COMMAND_LENGTH) {
-        std::string chunk = line.substr(i, std::min(PIPE_MAX_COMMAND_LENGTH, len - i));
-        putPipe(chunk);
+        writePipe(line.c_str() + i, std::min(PIPE_MAX_COMMAND_LENGTH, len - i));
+        writePipe("\n", 1);
+    }
+    writePipe(end.c_str(), end.length());
+    flushPipe();
+}
+
+/*
+ * Sends several newline-terminated commands with a single flush.
+ */
+static void putPipeLines(const std::string& lines) {
+    flushPendingImages();
+#ifdef PIPE_DEBUG
+    fprintf(stderr, "putPipeLines(\"%s\")\n", lines.c_str());  fflush(stderr);
+#endif // PIPE_DEBUG
+    writePipe(lines.c_str(), lines.length());
+    flushPipe();
+}
+
+/*
+ * Sends the pixel changes that images have deferred.  This happens before
+ * any command is sent to the back-end, so pause and console reads show the
+ * latest pixels too; before reading an event, even one already queued; and
+ * when the program exits.
+ */
+static void flushPendingImages() {
+    if (pendingImages.empty()) {
+        return;
+    }
+    std::vector<GBufferedImage*> images;
+    images.swap(pendingImages);
+    for (size_t i = 0; i < images.size(); i++) {
+        images[i]->flush();
+    }
+}
+
+// appends bytes to the outgoing buffer, writing it out whenever it fills up
+static void writePipe(const char* bytes, size_t length) {
+    while (length > 0) {
+        if (pipeOut.end == PIPE_BUFFER_SIZE) {
+            flushPipe();
+        }
+        size_t count = std::min(length, PIPE_BUFFER_SIZE - pipeOut.end);
+        memcpy(pipeOut.data + pipeOut.end, bytes, count);
+        pipeOut.end += count;
+        bytes += count;
+        length -= count;
+    }
+}
+
+static void flushPipe() {
+    if (pipeOut.end > 0) {
+        writePipeRaw(pipeOut.data, pipeOut.end);
+        pipeOut.end = 0;
+    }
+}
+
+/*
+ * Reads the next line from the back-end into 'line', up to and not including
+ * the first of the given terminator characters; the terminator is consumed.
+ * Stops early after maxLength characters.  Returns false if the pipe was
+ * closed or could not be read before a terminator was found.
+ */
+static bool readPipeLine(std::string& line, size_t maxLength, const char* terminators) {
+    line.clear();
+    const char* termEnd = terminators + strlen(terminators);
+    while (line.length() < maxLength) {
+        if (pipeIn.start == pipeIn.end) {
+            long count = readPipeRaw(pipeIn.data, PIPE_BUFFER_SIZE);
+            if (count <= 0) {
+                return false;
+            }
+            pipeIn.start = 0;
+            pipeIn.end = (size_t) count;
+        }
+        const char* first = pipeIn.data + pipeIn.start;
+        const char* last = first + std::min(pipeIn.end - pipeIn.start, maxLength - line.length());
+        const char* stop = std::find_first_of(first, last, terminators, termEnd);
+        line.append(first, stop);
+        pipeIn.start += stop - first;
+        if (stop != last) {
+            pipeIn.start++;   // consume the terminator
+            return true;
+        }
     }
-    putPipe("LongCommand.end()");
+    return true;
 }
 
 #ifdef _WIN32
@@ -1936,6 +2103,16 @@ static WINBOOL WinCheck(WINBOOL result) {
 
 // Windows implementation; see Unix implementation elsewhere in this file
 int startupMain(int argc, char **argv) {
+    initCommandLine(argc, argv);
+    if (headless) {
+        exceptions::setProgramNameForStackTrace(argv[0]);
+#ifndef SPL_AUTOGRADER_MODE
+        extern int Main(int argc, char **argv);
+        return Main(argc, argv);
+#else // SPL_AUTOGRADER_MODE
+        return 0;
+#endif // SPL_AUTOGRADER_MODE
+    }
     startupMainDontRunMain(argc, argv);
 
 #ifndef SPL_AUTOGRADER_MODE
@@ -2026,43 +2203,46 @@ static void initPipe() {
 }
 
 // Windows implementation; see Unix implementation elsewhere in this file
-static void putPipe(std::string line) {
+static void writePipeRaw(const char* bytes, size_t length) {
+    DWORD nch;
+    if (!WinCheck(WriteFile(wrToJBE, bytes, length, &nch, NULL))) return;
+    WinCheck(FlushFileBuffers(wrToJBE));
+}
+
+// Windows implementation; see Unix implementation elsewhere in this file
+static long readPipeRaw(char* buffer, size_t length) {
+    DWORD nch;
+    if (!WinCheck(ReadFile(rdFromJBE, buffer, length, &nch, NULL))) {
+        return -1;
+    }
+    return (long) nch;
+}
+
+// Windows implementation; see Unix implementation elsewhere in this file
+static void putPipe(const std::string& line) {
+    flushPendingImages();
     if (line.length() > PIPE_MAX_COMMAND_LENGTH) {
         putPipeLongString(line);
         return;
     }
     
-    DWORD nch;
 #ifdef PIPE_DEBUG
     fprintf(stderr, "putPipe(\"%s\")\n", line.c_str());  fflush(stderr);
 #endif // PIPE_DEBUG
-    if (!WinCheck(WriteFile(wrToJBE, line.c_str(), line.length(), &nch, NULL))) return;
-    if (!WinCheck(WriteFile(wrToJBE, "\n", 1, &nch, NULL))) return;
-    WinCheck(FlushFileBuffers(wrToJBE));
+    writePipe(line.c_str(), line.length());
+    writePipe("\n", 1);
+    flushPipe();
 }
 
 // Windows implementation; see Unix implementation elsewhere in this file
 static std::string getPipe() {
-    std::string line = "";
-    DWORD nch;
+    std::string line;
 #ifdef PIPE_DEBUG
     fprintf(stderr, "getPipe(): waiting ...\n");  fflush(stderr);
 #endif // PIPE_DEBUG
 
-    int charsRead = 0;
-    int charsReadMax = 1024*1024;
-    while (charsRead < charsReadMax) {
-        char ch;
-        WINBOOL readFileResult = WinCheck(ReadFile(rdFromJBE, &ch, 1, &nch, NULL));
-        if (readFileResult == 0) {
-            break;   // failed to read from subprocess
-        }
-        if (ch == '\n' || ch == '\r') {
-            break;
-        }
-        line += ch;
-        charsRead++;
-    }
+    // a failed read from the subprocess just ends the line
+    readPipeLine(line, 1024*1024, "\n\r");
 
 #ifdef PIPE_DEBUG
     fprintf(stderr, "getPipe(): returned \"%s\"\n", line.c_str());  fflush(stderr);
@@ -2075,16 +2255,29 @@ static std::string getPipe() {
 /* Linux/Mac implementation of interface to Java back end */
 
 // Unix implementation; see Windows implementation elsewhere in this file
-static bool LinCheck(ssize_t result) {
-    if (result == EPIPE) {
-        // fputs("Error from Java back-end subprocess.\n", stderr);
-        // throw InterruptedIOException();
-        return false;
-    } else {
-        return true;
+static void writePipeRaw(const char* bytes, size_t length) {
+    while (length > 0) {
+        ssize_t count = write(pout, bytes, length);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count <= 0) {
+            // fputs("Error from Java back-end subprocess.\n", stderr);
+            return;
+        }
+        bytes += count;
+        length -= count;
     }
 }
 
+// Unix implementation; see Windows implementation elsewhere in this file
+static long readPipeRaw(char* buffer, size_t length) {
+    ssize_t count;
+    do {
+        count = read(pin, buffer, length);
+    } while (count < 0 && errno == EINTR);
+    return (long) count;
+}
+
 // Unix implementation; see Windows implementation elsewhere in this file
 static void scanOptions() {
     char *home = getenv("HOME");
@@ -2115,7 +2308,7 @@ static std::string getOption(std::string key) {
 
 // Unix implementation; see Windows implementation elsewhere in this file
 #ifdef SPL_AUTOGRADER_MODE
-int startupMain(int /*argc*/, char** argv) {
+int startupMain(int argc, char** argv) {
 #else // not SPL_AUTOGRADER_MODE
 int startupMain(int argc, char **argv) {
     extern int Main(int argc, char **argv);
@@ -2133,8 +2326,8 @@ int startupMain(int argc, char **argv) {
             chdir(cwd.c_str());
         }
     }
-    char *noConsoleFlag = getenv("NOCONSOLE");
-    if (noConsoleFlag != NULL && startsWith(std::string(noConsoleFlag), "t")) {
+    initCommandLine(argc, argv);
+    if (headless) {
 #ifdef SPL_AUTOGRADER_MODE
         return 0;
 #else // not SPL_AUTOGRADER_MODE
@@ -2339,7 +2532,8 @@ static void initPipe() {
 }
 
 // Unix implementation; see Windows implementation elsewhere in this file
-static void putPipe(std::string line) {
+static void putPipe(const std::string& line) {
+    flushPendingImages();
     if (line.length() > PIPE_MAX_COMMAND_LENGTH) {
         putPipeLongString(line);
         return;
@@ -2347,8 +2541,9 @@ static void putPipe(std::string line) {
 #ifdef PIPE_DEBUG
     fprintf(stderr, "putPipe(\"%s\")\n", line.c_str());  fflush(stderr);
 #endif
-    LinCheck(write(pout, line.c_str(), line.length()));
-    LinCheck(write(pout, "\n", 1));
+    writePipe(line.c_str(), line.length());
+    writePipe("\n", 1);
+    flushPipe();
     if (tracePipe) logfile << "-> " << line << std::endl;
 }
 
@@ -2357,21 +2552,9 @@ static std::string getPipe() {
 #ifdef PIPE_DEBUG
     fprintf(stderr, "getPipe(): waiting ...\n");  fflush(stderr);
 #endif
-    std::string line = "";
-    int charsRead = 0;
-    int charsReadMax = PIPE_MAX_COMMAND_LENGTH + 100;
-    while (charsRead < charsReadMax) {
-        char ch;
-        ssize_t result = read(pin, &ch, 1);
-        if (result <= 0) {
-            throw InterruptedIOException();
-            // break;   // failed to read from subprocess
-        }
-        if (ch == '\n') {
-            break;
-        }
-        line += ch;
-        charsRead++;
+    std::string line;
+    if (!readPipeLine(line, PIPE_MAX_COMMAND_LENGTH + 100, "\n")) {
+        throw InterruptedIOException();
     }
 #ifdef PIPE_DEBUG
     fprintf(stderr, "getPipe(): \"%s\"\n", line.c_str());  fflush(stderr);
@@ -2515,7 +2698,7 @@ static GEvent parseEvent(std::string line) {
     scanner.ignoreWhitespace();
     scanner.scanNumbers();
     scanner.scanStrings();
-    std::string name = scanner.nextToken();
+    StringView name = scanner.nextTokenView().text;
     if (name == "mousePressed") {
         return parseMouseEvent(scanner, MOUSE_PRESSED);
     } else if (name == "mouseReleased") {
@@ -3110,3 +3293,31 @@ static void setConsoleProperties() {
 //#endif
 //    throw InterruptedIOException();
 //}
+
+/*
+ * Remembers the program's command-line arguments and decides whether to run
+ * headless: that is, without the Java back-end and graphical console.
+ * This happens if any argument is --headless or if the NOCONSOLE environment
+ * variable is set to a 'true' value.
+ */
+static void initCommandLine(int argc, char** argv) {
+    commandLineArguments.clear();
+    for (int i = 1; i < argc; i++) {
+        commandLineArguments.push_back(argv[i]);
+        if (std::string(argv[i]) == "--headless") {
+            headless = true;
+        }
+    }
+    char* noConsoleFlag = getenv("NOCONSOLE");
+    if (noConsoleFlag != NULL && startsWith(std::string(noConsoleFlag), "t")) {
+        headless = true;
+    }
+}
+
+std::vector<std::string> getCommandLineArguments() {
+    return commandLineArguments;
+}
+
+bool isHeadless() {
+    return headless;
+}
@@ -5,6 +5,9 @@
  * the platform-specific parts of the StanfordCPPLib package.  This file is
  * logically part of the implementation and is not interesting to clients.
  *
+ * @version 2026/10/18
+ * - added gbufferedimage_deferUpdate, gbufferedimage_cancelUpdate and
+ *   gbufferedimage_updatePixels for batched pixel updates
  * @version 2015/11/07
  * - added GTable back-end methods
  * @version 2014/11/20
@@ -34,6 +37,8 @@
 #include "point.h"
 #include "sound.h"
 
+class GBufferedImage;
+
 class Platform {
 private:
     Platform();
@@ -88,6 +93,9 @@ public:
     std::string gbufferedimage_save(const GObject* const gobj, const std::string& filename);
     void gbufferedimage_setRGB(GObject* gobj, double x, double y, int rgb);
     void gbufferedimage_updateAllPixels(GObject* gobj, const std::string& base64);
+    void gbufferedimage_updatePixels(GObject* gobj, const std::vector<int>& runs);
+    void gbufferedimage_deferUpdate(GBufferedImage* image);
+    void gbufferedimage_cancelUpdate(GBufferedImage* image);
     void gbutton_constructor(GObject* gobj, std::string label);
     void gcheckbox_constructor(GObject* gobj, std::string label);
     bool gcheckbox_isSelected(GObject* gobj);
@@ -5,6 +5,12 @@
  * in which values are ordinarily processed in a first-in/first-out
  * (FIFO) order.
  * 
+ * @version 2026/10/18
+ * - added move constructor and assignment, emplace, reserve, and
+ *   add/enqueue overloads that move their value; dequeue moves the value out
+ * - growing the ring buffer moves its elements in two blocks instead of
+ *   copying the whole buffer first
+ * - equals compares the queues in place instead of copying both
  * @version 2015/07/05
  * - using global hashing functions rather than global variables
  * @version 2014/11/13
@@ -21,8 +27,10 @@
 #ifndef _queue_h
 #define _queue_h
 
+#include <algorithm>
 #include <deque>
 #include <queue>
+#include <utility>
 #include "error.h"
 #include "hashcode.h"
 #include "vector.h"
@@ -61,6 +69,7 @@ public:
      * A synonym for the enqueue method.
      */
     void add(const ValueType& value);
+    void add(ValueType&& value);
 
     /*
      * Method: back
@@ -93,6 +102,17 @@ public:
      * Adds <code>value</code> to the end of the queue.
      */
     void enqueue(const ValueType& value);
+    void enqueue(ValueType&& value);
+
+    /*
+     * Method: emplace
+     * Usage: queue.emplace(args...);
+     * ------------------------------
+     * Adds a value built from the given constructor arguments to the end
+     * of the queue.
+     */
+    template <typename... Args>
+    void emplace(Args&&... args);
     
     /*
      * Method: equals
@@ -141,6 +161,15 @@ public:
      */
     ValueType remove();
 
+    /*
+     * Method: reserve
+     * Usage: queue.reserve(n);
+     * ------------------------
+     * Makes room for at least <code>n</code> values, so that adding values
+     * up to that size will not reallocate the queue's storage.
+     */
+    void reserve(int n);
+
     /*
      * Method: size
      * Usage: int n = queue.size();
@@ -203,6 +232,18 @@ public:
     
     template <typename T>
     friend std::ostream& operator <<(std::ostream& os, const Queue<T>& queue);
+
+    /*
+     * Copy and move support
+     * ---------------------
+     * Copying a queue copies its ring buffer.  Moving one takes over the
+     * source's ring buffer and leaves the source empty.  These have to be
+     * declared because the queue declares a destructor.
+     */
+    Queue(const Queue& src) = default;
+    Queue& operator =(const Queue& src) = default;
+    Queue(Queue&& src) noexcept;
+    Queue& operator =(Queue&& src) noexcept;
     
     /* Private section */
 
@@ -226,7 +267,7 @@ private:
     int tail;
 
     /* Private functions */
-    void expandRingBufferCapacity();
+    void expandRingBufferCapacity(int newCapacity);
     int queueCompare(const Queue& queue2) const;
 };
 
@@ -260,6 +301,35 @@ Queue<ValueType>::Queue() {
     clear();
 }
 
+/*
+ * Implementation notes: move constructor and assignment operator
+ * ---------------------------------------------------------------
+ * A moved-from queue has no ring buffer at all and a capacity of 0; the
+ * next enqueue gives it a buffer of INITIAL_CAPACITY elements again.
+ */
+template <typename ValueType>
+Queue<ValueType>::Queue(Queue&& src) noexcept
+        : ringBuffer(std::move(src.ringBuffer)),
+          count(src.count),
+          capacity(src.capacity),
+          head(src.head),
+          tail(src.tail) {
+    src.count = src.capacity = src.head = src.tail = 0;
+}
+
+template <typename ValueType>
+Queue<ValueType>& Queue<ValueType>::operator =(Queue&& src) noexcept {
+    if (this != &src) {
+        ringBuffer = std::move(src.ringBuffer);
+        count = src.count;
+        capacity = src.capacity;
+        head = src.head;
+        tail = src.tail;
+        src.count = src.capacity = src.head = src.tail = 0;
+    }
+    return *this;
+}
+
 /*
  * Implementation notes: ~Queue destructor
  * ---------------------------------------
@@ -276,6 +346,11 @@ void Queue<ValueType>::add(const ValueType& value) {
     enqueue(value);
 }
 
+template <typename ValueType>
+void Queue<ValueType>::add(ValueType&& value) {
+    enqueue(std::move(value));
+}
+
 template <typename ValueType>
 const ValueType& Queue<ValueType>::back() const {
     if (count == 0) {
@@ -304,7 +379,7 @@ ValueType Queue<ValueType>::dequeue() {
     if (count == 0) {
         error("Queue::dequeue: Attempting to dequeue an empty queue");
     }
-    ValueType result = ringBuffer[head];
+    ValueType result = std::move(ringBuffer[head]);
     head = (head + 1) % capacity;
     count--;
     return result;
@@ -313,13 +388,31 @@ ValueType Queue<ValueType>::dequeue() {
 template <typename ValueType>
 void Queue<ValueType>::enqueue(const ValueType& value) {
     if (count >= capacity - 1) {
-        expandRingBufferCapacity();
+        // value may be one of our own elements, about to be moved
+        enqueue(ValueType(value));
+        return;
     }
     ringBuffer[tail] = value;
     tail = (tail + 1) % capacity;
     count++;
 }
 
+template <typename ValueType>
+void Queue<ValueType>::enqueue(ValueType&& value) {
+    if (count >= capacity - 1) {
+        expandRingBufferCapacity(std::max(INITIAL_CAPACITY, 2 * capacity));
+    }
+    ringBuffer[tail] = std::move(value);
+    tail = (tail + 1) % capacity;
+    count++;
+}
+
+template <typename ValueType>
+template <typename... Args>
+void Queue<ValueType>::emplace(Args&&... args) {
+    enqueue(ValueType(std::forward<Args>(args)...));
+}
+
 template <typename ValueType>
 bool Queue<ValueType>::equals(const Queue<ValueType>& queue2) const {
     if (this == &queue2) {
@@ -328,14 +421,13 @@ bool Queue<ValueType>::equals(const Queue<ValueType>& queue2) const {
     if (size() != queue2.size()) {
         return false;
     }
-    Queue<ValueType> copy1 = *this;
-    Queue<ValueType> copy2 = queue2;
-    while (!copy1.isEmpty() && !copy2.isEmpty()) {
-        if (!(copy1.dequeue() == copy2.dequeue())) {
+    for (int i = 0; i < count; i++) {
+        if (!(ringBuffer[(head + i) % capacity]
+              == queue2.ringBuffer[(queue2.head + i) % queue2.capacity])) {
             return false;
         }
     }
-    return copy1.isEmpty() == copy2.isEmpty();
+    return true;
 }
 
 template <typename ValueType>
@@ -369,6 +461,13 @@ ValueType Queue<ValueType>::remove() {
     return dequeue();
 }
 
+template <typename ValueType>
+void Queue<ValueType>::reserve(int n) {
+    if (n >= capacity) {
+        expandRingBufferCapacity(n + 1);   // the ring always keeps one slot free
+    }
+}
+
 template <typename ValueType>
 int Queue<ValueType>::size() const {
     return count;
@@ -402,20 +501,26 @@ std::string Queue<ValueType>::toString() const {
 /*
  * Implementation notes: expandRingBufferCapacity
  * ----------------------------------------------
- * This private method doubles the capacity of the ringBuffer vector.
+ * This private method replaces the ringBuffer vector with a larger one.
  * Note that this implementation also shifts all the elements back to
- * the beginning of the vector.
+ * the beginning of the vector.  The elements run from head to the end
+ * of the old buffer and then wrap around to its start, so they are moved
+ * as those two blocks.
  */
 template <typename ValueType>
-void Queue<ValueType>::expandRingBufferCapacity() {
-    Vector<ValueType> copy = ringBuffer;
-    ringBuffer = Vector<ValueType>(2 * capacity);
-    for (int i = 0; i < count; i++) {
-        ringBuffer[i] = copy[(head + i) % capacity];
+void Queue<ValueType>::expandRingBufferCapacity(int newCapacity) {
+    Vector<ValueType> bigger(newCapacity);
+    if (count > 0) {
+        ValueType* from = &ringBuffer[0];
+        ValueType* to = &bigger[0];
+        int firstBlock = std::min(count, capacity - head);
+        std::move(from + head, from + head + firstBlock, to);
+        std::move(from, from + count - firstBlock, to + firstBlock);
     }
+    ringBuffer = std::move(bigger);
     head = 0;
     tail = count;
-    capacity *= 2;
+    capacity = newCapacity;
 }
 
 template <typename ValueType>
@@ -3,6 +3,11 @@
  * ----------------
  * This file implements the random.h interface.
  * 
+ * @version 2026/10/18
+ * - replaced rand() with a xoshiro256** generator per thread
+ * - randomInteger draws exactly uniform integers without floating point
+ * - the autograder queues are only consulted once values have been fed
+ * - added RandomGenerator and getRandomSeed
  * @version 2014/10/19
  * - alphabetized functions
  * @version 2014/10/08
@@ -10,14 +15,17 @@
  */
 
 #include "random.h"
-#include <cstdlib>
-#include <cmath>
+#include <atomic>
 #include <ctime>
+#include <mutex>
 #include <queue>
+#include "error.h"
+#include "strlib.h"
 
-/* Private function prototype */
+/* Private function prototypes */
 
 static void initRandomSeed();
+static RandomGenerator& threadGenerator();
 
 namespace autograder {
 /* internal buffer of fixed random numbers to return; used by autograders */
@@ -25,17 +33,156 @@ std::queue<bool> fixedBools;
 std::queue<int> fixedInts;
 std::queue<double> fixedReals;
 
+/* set once any value is fed, so that normal calls skip the queues */
+static std::atomic<bool> anyFixed(false);
+
 void randomFeedBool(bool value) {
     fixedBools.push(value);
+    anyFixed.store(true);
 }
 
 void randomFeedInteger(int value) {
     fixedInts.push(value);
+    anyFixed.store(true);
 }
 
 void randomFeedReal(double value) {
     fixedReals.push(value);
+    anyFixed.store(true);
+}
+}
+
+/*
+ * Implementation notes: RandomGenerator
+ * -------------------------------------
+ * The generator is xoshiro256** by David Blackman and Sebastiano Vigna,
+ * which passes the standard statistical test suites and produces a
+ * number in a handful of instructions.  Its 256 bits of state are filled
+ * from the seed and the stream number with SplitMix64, as its authors
+ * recommend; with so much state, two streams are overwhelmingly unlikely
+ * to come anywhere near each other.
+ */
+
+static unsigned long long splitMix64(unsigned long long& x) {
+    unsigned long long z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
 }
+
+static inline unsigned long long rotateLeft(unsigned long long x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+RandomGenerator::RandomGenerator(unsigned long long seed, unsigned long long stream) {
+    unsigned long long x = seed;
+    unsigned long long mixedStream = splitMix64(stream);
+    x ^= mixedStream;
+    for (int i = 0; i < 4; i++) {
+        state[i] = splitMix64(x);
+    }
+}
+
+unsigned long long RandomGenerator::next() {
+    unsigned long long result = rotateLeft(state[1] * 5, 7) * 9;
+    unsigned long long t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotateLeft(state[3], 45);
+    return result;
+}
+
+bool RandomGenerator::nextBool() {
+    return (next() >> 63) != 0;
+}
+
+bool RandomGenerator::nextChance(double p) {
+    return nextReal(0, 1) < p;
+}
+
+/*
+ * Implementation notes: nextBounded
+ * ---------------------------------
+ * Returns a number in [0 .. range) by Lemire's method: the top 32 bits of
+ * a 64-bit product of 32 random bits and the range.  Products whose low
+ * half falls below 2^32 mod range would make some results more likely
+ * than others, so they are rejected; the remainder that identifies them
+ * is only computed in the rare case that the low half is small at all.
+ */
+unsigned int RandomGenerator::nextBounded(unsigned int range) {
+    unsigned long long product = (next() >> 32) * range;
+    unsigned int low = (unsigned int) product;
+    if (low < range) {
+        unsigned int threshold = (0u - range) % range;
+        while (low < threshold) {
+            product = (next() >> 32) * range;
+            low = (unsigned int) product;
+        }
+    }
+    return (unsigned int) (product >> 32);
+}
+
+int RandomGenerator::nextInteger(int low, int high) {
+    if (low > high) {
+        error("RandomGenerator::nextInteger: low (" + integerToString(low)
+              + ") must not be greater than high (" + integerToString(high) + ")");
+    }
+    unsigned long long range = (unsigned long long) ((long long) high - low) + 1;
+    if (range > 0xFFFFFFFFULL) {
+        return (int) (unsigned int) (next() >> 32);
+    }
+    return (int) (low + (long long) nextBounded((unsigned int) range));
+}
+
+double RandomGenerator::nextReal(double low, double high) {
+    // the top 53 bits give every double in [0 .. 1) that is a multiple of 2^-53
+    double d = (next() >> 11) * (1.0 / 9007199254740992.0);
+    return low + d * (high - low);
+}
+
+void RandomGenerator::fillIntegers(int* values, int n, int low, int high) {
+    if (low > high) {
+        error("RandomGenerator::fillIntegers: low (" + integerToString(low)
+              + ") must not be greater than high (" + integerToString(high) + ")");
+    }
+    unsigned long long range = (unsigned long long) ((long long) high - low) + 1;
+    for (int i = 0; i < n; i++) {
+        if (range > 0xFFFFFFFFULL) {
+            values[i] = (int) (unsigned int) (next() >> 32);
+        } else {
+            values[i] = (int) (low + (long long) nextBounded((unsigned int) range));
+        }
+    }
+}
+
+void RandomGenerator::fillReals(double* values, int n, double low, double high) {
+    for (int i = 0; i < n; i++) {
+        values[i] = nextReal(low, high);
+    }
+}
+
+void RandomGenerator::jump() {
+    static const unsigned long long JUMP[] = {
+        0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+        0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+    };
+    unsigned long long s[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (JUMP[i] & (1ULL << b)) {
+                for (int k = 0; k < 4; k++) {
+                    s[k] ^= state[k];
+                }
+            }
+            next();
+        }
+    }
+    for (int k = 0; k < 4; k++) {
+        state[k] = s[k];
+    }
 }
 
 bool randomBool() {
@@ -49,13 +196,13 @@ bool randomBool() {
  * whether the result is less than the requested probability.
  */
 bool randomChance(double p) {
-    if (!autograder::fixedBools.empty()) {
+    if (autograder::anyFixed.load(std::memory_order_relaxed)
+            && !autograder::fixedBools.empty()) {
         bool top = autograder::fixedBools.front();
         autograder::fixedBools.pop();
         return top;
     }
-    initRandomSeed();
-    return randomReal(0, 1) < p;
+    return threadGenerator().nextChance(p);
 }
 
 //template <typename T>
@@ -67,77 +214,106 @@ bool randomChance(double p) {
 /*
  * Implementation notes: randomInteger
  * -----------------------------------
- * The code for randomInteger produces the number in four steps:
- *
- * 1. Generate a random real number d in the range [0 .. 1).
- * 2. Scale the number to the range [0 .. N) where N is the number of values.
- * 3. Translate the number so that the range starts at the appropriate value.
- * 4. Convert the result to the next lower integer.
- *
- * The implementation is complicated by the fact that both the expression
- *
- *     RAND_MAX + 1
- *
- * and the expression for the number of values
- *
- *     high - low + 1
- *
- * can overflow the integer range.  These calculations must therefore be
- * performed using doubles instead of ints.
+ * The code for randomInteger used to scale a random real number to the
+ * range, which made some values slightly more likely than others when the
+ * range did not divide RAND_MAX + 1.  RandomGenerator::nextInteger works
+ * on integers and is exactly uniform.
  */
 int randomInteger(int low, int high) {
-    if (!autograder::fixedInts.empty()) {
+    if (autograder::anyFixed.load(std::memory_order_relaxed)
+            && !autograder::fixedInts.empty()) {
         int top = autograder::fixedInts.front();
         autograder::fixedInts.pop();
         return top;
     }
-    initRandomSeed();
-    double d = rand() / (double(RAND_MAX) + 1);
-    double s = d * (double(high) - low + 1);
-    return int(floor(low + s));
+    if (low > high) {
+        error("randomInteger: low (" + integerToString(low)
+              + ") must not be greater than high (" + integerToString(high) + ")");
+    }
+    return threadGenerator().nextInteger(low, high);
 }
 
-/*
- * Implementation notes: randomReal
- * --------------------------------
- * The code for randomReal is similar to that for randomInteger,
- * without the final conversion step.
- */
 double randomReal(double low, double high) {
-    if (!autograder::fixedReals.empty()) {
+    if (autograder::anyFixed.load(std::memory_order_relaxed)
+            && !autograder::fixedReals.empty()) {
         double top = autograder::fixedReals.front();
         autograder::fixedReals.pop();
         return top;
     }
+    return threadGenerator().nextReal(low, high);
+}
+
+/*
+ * Implementation notes: seeds and threads
+ * ---------------------------------------
+ * The seed is shared by all threads, along with an epoch number that
+ * setRandomSeed increases.  Each thread keeps its own generator and the
+ * epoch it was made for; when the epoch has moved on, the thread rebuilds
+ * its generator from the current seed and the next stream number.
+ * setRandomSeed starts the stream numbers over at 0, so that reseeding
+ * hands out the same streams again.  Epoch 0 means that no seed has been
+ * chosen yet.
+ */
+static std::mutex seedMutex;
+static std::atomic<int> currentSeed(0);
+static std::atomic<unsigned int> seedEpoch(0);
+static int nextStream = 0;      // guarded by seedMutex
+
+struct ThreadRandom {
+    RandomGenerator generator;
+    unsigned int epoch;
+
+    ThreadRandom() : epoch(0) {}
+};
+
+static thread_local ThreadRandom threadRandom;
+
+static RandomGenerator& threadGenerator() {
+    initRandomSeed();
+    ThreadRandom& local = threadRandom;
+    if (local.epoch != seedEpoch.load(std::memory_order_acquire)) {
+        // the seed, epoch and stream number must all come from the same
+        // setRandomSeed call
+        std::lock_guard<std::mutex> lock(seedMutex);
+        local.epoch = seedEpoch.load(std::memory_order_relaxed);
+        local.generator = RandomGenerator((unsigned int) currentSeed.load(std::memory_order_relaxed),
+                                          nextStream++);
+    }
+    return local.generator;
+}
+
+int getRandomSeed() {
     initRandomSeed();
-    double d = rand() / (double(RAND_MAX) + 1);
-    double s = d * (high - low);
-    return low + s;
+    return currentSeed.load();
 }
 
 /*
  * Implementation notes: setRandomSeed
  * -----------------------------------
- * The setRandomSeed function simply forwards its argument to srand.
- * The call to initRandomSeed is required to set the initialized flag.
+ * The setRandomSeed function stores the new seed and starts a new epoch,
+ * so that every thread's generator is rebuilt before its next use, with
+ * stream numbers handed out from 0 again.
  */
 void setRandomSeed(int seed) {
-    initRandomSeed();
-    srand(seed);
+    std::lock_guard<std::mutex> lock(seedMutex);
+    currentSeed.store(seed, std::memory_order_relaxed);
+    nextStream = 0;
+    unsigned int epoch = seedEpoch.load(std::memory_order_relaxed) + 1;
+    seedEpoch.store(epoch == 0 ? 1 : epoch, std::memory_order_release);
 }
 
 /*
  * Implementation notes: initRandomSeed
  * ------------------------------------
- * The initRandomSeed function declares a static variable that keeps track
- * of whether the seed has been initialized.  The first time initRandomSeed
- * is called, initialized is false, so the seed is set to the current time.
+ * The first time a random number is needed, the initRandomSeed function
+ * sets the seed to the current time, unless setRandomSeed has been called.
  */
 static void initRandomSeed() {
-    static bool initialized = false;
-    if (!initialized) {
-        srand(int(time(NULL)));
-        rand();   // BUGFIX: throwaway call to get randomness going
-        initialized = true;
+    if (seedEpoch.load(std::memory_order_acquire) == 0) {
+        std::lock_guard<std::mutex> lock(seedMutex);
+        if (seedEpoch.load(std::memory_order_relaxed) == 0) {
+            currentSeed.store(int(time(NULL)), std::memory_order_relaxed);
+            seedEpoch.store(1, std::memory_order_release);
+        }
     }
 }
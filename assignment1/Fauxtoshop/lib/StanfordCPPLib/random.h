@@ -1,8 +1,15 @@
 /*
  * File: random.h
  * --------------
- * This file exports functions for generating pseudorandom numbers.
+ * This file exports functions for generating pseudorandom numbers, and the
+ * <code>RandomGenerator</code> class behind them.
  * 
+ * @version 2026/10/18
+ * - numbers come from a xoshiro256** generator per thread instead of rand(),
+ *   so the functions can be called from several threads at once
+ * - randomInteger is exactly uniform and uses no floating-point arithmetic
+ * - added RandomGenerator class with independent streams and bulk filling,
+ *   and getRandomSeed
  * @version 2014/10/19
  * - alphabetized functions
  */
@@ -12,6 +19,109 @@
 
 #include <vector>
 
+/*
+ * Class: RandomGenerator
+ * ----------------------
+ * A fast pseudorandom number generator using the xoshiro256** algorithm of
+ * Blackman and Vigna.  A generator is created from a seed and a stream
+ * number; generators with the same seed and different streams produce
+ * unrelated sequences, which lets parallel code give each task its own
+ * generator and still get the same results on every run, however the
+ * tasks are scheduled.  A generator must not be shared between threads
+ * without locking, but each thread may use its own.
+ */
+class RandomGenerator {
+public:
+    /*
+     * Constructor: RandomGenerator
+     * Usage: RandomGenerator gen(seed);
+     *        RandomGenerator gen(seed, stream);
+     * -----------------------------------------
+     * Initializes a generator for the given seed and stream, which
+     * defaults to 0.
+     */
+    explicit RandomGenerator(unsigned long long seed = 0, unsigned long long stream = 0);
+
+    /*
+     * Method: next
+     * Usage: unsigned long long bits = gen.next();
+     * --------------------------------------------
+     * Returns the next 64 random bits.
+     */
+    unsigned long long next();
+
+    /*
+     * Method: nextBool
+     * Usage: if (gen.nextBool()) ...
+     * ------------------------------
+     * Returns <code>true</code> with 50% probability.
+     */
+    bool nextBool();
+
+    /*
+     * Method: nextChance
+     * Usage: if (gen.nextChance(p)) ...
+     * ---------------------------------
+     * Returns <code>true</code> with probability <code>p</code>.
+     */
+    bool nextChance(double p);
+
+    /*
+     * Method: nextInteger
+     * Usage: int n = gen.nextInteger(low, high);
+     * ------------------------------------------
+     * Returns a random integer in the range <code>low</code> to
+     * <code>high</code>, inclusive, with every value exactly equally
+     * likely.  Raises an error if <code>low</code> is greater than
+     * <code>high</code>.
+     */
+    int nextInteger(int low, int high);
+
+    /*
+     * Method: nextReal
+     * Usage: double d = gen.nextReal(low, high);
+     * ------------------------------------------
+     * Returns a random real number in the half-open interval
+     * [<code>low</code>&nbsp;..&nbsp;<code>high</code>).
+     */
+    double nextReal(double low, double high);
+
+    /*
+     * Method: fillIntegers
+     * Usage: gen.fillIntegers(values, n, low, high);
+     * ----------------------------------------------
+     * Stores n random integers in the range <code>low</code> to
+     * <code>high</code> into the given array, the same values that n calls
+     * to nextInteger would return.
+     */
+    void fillIntegers(int* values, int n, int low, int high);
+
+    /*
+     * Method: fillReals
+     * Usage: gen.fillReals(values, n, low, high);
+     * -------------------------------------------
+     * Stores n random real numbers in [<code>low</code>&nbsp;..&nbsp;
+     * <code>high</code>) into the given array, the same values that n calls
+     * to nextReal would return.
+     */
+    void fillReals(double* values, int n, double low, double high);
+
+    /*
+     * Method: jump
+     * Usage: gen.jump();
+     * ------------------
+     * Advances the generator by 2<sup>128</sup> numbers, as if next had been
+     * called that many times.  Calling jump on copies of one generator gives
+     * sequences that are guaranteed not to overlap.
+     */
+    void jump();
+
+private:
+    unsigned long long state[4];
+
+    unsigned int nextBounded(unsigned int range);
+};
+
 /*
  * Function: randomBool
  * Usage: if (randomBool()) ...
@@ -47,7 +157,8 @@ bool randomChance(double p);
  * Usage: int n = randomInteger(low, high);
  * ----------------------------------------
  * Returns a random integer in the range <code>low</code> to
- * <code>high</code>, inclusive.
+ * <code>high</code>, inclusive.  Raises an error if <code>low</code> is
+ * greater than <code>high</code>.
  */
 int randomInteger(int low, int high);
 
@@ -63,6 +174,17 @@ int randomInteger(int low, int high);
  */
 double randomReal(double low, double high);
 
+/*
+ * Function: getRandomSeed
+ * Usage: int seed = getRandomSeed();
+ * ----------------------------------
+ * Returns the seed of the internal random number generators: the value
+ * last passed to setRandomSeed, or one chosen from the clock if it has not
+ * been called.  Parallel code can pass it to RandomGenerator along with a
+ * task number to make its own reproducible generators.
+ */
+int getRandomSeed();
+
 /*
  * Function: setRandomSeed
  * Usage: setRandomSeed(seed);
@@ -71,6 +193,14 @@ double randomReal(double low, double high);
  * can use this function to set a specific starting point for the
  * pseudorandom sequence or to ensure that program behavior is
  * repeatable during the debugging phase.
+ *
+ * Each thread draws the numbers for the functions above from its own
+ * generator.  After setRandomSeed, the threads are given stream numbers in
+ * the order in which they next ask for a random number, starting with 0.
+ * A thread's numbers are therefore only repeatable if the threads first
+ * ask for a random number in the same order every run, as when one thread
+ * at a time does so.  Parallel tasks whose order is not fixed should use
+ * RandomGenerator(getRandomSeed(), task) instead.
  */
 void setRandomSeed(int seed);
 
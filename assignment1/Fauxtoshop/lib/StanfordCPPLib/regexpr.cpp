@@ -5,6 +5,10 @@
  * See regexpr.h for documentation of each function.
  *
  * @author Marty Stepp
+ * @version 2026/10/18
+ * - regular expressions are compiled and matched in-process instead of
+ *   being sent to the Java back-end; compiled patterns are kept in an LRU
+ *   cache
  * @version 2015/07/05
  * - removed static global Platform variable, replaced by getPlatform as needed
  * @version 2014/10/14
@@ -15,16 +19,1297 @@
  */
 
 #include "regexpr.h"
-#include "platform.h"
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "error.h"
+#include "strlib.h"
+
+/* characters with a special meaning in a pattern */
+static const char* const SPECIAL_CHARS = "\\^$.|?*+()[]{}";
+
+/* most instructions a pattern may compile to, after expanding {n,m} */
+static const int MAX_PROGRAM_SIZE = 100000;
+
+/*
+ * Implementation notes: matcher
+ * -----------------------------
+ * A pattern is parsed into a small tree and compiled into a program of
+ * the instructions below.  Most programs are run as a "Pike VM": the
+ * matcher reads the input one character at a time and keeps a list of
+ * every place in the program a match could have reached, in the order a
+ * backtracking matcher would try them, so it finds the same match.  The
+ * list holds each instruction at most once, so a match takes time
+ * proportional to the length of the input times the size of the program,
+ * and neither the time nor the stack use can blow up on long input.
+ *
+ * Each lookahead is compiled as a separate part of the program, after the
+ * main part, and is run from the position where it is reached as a match
+ * that must start there.  Its result depends only on the position, so it
+ * is computed once per position.
+ *
+ * A back-reference makes the match depend on the text of each group, not
+ * just on the place in the program, so a pattern with one is run by a
+ * backtracking matcher instead, as Java does.  It keeps its choice points
+ * and the group positions to restore on an explicit stack rather than by
+ * recursion, and each loop records where its iteration started so that,
+ * as in Java, an iteration that consumes nothing ends the loop instead of
+ * repeating forever.
+ */
+enum RegexOp {
+    OP_CHAR,                // x = the character
+    OP_ANY,                 // any character but a line break
+    OP_CLASS,               // x = index of the character class
+    OP_BACKREF,             // x = the group whose text must appear next
+    OP_SPLIT,               // continue at x, or failing that at y
+    OP_JUMP,                // continue at x
+    OP_SAVE,                // record the position in slot x
+    OP_PROGRESS,            // continue at y if the position equals slot x
+    OP_LOOKAHEAD,           // x = start of the lookahead, y = its index
+    OP_NEGATIVE_LOOKAHEAD,
+    OP_LINE_START,
+    OP_LINE_END,
+    OP_WORD_BOUNDARY,
+    OP_NOT_WORD_BOUNDARY,
+    OP_MATCH
+};
+
+struct RegexInstruction {
+    RegexOp op;
+    int x;
+    int y;
+};
+
+struct RegexProgram {
+    std::vector<RegexInstruction> code;
+    std::vector<std::bitset<256> > classes;
+    std::bitset<256> firstChars;    // characters a match can start with
+    bool emptyMatch;                // true if a match may consume nothing
+    bool anchored;                  // true if a match can only start at 0
+    bool backtrack;                 // true if run by the backtracking matcher
+    bool icase;                     // true if back-references ignore case
+    int groups;                     // number of capturing groups
+    int slots;                      // group positions plus loop starts
+    int lookaheads;                 // number of lookaheads
+};
+
+static bool isWordChar(int ch) {
+    return isalnum(ch) || ch == '_';
+}
+
+/*
+ * Sets set to the characters matched by the class escape \ch, such as \d
+ * or \W, and returns true, or returns false if ch is not a class escape.
+ */
+static bool classEscape(char ch, std::bitset<256>& set) {
+    set.reset();
+    switch (tolower((unsigned char) ch)) {
+    case 'd':
+        for (int c = '0'; c <= '9'; c++) {
+            set.set(c);
+        }
+        break;
+    case 'w':
+        for (int c = 0; c < 256; c++) {
+            if (c < 128 && isWordChar(c)) {
+                set.set(c);
+            }
+        }
+        break;
+    case 's':
+        for (const char* p = " \t\n\v\f\r"; *p != '\0'; p++) {
+            set.set((unsigned char) *p);
+        }
+        break;
+    default:
+        return false;
+    }
+    if (isupper((unsigned char) ch)) {
+        set.flip();
+    }
+    return true;
+}
+
+/*
+ * Class: RegexCompiler
+ * --------------------
+ * Parses a pattern into a tree of nodes and compiles the tree into a
+ * RegexProgram.  Nodes refer to their children by index in the node list.
+ * Syntax errors, and the Java features that are not implemented, are
+ * reported with error() naming the pattern as the user wrote it.
+ */
+class RegexCompiler {
+public:
+    RegexCompiler(const std::string& source, const std::string& pattern, bool icase)
+            : source(source), pattern(pattern), pos(0), icase(icase), maxBackref(0) {
+        /* empty */
+    }
+
+    void compile(RegexProgram& program) {
+        program.groups = 0;
+        program.backtrack = false;
+        program.icase = icase;
+        program.lookaheads = 0;
+        this->program = &program;
+        int root = parseAlternation();
+        if (pos < pattern.length()) {
+            fail("unmatched ')'");
+        }
+        if (maxBackref > program.groups) {
+            fail("back-reference \\" + integerToString(maxBackref)
+                 + " to a group that does not exist");
+        }
+        program.slots = 2 * (program.groups + 1);
+        program.code.clear();
+        add(OP_SAVE, 0);
+        emit(root);
+        add(OP_SAVE, 1);
+        add(OP_MATCH);
+
+        // each lookahead runs from its own start to its own OP_MATCH
+        for (size_t i = 0; i < lookaheadNodes.size(); i++) {
+            program.code[lookaheadNodes[i].first].x = program.code.size();
+            emit(lookaheadNodes[i].second);
+            add(OP_MATCH);
+        }
+        program.anchored = nodes[root].kind == CONCAT && !nodes[root].children.empty()
+                && nodes[nodes[root].children[0]].kind == ASSERT
+                && nodes[nodes[root].children[0]].value == OP_LINE_START;
+        findFirstChars();
+    }
+
+private:
+    enum Kind { CHAR, ANY, CLASS, BACKREF, CONCAT, ALTERNATE, REPEAT, GROUP,
+                LOOKAHEAD, ASSERT };
+
+    struct Node {
+        Kind kind;
+        int value;      // the character, class index, group number or assertion
+        int min;        // REPEAT: fewest repetitions
+        int max;        // REPEAT: most repetitions, or -1 for no limit
+        bool greedy;
+        std::vector<int> children;
+    };
+
+    const std::string& source;
+    const std::string& pattern;
+    size_t pos;
+    bool icase;
+    int maxBackref;
+    RegexProgram* program;
+    std::vector<Node> nodes;
+    std::vector<std::pair<int, int> > lookaheadNodes;   // instruction, body node
+
+    void fail(const std::string& reason) const {
+        error("Regex: invalid regular expression \"" + source + "\": " + reason);
+    }
+
+    int newNode(Kind kind, int value = 0) {
+        Node node;
+        node.kind = kind;
+        node.value = value;
+        node.min = node.max = 0;
+        node.greedy = true;
+        nodes.push_back(node);
+        return nodes.size() - 1;
+    }
+
+    bool peek(char ch) const {
+        return pos < pattern.length() && pattern[pos] == ch;
+    }
+
+    char next() {
+        if (pos >= pattern.length()) {
+            fail("unexpected end of pattern");
+        }
+        return pattern[pos++];
+    }
+
+    int parseAlternation() {
+        int first = parseConcatenation();
+        if (!peek('|')) {
+            return first;
+        }
+        std::vector<int> choices(1, first);
+        while (peek('|')) {
+            pos++;
+            choices.push_back(parseConcatenation());
+        }
+        int alt = newNode(ALTERNATE);
+        nodes[alt].children = choices;
+        return alt;
+    }
+
+    int parseConcatenation() {
+        std::vector<int> items;
+        while (pos < pattern.length() && !peek('|') && !peek(')')) {
+            items.push_back(parseRepetition());
+        }
+        int concat = newNode(CONCAT);
+        nodes[concat].children = items;
+        return concat;
+    }
+
+    int parseRepetition() {
+        int atom = parseAtom();
+        int min, max;
+        if (peek('*')) {
+            min = 0;
+            max = -1;
+        } else if (peek('+')) {
+            min = 1;
+            max = -1;
+        } else if (peek('?')) {
+            min = 0;
+            max = 1;
+        } else if (peek('{')) {
+            pos++;
+            min = max = parseNumber();
+            if (peek(',')) {
+                pos++;
+                max = peek('}') ? -1 : parseNumber();
+            }
+            if (!peek('}')) {
+                fail("malformed {n,m} repetition");
+            } else if (max >= 0 && max < min) {
+                fail("{n,m} repetition with m less than n");
+            }
+        } else {
+            return atom;
+        }
+        pos++;
+        if (nodes[atom].kind == ASSERT) {
+            fail("nothing to repeat before '" + pattern.substr(pos - 1, 1) + "'");
+        }
+        bool greedy = true;
+        if (peek('?')) {
+            greedy = false;
+            pos++;
+        } else if (peek('+')) {
+            fail("possessive quantifiers are not supported");
+        }
+        if (peek('*') || peek('+') || peek('?') || peek('{')) {
+            fail("nothing to repeat before '" + pattern.substr(pos, 1) + "'");
+        }
+        int repeat = newNode(REPEAT);
+        nodes[repeat].min = min;
+        nodes[repeat].max = max;
+        nodes[repeat].greedy = greedy;
+        nodes[repeat].children.push_back(atom);
+        return repeat;
+    }
+
+    int parseNumber() {
+        int n = 0;
+        if (pos >= pattern.length() || !isdigit((unsigned char) pattern[pos])) {
+            fail("malformed {n,m} repetition");
+        }
+        while (pos < pattern.length() && isdigit((unsigned char) pattern[pos])) {
+            n = n * 10 + (pattern[pos++] - '0');
+            if (n > MAX_PROGRAM_SIZE) {
+                fail("repetition count is too large");
+            }
+        }
+        return n;
+    }
+
+    int parseAtom() {
+        char ch = next();
+        switch (ch) {
+        case '(':
+            return parseGroup();
+        case '.':
+            return newNode(ANY);
+        case '^':
+            return newNode(ASSERT, OP_LINE_START);
+        case '$':
+            return newNode(ASSERT, OP_LINE_END);
+        case '[':
+            return parseClass();
+        case '\\': {
+            char escaped = next();
+            if (escaped == 'b') {
+                return newNode(ASSERT, OP_WORD_BOUNDARY);
+            } else if (escaped == 'B') {
+                return newNode(ASSERT, OP_NOT_WORD_BOUNDARY);
+            } else if (escaped >= '1' && escaped <= '9') {
+                return parseBackreference(escaped - '0');
+            }
+            std::bitset<256> set;
+            if (classEscape(escaped, set)) {
+                return classNode(set);
+            }
+            return charNode(characterEscape(escaped));
+        }
+        case ')':
+            fail("unmatched ')'");
+            break;
+        case '*': case '+': case '?': case '{':
+            fail("nothing to repeat before '" + std::string(1, ch) + "'");
+            break;
+        default:
+            return charNode((unsigned char) ch);
+        }
+        return -1;
+    }
+
+    /*
+     * Parses the rest of a group after its '('.  (?:...) does not capture,
+     * and (?=...) and (?!...) are lookaheads; the other (? forms are not
+     * supported.
+     */
+    int parseGroup() {
+        Kind kind = GROUP;
+        int value = -1;
+        if (peek('?')) {
+            pos++;
+            char type = next();
+            if (type == '=' || type == '!') {
+                kind = LOOKAHEAD;
+                value = type == '!';
+            } else if (type == '<' && (peek('=') || peek('!'))) {
+                fail("lookbehind is not supported");
+            } else if (type == '<') {
+                fail("named groups are not supported");
+            } else if (type == '>') {
+                fail("atomic groups are not supported");
+            } else if (type != ':') {
+                fail("flags other than a leading (?i) are not supported");
+            }
+        } else {
+            value = ++program->groups;
+        }
+        int inner = parseAlternation();
+        if (pos >= pattern.length()) {
+            fail("missing ')'");
+        }
+        pos++;
+        int node = newNode(kind, value);
+        nodes[node].children.push_back(inner);
+        return node;
+    }
+
+    /*
+     * Parses a back-reference to group n.  As in Java, further digits are
+     * part of the number as long as a group with that number has begun.
+     */
+    int parseBackreference(int n) {
+        while (pos < pattern.length() && isdigit((unsigned char) pattern[pos])
+               && n * 10 + (pattern[pos] - '0') <= program->groups) {
+            n = n * 10 + (pattern[pos++] - '0');
+        }
+        maxBackref = std::max(maxBackref, n);
+        program->backtrack = true;
+        return newNode(BACKREF, n);
+    }
+
+    /*
+     * Returns the character written as \ch, not counting class escapes and
+     * back-references.
+     */
+    int characterEscape(char ch) {
+        switch (ch) {
+        case 'n': return '\n';
+        case 'r': return '\r';
+        case 't': return '\t';
+        case 'f': return '\f';
+        case 'v': return '\v';
+        case 'a': return '\a';
+        case 'e': return '\x1b';
+        case '0': {
+            // up to three octal digits, at most \0377
+            int value = 0;
+            for (int i = 0; i < 3 && pos < pattern.length() && pattern[pos] >= '0'
+                 && pattern[pos] <= '7' && value * 8 + (pattern[pos] - '0') <= 0377; i++) {
+                value = value * 8 + (pattern[pos++] - '0');
+            }
+            return value;
+        }
+        case 'x':
+            return parseHex(2);
+        case 'u': {
+            int value = parseHex(4);
+            if (value > 255) {
+                fail("characters above \\u00ff are not supported");
+            }
+            return value;
+        }
+        default:
+            if (isdigit((unsigned char) ch)) {
+                fail("back-references are not allowed in a character class");
+            } else if (isalpha((unsigned char) ch)) {
+                fail("the escape \\" + std::string(1, ch) + " is not supported");
+            }
+            return (unsigned char) ch;
+        }
+    }
+
+    int parseHex(int digits) {
+        int value = 0;
+        for (int i = 0; i < digits; i++) {
+            char ch = next();
+            if (!isxdigit((unsigned char) ch)) {
+                fail("malformed hexadecimal escape");
+            }
+            value = value * 16 + (isdigit((unsigned char) ch) ? ch - '0'
+                                  : tolower((unsigned char) ch) - 'a' + 10);
+        }
+        return value;
+    }
+
+    /*
+     * Parses the rest of a [...] class.  Java's nested classes and
+     * intersections are not supported, and neither is a ']' right after
+     * the '[', which Java and ECMAScript read differently.
+     */
+    int parseClass() {
+        bool negate = false;
+        if (peek('^')) {
+            negate = true;
+            pos++;
+        }
+        if (peek(']')) {
+            fail("a ']' at the start of a character class must be escaped");
+        }
+        std::bitset<256> set;
+        while (true) {
+            char ch = next();
+            if (ch == ']') {
+                break;
+            }
+            int low = (unsigned char) ch;
+            if (ch == '\\') {
+                char escaped = next();
+                std::bitset<256> escapeSet;
+                if (classEscape(escaped, escapeSet)) {
+                    set |= escapeSet;
+                    continue;
+                }
+                low = escaped == 'b' ? '\b' : characterEscape(escaped);
+            } else if (ch == '[') {
+                fail("nested character classes are not supported; write \\[ for a '['");
+            } else if (ch == '&' && peek('&')) {
+                fail("character class intersections are not supported");
+            }
+            int high = low;
+            if (peek('-') && pos + 1 < pattern.length() && pattern[pos + 1] != ']') {
+                pos++;
+                char end = next();
+                if (end == '\\') {
+                    char escaped = next();
+                    high = escaped == 'b' ? '\b' : characterEscape(escaped);
+                } else if (end == '[') {
+                    fail("nested character classes are not supported; write \\[ for a '['");
+                } else {
+                    high = (unsigned char) end;
+                }
+                if (high < low) {
+                    fail("character class range out of order");
+                }
+            }
+            for (int c = low; c <= high; c++) {
+                set.set(c);
+            }
+        }
+        if (icase) {
+            for (int c = 'a'; c <= 'z'; c++) {
+                if (set.test(c) || set.test(toupper(c))) {
+                    set.set(c);
+                    set.set(toupper(c));
+                }
+            }
+        }
+        if (negate) {
+            set.flip();
+        }
+        return classNode(set);
+    }
+
+    int charNode(int ch) {
+        if (icase && isalpha(ch) && ch < 128) {
+            std::bitset<256> set;
+            set.set(tolower(ch));
+            set.set(toupper(ch));
+            return classNode(set);
+        }
+        return newNode(CHAR, ch);
+    }
+
+    int classNode(const std::bitset<256>& set) {
+        program->classes.push_back(set);
+        return newNode(CLASS, program->classes.size() - 1);
+    }
+
+    int add(RegexOp op, int x = 0, int y = 0) {
+        if ((int) program->code.size() >= MAX_PROGRAM_SIZE) {
+            fail("the pattern is too large");
+        }
+        RegexInstruction inst = { op, x, y };
+        program->code.push_back(inst);
+        return program->code.size() - 1;
+    }
+
+    void emit(int index) {
+        const Node& node = nodes[index];
+        std::vector<RegexInstruction>& code = program->code;
+        switch (node.kind) {
+        case CHAR:
+            add(OP_CHAR, node.value);
+            break;
+        case ANY:
+            add(OP_ANY);
+            break;
+        case CLASS:
+            add(OP_CLASS, node.value);
+            break;
+        case BACKREF:
+            add(OP_BACKREF, node.value);
+            break;
+        case ASSERT:
+            add((RegexOp) node.value);
+            break;
+        case LOOKAHEAD: {
+            // the start of the lookahead is filled in by compile
+            int inst = add(node.value ? OP_NEGATIVE_LOOKAHEAD : OP_LOOKAHEAD, 0,
+                           program->lookaheads++);
+            lookaheadNodes.push_back(std::make_pair(inst, node.children[0]));
+            break;
+        }
+        case CONCAT:
+            for (int child : node.children) {
+                emit(child);
+            }
+            break;
+        case GROUP:
+            if (node.value >= 0) {
+                add(OP_SAVE, 2 * node.value);
+            }
+            emit(node.children[0]);
+            if (node.value >= 0) {
+                add(OP_SAVE, 2 * node.value + 1);
+            }
+            break;
+        case ALTERNATE: {
+            std::vector<int> jumps;
+            for (size_t i = 0; i + 1 < node.children.size(); i++) {
+                int split = add(OP_SPLIT, code.size() + 1);
+                emit(node.children[i]);
+                jumps.push_back(add(OP_JUMP));
+                code[split].y = code.size();
+            }
+            emit(node.children.back());
+            for (int jump : jumps) {
+                code[jump].x = code.size();
+            }
+            break;
+        }
+        case REPEAT:
+            emitRepeat(node);
+            break;
+        }
+    }
+
+    /*
+     * x{min,} repeats the body min - 1 times and loops back over the last
+     * copy; x{min,max} follows min copies with max - min optional ones,
+     * each of which skips to the end if it is not taken.  For the
+     * backtracking matcher, x{min,} is instead min copies followed by a
+     * loop that records where each iteration starts in a slot of its own
+     * and leaves the loop after an iteration that consumed nothing.
+     */
+    void emitRepeat(const Node& node) {
+        std::vector<RegexInstruction>& code = program->code;
+        int body = node.children[0];
+        if (node.max < 0 && program->backtrack) {
+            for (int i = 0; i < node.min; i++) {
+                emit(body);
+            }
+            int slot = program->slots++;
+            int loop = add(OP_SPLIT);
+            add(OP_SAVE, slot);
+            emit(body);
+            int progress = add(OP_PROGRESS, slot);
+            add(OP_JUMP, loop);
+            code[progress].y = code.size();
+            setSplit(loop, loop + 1, code.size(), node.greedy);
+            return;
+        } else if (node.max < 0) {
+            for (int i = 1; i < node.min; i++) {
+                emit(body);
+            }
+            int loop = code.size();
+            if (node.min == 0) {
+                add(OP_SPLIT);
+            }
+            emit(body);
+            if (node.min == 0) {
+                add(OP_JUMP, loop);
+                setSplit(loop, loop + 1, code.size(), node.greedy);
+            } else {
+                int split = add(OP_SPLIT);
+                setSplit(split, loop, split + 1, node.greedy);
+            }
+            return;
+        }
+        for (int i = 0; i < node.min; i++) {
+            emit(body);
+        }
+        std::vector<int> splits;
+        for (int i = node.min; i < node.max; i++) {
+            splits.push_back(add(OP_SPLIT));
+            emit(body);
+        }
+        for (int split : splits) {
+            setSplit(split, split + 1, code.size(), node.greedy);
+        }
+    }
+
+    void setSplit(int split, int take, int skip, bool greedy) {
+        program->code[split].x = greedy ? take : skip;
+        program->code[split].y = greedy ? skip : take;
+    }
+
+    /*
+     * Finds the characters a match can start with by following the
+     * program from the start without reading input.  Assertions and
+     * lookaheads are assumed to hold and back-references to match any
+     * text, which can only add characters to the set.
+     */
+    void findFirstChars() {
+        const std::vector<RegexInstruction>& code = program->code;
+        std::vector<bool> seen(code.size(), false);
+        std::vector<int> stack(1, 0);
+        program->firstChars.reset();
+        program->emptyMatch = false;
+        while (!stack.empty()) {
+            int pc = stack.back();
+            stack.pop_back();
+            if (seen[pc]) {
+                continue;
+            }
+            seen[pc] = true;
+            const RegexInstruction& inst = code[pc];
+            switch (inst.op) {
+            case OP_CHAR:
+                program->firstChars.set(inst.x);
+                break;
+            case OP_ANY: {
+                std::bitset<256> any;
+                any.set();
+                any.reset('\n');
+                any.reset('\r');
+                program->firstChars |= any;
+                break;
+            }
+            case OP_CLASS:
+                program->firstChars |= program->classes[inst.x];
+                break;
+            case OP_BACKREF:
+                program->firstChars.set();
+                stack.push_back(pc + 1);
+                break;
+            case OP_MATCH:
+                program->emptyMatch = true;
+                break;
+            case OP_SPLIT:
+                stack.push_back(inst.y);
+                stack.push_back(inst.x);
+                break;
+            case OP_JUMP:
+                stack.push_back(inst.x);
+                break;
+            default:
+                stack.push_back(pc + 1);
+                break;
+            }
+        }
+    }
+};
+
+/*
+ * A list of the program positions reached so far, in priority order, with
+ * the group positions recorded on the way to each one.  The sparse/dense
+ * pair makes adding, testing and clearing take constant time.
+ */
+struct RegexThreadList {
+    std::vector<int> sparse;
+    std::vector<int> dense;
+    std::vector<int> groups;
+    int count;
+    int groupSlots;
+
+    RegexThreadList(int size, int groupSlots)
+            : sparse(size, 0), dense(size), groups(size * groupSlots), count(0),
+              groupSlots(groupSlots) {
+        /* empty */
+    }
+
+    bool contains(int pc) const {
+        int i = sparse[pc];
+        return i < count && dense[i] == pc;
+    }
+
+    int add(int pc) {
+        sparse[pc] = count;
+        dense[count] = pc;
+        return count++;
+    }
+};
+
+struct RegexStackEntry {
+    int pc;         // instruction to continue at, or -1 to restore a slot
+    int slot;
+    int value;      // the position to continue at, or the slot's old value
+};
+
+/*
+ * The result of a lookahead at one position, kept because every thread
+ * that reaches the lookahead there gets the same result.
+ */
+struct RegexLookaheadResult {
+    int pos;
+    bool matched;
+    std::vector<int> groups;
+};
+
+/*
+ * Class: RegexMatcher
+ * -------------------
+ * Runs a program against one string.  A matcher can look for several
+ * matches in turn, which lets the lookahead results be reused.
+ */
+class RegexMatcher {
+public:
+    RegexMatcher(const RegexProgram& program, const std::string& s)
+            : program(program), s(s), length(s.length()),
+              lookaheads(program.lookaheads) {
+        for (RegexLookaheadResult& result : lookaheads) {
+            result.pos = -1;
+        }
+    }
+
+    /*
+     * Looks for the leftmost match that starts at or after position start
+     * and stores the positions of its groups in groups: the start and end
+     * of the whole match, then of each group, with -1 for groups that did
+     * not take part.  Only groups.size() slots are recorded; with none,
+     * the search stops at the first match of any kind.  Returns whether a
+     * match was found.
+     */
+    bool find(int start, std::vector<int>& groups) {
+        if (!program.backtrack) {
+            return runThreads(0, start, false, groups);
+        }
+        std::vector<int> slots(program.slots);
+        for (int pos = start; pos <= length && (pos == 0 || !program.anchored); pos++) {
+            if (!program.emptyMatch) {
+                while (pos < length && !program.firstChars.test((unsigned char) s[pos])) {
+                    pos++;
+                }
+                if (pos == length) {
+                    break;
+                }
+            }
+            std::fill(slots.begin(), slots.end(), -1);
+            if (backtrack(0, pos, slots)) {
+                std::copy(slots.begin(), slots.begin() + groups.size(), groups.begin());
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    const RegexProgram& program;
+    const std::string& s;
+    int length;
+    std::vector<RegexLookaheadResult> lookaheads;
+    std::vector<RegexStackEntry> backtrackStack;
+
+    /*
+     * Returns whether the character ch matches a character instruction.
+     */
+    bool matchesChar(const RegexInstruction& inst, int ch) const {
+        switch (inst.op) {
+        case OP_CHAR:
+            return ch == inst.x;
+        case OP_ANY:
+            return ch >= 0 && ch != '\n' && ch != '\r';
+        case OP_CLASS:
+            return ch >= 0 && program.classes[inst.x].test(ch);
+        default:
+            return false;
+        }
+    }
+
+    /*
+     * Returns whether the assertion op holds at position pos.
+     */
+    bool assertionHolds(RegexOp op, int pos) const {
+        switch (op) {
+        case OP_LINE_START:
+            return pos == 0;
+        case OP_LINE_END:
+            return pos == length;
+        default: {
+            bool before = pos > 0 && isWordChar((unsigned char) s[pos - 1]);
+            bool after = pos < length && isWordChar((unsigned char) s[pos]);
+            return (before != after) == (op == OP_WORD_BOUNDARY);
+        }
+        }
+    }
+
+    /*
+     * Runs the lookahead instruction inst at position pos, recording
+     * groupSlots group positions, and returns its result.
+     */
+    const RegexLookaheadResult& lookahead(const RegexInstruction& inst, int pos,
+                                          int groupSlots) {
+        RegexLookaheadResult& result = lookaheads[inst.y];
+        if (result.pos != pos || (int) result.groups.size() != groupSlots) {
+            result.pos = pos;
+            result.groups.assign(groupSlots, -1);
+            result.matched = runThreads(inst.x, pos, true, result.groups);
+        }
+        return result;
+    }
+
+    /*
+     * Adds pc to the list along with every instruction reachable from it
+     * without reading a character at position pos.  groups holds the group
+     * positions so far; it is changed while following OP_SAVE and restored
+     * before returning.  An explicit stack keeps the stack depth constant.
+     */
+    void addThread(RegexThreadList& list, int pc, std::vector<int>& groups, int pos,
+                   std::vector<RegexStackEntry>& stack) {
+        stack.clear();
+        RegexStackEntry start = { pc, 0, 0 };
+        stack.push_back(start);
+        while (!stack.empty()) {
+            RegexStackEntry entry = stack.back();
+            stack.pop_back();
+            if (entry.pc < 0) {
+                groups[entry.slot] = entry.value;
+                continue;
+            }
+            pc = entry.pc;
+            while (!list.contains(pc)) {
+                int index = list.add(pc);
+                const RegexInstruction& inst = program.code[pc];
+                bool follow = true;
+                switch (inst.op) {
+                case OP_JUMP:
+                    pc = inst.x;
+                    continue;
+                case OP_SPLIT: {
+                    RegexStackEntry other = { inst.y, 0, 0 };
+                    stack.push_back(other);
+                    pc = inst.x;
+                    continue;
+                }
+                case OP_SAVE:
+                    if (inst.x < list.groupSlots) {
+                        RegexStackEntry restore = { -1, inst.x, groups[inst.x] };
+                        stack.push_back(restore);
+                        groups[inst.x] = pos;
+                    }
+                    break;
+                case OP_LOOKAHEAD:
+                case OP_NEGATIVE_LOOKAHEAD: {
+                    bool negative = inst.op == OP_NEGATIVE_LOOKAHEAD;
+                    const RegexLookaheadResult& result =
+                            lookahead(inst, pos, negative ? 0 : list.groupSlots);
+                    follow = result.matched != negative;
+                    for (int slot = 2; follow && slot < (int) result.groups.size(); slot++) {
+                        if (result.groups[slot] >= 0) {
+                            RegexStackEntry restore = { -1, slot, groups[slot] };
+                            stack.push_back(restore);
+                            groups[slot] = result.groups[slot];
+                        }
+                    }
+                    break;
+                }
+                case OP_LINE_START:
+                case OP_LINE_END:
+                case OP_WORD_BOUNDARY:
+                case OP_NOT_WORD_BOUNDARY:
+                    follow = assertionHolds(inst.op, pos);
+                    break;
+                default:
+                    // the thread waits here for the next character
+                    std::copy(groups.begin(), groups.end(),
+                              list.groups.begin() + index * list.groupSlots);
+                    follow = false;
+                    break;
+                }
+                if (!follow) {
+                    break;
+                }
+                pc++;
+            }
+        }
+    }
+
+    /*
+     * Runs the program as a Pike VM from instruction startPc, looking for
+     * a match that starts at position start, or if onlyAtStart is false at
+     * any later position, and stores its groups as find does.
+     */
+    bool runThreads(int startPc, int start, bool onlyAtStart, std::vector<int>& groups) {
+        int size = program.code.size();
+        int groupSlots = groups.size();
+        RegexThreadList list1(size, groupSlots);
+        RegexThreadList list2(size, groupSlots);
+        RegexThreadList* current = &list1;
+        RegexThreadList* following = &list2;
+        std::vector<int> threadGroups(groupSlots);
+        std::vector<RegexStackEntry> stack;
+        bool matched = false;
+        for (int pos = start; ; pos++) {
+            if (!matched && (onlyAtStart ? pos == start : pos == 0 || !program.anchored)) {
+                if (!onlyAtStart && current->count == 0 && !program.emptyMatch) {
+                    // nothing is in progress, so skip ahead to a possible start
+                    while (pos < length && !program.firstChars.test((unsigned char) s[pos])) {
+                        pos++;
+                    }
+                    if (pos == length) {
+                        break;
+                    }
+                }
+                std::fill(threadGroups.begin(), threadGroups.end(), -1);
+                addThread(*current, startPc, threadGroups, pos, stack);
+            }
+            if (current->count == 0) {
+                break;
+            }
+            following->count = 0;
+            int ch = pos < length ? (unsigned char) s[pos] : -1;
+            for (int i = 0; i < current->count; i++) {
+                const RegexInstruction& inst = program.code[current->dense[i]];
+                if (inst.op == OP_MATCH) {
+                    if (groupSlots == 0) {
+                        return true;
+                    }
+                    std::copy(current->groups.begin() + i * groupSlots,
+                              current->groups.begin() + (i + 1) * groupSlots, groups.begin());
+                    matched = true;
+                    break;   // threads after this one have lower priority
+                } else if (matchesChar(inst, ch)) {
+                    std::copy(current->groups.begin() + i * groupSlots,
+                              current->groups.begin() + (i + 1) * groupSlots,
+                              threadGroups.begin());
+                    addThread(*following, current->dense[i] + 1, threadGroups, pos + 1, stack);
+                }
+            }
+            std::swap(current, following);
+            if (pos >= length) {
+                break;
+            }
+        }
+        return matched;
+    }
+
+    /*
+     * Returns whether the text at [pos, pos + count) equals the text
+     * at [start, start + count), ignoring case if the pattern does.
+     */
+    bool sameText(int start, int pos, int count) const {
+        if (pos + count > length) {
+            return false;
+        }
+        for (int i = 0; i < count; i++) {
+            unsigned char a = s[start + i];
+            unsigned char b = s[pos + i];
+            if (a != b && !(program.icase && a < 128 && b < 128 && tolower(a) == tolower(b))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*
+     * Runs the program from instruction pc by backtracking, looking for a
+     * match that starts at position pos.  slots holds the group positions
+     * and loop starts so far and receives those of the match.  Nested
+     * calls, for lookaheads, share the stack above the caller's entries.
+     */
+    bool backtrack(int pc, int pos, std::vector<int>& slots) {
+        std::vector<RegexStackEntry>& stack = backtrackStack;
+        size_t base = stack.size();
+        while (true) {
+            const RegexInstruction& inst = program.code[pc];
+            bool failed = false;
+            switch (inst.op) {
+            case OP_CHAR:
+            case OP_ANY:
+            case OP_CLASS:
+                failed = !matchesChar(inst, pos < length ? (unsigned char) s[pos] : -1);
+                pos++;
+                pc++;
+                break;
+            case OP_BACKREF: {
+                int start = slots[2 * inst.x];
+                int end = slots[2 * inst.x + 1];
+                failed = start < 0 || end < 0 || !sameText(start, pos, end - start);
+                pos += end - start;
+                pc++;
+                break;
+            }
+            case OP_SPLIT: {
+                RegexStackEntry other = { inst.y, 0, pos };
+                stack.push_back(other);
+                pc = inst.x;
+                break;
+            }
+            case OP_JUMP:
+                pc = inst.x;
+                break;
+            case OP_SAVE: {
+                RegexStackEntry restore = { -1, inst.x, slots[inst.x] };
+                stack.push_back(restore);
+                slots[inst.x] = pos;
+                pc++;
+                break;
+            }
+            case OP_PROGRESS:
+                pc = slots[inst.x] == pos ? inst.y : pc + 1;
+                break;
+            case OP_LOOKAHEAD:
+            case OP_NEGATIVE_LOOKAHEAD: {
+                bool negative = inst.op == OP_NEGATIVE_LOOKAHEAD;
+                std::vector<int> inner(slots);
+                failed = backtrack(inst.x, pos, inner) == negative;
+                for (int slot = 2; !failed && !negative && slot < 2 * (program.groups + 1);
+                     slot++) {
+                    if (inner[slot] != slots[slot]) {
+                        RegexStackEntry restore = { -1, slot, slots[slot] };
+                        stack.push_back(restore);
+                        slots[slot] = inner[slot];
+                    }
+                }
+                pc++;
+                break;
+            }
+            case OP_MATCH:
+                stack.resize(base);
+                return true;
+            default:
+                failed = !assertionHolds(inst.op, pos);
+                pc++;
+                break;
+            }
+            while (failed) {
+                if (stack.size() == base) {
+                    return false;
+                }
+                RegexStackEntry entry = stack.back();
+                stack.pop_back();
+                if (entry.pc < 0) {
+                    slots[entry.slot] = entry.value;
+                } else {
+                    pc = entry.pc;
+                    pos = entry.value;
+                    failed = false;
+                }
+            }
+        }
+    }
+};
+
+Regex::Regex(const std::string& pattern) : source(pattern), isLiteral(false) {
+    std::string body = pattern;
+    bool icase = false;
+    if (body.compare(0, 4, "(?i)") == 0) {
+        body = body.substr(4);
+        icase = true;
+    } else if (!body.empty() && body.find_first_of(SPECIAL_CHARS) == std::string::npos) {
+        isLiteral = true;
+        literal = body;
+        return;
+    }
+    std::shared_ptr<RegexProgram> compiled = std::make_shared<RegexProgram>();
+    RegexCompiler(pattern, body, icase).compile(*compiled);
+    program = compiled;
+}
+
+bool Regex::matches(const std::string& s) const {
+    if (isLiteral) {
+        return s.find(literal) != std::string::npos;
+    }
+    std::vector<int> groups;
+    return RegexMatcher(*program, s).find(0, groups);
+}
+
+/*
+ * Returns where to look for the match after one at [start, end): at its
+ * end, or one character later after an empty match, as Java does.
+ */
+static int nextSearchStart(const std::vector<int>& groups) {
+    return groups[1] > groups[0] ? groups[1] : groups[1] + 1;
+}
+
+int Regex::matchCount(const std::string& s) const {
+    int count = 0;
+    if (isLiteral) {
+        for (size_t i = s.find(literal); i != std::string::npos;
+             i = s.find(literal, i + literal.length())) {
+            count++;
+        }
+    } else {
+        RegexMatcher matcher(*program, s);
+        std::vector<int> groups(2);
+        for (int start = 0; start <= (int) s.length() && matcher.find(start, groups);
+             start = nextSearchStart(groups)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/*
+ * Appends the replacement text for one match, expanding $n group
+ * references and backslash escapes the way Java's Matcher does: the
+ * group number takes as many digits as still name an existing group.
+ * groups holds the start and end in s of each group, as from find.
+ */
+static void appendReplacement(std::string& out, const std::string& replacement,
+                              const std::string& s, const std::vector<int>& groups) {
+    int groupCount = groups.size() / 2;
+    for (size_t i = 0; i < replacement.length(); i++) {
+        char ch = replacement[i];
+        if (ch == '\\' && i + 1 < replacement.length()) {
+            out += replacement[++i];
+        } else if (ch == '$') {
+            if (i + 1 >= replacement.length() || !isdigit((unsigned char) replacement[i + 1])) {
+                error("Regex::replace: illegal group reference in replacement \""
+                      + replacement + "\"");
+            }
+            int group = replacement[++i] - '0';
+            while (i + 1 < replacement.length() && isdigit((unsigned char) replacement[i + 1])
+                   && group * 10 + (replacement[i + 1] - '0') < groupCount) {
+                group = group * 10 + (replacement[++i] - '0');
+            }
+            if (group >= groupCount) {
+                error("Regex::replace: no group " + integerToString(group)
+                      + " in replacement \"" + replacement + "\"");
+            }
+            if (groups[2 * group] >= 0) {
+                out.append(s, groups[2 * group], groups[2 * group + 1] - groups[2 * group]);
+            }
+        } else {
+            out += ch;
+        }
+    }
+}
+
+std::string Regex::replace(const std::string& s, const std::string& replacement,
+                           int limit) const {
+    std::string result;
+    int count = 0;
+    int last = 0;
+    std::vector<int> groups;
+    if (isLiteral) {
+        // every match is the same text, so the replacement is expanded once
+        std::string text;
+        groups.push_back(0);
+        groups.push_back(literal.length());
+        appendReplacement(text, replacement, literal, groups);
+        for (size_t i = s.find(literal); i != std::string::npos && (limit < 0 || count < limit);
+             i = s.find(literal, last)) {
+            result.append(s, last, i - last);
+            result += text;
+            last = i + literal.length();
+            count++;
+        }
+    } else {
+        RegexMatcher matcher(*program, s);
+        groups.resize(2 * (program->groups + 1));
+        for (int start = 0; (limit < 0 || count < limit) && start <= (int) s.length()
+             && matcher.find(start, groups); start = nextSearchStart(groups)) {
+            result.append(s, last, groups[0] - last);
+            appendReplacement(result, replacement, s, groups);
+            last = groups[1];
+            count++;
+        }
+    }
+    result.append(s, last, std::string::npos);
+    return result;
+}
+
+const std::string& Regex::pattern() const {
+    return source;
+}
+
+/*
+ * Implementation notes: pattern cache
+ * -----------------------------------
+ * The cache is a list of compiled patterns in order of use, most recent
+ * first, plus a hash map from each pattern string to its list node, so a
+ * lookup, a move to the front and an eviction each take constant time.
+ * Entries are shared pointers so that a pattern evicted by one thread
+ * stays alive while another thread is still matching with it.
+ */
+typedef std::shared_ptr<const Regex> RegexPtr;
+typedef std::list<std::pair<std::string, RegexPtr> > RegexList;
+
+static std::mutex cacheMutex;
+static RegexList cacheOrder;
+static std::unordered_map<std::string, RegexList::iterator> cacheIndex;
+static size_t cacheCapacity = 64;
+
+static void trimCache() {
+    while (cacheOrder.size() > cacheCapacity) {
+        cacheIndex.erase(cacheOrder.back().first);
+        cacheOrder.pop_back();
+    }
+}
+
+static RegexPtr getRegex(const std::string& regexp) {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        std::unordered_map<std::string, RegexList::iterator>::iterator found =
+                cacheIndex.find(regexp);
+        if (found != cacheIndex.end()) {
+            cacheOrder.splice(cacheOrder.begin(), cacheOrder, found->second);
+            return found->second->second;
+        }
+    }
+
+    // compile outside the lock; if two threads race, the first one stored wins
+    RegexPtr regex = std::make_shared<const Regex>(regexp);
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (cacheCapacity == 0 || cacheIndex.count(regexp) > 0) {
+        return regex;
+    }
+    cacheOrder.push_front(std::make_pair(regexp, regex));
+    cacheIndex[regexp] = cacheOrder.begin();
+    trimCache();
+    return regex;
+}
 
 bool regexMatch(std::string s, std::string regexp) {
-    return getPlatform()->regex_match(s, regexp);
+    return getRegex(regexp)->matches(s);
 }
 
 int regexMatchCount(std::string s, std::string regexp) {
-    return getPlatform()->regex_matchCount(s, regexp);
+    return getRegex(regexp)->matchCount(s);
 }
 
 std::string regexReplace(std::string s, std::string regexp, std::string replacement, int limit) {
-    return getPlatform()->regex_replace(s, regexp, replacement, limit);
+    return getRegex(regexp)->replace(s, replacement, limit);
+}
+
+void setRegexCacheCapacity(int capacity) {
+    if (capacity < 0) {
+        error("setRegexCacheCapacity: capacity must not be negative");
+    }
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cacheCapacity = capacity;
+    trimCache();
 }
@@ -2,16 +2,33 @@
  * File: regexpr.h
  * ---------------
  * This file exports functions for performing regular expression operations
- * on C++ strings.  It will be unnecessary once the C++11 regex library
- * is widely available, but as of this writing the regex library is not
- * supported on gcc and other major C++ compilers.
- * 
- * The regular expression functions are implemented by sending the strings and
- * regexes to the Java Back-End to run the operations in Java.  This is a bit
- * kludgy but we don't want to write our own regex parser from scratch.
- * Using Java's is a compromise for now.
+ * on C++ strings, and the <code>Regex</code> class, which holds a compiled
+ * regular expression for repeated use.
+ *
+ * The regular expressions are compiled and run in C++, in the Java syntax
+ * the back-end used to implement: character classes and the escapes \d,
+ * \w, \s, \b and their negations, greedy and reluctant quantifiers,
+ * capturing and (?:...) groups, back-references such as \1, and lookahead
+ * with (?=...) and (?!...).  A pattern may begin with (?i) to ignore case.
+ * Lookbehind, named and atomic groups, possessive quantifiers, nested
+ * classes and inline flags elsewhere in the pattern are not supported and
+ * raise an error when the pattern is compiled, as do syntax errors.  The
+ * free functions keep the most recently used patterns compiled, so calling
+ * them repeatedly with the same pattern costs no more than using a Regex
+ * object.
+ *
+ * Matching does not backtrack and takes time proportional to the length
+ * of the input, times the length a lookahead looks ahead for patterns
+ * with one, so it is safe on long strings.  The exception is
+ * patterns with back-references, which are matched by backtracking, as
+ * in Java, and can take time exponential in the length of the input for
+ * patterns such as (a*)*\1b.  No pattern uses stack space that grows with
+ * the input.
  *
  * @author Marty Stepp
+ * @version 2026/10/18
+ * - regular expressions run in-process instead of in the Java back-end
+ * - added Regex class and a cache of compiled patterns
  * @version 2014/10/14
  * - removed regexMatchCountWithLines for simplicity
  * @since 2014/03/01
@@ -20,8 +37,75 @@
 #ifndef _regexpr_h
 #define _regexpr_h
 
+#include <memory>
 #include <string>
 
+/* the compiled form of a pattern, defined in regexpr.cpp */
+struct RegexProgram;
+
+/*
+ * Class: Regex
+ * ------------
+ * A compiled regular expression.  Compiling a pattern is much slower than
+ * matching it, so a pattern that is used many times should be compiled
+ * once.  Patterns without any special characters are searched for as
+ * plain text.  A Regex can be used by several threads at once.
+ */
+class Regex {
+public:
+    /*
+     * Constructor: Regex
+     * Usage: Regex re(pattern);
+     * -------------------------
+     * Compiles the given pattern.  Raises an error if it is not a valid
+     * regular expression or uses a feature that is not supported.
+     */
+    explicit Regex(const std::string& pattern);
+
+    /*
+     * Method: matches
+     * Usage: if (re.matches(s)) ...
+     * -----------------------------
+     * Returns true if the regular expression matches a substring of s.
+     */
+    bool matches(const std::string& s) const;
+
+    /*
+     * Method: matchCount
+     * Usage: int count = re.matchCount(s);
+     * ------------------------------------
+     * Returns the number of non-overlapping matches of the regular
+     * expression in s.
+     */
+    int matchCount(const std::string& s) const;
+
+    /*
+     * Method: replace
+     * Usage: string result = re.replace(s, replacement, limit);
+     * ---------------------------------------------------------
+     * Returns s with matches of the regular expression replaced by the
+     * given replacement text, in which $n stands for the text matched by
+     * group n and a backslash makes the next character literal, as in
+     * Java.  If limit >= 0, only the first limit matches are replaced.
+     */
+    std::string replace(const std::string& s, const std::string& replacement,
+                        int limit = -1) const;
+
+    /*
+     * Method: pattern
+     * Usage: string pattern = re.pattern();
+     * -------------------------------------
+     * Returns the pattern this regular expression was compiled from.
+     */
+    const std::string& pattern() const;
+
+private:
+    std::string source;     // the pattern as given
+    std::string literal;    // the text to find, for a plain-text pattern
+    bool isLiteral;
+    std::shared_ptr<const RegexProgram> program;    // NULL for a plain-text pattern
+};
+
 /*
  * Returns true if the given string s matches the given regular expression
  * as a substring.
@@ -43,4 +127,10 @@ int regexMatchCount(std::string s, std::string regexp);
 std::string regexReplace(std::string s, std::string regexp,
                          std::string replacement, int limit = -1);
 
+/*
+ * Sets how many compiled patterns the functions above keep for reuse,
+ * discarding the least recently used ones beyond that; the default is 64.
+ */
+void setRegexCacheCapacity(int capacity);
+
 #endif
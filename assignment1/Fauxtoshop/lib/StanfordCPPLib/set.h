@@ -4,6 +4,8 @@
  * This file exports the <code>Set</code> class, which implements a
  * collection for storing a set of distinct elements.
  * 
+ * @version 2026/10/18
+ * - added MapType template parameter and BTreeSet
  * @version 2015/07/05
  * - using global hashing functions rather than global variables
  * @version 2014/11/13
@@ -18,6 +20,7 @@
 
 #include <iostream>
 #include <set>
+#include "btreemap.h"
 #include "compare.h"
 #include "error.h"
 #include "hashcode.h"
@@ -28,8 +31,13 @@
  * Class: Set<ValueType>
  * ---------------------
  * This class stores a collection of distinct elements.
+ *
+ * The optional <code>MapType</code> parameter selects the ordered map
+ * that stores the elements; it must have the interface of
+ * <code>Map</code>.  <code>BTreeSet</code>, below, is a <code>Set</code>
+ * stored in a <code>BTreeMap</code>.
  */
-template <typename ValueType>
+template <typename ValueType, typename MapType = Map<ValueType, bool> >
 class Set {
 public:
     /*
@@ -65,7 +73,7 @@ public:
      * Returns a reference to this set.
      * Identical in behavior to the += operator.
      */
-    Set<ValueType>& addAll(const Set<ValueType>& set);
+    Set& addAll(const Set& set);
     
     /*
      * Method: clear
@@ -91,7 +99,7 @@ public:
      * as the given other set.
      * Identical in behavior to the == operator.
      */
-    bool equals(const Set<ValueType>& set2) const;
+    bool equals(const Set& set2) const;
     
     /*
      * Method: first
@@ -162,7 +170,7 @@ public:
      * Returns a reference to this set.
      * Identical in behavior to the -= operator.
      */
-    Set<ValueType>& removeAll(const Set<ValueType>& set);
+    Set& removeAll(const Set& set);
     
     /*
      * Method: retainAll
@@ -172,7 +180,7 @@ public:
      * other set. Returns a reference to this set.
      * Identical in behavior to the *= operator.
      */
-    Set<ValueType>& retainAll(const Set<ValueType>& set);
+    Set& retainAll(const Set& set);
 
     /*
      * Method: size
@@ -335,7 +343,7 @@ public:
     /**********************************************************************/
 
 private:
-    Map<ValueType, bool> map;            /* Map used to store the element     */
+    MapType map;                         /* Map used to store the element     */
     bool removeFlag;                     /* Flag to differentiate += and -=   */
 
 public:
@@ -350,7 +358,7 @@ public:
 
     /* Extended constructors */
     template <typename CompareType>
-    explicit Set(CompareType cmp) : map(Map<ValueType, bool>(cmp)), removeFlag(false) {
+    explicit Set(CompareType cmp) : map(MapType(cmp)), removeFlag(false) {
         // Empty
     }
 
@@ -372,14 +380,14 @@ public:
      */
     class iterator : public std::iterator<std::input_iterator_tag,ValueType> {
     private:
-        typename Map<ValueType,bool>::iterator mapit;  /* Iterator for the map */
+        typename MapType::iterator mapit;              /* Iterator for the map */
 
     public:
         iterator() {
             /* Empty */
         }
 
-        iterator(typename Map<ValueType,bool>::iterator it) : mapit(it) {
+        iterator(typename MapType::iterator it) : mapit(it) {
             /* Empty */
         }
 
@@ -424,43 +432,53 @@ public:
     }
 };
 
+/*
+ * Type: BTreeSet<ValueType,Compare>
+ * ---------------------------------
+ * A <code>Set</code> stored in a <code>BTreeMap</code>, which uses much
+ * less memory and fewer cache misses than the default tree for sets with
+ * many elements.
+ */
+template <typename ValueType, typename Compare = std::less<ValueType> >
+using BTreeSet = Set<ValueType, BTreeMap<ValueType, bool, Compare> >;
+
 extern void error(std::string msg);
 
-template <typename ValueType>
-Set<ValueType>::Set() : removeFlag(false) {
+template <typename ValueType, typename MapType>
+Set<ValueType, MapType>::Set() : removeFlag(false) {
     /* Empty */
 }
 
-template <typename ValueType>
-Set<ValueType>::~Set() {
+template <typename ValueType, typename MapType>
+Set<ValueType, MapType>::~Set() {
     /* Empty */
 }
 
-template <typename ValueType>
-void Set<ValueType>::add(const ValueType& value) {
+template <typename ValueType, typename MapType>
+void Set<ValueType, MapType>::add(const ValueType& value) {
     map.put(value, true);
 }
 
-template <typename ValueType>
-Set<ValueType>& Set<ValueType>::addAll(const Set& set2) {
+template <typename ValueType, typename MapType>
+Set<ValueType, MapType>& Set<ValueType, MapType>::addAll(const Set& set2) {
     for (ValueType value : set2) {
         this->add(value);
     }
     return *this;
 }
 
-template <typename ValueType>
-void Set<ValueType>::clear() {
+template <typename ValueType, typename MapType>
+void Set<ValueType, MapType>::clear() {
     map.clear();
 }
 
-template <typename ValueType>
-bool Set<ValueType>::contains(const ValueType& value) const {
+template <typename ValueType, typename MapType>
+bool Set<ValueType, MapType>::contains(const ValueType& value) const {
     return map.containsKey(value);
 }
 
-template <typename ValueType>
-bool Set<ValueType>::equals(const Set<ValueType>& set2) const {
+template <typename ValueType, typename MapType>
+bool Set<ValueType, MapType>::equals(const Set<ValueType, MapType>& set2) const {
     // optimization: if literally same set, stop
     if (this == &set2) {
         return true;
@@ -481,26 +499,26 @@ bool Set<ValueType>::equals(const Set<ValueType>& set2) const {
     return true;
 }
 
-template <typename ValueType>
-ValueType Set<ValueType>::first() const {
+template <typename ValueType, typename MapType>
+ValueType Set<ValueType, MapType>::first() const {
     if (isEmpty()) {
         error("Set::first: set is empty");
     }
     return *begin();
 }
 
-template <typename ValueType>
-void Set<ValueType>::insert(const ValueType& value) {
+template <typename ValueType, typename MapType>
+void Set<ValueType, MapType>::insert(const ValueType& value) {
     map.put(value, true);
 }
 
-template <typename ValueType>
-bool Set<ValueType>::isEmpty() const {
+template <typename ValueType, typename MapType>
+bool Set<ValueType, MapType>::isEmpty() const {
     return map.isEmpty();
 }
 
-template <typename ValueType>
-bool Set<ValueType>::isSubsetOf(const Set& set2) const {
+template <typename ValueType, typename MapType>
+bool Set<ValueType, MapType>::isSubsetOf(const Set& set2) const {
     iterator it = begin();
     iterator end = this->end();
     while (it != end) {
@@ -512,29 +530,29 @@ bool Set<ValueType>::isSubsetOf(const Set& set2) const {
     return true;
 }
 
-template <typename ValueType>
-void Set<ValueType>::mapAll(void (*fn)(ValueType)) const {
+template <typename ValueType, typename MapType>
+void Set<ValueType, MapType>::mapAll(void (*fn)(ValueType)) const {
     map.mapAll(fn);
 }
 
-template <typename ValueType>
-void Set<ValueType>::mapAll(void (*fn)(const ValueType&)) const {
+template <typename ValueType, typename MapType>
+void Set<ValueType, MapType>::mapAll(void (*fn)(const ValueType&)) const {
     map.mapAll(fn);
 }
 
-template <typename ValueType>
+template <typename ValueType, typename MapType>
 template <typename FunctorType>
-void Set<ValueType>::mapAll(FunctorType fn) const {
+void Set<ValueType, MapType>::mapAll(FunctorType fn) const {
     map.mapAll(fn);
 }
 
-template <typename ValueType>
-void Set<ValueType>::remove(const ValueType& value) {
+template <typename ValueType, typename MapType>
+void Set<ValueType, MapType>::remove(const ValueType& value) {
     map.remove(value);
 }
 
-template <typename ValueType>
-Set<ValueType>& Set<ValueType>::removeAll(const Set& set2) {
+template <typename ValueType, typename MapType>
+Set<ValueType, MapType>& Set<ValueType, MapType>::removeAll(const Set& set2) {
     Vector<ValueType> toRemove;
     for (ValueType value : *this) {
         if (set2.map.containsKey(value)) {
@@ -547,8 +565,8 @@ Set<ValueType>& Set<ValueType>::removeAll(const Set& set2) {
     return *this;
 }
 
-template <typename ValueType>
-Set<ValueType>& Set<ValueType>::retainAll(const Set& set2) {
+template <typename ValueType, typename MapType>
+Set<ValueType, MapType>& Set<ValueType, MapType>::retainAll(const Set& set2) {
     Vector<ValueType> toRemove;
     for (ValueType value : *this) {
         if (!set2.map.containsKey(value)) {
@@ -561,13 +579,13 @@ Set<ValueType>& Set<ValueType>::retainAll(const Set& set2) {
     return *this;
 }
 
-template <typename ValueType>
-int Set<ValueType>::size() const {
+template <typename ValueType, typename MapType>
+int Set<ValueType, MapType>::size() const {
     return map.size();
 }
 
-template <typename ValueType>
-std::set<ValueType> Set<ValueType>::toStlSet() const {
+template <typename ValueType, typename MapType>
+std::set<ValueType> Set<ValueType, MapType>::toStlSet() const {
     std::set<ValueType> result;
     for (ValueType value : *this) {
         result.insert(value);
@@ -575,8 +593,8 @@ std::set<ValueType> Set<ValueType>::toStlSet() const {
     return result;
 }
 
-template <typename ValueType>
-std::string Set<ValueType>::toString() const {
+template <typename ValueType, typename MapType>
+std::string Set<ValueType, MapType>::toString() const {
     std::ostringstream os;
     os << *this;
     return os.str();
@@ -588,100 +606,100 @@ std::string Set<ValueType>::toString() const {
  * The implementations for the set operators use iteration to walk
  * over the elements in one or both sets.
  */
-template <typename ValueType>
-bool Set<ValueType>::operator ==(const Set& set2) const {
+template <typename ValueType, typename MapType>
+bool Set<ValueType, MapType>::operator ==(const Set& set2) const {
     return equals(set2);
 }
 
-template <typename ValueType>
-bool Set<ValueType>::operator !=(const Set& set2) const {
+template <typename ValueType, typename MapType>
+bool Set<ValueType, MapType>::operator !=(const Set& set2) const {
     return !equals(set2);
 }
 
-template <typename ValueType>
-bool Set<ValueType>::operator <(const Set& set2) const {
+template <typename ValueType, typename MapType>
+bool Set<ValueType, MapType>::operator <(const Set& set2) const {
     return compare::compare(*this, set2) < 0;
 }
 
-template <typename ValueType>
-bool Set<ValueType>::operator <=(const Set& set2) const {
+template <typename ValueType, typename MapType>
+bool Set<ValueType, MapType>::operator <=(const Set& set2) const {
     return compare::compare(*this, set2) <= 0;
 }
 
-template <typename ValueType>
-bool Set<ValueType>::operator >(const Set& set2) const {
+template <typename ValueType, typename MapType>
+bool Set<ValueType, MapType>::operator >(const Set& set2) const {
     return compare::compare(*this, set2) > 0;
 }
 
-template <typename ValueType>
-bool Set<ValueType>::operator >=(const Set& set2) const {
+template <typename ValueType, typename MapType>
+bool Set<ValueType, MapType>::operator >=(const Set& set2) const {
     return compare::compare(*this, set2) >= 0;
 }
 
-template <typename ValueType>
-Set<ValueType> Set<ValueType>::operator +(const Set& set2) const {
-    Set<ValueType> set = *this;
+template <typename ValueType, typename MapType>
+Set<ValueType, MapType> Set<ValueType, MapType>::operator +(const Set& set2) const {
+    Set<ValueType, MapType> set = *this;
     set.addAll(set2);
     return set;
 }
 
-template <typename ValueType>
-Set<ValueType> Set<ValueType>::operator +(const ValueType& element) const {
-    Set<ValueType> set = *this;
+template <typename ValueType, typename MapType>
+Set<ValueType, MapType> Set<ValueType, MapType>::operator +(const ValueType& element) const {
+    Set<ValueType, MapType> set = *this;
     set.add(element);
     return set;
 }
 
-template <typename ValueType>
-Set<ValueType> Set<ValueType>::operator *(const Set& set2) const {
-    Set<ValueType> set = *this;
+template <typename ValueType, typename MapType>
+Set<ValueType, MapType> Set<ValueType, MapType>::operator *(const Set& set2) const {
+    Set<ValueType, MapType> set = *this;
     return set.retainAll(set2);
 }
 
-template <typename ValueType>
-Set<ValueType> Set<ValueType>::operator -(const Set& set2) const {
-    Set<ValueType> set = *this;
+template <typename ValueType, typename MapType>
+Set<ValueType, MapType> Set<ValueType, MapType>::operator -(const Set& set2) const {
+    Set<ValueType, MapType> set = *this;
     return set.removeAll(set2);
 }
 
-template <typename ValueType>
-Set<ValueType> Set<ValueType>::operator -(const ValueType& element) const {
-    Set<ValueType> set = *this;
+template <typename ValueType, typename MapType>
+Set<ValueType, MapType> Set<ValueType, MapType>::operator -(const ValueType& element) const {
+    Set<ValueType, MapType> set = *this;
     set.remove(element);
     return set;
 }
 
-template <typename ValueType>
-Set<ValueType>& Set<ValueType>::operator +=(const Set& set2) {
+template <typename ValueType, typename MapType>
+Set<ValueType, MapType>& Set<ValueType, MapType>::operator +=(const Set& set2) {
     return addAll(set2);
 }
 
-template <typename ValueType>
-Set<ValueType>& Set<ValueType>::operator +=(const ValueType& value) {
+template <typename ValueType, typename MapType>
+Set<ValueType, MapType>& Set<ValueType, MapType>::operator +=(const ValueType& value) {
     add(value);
     removeFlag = false;
     return *this;
 }
 
-template <typename ValueType>
-Set<ValueType>& Set<ValueType>::operator *=(const Set& set2) {
+template <typename ValueType, typename MapType>
+Set<ValueType, MapType>& Set<ValueType, MapType>::operator *=(const Set& set2) {
     return retainAll(set2);
 }
 
-template <typename ValueType>
-Set<ValueType>& Set<ValueType>::operator -=(const Set& set2) {
+template <typename ValueType, typename MapType>
+Set<ValueType, MapType>& Set<ValueType, MapType>::operator -=(const Set& set2) {
     return removeAll(set2);
 }
 
-template <typename ValueType>
-Set<ValueType>& Set<ValueType>::operator -=(const ValueType& value) {
+template <typename ValueType, typename MapType>
+Set<ValueType, MapType>& Set<ValueType, MapType>::operator -=(const ValueType& value) {
     remove(value);
     removeFlag = true;
     return *this;
 }
 
-template <typename ValueType>
-std::ostream& operator <<(std::ostream& os, const Set<ValueType>& set) {
+template <typename ValueType, typename MapType>
+std::ostream& operator <<(std::ostream& os, const Set<ValueType, MapType>& set) {
     os << "{";
     bool started = false;
     for (ValueType value : set) {
@@ -695,8 +713,8 @@ std::ostream& operator <<(std::ostream& os, const Set<ValueType>& set) {
     return os;
 }
 
-template <typename ValueType>
-std::istream& operator >>(std::istream& is, Set<ValueType>& set) {
+template <typename ValueType, typename MapType>
+std::istream& operator >>(std::istream& is, Set<ValueType, MapType>& set) {
     char ch = '\0';
     is >> ch;
     if (ch != '{') {
@@ -726,8 +744,8 @@ std::istream& operator >>(std::istream& is, Set<ValueType>& set) {
  * Template hash function for sets.
  * Requires the element type in the Set to have a hashCode function.
  */
-template <typename T>
-int hashCode(const Set<T>& s) {
+template <typename T, typename M>
+int hashCode(const Set<T, M>& s) {
     int code = hashSeed();
     for (T n : s) {
         code = hashMultiplier() * code + hashCode(n);
@@ -742,8 +760,8 @@ int hashCode(const Set<T>& s) {
  * Returns a randomly chosen element of the given set.
  * Throws an error if the set is empty.
  */
-template <typename T>
-const T& randomElement(const Set<T>& set) {
+template <typename T, typename M>
+const T& randomElement(const Set<T, M>& set) {
     if (set.isEmpty()) {
         error("randomElement: empty set was passed");
     }
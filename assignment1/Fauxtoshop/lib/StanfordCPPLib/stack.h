@@ -4,6 +4,9 @@
  * This file exports the <code>Stack</code> class, which implements
  * a collection that processes values in a last-in/first-out (LIFO) order.
  * 
+ * @version 2026/10/18
+ * - added move constructor and assignment, emplace, reserve, and add/push
+ *   overloads that move their value; pop moves the top value out
  * @version 2014/11/13
  * - added add() method as synonym for push()
  * - added remove() method as synonym for pop()
@@ -16,6 +19,7 @@
 
 #include <iterator>
 #include <stack>
+#include <utility>
 #include "error.h"
 #include "hashcode.h"
 #include "vector.h"
@@ -56,6 +60,7 @@ public:
      * A synonym for the push method.
      */
     void add(const ValueType& value);
+    void add(ValueType&& value);
     
     /*
      * Method: clear
@@ -64,6 +69,16 @@ public:
      * Removes all elements from this stack.
      */
     void clear();
+
+    /*
+     * Method: emplace
+     * Usage: stack.emplace(args...);
+     * ------------------------------
+     * Pushes a value built from the given constructor arguments onto the
+     * top of this stack.
+     */
+    template <typename... Args>
+    void emplace(Args&&... args);
     
     /*
      * Method: equals
@@ -108,6 +123,7 @@ public:
      * Pushes the specified value onto the top of this stack.
      */
     void push(const ValueType& value);
+    void push(ValueType&& value);
 
     /*
      * Method: remove
@@ -118,6 +134,15 @@ public:
      */
     ValueType remove();
 
+    /*
+     * Method: reserve
+     * Usage: stack.reserve(n);
+     * ------------------------
+     * Makes room for at least <code>n</code> values, so that pushing values
+     * up to that size will not reallocate the stack's storage.
+     */
+    void reserve(int n);
+
     /*
      * Method: size
      * Usage: int n = stack.size();
@@ -203,6 +228,18 @@ public:
     
     template <typename T>
     friend std::ostream& operator <<(std::ostream& os, const Stack<T>& stack);
+
+    /*
+     * Copy and move support
+     * ---------------------
+     * Copying a stack copies its elements.  Moving one takes over the
+     * source's elements and leaves the source empty.  These have to be
+     * declared because the stack declares a destructor.
+     */
+    Stack(const Stack& src) = default;
+    Stack& operator =(const Stack& src) = default;
+    Stack(Stack&& src) = default;
+    Stack& operator =(Stack&& src) = default;
     
 private:
     Vector<ValueType> elements;
@@ -283,11 +320,22 @@ void Stack<ValueType>::add(const ValueType& value) {
     push(value);
 }
 
+template <typename ValueType>
+void Stack<ValueType>::add(ValueType&& value) {
+    push(std::move(value));
+}
+
 template <typename ValueType>
 void Stack<ValueType>::clear() {
     elements.clear();
 }
 
+template <typename ValueType>
+template <typename... Args>
+void Stack<ValueType>::emplace(Args&&... args) {
+    elements.emplace_back(std::forward<Args>(args)...);
+}
+
 template <typename ValueType>
 bool Stack<ValueType>::equals(const Stack<ValueType>& stack2) const {
     if (this == &stack2) {
@@ -322,7 +370,7 @@ ValueType Stack<ValueType>::pop() {
     if (isEmpty()) {
         error("Stack::pop: Attempting to pop an empty stack");
     }
-    ValueType top = elements[elements.size() - 1];
+    ValueType top = std::move(elements[elements.size() - 1]);
     elements.remove(elements.size() - 1);
     return top;
 }
@@ -332,11 +380,21 @@ void Stack<ValueType>::push(const ValueType& value) {
     elements.add(value);
 }
 
+template <typename ValueType>
+void Stack<ValueType>::push(ValueType&& value) {
+    elements.add(std::move(value));
+}
+
 template <typename ValueType>
 ValueType Stack<ValueType>::remove() {
     return pop();
 }
 
+template <typename ValueType>
+void Stack<ValueType>::reserve(int n) {
+    elements.reserve(n);
+}
+
 template <typename ValueType>
 int Stack<ValueType>::size() const {
     return elements.size();
@@ -3,6 +3,11 @@
  * ----------------
  * This file implements the strlib.h interface.
  * 
+ * @version 2026/10/18
+ * - added StringView, StringSplitter, stringTokenize and trimView
+ * - stringSplit scans the string once instead of erasing from a copy
+ * - numeric conversions read and write digits directly instead of using
+ *   string streams; added parse, ToChars, tryStringTo and bulk variants
  * @version 2015/11/07
  * - fixed bugs in urlDecode (wasn't decoding % sequences properly, oops)
  * @version 2015/10/26
@@ -22,10 +27,15 @@
 
 #include "strlib.h"
 #include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdio>
 #include <iomanip>
 #include <iostream>
+#include <locale>
 #include <sstream>
 #include "error.h"
+#include "vector.h"
 
 /* Function prototypes */
 
@@ -113,28 +123,231 @@ char integerToChar(int n) {
 /*
  * Implementation notes: numeric conversion
  * ----------------------------------------
- * These functions use the <sstream> library to perform the conversion.
+ * These functions read and write digits directly rather than going
+ * through <sstream>, which builds a stream and consults the locale on
+ * every call.  A real number takes a fast path when its digits and its
+ * power of ten are both exactly representable as doubles, because then a
+ * single multiplication or division is correctly rounded.  Any other real
+ * number is handed to a stream imbued with the classic locale, so the
+ * results and the range errors are the same as before.
  */
+
+static const double POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*
+ * Returns the value of the given digit character in bases up to 36, or
+ * a value of at least 36 if it is not a digit.
+ */
+static int digitValue(char ch) {
+    if (ch >= '0' && ch <= '9') {
+        return ch - '0';
+    } else if (ch >= 'a' && ch <= 'z') {
+        return ch - 'a' + 10;
+    } else if (ch >= 'A' && ch <= 'Z') {
+        return ch - 'A' + 10;
+    } else {
+        return 36;
+    }
+}
+
+/*
+ * Reads a signed integer in [minValue, maxValue] from [p, end); shared by
+ * parseInteger and parseLong.
+ */
+static const char* parseSigned(const char* p, const char* end, int radix,
+                               long long minValue, long long maxValue,
+                               long long& result) {
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        p++;
+    }
+    bool hexPrefix = end - p >= 3 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')
+            && digitValue(p[2]) < 16;
+    if (radix == 0) {
+        radix = hexPrefix ? 16 : (p < end && *p == '0') ? 8 : 10;
+    } else if (radix < 2 || radix > 36) {
+        return NULL;
+    }
+    if (radix == 16 && hexPrefix) {
+        p += 2;
+    }
+    unsigned long long limit = negative
+            ? (unsigned long long) -(minValue + 1) + 1
+            : (unsigned long long) maxValue;
+    unsigned long long value = 0;
+    const char* start = p;
+    while (p < end) {
+        int digit = digitValue(*p);
+        if (digit >= radix) {
+            break;
+        }
+        if (value > (limit - digit) / radix) {
+            return NULL;   // out of range
+        }
+        value = value * radix + digit;
+        p++;
+    }
+    if (p == start) {
+        return NULL;
+    }
+    if (!negative) {
+        result = (long long) value;
+    } else if (value == 0) {
+        result = 0;
+    } else {
+        result = -(long long) (value - 1) - 1;
+    }
+    return p;
+}
+
+const char* parseInteger(const char* begin, const char* end, int& n, int radix) {
+    long long value;
+    const char* next = parseSigned(begin, end, radix, INT_MIN, INT_MAX, value);
+    if (next != NULL) {
+        n = (int) value;
+    }
+    return next;
+}
+
+const char* parseLong(const char* begin, const char* end, long& n, int radix) {
+    long long value;
+    const char* next = parseSigned(begin, end, radix, LONG_MIN, LONG_MAX, value);
+    if (next != NULL) {
+        n = (long) value;
+    }
+    return next;
+}
+
+const char* parseReal(const char* begin, const char* end, double& d) {
+    const char* p = begin;
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    // up to 19 significant digits fit in the mantissa without overflow
+    unsigned long long mantissa = 0;
+    int significant = 0;
+    int exponent = 0;
+    bool anyDigits = false;
+    bool exact = true;
+    for (; p < end && isdigit((unsigned char) *p); p++) {
+        anyDigits = true;
+        if (significant < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            significant += mantissa != 0;
+        } else {
+            exponent++;
+            exact = false;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && isdigit((unsigned char) *p); p++) {
+            anyDigits = true;
+            if (significant < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                significant += mantissa != 0;
+                exponent--;
+            } else {
+                exact = false;
+            }
+        }
+    }
+    if (!anyDigits) {
+        return NULL;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool negativeExponent = false;
+        if (q < end && (*q == '+' || *q == '-')) {
+            negativeExponent = *q == '-';
+            q++;
+        }
+        if (q < end && isdigit((unsigned char) *q)) {
+            int power = 0;
+            for (; q < end && isdigit((unsigned char) *q); q++) {
+                if (power < 100000) {
+                    power = power * 10 + (*q - '0');
+                }
+            }
+            exponent += negativeExponent ? -power : power;
+            p = q;
+        }
+    }
+
+    if (mantissa == 0 && exact) {
+        d = negative ? -0.0 : 0.0;
+    } else if (exact && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        double value = (double) mantissa;
+        value = exponent < 0 ? value / POWERS_OF_TEN[-exponent]
+                             : value * POWERS_OF_TEN[exponent];
+        d = negative ? -value : value;
+    } else {
+        std::istringstream stream(std::string(begin, p));
+        stream.imbue(std::locale::classic());
+        double value;
+        stream >> value;
+        if (stream.fail()) {
+            return NULL;
+        }
+        d = value;
+    }
+    return p;
+}
+
 std::string doubleToString(double d) {
     return realToString(d);
 }
 
+char* integerToChars(char* buffer, int n) {
+    return longToChars(buffer, n);
+}
+
 std::string integerToString(int n) {
-    std::ostringstream stream;
-    stream << n;
-    return stream.str();
+    char buffer[NUMBER_BUFFER_SIZE];
+    return std::string(buffer, integerToChars(buffer, n));
+}
+
+char* longToChars(char* buffer, long n) {
+    char digits[NUMBER_BUFFER_SIZE];
+    int count = 0;
+    unsigned long magnitude = n < 0 ? 0UL - (unsigned long) n : (unsigned long) n;
+    do {
+        digits[count++] = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (n < 0) {
+        *buffer++ = '-';
+    }
+    while (count > 0) {
+        *buffer++ = digits[--count];
+    }
+    return buffer;
 }
 
 std::string longToString(long n) {
-    std::ostringstream stream;
-    stream << n;
-    return stream.str();
+    char buffer[NUMBER_BUFFER_SIZE];
+    return std::string(buffer, longToChars(buffer, n));
+}
+
+char* realToChars(char* buffer, double d) {
+    // small whole numbers print the same as integers under %G
+    if (d > -1e6 && d < 1e6 && d == (double) (long) d
+            && !(d == 0 && std::signbit(d))) {
+        return longToChars(buffer, (long) d);
+    }
+    int length = snprintf(buffer, NUMBER_BUFFER_SIZE, "%G", d);
+    return buffer + length;
 }
 
 std::string realToString(double d) {
-    std::ostringstream stream;
-    stream << std::uppercase << d;
-    return stream.str();
+    char buffer[NUMBER_BUFFER_SIZE];
+    return std::string(buffer, realToChars(buffer, d));
 }
 
 bool startsWith(const std::string& str, char prefix) {
@@ -159,26 +372,18 @@ bool stringIsDouble(const std::string& str) {
 }
 
 bool stringIsInteger(const std::string& str, int radix) {
-    std::istringstream stream(trim(str));
-    stream >> std::setbase(radix);
     int value;
-    stream >> value;
-    return !(stream.fail() || !stream.eof());
+    return tryStringToInteger(str, value, radix);
 }
 
 bool stringIsLong(const std::string& str, int radix) {
-    std::istringstream stream(trim(str));
-    stream >> std::setbase(radix);
     long value;
-    stream >> value;
-    return !(stream.fail() || !stream.eof());
+    return tryStringToLong(str, value, radix);
 }
 
 bool stringIsReal(const std::string& str) {
-    std::istringstream stream(trim(str));
     double value;
-    stream >> value;
-    return !(stream.fail() || !stream.eof());
+    return tryStringToReal(str, value);
 }
 
 bool stringToBool(const std::string& str) {
@@ -209,32 +414,24 @@ double stringToDouble(const std::string& str) {
 }
 
 int stringToInteger(const std::string& str, int radix) {
-    std::istringstream stream(trim(str));
-    stream >> std::setbase(radix);
-    int value;
-    stream >> value;
-    if (stream.fail() || !stream.eof()) {
+    int value = 0;
+    if (!tryStringToInteger(str, value, radix)) {
         error("stringToInteger: Illegal integer format (" + str + ")");
     }
     return value;
 }
 
 long stringToLong(const std::string& str, int radix) {
-    std::istringstream stream(trim(str));
-    stream >> std::setbase(radix);
-    long value;
-    stream >> value;
-    if (stream.fail() || !stream.eof()) {
+    long value = 0;
+    if (!tryStringToLong(str, value, radix)) {
         error("stringToLong: Illegal long format (" + str + ")");
     }
     return value;
 }
 
 double stringToReal(const std::string& str) {
-    std::istringstream stream(trim(str));
-    double value;
-    stream >> value;
-    if (stream.fail() || !stream.eof()) {
+    double value = 0;
+    if (!tryStringToReal(str, value)) {
         error("stringToReal: Illegal floating-point format (" + str + ")");
     }
     return value;
@@ -277,9 +474,7 @@ void toUpperCaseInPlace(std::string& str) {
 }
 
 std::string trim(const std::string& str) {
-    std::string str2 = str;
-    trimInPlace(str2);
-    return str2;
+    return trimView(str).toString();
 }
 
 void trimInPlace(std::string& str) {
@@ -288,9 +483,7 @@ void trimInPlace(std::string& str) {
 }
 
 std::string trimEnd(const std::string& str) {
-    std::string str2 = str;
-    trimEndInPlace(str2);
-    return str2;
+    return trimViewEnd(str).toString();
 }
 
 void trimEndInPlace(std::string& str) {
@@ -305,9 +498,7 @@ void trimEndInPlace(std::string& str) {
 }
 
 std::string trimStart(const std::string& str) {
-    std::string str2 = str;
-    trimStartInPlace(str2);
-    return str2;
+    return trimViewStart(str).toString();
 }
 
 void trimStartInPlace(std::string& str) {
@@ -366,24 +557,178 @@ int stringReplaceInPlace(std::string& str, const std::string& old, const std::st
 }
 
 std::vector<std::string> stringSplit(const std::string& str, const std::string& delimiter, int limit) {
-    std::string str2 = str;
+    std::vector<StringView> fields;
+    stringSplit(str, delimiter, fields, limit);
     std::vector<std::string> result;
-    int count = 0;
-    size_t index = 0;
-    while (limit < 0 || count < limit) {
-        index = str2.find(delimiter);
-        if (index == std::string::npos) {
-            break;
+    result.reserve(fields.size());
+    for (int i = 0; i < (int) fields.size(); i++) {
+        result.push_back(fields[i].toString());
+    }
+    return result;
+}
+
+int stringSplit(const StringView& str, const StringView& delimiter,
+                std::vector<StringView>& result, int limit) {
+    result.clear();
+    StringSplitter splitter(str, delimiter, false, limit);
+    for (StringSplitter::iterator it = splitter.begin(); it != splitter.end(); ++it) {
+        result.push_back(*it);
+    }
+    return (int) result.size();
+}
+
+StringSplitter stringSplitLazy(const StringView& str, const StringView& delimiter, int limit) {
+    return StringSplitter(str, delimiter, false, limit);
+}
+
+int stringTokenize(const StringView& str, std::vector<StringView>& tokens) {
+    return stringTokenize(str, " \t\r\n\f\v", tokens);
+}
+
+int stringTokenize(const StringView& str, const StringView& delimiters,
+                   std::vector<StringView>& tokens) {
+    tokens.clear();
+    StringSplitter splitter(str, delimiters, true);
+    for (StringSplitter::iterator it = splitter.begin(); it != splitter.end(); ++it) {
+        tokens.push_back(*it);
+    }
+    return (int) tokens.size();
+}
+
+StringSplitter stringTokenizeLazy(const StringView& str, const StringView& delimiters) {
+    return StringSplitter(str, delimiters, true);
+}
+
+StringView trimView(const StringView& str) {
+    return trimViewStart(trimViewEnd(str));
+}
+
+StringView trimViewEnd(const StringView& str) {
+    int finish = str.length();
+    while (finish > 0 && isspace((unsigned char) str[finish - 1])) {
+        finish--;
+    }
+    return StringView(str.data(), finish);
+}
+
+StringView trimViewStart(const StringView& str) {
+    int start = 0;
+    while (start < str.length() && isspace((unsigned char) str[start])) {
+        start++;
+    }
+    return StringView(str.data() + start, str.length() - start);
+}
+
+bool tryStringToInteger(const StringView& str, int& n, int radix) {
+    StringView trimmed = trimView(str);
+    int value = 0;
+    if (parseInteger(trimmed.begin(), trimmed.end(), value, radix) != trimmed.end()) {
+        return false;
+    }
+    n = value;
+    return true;
+}
+
+bool tryStringToLong(const StringView& str, long& n, int radix) {
+    StringView trimmed = trimView(str);
+    long value = 0;
+    if (parseLong(trimmed.begin(), trimmed.end(), value, radix) != trimmed.end()) {
+        return false;
+    }
+    n = value;
+    return true;
+}
+
+bool tryStringToReal(const StringView& str, double& d) {
+    StringView trimmed = trimView(str);
+    double value = 0;
+    if (parseReal(trimmed.begin(), trimmed.end(), value) != trimmed.end()) {
+        return false;
+    }
+    d = value;
+    return true;
+}
+
+/*
+ * Reads a line of numbers separated by delimiters into values, using the
+ * given function to read each number.  Shared by tryStringToIntegers and
+ * tryStringToReals.
+ */
+template <typename T>
+static bool parseDelimited(const StringView& line, const StringView& delimiters,
+                           const char* (*parse)(const char*, const char*, T&),
+                           Vector<T>& values) {
+    values.clear();
+    bool isDelimiter[256] = { false };
+    bool spaceSeparates = false;
+    for (char ch : delimiters) {
+        if (isspace((unsigned char) ch)) {
+            spaceSeparates = true;
+        } else {
+            isDelimiter[(unsigned char) ch] = true;
         }
-        result.push_back(str2.substr(0, index));
-        str2.erase(str2.begin(), str2.begin() + index + delimiter.length());
-        count++;
     }
-    if ((int) str2.length() > 0) {
-        result.push_back(str2);
+    const char* p = line.begin();
+    const char* end = line.end();
+    while (p < end && isspace((unsigned char) *p)) {
+        p++;
+    }
+    if (p == end) {
+        return true;
     }
+    while (true) {
+        T value;
+        p = parse(p, end, value);
+        if (p == NULL) {
+            return false;
+        }
+        values.add(value);
+        const char* afterNumber = p;
+        while (p < end && isspace((unsigned char) *p)) {
+            p++;
+        }
+        if (p == end) {
+            return true;
+        }
+        if (isDelimiter[(unsigned char) *p]) {
+            p++;
+            while (p < end && isspace((unsigned char) *p)) {
+                p++;
+            }
+        } else if (!spaceSeparates || p == afterNumber) {
+            return false;
+        }
+    }
+}
 
-    return result;
+static const char* parseDecimalInteger(const char* begin, const char* end, int& n) {
+    return parseInteger(begin, end, n, 10);
+}
+
+bool tryStringToIntegers(const StringView& line, Vector<int>& values,
+                         const StringView& delimiters) {
+    return parseDelimited(line, delimiters, parseDecimalInteger, values);
+}
+
+bool tryStringToReals(const StringView& line, Vector<double>& values,
+                      const StringView& delimiters) {
+    return parseDelimited(line, delimiters, parseReal, values);
+}
+
+Vector<int> stringToIntegers(const StringView& line, const StringView& delimiters) {
+    Vector<int> values;
+    if (!tryStringToIntegers(line, values, delimiters)) {
+        error("stringToIntegers: Illegal integer format (" + line.toString() + ")");
+    }
+    return values;
+}
+
+Vector<double> stringToReals(const StringView& line, const StringView& delimiters) {
+    Vector<double> values;
+    if (!tryStringToReals(line, values, delimiters)) {
+        error("stringToReals: Illegal floating-point format (" + line.toString() + ")");
+    }
+    return values;
 }
 
 std::string stringJoin(const std::vector<std::string>& v, const std::string& delimiter) {
@@ -458,6 +803,111 @@ void urlEncodeInPlace(std::string& str) {
 }
 
 
+/*
+ * Implementation notes: StringView and StringSplitter
+ * ---------------------------------------------------
+ * A splitter walks a cursor forward through the string and never looks
+ * behind it, so splitting or tokenizing a whole string is one linear scan.
+ * Delimiter text is found with memchr on its first character followed by
+ * a memcmp of the rest; tokenizing looks each character up in a 256-entry
+ * table of delimiter characters.
+ */
+
+/*
+ * Returns a pointer to the first occurrence of the given text in
+ * [from, end), or NULL if there is none.
+ */
+static const char* findText(const char* from, const char* end, const StringView& text) {
+    int n = text.length();
+    char first = text[0];
+    while (end - from >= n) {
+        const char* p = (const char*) std::memchr(from, first, end - from - n + 1);
+        if (p == NULL) {
+            return NULL;
+        }
+        if (std::memcmp(p + 1, text.data() + 1, n - 1) == 0) {
+            return p;
+        }
+        from = p + 1;
+    }
+    return NULL;
+}
+
+int StringView::indexOf(const StringView& substring, int startIndex) const {
+    if (startIndex < 0 || startIndex > len) {
+        return -1;
+    }
+    if (substring.isEmpty()) {
+        return startIndex;
+    }
+    const char* p = findText(ptr + startIndex, ptr + len, substring);
+    return p == NULL ? -1 : (int) (p - ptr);
+}
+
+StringView StringView::substr(int start, int length) const {
+    if (start < 0 || start > len) {
+        error("StringView::substr: start index " + integerToString(start)
+              + " out of range for length " + integerToString(len));
+    }
+    if (length < 0 || length > len - start) {
+        length = len - start;
+    }
+    return StringView(ptr + start, length);
+}
+
+std::ostream& operator <<(std::ostream& os, const StringView& view) {
+    return os.write(view.data(), view.length());
+}
+
+StringSplitter::StringSplitter(const StringView& str, const StringView& delimiter,
+                               bool tokenize, int limit)
+        : str(str), delimiter(delimiter), tokenize(tokenize), limit(limit) {
+    if (!tokenize && delimiter.isEmpty()) {
+        error("stringSplit: delimiter cannot be empty");
+    }
+    std::memset(isDelimiter, 0, sizeof(isDelimiter));
+    if (tokenize) {
+        for (char ch : delimiter) {
+            isDelimiter[(unsigned char) ch] = true;
+        }
+    }
+}
+
+bool StringSplitter::next(const char*& cursor, int& count, StringView& field) const {
+    if (cursor == NULL) {
+        return false;
+    }
+    const char* end = str.end();
+    if (tokenize) {
+        while (cursor < end && isDelimiter[(unsigned char) *cursor]) {
+            cursor++;
+        }
+        if (cursor == end) {
+            cursor = NULL;
+            return false;
+        }
+        const char* start = cursor;
+        while (cursor < end && !isDelimiter[(unsigned char) *cursor]) {
+            cursor++;
+        }
+        field = StringView(start, (int) (cursor - start));
+        return true;
+    }
+
+    // like the original stringSplit, a trailing empty piece is dropped
+    const char* found = (limit < 0 || count < limit)
+            ? findText(cursor, end, delimiter) : NULL;
+    if (found != NULL) {
+        field = StringView(cursor, (int) (found - cursor));
+        cursor = found + delimiter.length();
+        count++;
+        return true;
+    }
+    field = StringView(cursor, (int) (end - cursor));
+    cursor = NULL;
+    return !field.isEmpty();
+}
+
 /*
  * Implementation notes: readQuotedString and writeQuotedString
  * ------------------------------------------------------------
@@ -4,6 +4,12 @@
  * This file exports several useful string functions that are not
  * included in the C++ string library.
  * 
+ * @version 2026/10/18
+ * - added StringView and StringSplitter types
+ * - added view-based stringSplit, stringTokenize and trimView functions
+ * - stringSplit now runs in linear time
+ * - added parse/ToChars/tryStringTo numeric conversions that do not use
+ *   streams, and stringToIntegers/stringToReals for whole lines
  * @version 2015/10/26
  * - added charToInteger/integerToChar functions
  * @version 2015/08/02
@@ -18,11 +24,259 @@
 #ifndef _strlib_h
 #define _strlib_h
 
+#include <cstring>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include <string>
 #include <vector>
 
+template <typename ValueType> class Vector;   // forward declaration
+
+/*
+ * Constant: NUMBER_BUFFER_SIZE
+ * ----------------------------
+ * The number of characters a buffer passed to integerToChars,
+ * longToChars or realToChars must have room for.
+ */
+const int NUMBER_BUFFER_SIZE = 32;
+
+/*
+ * Class: StringView
+ * -----------------
+ * A read-only reference to a run of characters that live somewhere else,
+ * usually inside a std::string.  A view is just a pointer and a length,
+ * so making one or taking a substring of one never copies the characters.
+ * The functions below that produce views use this to split and trim long
+ * strings without allocating a new string for every piece.
+ *
+ * A view does not own its characters.  It is only valid for as long as
+ * the string it refers to is alive and unmodified, so do not make a view
+ * of a temporary string or keep a view after changing the original.
+ */
+class StringView {
+public:
+    /*
+     * Constructor: StringView
+     * Usage: StringView view;
+     *        StringView view(str);
+     *        StringView view(chars, length);
+     * --------------------------------------
+     * Creates an empty view, a view of all of a string, or a view of the
+     * given number of characters starting at the given pointer.
+     */
+    StringView() : ptr(""), len(0) {}
+    StringView(const char* s) : ptr(s), len((int) std::strlen(s)) {}
+    StringView(const char* s, int length) : ptr(s), len(length) {}
+    StringView(const std::string& s) : ptr(s.data()), len((int) s.length()) {}
+
+    /*
+     * Method: begin, end
+     * Usage: for (char ch : view) ...
+     * -------------------------------
+     * Returns pointers to the first character of the view and just past
+     * its last character.
+     */
+    const char* begin() const { return ptr; }
+    const char* end() const { return ptr + len; }
+
+    /*
+     * Method: data
+     * Usage: const char* chars = view.data();
+     * ---------------------------------------
+     * Returns a pointer to the first character of the view.  The characters
+     * are not null-terminated.
+     */
+    const char* data() const { return ptr; }
+
+    /*
+     * Method: indexOf
+     * Usage: int index = view.indexOf(substring, startIndex);
+     * -------------------------------------------------------
+     * Returns the index of the first occurrence of the given text at or
+     * after startIndex, or -1 if it does not occur.
+     */
+    int indexOf(const StringView& substring, int startIndex = 0) const;
+
+    /*
+     * Method: isEmpty
+     * Usage: if (view.isEmpty()) ...
+     * ------------------------------
+     * Returns true if the view has no characters.
+     */
+    bool isEmpty() const { return len == 0; }
+
+    /*
+     * Method: length, size
+     * Usage: int n = view.length();
+     * -----------------------------
+     * Returns the number of characters in the view.
+     */
+    int length() const { return len; }
+    int size() const { return len; }
+
+    /*
+     * Method: substr
+     * Usage: StringView sub = view.substr(start, length);
+     * ---------------------------------------------------
+     * Returns a view of part of this view, without copying.  If length is
+     * omitted or runs past the end, the substring runs to the end.
+     * Throws an error if start is not in the range [0, length()].
+     */
+    StringView substr(int start, int length = -1) const;
+
+    /*
+     * Method: toString
+     * Usage: string str = view.toString();
+     * ------------------------------------
+     * Returns a new string holding a copy of the characters in the view.
+     */
+    std::string toString() const { return std::string(ptr, len); }
+
+    /*
+     * Operator: []
+     * Usage: char ch = view[index];
+     * -----------------------------
+     * Returns the character at the given index.  The index is not checked.
+     */
+    char operator [](int index) const { return ptr[index]; }
+
+    /*
+     * Operators: ==, !=
+     * Usage: if (view1 == view2) ...
+     * ------------------------------
+     * Compares the characters of two views.
+     */
+    bool operator ==(const StringView& other) const {
+        return len == other.len && std::memcmp(ptr, other.ptr, len) == 0;
+    }
+
+    bool operator !=(const StringView& other) const {
+        return !(*this == other);
+    }
+
+private:
+    const char* ptr;   // first character of the view
+    int len;           // number of characters
+};
+
+/*
+ * Operator: <<
+ * Usage: cout << view;
+ * --------------------
+ * Writes the characters of the view to the given output stream.
+ */
+std::ostream& operator <<(std::ostream& os, const StringView& view);
+
+/*
+ * Class: StringSplitter
+ * ---------------------
+ * A lazy sequence of the pieces of a string, as produced by the
+ * stringSplitLazy and stringTokenizeLazy functions below.  Each piece is
+ * found only when the loop asks for it, so a loop that stops early never
+ * scans the rest of the string:
+ *
+ *    for (StringView field : stringSplitLazy(line, ",")) {
+ *        if (field == "END") break;
+ *        ...
+ *    }
+ *
+ * Like StringView, a splitter refers to the original string and must not
+ * outlive it.
+ */
+class StringSplitter {
+public:
+    /*
+     * Constructor: StringSplitter
+     * Usage: StringSplitter splitter(str, delimiter, tokenize, limit);
+     * ----------------------------------------------------------------
+     * Creates a splitter over str.  If tokenize is false, the string is
+     * split on the text of 'delimiter' exactly as stringSplit does.  If
+     * tokenize is true, any character of 'delimiter' separates pieces and
+     * empty pieces are skipped, as in stringTokenize.
+     */
+    StringSplitter(const StringView& str, const StringView& delimiter,
+                   bool tokenize = false, int limit = -1);
+
+    /*
+     * Iterator support
+     * ----------------
+     * The iterator is an input iterator whose values are StringViews.
+     */
+    class iterator {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef StringView value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const StringView* pointer;
+        typedef const StringView& reference;
+
+        iterator() : sp(NULL), cursor(NULL), count(0), done(true) {}
+
+        iterator(const StringSplitter* sp, bool end)
+                : sp(sp), cursor(sp->str.begin()), count(0), done(end) {
+            if (!done) {
+                done = !sp->next(cursor, count, field);
+            }
+        }
+
+        iterator& operator ++() {
+            done = !sp->next(cursor, count, field);
+            return *this;
+        }
+
+        iterator operator ++(int) {
+            iterator copy(*this);
+            operator++();
+            return copy;
+        }
+
+        bool operator ==(const iterator& rhs) const {
+            return done == rhs.done && (done || cursor == rhs.cursor);
+        }
+
+        bool operator !=(const iterator& rhs) const {
+            return !(*this == rhs);
+        }
+
+        const StringView& operator *() const {
+            return field;
+        }
+
+        const StringView* operator ->() const {
+            return &field;
+        }
+
+    private:
+        const StringSplitter* sp;
+        const char* cursor;   // where the search for the next piece starts
+        int count;            // number of delimiters consumed so far
+        StringView field;
+        bool done;
+    };
+
+    iterator begin() const {
+        return iterator(this, false);
+    }
+
+    iterator end() const {
+        return iterator(this, true);
+    }
+
+private:
+    StringView str;
+    StringView delimiter;
+    bool tokenize;
+    int limit;
+    bool isDelimiter[256];   // character set used when tokenizing
+
+    /*
+     * Finds the piece that starts at or after cursor, stores it in field,
+     * and moves cursor past it.  Returns false if there are no more pieces.
+     */
+    bool next(const char*& cursor, int& count, StringView& field) const;
+};
+
 /*
  * Returns the string "true" if b is true, or "false" if b is false.
  */
@@ -110,6 +364,17 @@ char integerToChar(int n);
  */
 std::string integerToString(int n);
 
+/*
+ * Function: integerToChars
+ * Usage: char* end = integerToChars(buffer, n);
+ * ---------------------------------------------
+ * Writes the digits of n into the given buffer, which must have room for
+ * NUMBER_BUFFER_SIZE characters, and returns a pointer just past the last
+ * character written.  No null terminator is written.  This produces the
+ * same text as integerToString without creating a string.
+ */
+char* integerToChars(char* buffer, int n);
+
 /*
  * Function: longToString
  * Usage: string s = longToString(n);
@@ -120,6 +385,47 @@ std::string integerToString(int n);
  */
 std::string longToString(long n);
 
+/*
+ * Function: longToChars
+ * Usage: char* end = longToChars(buffer, n);
+ * ------------------------------------------
+ * Like integerToChars, but for a long.
+ */
+char* longToChars(char* buffer, long n);
+
+/*
+ * Function: parseInteger
+ * Usage: const char* next = parseInteger(begin, end, n, radix);
+ * -------------------------------------------------------------
+ * Reads an integer from the characters in [begin, end) into n and returns
+ * a pointer just past the characters it used, or NULL if the characters
+ * do not start with an integer that fits in an int.  There may be more
+ * characters after the number; leading whitespace is not skipped.
+ * The number may have a + or - sign.  The radix may be 2 through 36;
+ * base-16 numbers may start with 0x, and a radix of 0 picks the base from
+ * the prefix (0x for 16, 0 for 8, otherwise 10).
+ * These functions never throw and do not depend on the current locale.
+ */
+const char* parseInteger(const char* begin, const char* end, int& n, int radix = 10);
+
+/*
+ * Function: parseLong
+ * Usage: const char* next = parseLong(begin, end, n, radix);
+ * ----------------------------------------------------------
+ * Like parseInteger, but for a long.
+ */
+const char* parseLong(const char* begin, const char* end, long& n, int radix = 10);
+
+/*
+ * Function: parseReal
+ * Usage: const char* next = parseReal(begin, end, d);
+ * ---------------------------------------------------
+ * Like parseInteger, but reads a real number such as "-3.5", ".25" or
+ * "6.02e23" into d.  The result is correctly rounded.  Returns NULL if
+ * the number is too large to be represented as a double.
+ */
+const char* parseReal(const char* begin, const char* end, double& d);
+
 /*
  * Function: realToString
  * Usage: string s = realToString(d);
@@ -131,6 +437,16 @@ std::string longToString(long n);
 std::string realToString(double d);
 std::string doubleToString(double d);   // alias
 
+/*
+ * Function: realToChars
+ * Usage: char* end = realToChars(buffer, d);
+ * ------------------------------------------
+ * Writes the same text as realToString into the given buffer, which must
+ * have room for NUMBER_BUFFER_SIZE characters, and returns a pointer just
+ * past the last character written.  No null terminator is written.
+ */
+char* realToChars(char* buffer, double d);
+
 /*
  * Function: startsWith
  * Usage: if (startsWith(str, prefix)) ...
@@ -218,6 +534,26 @@ int stringReplaceInPlace(std::string& str, const std::string& old, const std::st
  */
 std::vector<std::string> stringSplit(const std::string& str, const std::string& delimiter, int limit = -1);
 
+/*
+ * Splits str in the same way as the function above, but stores views of
+ * the pieces into 'result' instead of copying each one into a new string.
+ * The vector is cleared first, so one vector can be reused for many lines
+ * without reallocating.  Returns the number of pieces.
+ * The string is scanned once from left to right.
+ */
+int stringSplit(const StringView& str, const StringView& delimiter,
+                std::vector<StringView>& result, int limit = -1);
+
+/*
+ * Function: stringSplitLazy
+ * Usage: for (StringView field : stringSplitLazy(str, delimiter)) ...
+ * -------------------------------------------------------------------
+ * Returns a sequence of the same pieces that stringSplit would produce,
+ * found one at a time as a loop asks for them.
+ */
+StringSplitter stringSplitLazy(const StringView& str, const StringView& delimiter,
+                               int limit = -1);
+
 /*
  * If str is "true", returns the bool value true.
  * If str is "false", returns the bool value false.
@@ -246,6 +582,24 @@ char stringToChar(const std::string& str);
  */
 int stringToInteger(const std::string& str, int radix = 10);
 
+/*
+ * Function: stringToIntegers
+ * Usage: Vector<int> v = stringToIntegers(line, delimiters);
+ * ----------------------------------------------------------
+ * Converts a line of integers separated by any one of the characters in
+ * 'delimiters' (by default a comma) into a Vector, in one pass over the
+ * line.  Whitespace around each number is ignored, and if the delimiters
+ * include whitespace, a run of whitespace separates numbers.  A blank line
+ * gives an empty Vector.  If any field is empty or is not a legal integer,
+ * <code>stringToIntegers</code> calls <code>error</code> with an
+ * appropriate message.  Include vector.h to use this function.
+ * The 'try' variant stores the numbers into the given Vector and returns
+ * false instead of calling error.
+ */
+Vector<int> stringToIntegers(const StringView& line, const StringView& delimiters = ",");
+bool tryStringToIntegers(const StringView& line, Vector<int>& values,
+                         const StringView& delimiters = ",");
+
 /*
  * Function: stringToLong
  * Usage: long n = stringToLong(str);
@@ -272,6 +626,40 @@ long stringToLong(const std::string& str, int radix = 10);
 double stringToReal(const std::string& str);
 double stringToDouble(const std::string& str);   // alias
 
+/*
+ * Function: stringToReals
+ * Usage: Vector<double> v = stringToReals(line, delimiters);
+ * ----------------------------------------------------------
+ * Like stringToIntegers, but for a line of real numbers.
+ */
+Vector<double> stringToReals(const StringView& line, const StringView& delimiters = ",");
+bool tryStringToReals(const StringView& line, Vector<double>& values,
+                      const StringView& delimiters = ",");
+
+/*
+ * Function: stringTokenize
+ * Usage: int count = stringTokenize(str, delimiters, tokens);
+ * -----------------------------------------------------------
+ * Stores into 'tokens' views of the non-empty runs of characters in str
+ * that are separated by any of the characters in 'delimiters', which by
+ * default are the whitespace characters.  For example, tokenizing
+ * "  Hi there,,Jim! " on " ," gives {"Hi", "there", "Jim!"}.
+ * The vector is cleared first.  Returns the number of tokens.
+ */
+int stringTokenize(const StringView& str, std::vector<StringView>& tokens);
+int stringTokenize(const StringView& str, const StringView& delimiters,
+                   std::vector<StringView>& tokens);
+
+/*
+ * Function: stringTokenizeLazy
+ * Usage: for (StringView token : stringTokenizeLazy(str, delimiters)) ...
+ * -----------------------------------------------------------------------
+ * Returns a sequence of the same tokens that stringTokenize would produce,
+ * found one at a time as a loop asks for them.
+ */
+StringSplitter stringTokenizeLazy(const StringView& str,
+                                  const StringView& delimiters = " \t\r\n\f\v");
+
 /*
  * Function: toLowerCase
  * Usage: string s = toLowerCase(str);
@@ -327,6 +715,30 @@ void trimEndInPlace(std::string& str);
 std::string trimStart(const std::string& str);
 void trimStartInPlace(std::string& str);
 
+/*
+ * Function: trimView
+ * Usage: StringView trimmed = trimView(view);
+ * -------------------------------------------
+ * Returns a view of the argument without any whitespace characters at
+ * its beginning and end.  Nothing is copied.  The trimViewEnd and
+ * trimViewStart variants only trim one side.
+ */
+StringView trimView(const StringView& str);
+StringView trimViewEnd(const StringView& str);
+StringView trimViewStart(const StringView& str);
+
+/*
+ * Function: tryStringToInteger
+ * Usage: if (tryStringToInteger(str, n)) ...
+ * ------------------------------------------
+ * Converts a string to a number in the same way as stringToInteger,
+ * stringToLong and stringToReal, but instead of calling error on an
+ * illegal string, returns false and leaves the number unchanged.
+ */
+bool tryStringToInteger(const StringView& str, int& n, int radix = 10);
+bool tryStringToLong(const StringView& str, long& n, int radix = 10);
+bool tryStringToReal(const StringView& str, double& d);
+
 /*
  * Returns a URL-decoded version of the given string, where any %xx character
  * codes are converted back to the equivalent characters.
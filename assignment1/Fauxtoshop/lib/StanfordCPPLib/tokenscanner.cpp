@@ -3,6 +3,11 @@
  * ----------------------
  * Implementation for the TokenScanner class.
  * 
+ * @version 2026/10/18
+ * - string input is scanned in place by scanBufferToken
+ * - added setInputBuffer and nextTokenView
+ * - operators are kept in a trie instead of a list
+ * - scanNumber no longer keeps an 'e' or sign that it pushed back
  * @version 2014/10/08
  * - removed 'using namespace' statement
  */
@@ -30,23 +35,52 @@ TokenScanner::TokenScanner(std::istream & infile) {
 }
 
 TokenScanner::~TokenScanner() {
-    if (stringInputFlag) delete isp;
+    while (savedTokens != NULL) {
+        StringCell *cp = savedTokens;
+        savedTokens = cp->link;
+        delete cp;
+    }
 }
 
 void TokenScanner::setInput(std::string str) {
-    stringInputFlag = true;
-    buffer = str;
-    isp = new std::istringstream(buffer);
-    savedTokens = NULL;
+    buffer.swap(str);
+    setInputBuffer(buffer);
 }
 
 void TokenScanner::setInput(std::istream & infile) {
     stringInputFlag = false;
     isp = &infile;
+    bufferStart = bufferEnd = cursor = NULL;
+    peekStart = NULL;
+    savedTokens = NULL;
+}
+
+void TokenScanner::setInputBuffer(const StringView& input) {
+    stringInputFlag = true;
+    isp = NULL;
+    bufferStart = cursor = input.begin();
+    bufferEnd = input.end();
+    peekStart = NULL;
     savedTokens = NULL;
 }
 
+/*
+ * Implementation notes: hasMoreTokens
+ * -----------------------------------
+ * For buffer input, the token found here is kept in peekedToken, with
+ * peekStart marking where it began, so that the usual loop of
+ * hasMoreTokens and nextToken scans each token only once.
+ */
+
 bool TokenScanner::hasMoreTokens() {
+    if (stringInputFlag && savedTokens == NULL) {
+        if (peekStart == NULL) {
+            const char *start = cursor;
+            peekedToken = scanBufferToken();
+            peekStart = start;
+        }
+        return !peekedToken.text.isEmpty();
+    }
     std::string token = nextToken();
     saveToken(token);
     return (token != "");
@@ -60,6 +94,9 @@ std::string TokenScanner::nextToken() {
         delete cp;
         return token;
     }
+    if (stringInputFlag) {
+        return nextTokenView().text.toString();
+    }
     while (true) {
         if (ignoreWhitespaceFlag) skipSpaces();
         int ch = isp->get();
@@ -110,6 +147,21 @@ std::string TokenScanner::nextToken() {
     }
 }
 
+ScannedToken TokenScanner::nextTokenView() {
+    if (savedTokens != NULL || !stringInputFlag) {
+        tokenText = nextToken();
+        ScannedToken token;
+        token.text = tokenText;
+        token.type = tokenTypeOf(token.text);
+        return token;
+    }
+    if (peekStart != NULL) {
+        peekStart = NULL;
+        return peekedToken;
+    }
+    return scanBufferToken();
+}
+
 void TokenScanner::saveToken(std::string token) {
     StringCell *cp = new StringCell;
     cp->str = token;
@@ -118,61 +170,78 @@ void TokenScanner::saveToken(std::string token) {
 }
 
 void TokenScanner::ignoreWhitespace() {
+    rewindPeek();
     ignoreWhitespaceFlag = true;
 }
 
 void TokenScanner::ignoreComments() {
+    rewindPeek();
     ignoreCommentsFlag = true;
 }
 
 void TokenScanner::scanNumbers() {
+    rewindPeek();
     scanNumbersFlag = true;
 }
 
 void TokenScanner::scanStrings() {
+    rewindPeek();
     scanStringsFlag = true;
 }
 
 void TokenScanner::addWordCharacters(std::string str) {
+    rewindPeek();
     wordChars += str;
+    for (int i = 0; i < (int) str.length(); i++) {
+        wordCharTable[(unsigned char) str[i]] = true;
+    }
 }
 
 void TokenScanner::addOperator(std::string op) {
-    StringCell *cp = new StringCell;
-    cp->str = op;
-    cp->link = operators;
-    operators = cp;
+    rewindPeek();
+    int node = 0;
+    for (int i = 0; i < (int) op.length(); i++) {
+        int child = findOperatorChild(node, op[i]);
+        if (child < 0) {
+            OperatorNode cell = { op[i], false, -1, operatorTrie[node].firstChild };
+            child = operatorTrie.size();
+            operatorTrie.push_back(cell);
+            operatorTrie[node].firstChild = child;
+        }
+        node = child;
+    }
+    operatorTrie[node].isOperator = true;
 }
 
 int TokenScanner::getPosition() const {
+    int pos;
+    if (stringInputFlag) {
+        pos = int((peekStart != NULL ? peekStart : cursor) - bufferStart);
+    } else {
+        pos = int(isp->tellg());
+    }
     if (savedTokens == NULL) {
-        return int(isp->tellg());
+        return pos;
     } else {
-        return int(isp->tellg()) - savedTokens->str.length();
+        return pos - savedTokens->str.length();
     }
 }
 
 bool TokenScanner::isWordCharacter(char ch) const {
-    return isalnum(ch) || wordChars.find(ch) != std::string::npos;
+    return wordCharTable[(unsigned char) ch];
 }
 
 void TokenScanner::verifyToken(std::string expected) {
-    std::string token = nextToken();
+    StringView token = nextTokenView().text;
     if (token != expected) {
-        error("TokenScanner::verifyToken: Found \"" + token + "\"" +
+        error("TokenScanner::verifyToken: Found \"" + token.toString() + "\"" +
               " when expecting \"" + expected + "\"");
     }
 }
 
-TokenType TokenScanner::getTokenType(std::string token) const {
-    if (token == "") return TokenType(EOF);
-    char ch = token[0];
-    if (isspace(ch)) return SEPARATOR;
-    if (ch == '"' || (ch == '\'' && token.length() > 1)) return STRING;
-    if (isdigit(ch)) return NUMBER;
-    if (isWordCharacter(ch)) return WORD;
-    return OPERATOR;
-};
+TokenType TokenScanner::getTokenType(const std::string& token) const {
+    return tokenTypeOf(token);
+}
 
 std::string TokenScanner::getStringValue(std::string token) const {
     std::string str = "";
@@ -230,10 +299,19 @@ std::string TokenScanner::getStringValue(std::string token) const {
 }
 
 int TokenScanner::getChar() {
+    if (stringInputFlag) {
+        rewindPeek();
+        return (cursor < bufferEnd) ? (unsigned char) *cursor++ : EOF;
+    }
     return isp->get();
 }
 
 void TokenScanner::ungetChar(int) {
+    if (stringInputFlag) {
+        rewindPeek();
+        if (cursor > bufferStart) cursor--;
+        return;
+    }
     isp->unget();
 }
 
@@ -244,7 +322,118 @@ void TokenScanner::initScanner() {
     ignoreCommentsFlag = false;
     scanNumbersFlag = false;
     scanStringsFlag = false;
-    operators = NULL;
+    isp = NULL;
+    peekStart = NULL;
+    savedTokens = NULL;
+    for (int ch = 0; ch < 256; ch++) {
+        wordCharTable[ch] = isalnum(ch);
+    }
+    OperatorNode root = { '\0', false, -1, -1 };
+    operatorTrie.push_back(root);
+}
+
+/*
+ * Implementation notes: rewindPeek
+ * --------------------------------
+ * Puts back a token that hasMoreTokens scanned ahead, so that it is
+ * scanned again under the scanner's current settings.
+ */
+
+void TokenScanner::rewindPeek() {
+    if (peekStart != NULL) {
+        cursor = peekStart;
+        peekStart = NULL;
+    }
+}
+
+TokenType TokenScanner::tokenTypeOf(const StringView& token) const {
+    if (token.isEmpty()) return TokenType(EOF);
+    char ch = token[0];
+    if (isspace((unsigned char) ch)) return SEPARATOR;
+    if (ch == '"' || (ch == '\'' && token.length() > 1)) return STRING;
+    if (isdigit((unsigned char) ch)) return NUMBER;
+    if (isWordCharacter(ch)) return WORD;
+    return OPERATOR;
+}
+
+/*
+ * Implementation notes: scanBufferToken
+ * -------------------------------------
+ * Reads the next token from buffer input by moving a pointer over the
+ * characters, following the same rules as the stream-based code below:
+ * comments, strings, numbers and words are recognized in that order, and
+ * anything else is the longest defined operator found by walking the
+ * operator trie, or a single character if there is none.  The token is a
+ * view into the buffer, so nothing is copied or allocated.
+ */
+
+ScannedToken TokenScanner::scanBufferToken() {
+    const char *p = cursor;
+    const char *end = bufferEnd;
+    while (true) {
+        if (ignoreWhitespaceFlag) {
+            while (p < end && isspace((unsigned char) *p)) p++;
+        }
+        if (end - p >= 2 && *p == '/' && ignoreCommentsFlag) {
+            if (p[1] == '/') {
+                for (p += 2; p < end; p++) {
+                    if (*p == '\n' || *p == '\r') {
+                        p++;
+                        break;
+                    }
+                }
+                continue;
+            } else if (p[1] == '*') {
+                int prev = EOF;
+                for (p += 2; p < end; ) {
+                    char ch = *p++;
+                    if (prev == '*' && ch == '/') break;
+                    prev = ch;
+                }
+                continue;
+            }
+        }
+        break;
+    }
+    const char *start = p;
+    if (p < end) {
+        char ch = *p++;
+        if ((ch == '"' || ch == '\'') && scanStringsFlag) {
+            bool escape = false;
+            while (true) {
+                if (p == end) error("TokenScanner::scanString: found unterminated string");
+                char c = *p++;
+                if (c == ch && !escape) break;
+                escape = (c == '\\') && !escape;
+            }
+        } else if (isdigit((unsigned char) ch) && scanNumbersFlag) {
+            while (p < end && isdigit((unsigned char) *p)) p++;
+            if (p < end && *p == '.') {
+                for (p++; p < end && isdigit((unsigned char) *p); p++) { }
+            }
+            if (p < end && (*p == 'E' || *p == 'e')) {
+                const char *q = p + 1;
+                if (q < end && (*q == '+' || *q == '-')) q++;
+                if (q < end && isdigit((unsigned char) *q)) {
+                    for (p = q; p < end && isdigit((unsigned char) *p); p++) { }
+                }
+            }
+        } else if (isWordCharacter(ch)) {
+            while (p < end && isWordCharacter(*p)) p++;
+        } else {
+            int node = 0;
+            for (const char *q = start; q < end; ) {
+                node = findOperatorChild(node, *q++);
+                if (node < 0) break;
+                if (operatorTrie[node].isOperator && q - start > 1) p = q;
+            }
+        }
+    }
+    cursor = p;
+    ScannedToken token;
+    token.text = StringView(start, int(p - start));
+    token.type = tokenTypeOf(token.text);
+    return token;
 }
 
 /*
@@ -334,6 +523,7 @@ std::string TokenScanner::scanNumber() {
             } else {
                 if (ch != EOF) isp->unget();
                 isp->unget();
+                token.erase(token.length() - 1);
                 state = FINAL_STATE;
             }
             break;
@@ -344,6 +534,7 @@ std::string TokenScanner::scanNumber() {
                 if (ch != EOF) isp->unget();
                 isp->unget();
                 isp->unget();
+                token.erase(token.length() - 2);
                 state = FINAL_STATE;
             }
             break;
@@ -390,22 +581,33 @@ std::string TokenScanner::scanString() {
 /*
  * Implementation notes: isOperator, isOperatorPrefix
  * --------------------------------------------------
- * These methods search the list of operators and return true if the
- * specified operator is either in the list or a prefix of an operator
- * in the list, respectively.  This code could be made considerably more
- * efficient by implementing operators as a trie.
+ * These methods look the specified string up in the operator trie and
+ * return true if it is a defined operator or a prefix of one, respectively.
+ * The string is a prefix exactly when the walk reaches a node, and an
+ * operator when that node is marked as the end of one.
  */
 
-bool TokenScanner::isOperator(std::string op) {
-    for (StringCell *cp = operators; cp != NULL; cp = cp->link) {
-        if (op == cp->str) return true;
+bool TokenScanner::isOperator(const std::string& op) const {
+    int node = findOperatorNode(op);
+    return node >= 0 && operatorTrie[node].isOperator;
+}
+
+bool TokenScanner::isOperatorPrefix(const std::string& op) const {
+    return findOperatorNode(op) >= 0;
+}
+
+int TokenScanner::findOperatorChild(int node, char ch) const {
+    for (int child = operatorTrie[node].firstChild; child >= 0;
+         child = operatorTrie[child].nextSibling) {
+        if (operatorTrie[child].ch == ch) return child;
     }
-    return false;
+    return -1;
 }
 
-bool TokenScanner::isOperatorPrefix(std::string op) {
-    for (StringCell *cp = operators; cp != NULL; cp = cp->link) {
-        if (startsWith(cp->str, op)) return true;
+int TokenScanner::findOperatorNode(const std::string& op) const {
+    int node = 0;
+    for (int i = 0; i < (int) op.length() && node >= 0; i++) {
+        node = findOperatorChild(node, op[i]);
     }
-    return false;
+    return node;
 }
@@ -3,6 +3,11 @@
  * --------------------
  * This file exports a <code>TokenScanner</code> class that divides
  * a string into individual logical units called <b><i>tokens</i></b>.
+ * 
+ * @version 2026/10/18
+ * - string and buffer input are scanned in place instead of through a stream
+ * - added setInputBuffer and nextTokenView for reading tokens without copying
+ * - operators are matched with a trie
  */
 
 #ifndef _tokenscanner_h
@@ -10,6 +15,8 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include "strlib.h"
 #include "private/tokenpatch.h"
 
 /*
@@ -26,6 +33,17 @@
 
 enum TokenType { SEPARATOR, WORD, NUMBER, STRING, OPERATOR };
 
+/*
+ * Type: ScannedToken
+ * ------------------
+ * A token returned by the <code>nextTokenView</code> method: a view of
+ * the token's characters together with its type.
+ */
+struct ScannedToken {
+    StringView text;
+    TokenType type;
+};
+
 /*
  * Class: TokenScanner
  * -------------------
@@ -80,6 +98,17 @@ public:
     void setInput(std::string str);
     void setInput(std::istream & infile);
 
+    /*
+     * Method: setInputBuffer
+     * Usage: scanner.setInputBuffer(view);
+     * ------------------------------------
+     * Sets the token stream for this scanner to the characters of the
+     * given view, without copying them.  The characters may belong to a
+     * string, a memory-mapped file or any other block of memory, which
+     * must stay alive and unchanged for as long as the scanner reads it.
+     */
+    void setInputBuffer(const StringView& input);
+
     /*
      * Method: hasMoreTokens
      * Usage: if (scanner.hasMoreTokens()) ...
@@ -98,6 +127,20 @@ public:
      */
     std::string nextToken();
 
+    /*
+     * Method: nextTokenView
+     * Usage: ScannedToken token = scanner.nextTokenView();
+     * ----------------------------------------------------
+     * Returns the next token together with its type, as
+     * <code>getTokenType</code> would report it.  When the input is a
+     * string or a buffer, the token's text is a view directly into the
+     * input, so no string is created for it.  For stream input and for
+     * tokens pushed back with <code>saveToken</code>, the view is only
+     * valid until the next call.  At the end of the input the text is
+     * empty and the type is <code>EOF</code>.
+     */
+    ScannedToken nextTokenView();
+
     /*
      * Method: saveToken
      * Usage: scanner.saveToken(token);
@@ -240,7 +283,7 @@ public:
      * <code>SEPARATOR</code>, <code>WORD</code>, <code>NUMBER</code>,
      * <code>STRING</code>, or <code>OPERATOR</code>.
      */
-    TokenType getTokenType(std::string token) const;
+    TokenType getTokenType(const std::string& token) const;
 
     /*
      * Method: getChar
@@ -281,8 +324,8 @@ private:
      * Private type: StringCell
      * ------------------------
      * This type is used to construct linked lists of cells, which are used
-     * to represent both the stack of saved tokens and the set of defined
-     * operators.  These types cannot use the Stack and Lexicon classes
+     * to represent the stack of saved tokens.  These types cannot use the
+     * Stack and Lexicon classes
      * directly because tokenscanner.h is an extremely low-level interface,
      * and doing so would create circular dependencies in the .h files.
      */
@@ -291,6 +334,19 @@ private:
         StringCell *link;
     };
 
+    /*
+     * Private type: OperatorNode
+     * --------------------------
+     * A node of the trie of defined operators.  Node 0 is the root; the
+     * children of a node form a linked list through nextSibling.
+     */
+    struct OperatorNode {
+        char ch;
+        bool isOperator;
+        int firstChild;
+        int nextSibling;
+    };
+
     enum NumberScannerState {
         INITIAL_STATE,
         BEFORE_DECIMAL_POINT,
@@ -303,14 +359,21 @@ private:
 
     std::string buffer;              /* The original argument string */
     std::istream *isp;               /* The input stream for tokens  */
-    bool stringInputFlag;            /* Flag indicating string input */
+    bool stringInputFlag;            /* Flag indicating buffer input */
+    const char *bufferStart;         /* Start of the input buffer    */
+    const char *bufferEnd;           /* End of the input buffer      */
+    const char *cursor;              /* Next character to scan       */
+    const char *peekStart;           /* Start of peeked token        */
+    ScannedToken peekedToken;        /* Token read by hasMoreTokens  */
+    std::string tokenText;           /* Copy of the last token       */
     bool ignoreWhitespaceFlag;       /* Scanner ignores whitespace   */
     bool ignoreCommentsFlag;         /* Scanner ignores comments     */
     bool scanNumbersFlag;            /* Scanner parses numbers       */
     bool scanStringsFlag;            /* Scanner parses strings       */
     std::string wordChars;           /* Additional word characters   */
+    bool wordCharTable[256];         /* Legal word characters        */
     StringCell *savedTokens;         /* Stack of saved tokens        */
-    StringCell *operators;           /* List of multichar operators  */
+    std::vector<OperatorNode> operatorTrie;   /* Defined operators  */
 
     /* Private method prototypes */
     void initScanner();
@@ -318,8 +381,13 @@ private:
     std::string scanWord();
     std::string scanNumber();
     std::string scanString();
-    bool isOperator(std::string op);
-    bool isOperatorPrefix(std::string op);
+    bool isOperator(const std::string& op) const;
+    bool isOperatorPrefix(const std::string& op) const;
+    int findOperatorChild(int node, char ch) const;
+    int findOperatorNode(const std::string& op) const;
+    ScannedToken scanBufferToken();
+    TokenType tokenTypeOf(const StringView& token) const;
+    void rewindPeek();
 };
 
 #endif
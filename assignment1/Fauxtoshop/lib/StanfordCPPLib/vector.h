@@ -4,6 +4,12 @@
  * This file exports the <code>Vector</code> class, which provides an
  * efficient, safe, convenient replacement for the array type in C++.
  *
+ * @version 2026/10/18
+ * - added move constructor and assignment, emplace, emplace_back, reserve,
+ *   shrink_to_fit, and add/insert/push_back overloads that move their value
+ * - elements are moved rather than copied when the array grows or shifts,
+ *   which for simple types such as int compiles down to memmove
+ * - fixed add/insert of one of the vector's own elements when it grows
  * @version 2015/10/13
  * - nulled out pointer fields in destructor after deletion to avoid double-free
  * @version 2015/07/05
@@ -25,10 +31,12 @@
 #ifndef _vector_h
 #define _vector_h
 
+#include <algorithm>
 #include <iterator>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 #include "compare.h"
 #include "error.h"
@@ -77,6 +85,7 @@ public:
      * Adds a new value to the end of this vector.
      */
     void add(const ValueType& value);
+    void add(ValueType&& value);
 
     /*
      * Method: addAll
@@ -95,6 +104,28 @@ public:
      * Removes all elements from this vector.
      */
     void clear();
+
+    /*
+     * Method: emplace
+     * Usage: vec.emplace(index, args...);
+     * -----------------------------------
+     * Inserts a value built from the given constructor arguments into
+     * this vector before the specified index, like <code>insert</code>.
+     * The value is constructed once and then moved into place.
+     */
+    template <typename... Args>
+    void emplace(int index, Args&&... args);
+
+    /*
+     * Method: emplace_back
+     * Usage: vec.emplace_back(args...);
+     * ---------------------------------
+     * Adds a value built from the given constructor arguments to the end
+     * of this vector.  The value is constructed once and then moved into
+     * place.
+     */
+    template <typename... Args>
+    void emplace_back(Args&&... args);
     
     /*
      * Method: equals
@@ -126,6 +157,7 @@ public:
      * up to and including the length of the vector.
      */
     void insert(int index, const ValueType& value);
+    void insert(int index, ValueType&& value);
 
     /*
      * Method: isEmpty
@@ -157,6 +189,7 @@ public:
      * with the <code>vector</code> class in the Standard Template Library.
      */
     void push_back(const ValueType& value);
+    void push_back(ValueType&& value);
 
     /*
      * Method: remove
@@ -167,6 +200,16 @@ public:
      * method signals an error if the index is outside the array range.
      */
     void remove(int index);
+
+    /*
+     * Method: reserve
+     * Usage: vec.reserve(n);
+     * ----------------------
+     * Makes room for at least <code>n</code> elements, so that adding
+     * elements up to that size will not reallocate the array.  This does
+     * not change the size of the vector.
+     */
+    void reserve(int n);
     
     /*
      * Method: set
@@ -177,6 +220,14 @@ public:
      * This method signals an error if the index is not in the array range.
      */
     void set(int index, const ValueType& value);
+
+    /*
+     * Method: shrink_to_fit
+     * Usage: vec.shrink_to_fit();
+     * ---------------------------
+     * Frees any space in the array beyond what the current elements need.
+     */
+    void shrink_to_fit();
     
     /*
      * Method: size
@@ -288,6 +339,7 @@ public:
      *
      *   - Stream I/O using the << and >> operators
      *   - Deep copying for the copy constructor and assignment operator
+     *   - Moving, which leaves the source vector empty
      *   - Iteration using the range-based for statement or STL iterators
      *
      * The iteration forms process the Vector in index order.
@@ -307,6 +359,8 @@ private:
      * The elements of the Vector are stored in a dynamic array of
      * the specified element type.  If the space in the array is ever
      * exhausted, the implementation doubles the array capacity.
+     * Elements are moved with std::move and std::move_backward, which
+     * for trivially copyable types become a single memmove.
      */
 
     /* Instance variables */
@@ -327,6 +381,7 @@ private:
     void checkIndex(int index, int min, int max, std::string prefix) const;
 
     void expandCapacity();
+    void reallocate(int newCapacity);
     void deepCopy(const Vector& src);
 
     /*
@@ -349,6 +404,16 @@ public:
     Vector(const Vector& src);
     Vector& operator =(const Vector& src);
 
+    /*
+     * Move support
+     * ------------
+     * The move constructor and move assignment operator take over the
+     * source vector's array instead of copying it, leaving the source
+     * empty, so returning a vector by value never copies its elements.
+     */
+    Vector(Vector&& src) noexcept;
+    Vector& operator =(Vector&& src) noexcept;
+
     /*
      * Operator: ,
      * -----------
@@ -520,9 +585,7 @@ template <typename ValueType>
 Vector<ValueType>::Vector(const std::vector<ValueType>& v) {
     count = capacity = v.size();
     elements = new ValueType[count];
-    for (int i = 0; i < count; i++) {
-        elements[i] = v[i];
-    }
+    std::copy(v.begin(), v.end(), elements);
 }
 
 /*
@@ -536,6 +599,15 @@ Vector<ValueType>::Vector(const Vector& src) {
     deepCopy(src);
 }
 
+template <typename ValueType>
+Vector<ValueType>::Vector(Vector&& src) noexcept
+        : elements(src.elements),
+          capacity(src.capacity),
+          count(src.count) {
+    src.elements = NULL;
+    src.capacity = src.count = 0;
+}
+
 template <typename ValueType>
 Vector<ValueType>::~Vector() {
     if (elements != NULL) {
@@ -555,11 +627,19 @@ void Vector<ValueType>::add(const ValueType& value) {
     insert(count, value);
 }
 
+template <typename ValueType>
+void Vector<ValueType>::add(ValueType&& value) {
+    insert(count, std::move(value));
+}
+
 template <typename ValueType>
 Vector<ValueType>& Vector<ValueType>::addAll(const Vector<ValueType>& v) {
-    for (ValueType value : v) {
-        add(value);
+    int n = v.count;   // v may be this vector
+    if (count + n > capacity) {
+        reserve(std::max(count + n, capacity * 2));
     }
+    std::copy(v.elements, v.elements + n, elements + count);
+    count += n;
     return *this;   // BUGFIX 2014/04/27
 }
 
@@ -572,6 +652,18 @@ void Vector<ValueType>::clear() {
     elements = NULL;
 }
 
+template <typename ValueType>
+template <typename... Args>
+void Vector<ValueType>::emplace(int index, Args&&... args) {
+    insert(index, ValueType(std::forward<Args>(args)...));
+}
+
+template <typename ValueType>
+template <typename... Args>
+void Vector<ValueType>::emplace_back(Args&&... args) {
+    insert(count, ValueType(std::forward<Args>(args)...));
+}
+
 template <typename ValueType>
 bool Vector<ValueType>::equals(const Vector<ValueType>& v) const {
     if (this == &v) {
@@ -589,20 +681,24 @@ bool Vector<ValueType>::equals(const Vector<ValueType>& v) const {
 }
 
 /*
- * Implementation notes: expandCapacity
- * ------------------------------------
- * This function doubles the array capacity, copies the old elements
- * into the new array, and then frees the old one.
+ * Implementation notes: expandCapacity, reallocate
+ * ------------------------------------------------
+ * expandCapacity doubles the array capacity.  reallocate moves the old
+ * elements into a new array of the given capacity and then frees the
+ * old one.
  */
 template <typename ValueType>
 void Vector<ValueType>::expandCapacity() {
-    capacity = std::max(1, capacity * 2);
-    ValueType *array = new ValueType[capacity];
-    for (int i = 0; i < count; i++) {
-        array[i] = elements[i];
-    }
+    reallocate(std::max(1, capacity * 2));
+}
+
+template <typename ValueType>
+void Vector<ValueType>::reallocate(int newCapacity) {
+    ValueType* array = (newCapacity == 0) ? NULL : new ValueType[newCapacity];
+    std::move(elements, elements + count, array);
     if (elements != NULL) delete[] elements;
     elements = array;
+    capacity = newCapacity;
 }
 
 template <typename ValueType>
@@ -621,11 +717,20 @@ const ValueType& Vector<ValueType>::get(int index) const {
 template <typename ValueType>
 void Vector<ValueType>::insert(int index, const ValueType& value) {
     checkIndex(index, 0, count, "insert");
-    if (count == capacity) expandCapacity();
-    for (int i = count; i > index; i--) {
-        elements[i] = elements[i - 1];
+    if (index == count && count < capacity) {
+        elements[count++] = value;
+    } else {
+        // value may be one of our own elements, about to be moved or freed
+        insert(index, ValueType(value));
     }
-    elements[index] = value;
+}
+
+template <typename ValueType>
+void Vector<ValueType>::insert(int index, ValueType&& value) {
+    checkIndex(index, 0, count, "insert");
+    if (count == capacity) expandCapacity();
+    std::move_backward(elements + index, elements + count, elements + count + 1);
+    elements[index] = std::move(value);
     count++;
 }
 
@@ -667,21 +772,41 @@ void Vector<ValueType>::push_back(const ValueType& value) {
     insert(count, value);
 }
 
+template <typename ValueType>
+void Vector<ValueType>::push_back(ValueType&& value) {
+    insert(count, std::move(value));
+}
+
 template <typename ValueType>
 void Vector<ValueType>::remove(int index) {
     checkIndex(index, 0, count-1, "remove");
-    for (int i = index; i < count - 1; i++) {
-        elements[i] = elements[i + 1];
-    }
+    std::move(elements + index + 1, elements + count, elements + index);
     count--;
 }
 
+template <typename ValueType>
+void Vector<ValueType>::reserve(int n) {
+    if (n < 0) {
+        error("Vector::reserve: capacity cannot be negative");
+    }
+    if (n > capacity) {
+        reallocate(n);
+    }
+}
+
 template <typename ValueType>
 void Vector<ValueType>::set(int index, const ValueType& value) {
     checkIndex(index, 0, count-1, "set");
     elements[index] = value;
 }
 
+template <typename ValueType>
+void Vector<ValueType>::shrink_to_fit() {
+    if (capacity > count) {
+        reallocate(count);
+    }
+}
+
 template <typename ValueType>
 int Vector<ValueType>::size() const {
     return count;
@@ -695,19 +820,15 @@ Vector<ValueType> Vector<ValueType>::subList(int start, int length) const {
         error("Vector::subList: length cannot be negative");
     }
     Vector<ValueType> result;
-    for (int i = start; i < start + length; i++) {
-        result.add(get(i));
-    }
+    result.reserve(length);
+    std::copy(elements + start, elements + start + length, result.elements);
+    result.count = length;
     return result;
 }
 
 template <typename ValueType>
 std::vector<ValueType> Vector<ValueType>::toStlVector() const {
-    std::vector<ValueType> v;
-    for (int i = 0; i < count; i++) {
-        v.push_back(elements[i]);
-    }
-    return v;
+    return std::vector<ValueType>(elements, elements + count);
 }
 
 template <typename ValueType>
@@ -736,8 +857,11 @@ const ValueType& Vector<ValueType>::operator [](int index) const {
 
 template <typename ValueType>
 Vector<ValueType> Vector<ValueType>::operator +(const Vector& v2) const {
-    Vector<ValueType> result = *this;
-    return result.addAll(v2);
+    Vector<ValueType> result;
+    result.reserve(count + v2.count);
+    result.addAll(*this);
+    result.addAll(v2);
+    return result;
 }
 
 template <typename ValueType>
@@ -792,6 +916,21 @@ Vector<ValueType> & Vector<ValueType>::operator =(const Vector& src) {
     return *this;
 }
 
+template <typename ValueType>
+Vector<ValueType>& Vector<ValueType>::operator =(Vector&& src) noexcept {
+    if (this != &src) {
+        if (elements != NULL) {
+            delete[] elements;
+        }
+        elements = src.elements;
+        capacity = src.capacity;
+        count = src.count;
+        src.elements = NULL;
+        src.capacity = src.count = 0;
+    }
+    return *this;
+}
+
 template <typename ValueType>
 void Vector<ValueType>::checkIndex(int index, int min, int max, std::string prefix) const {
     if (index < min || index > max) {
@@ -817,9 +956,7 @@ template <typename ValueType>
 void Vector<ValueType>::deepCopy(const Vector& src) {
     count = capacity = src.count;
     elements = (capacity == 0) ? NULL : new ValueType[capacity];
-    for (int i = 0; i < count; i++) {
-        elements[i] = src.elements[i];
-    }
+    std::copy(src.elements, src.elements + count, elements);
 }
 
 /*
@@ -888,7 +1025,7 @@ std::istream& operator >>(std::istream& is, Vector<ValueType>& vec) {
 template <typename ValueType>
 int hashCode(const Vector<ValueType>& v) {
     int code = hashSeed();
-    for (ValueType element : v) {
+    for (const ValueType& element : v) {
         code = hashMultiplier() * code + hashCode(element);
     }
     return (code & hashMask());
@@ -918,9 +1055,7 @@ void shuffle(Vector<T>& v) {
     for (int i = 0, length = v.size(); i < length; i++) {
         int j = randomInteger(i, length - 1);
         if (i != j) {
-            T temp = v[i];
-            v[i] = v[j];
-            v[j] = temp;
+            std::swap(v[i], v[j]);
         }
     }
 }
@@ -0,0 +1,288 @@
+/*
+ * File: batch.cpp
+ * ---------------
+ * Implements the headless batch mode declared in batch.h.
+ * Images are read and written with imagecodec.h and filtered with the
+ * functions in filters.h, so nothing here talks to the Java back-end.
+ */
+
+#include "batch.h"
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include "error.h"
+#include "filelib.h"
+#include "filters.h"
+#include "imagecodec.h"
+#include "random.h"
+#include "strlib.h"
+
+using namespace std;
+
+static const int MAX_COORDINATE = 65535;
+static const int MAX_BLUR_PASSES = 5;
+
+/*
+ * One stage of a filter pipeline, such as "blur:3".
+ */
+struct Stage {
+    string name;
+    vector<string> params;
+    Grid<int> other;   // the sticker or comparison image, loaded once
+};
+
+/*
+ * The outcome of processing one input file.
+ */
+struct Result {
+    bool ok;
+    string message;
+};
+
+static void usage() {
+    cerr << "Usage: Fauxtoshop --headless PIPELINE INPUT_DIR OUTPUT_DIR"
+         << " [--workers N] [--format EXT] [--seed N]" << endl;
+    cerr << "PIPELINE is a comma-separated list of: scatter:DEGREE, edge:THRESHOLD,"
+         << " greenscreen:STICKER:TOLERANCE:ROW:COL, compare:FILE, rotate:ANGLE,"
+         << " blur:RADIUS[:PASSES]" << endl;
+}
+
+static int integerParam(const Stage& stage, int index, int min, int max) {
+    string text = trim(stage.params[index]);
+    if (!stringIsInteger(text)) {
+        error("stage \"" + stage.name + "\": expected an integer but saw \"" + text + "\"");
+    }
+    int value = stringToInteger(text);
+    if (value < min || value > max) {
+        error("stage \"" + stage.name + "\": " + text + " is out of range ["
+              + integerToString(min) + ", " + integerToString(max) + "]");
+    }
+    return value;
+}
+
+static Grid<int> readImageFile(const string& filename) {
+    Grid<int> pixels;
+    if (!imagecodec::readImage(filename, pixels)) {
+        error("unsupported image format: " + filename);
+    }
+    return pixels;
+}
+
+/*
+ * Parses a pipeline spec into stages, checking every setting up front and
+ * loading any sticker/comparison images, so that a typo is reported before
+ * thousands of images are processed.
+ */
+static vector<Stage> parsePipeline(const string& spec) {
+    vector<Stage> stages;
+    vector<string> parts = stringSplit(spec, ",");
+    for (size_t i = 0; i < parts.size(); i++) {
+        vector<string> tokens = stringSplit(trim(parts[i]), ":");
+        if (tokens.empty() || trim(tokens[0]).empty()) {
+            error("empty filter name in pipeline \"" + spec + "\"");
+        }
+        Stage stage;
+        stage.name = toLowerCase(trim(tokens[0]));
+        stage.params.assign(tokens.begin() + 1, tokens.end());
+        size_t expected = 0;
+        if (stage.name == "greenscreen") {
+            expected = 4;
+        } else if (stage.name == "blur") {
+            expected = stage.params.size() == 1 ? 1 : 2;   // PASSES is optional
+        } else if (stage.name == "scatter" || stage.name == "edge" || stage.name == "compare"
+                   || stage.name == "rotate") {
+            expected = 1;
+        } else {
+            error("unknown filter \"" + stage.name + "\"");
+        }
+        if (stage.params.size() != expected) {
+            error("stage \"" + stage.name + "\": expected " + integerToString(expected)
+                  + " setting(s) but saw " + integerToString(stage.params.size()));
+        }
+
+        if (stage.name == "scatter") {
+            integerParam(stage, 0, 1, 100);
+        } else if (stage.name == "edge") {
+            integerParam(stage, 0, 1, 255);
+        } else if (stage.name == "greenscreen") {
+            stage.other = readImageFile(trim(stage.params[0]));
+            integerParam(stage, 1, 1, 100);
+            integerParam(stage, 2, 0, MAX_COORDINATE);
+            integerParam(stage, 3, 0, MAX_COORDINATE);
+        } else if (stage.name == "compare") {
+            stage.other = readImageFile(trim(stage.params[0]));
+        } else if (stage.name == "rotate") {
+            integerParam(stage, 0, 0, 360);
+        } else if (stage.name == "blur") {
+            integerParam(stage, 0, 0, 1000);
+            if (stage.params.size() == 2) {
+                integerParam(stage, 1, 0, MAX_BLUR_PASSES);
+            }
+        }
+        stages.push_back(std::move(stage));
+    }
+    return stages;
+}
+
+/*
+ * Runs the pipeline on one file.  'filterWorkers' is the thread count given
+ * to filters that can parallelize a single image.  Random filters draw from
+ * a generator for stream 'job' of 'seed', so a file's output depends only
+ * on the seed and its place in the list, not on which worker ran it.
+ */
+static Result processFile(const vector<Stage>& stages, const string& inputFile,
+                          const string& outputFile, int seed, int job,
+                          int filterWorkers) {
+    Result result;
+    result.ok = false;
+    RandomGenerator rng(seed, job);
+    try {
+        Grid<int> grid;
+        if (!imagecodec::readImage(inputFile, grid)) {
+            result.message = "skipped (unsupported format)";
+            return result;
+        }
+        string notes;
+        for (size_t i = 0; i < stages.size(); i++) {
+            const Stage& stage = stages[i];
+            if (stage.name == "scatter") {
+                grid = scatter(grid, integerParam(stage, 0, 1, 100), rng, filterWorkers);
+            } else if (stage.name == "edge") {
+                grid = edgeDetect(grid, integerParam(stage, 0, 1, 255));
+            } else if (stage.name == "greenscreen") {
+                grid = greenScreen(grid, stage.other, integerParam(stage, 1, 1, 100),
+                                   integerParam(stage, 2, 0, MAX_COORDINATE),
+                                   integerParam(stage, 3, 0, MAX_COORDINATE));
+            } else if (stage.name == "compare") {
+                notes += " differs from " + trim(stage.params[0]) + " by "
+                        + integerToString(countDiffPixels(grid, stage.other)) + " pixels;";
+            } else if (stage.name == "rotate") {
+                grid = rotate(grid, integerParam(stage, 0, 0, 360));
+            } else if (stage.name == "blur") {
+                int radius = integerParam(stage, 0, 0, 1000);
+                int passes = stage.params.size() == 2
+                        ? integerParam(stage, 1, 0, MAX_BLUR_PASSES) : 0;
+                if (passes == 0) {
+                    grid = gaussianBlur(grid, radius, filterWorkers);
+                } else {
+                    grid = fastGaussianBlur(grid, radius, passes, filterWorkers);
+                }
+            }
+        }
+        if (!imagecodec::writeImage(outputFile, grid)) {
+            result.message = "cannot write format of " + outputFile;
+            return result;
+        }
+        result.ok = true;
+        result.message = "-> " + outputFile + notes;
+    } catch (const ErrorException& ex) {
+        result.message = ex.getMessage();
+    }
+    return result;
+}
+
+int runBatch(const vector<string>& args) {
+    vector<string> positional;
+    int workers = (int) thread::hardware_concurrency();
+    string format;
+    for (size_t i = 0; i < args.size(); i++) {
+        if (args[i] == "--headless") {
+            continue;
+        } else if ((args[i] == "--workers" || args[i] == "--format" || args[i] == "--seed")
+                   && i + 1 < args.size()) {
+            if (args[i] == "--workers") {
+                if (!stringIsInteger(args[i + 1]) || stringToInteger(args[i + 1]) < 1) {
+                    cerr << "--workers must be a positive integer" << endl;
+                    return 2;
+                }
+                workers = stringToInteger(args[i + 1]);
+            } else if (args[i] == "--seed") {
+                if (!stringIsInteger(args[i + 1])) {
+                    cerr << "--seed must be an integer" << endl;
+                    return 2;
+                }
+                setRandomSeed(stringToInteger(args[i + 1]));
+            } else {
+                format = args[i + 1];
+                if (!startsWith(format, ".")) {
+                    format = "." + format;
+                }
+            }
+            i++;
+        } else {
+            positional.push_back(args[i]);
+        }
+    }
+    if (positional.size() != 3) {
+        usage();
+        return 2;
+    }
+    string inputDir = positional[1];
+    string outputDir = positional[2];
+    if (!isDirectory(inputDir)) {
+        cerr << "Input directory not found: " << inputDir << endl;
+        return 2;
+    }
+    if (!format.empty() && imagecodec::formatFromFilename("x" + format) == imagecodec::FORMAT_UNKNOWN) {
+        cerr << "Unsupported output format: " << format << endl;
+        return 2;
+    }
+
+    vector<Stage> stages;
+    try {
+        stages = parsePipeline(positional[0]);
+        createDirectoryPath(outputDir);
+    } catch (const ErrorException& ex) {
+        cerr << ex.getMessage() << endl;
+        return 2;
+    }
+
+    string separator = getDirectoryPathSeparator();
+    vector<string> names;
+    listDirectory(inputDir, names);
+    vector<string> inputs, outputs;
+    for (size_t i = 0; i < names.size(); i++) {
+        string path = inputDir + separator + names[i];
+        if (imagecodec::formatFromFilename(path) == imagecodec::FORMAT_UNKNOWN || !isFile(path)) {
+            continue;
+        }
+        string name = format.empty() ? names[i] : getRoot(names[i]) + format;
+        inputs.push_back(path);
+        outputs.push_back(outputDir + separator + name);
+    }
+
+    // choose the random seed before the workers start; each file's own
+    // generator is derived from it and the file's index
+    int seed = getRandomSeed();
+
+    // each worker claims the next unprocessed file until none are left
+    vector<Result> results(inputs.size());
+    atomic<size_t> next(0);
+    workers = max(1, min(workers, (int) inputs.size()));
+    // with several images in flight, filters stay single-threaded per image
+    int filterWorkers = workers > 1 ? 1 : 0;
+    vector<thread> pool;
+    for (int w = 0; w < workers; w++) {
+        pool.push_back(thread([&]() {
+            for (size_t i = next++; i < inputs.size(); i = next++) {
+                results[i] = processFile(stages, inputs[i], outputs[i], seed, (int) i,
+                                         filterWorkers);
+            }
+        }));
+    }
+    for (size_t w = 0; w < pool.size(); w++) {
+        pool[w].join();
+    }
+
+    int failures = 0;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        (results[i].ok ? cout : cerr) << inputs[i] << ": " << results[i].message << endl;
+        if (!results[i].ok) {
+            failures++;
+        }
+    }
+    cout << (inputs.size() - failures) << " of " << inputs.size()
+         << " image(s) processed" << endl;
+    return failures == 0 ? 0 : 1;
+}
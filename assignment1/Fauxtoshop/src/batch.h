@@ -0,0 +1,42 @@
+/*
+ * File: batch.h
+ * -------------
+ * Headless batch mode for Fauxtoshop: runs a pipeline of filters over every
+ * image in a directory without opening any windows or starting the Java
+ * back-end.  Usage:
+ *
+ *     Fauxtoshop --headless PIPELINE INPUT_DIR OUTPUT_DIR [--workers N] [--format EXT]
+ *                [--seed N]
+ *
+ * PIPELINE is a comma-separated list of stages, each a filter name followed
+ * by its colon-separated settings:
+ *
+ *     scatter:DEGREE
+ *     edge:THRESHOLD
+ *     greenscreen:STICKER_FILE:TOLERANCE:ROW:COL
+ *     compare:OTHER_FILE       (prints the number of differing pixels)
+ *     rotate:ANGLE
+ *     blur:RADIUS[:PASSES]     (PASSES 1-5 uses fastGaussianBlur, 0 the exact blur)
+ *
+ * for example "blur:3,edge:40".  Each image in INPUT_DIR that can be decoded
+ * is written to OUTPUT_DIR under the same name, or with extension EXT if
+ * --format is given.  Images are processed by N worker threads at once
+ * (default: the number of processors).  Random filters such as scatter
+ * give the same output for the same --seed whatever the number of workers;
+ * without one, the seed is chosen from the clock.
+ */
+
+#ifndef _batch_h
+#define _batch_h
+
+#include <string>
+#include <vector>
+
+/*
+ * Runs batch mode with the given command-line arguments and returns the
+ * program's exit status: 0 if every image was processed, 1 if any failed,
+ * or 2 if the arguments were invalid.
+ */
+int runBatch(const std::vector<std::string>& args);
+
+#endif
@@ -0,0 +1,549 @@
+/*
+ * File: filters.cpp
+ * -----------------
+ * Implements the image filters declared in filters.h.
+ */
+
+#include "filters.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <vector>
+#include "error.h"
+#include "gbufferedimage.h"
+#include "gmath.h"
+#include "math.h"
+#include "parallel.h"
+#include "planar.h"
+#include "random.h"
+
+using namespace std;
+
+static const int    WHITE = 0xFFFFFF;
+static const int    BLACK = 0x000000;
+static const int    GREEN = 0x00FF00;
+
+/*
+ * Each pixel's offset is drawn uniformly from the part of the square of
+ * offsets that stays inside the image, one axis at a time, which gives the
+ * same distribution as drawing from the whole square until the result is
+ * in bounds but never has to retry.  The rows are processed in bands of
+ * fixed height, one parallelFor task each, and every band draws from its
+ * own RandomGenerator stream, keyed by a number taken from the shared
+ * generator (or the caller's) and the band's index, so the result depends
+ * only on the random seed and never on the number of threads.
+ */
+static const int SCATTER_BAND_ROWS = 16;
+
+static Grid<int> scatterWithKey(const Grid<int>& img_grid, int degree,
+                                unsigned long long key, int workers) {
+
+    int rows = img_grid.numRows();
+    int cols = img_grid.numCols();
+    if (img_grid.isEmpty()) {
+        return img_grid;
+    }
+
+    Grid<int> duplicate(rows, cols);
+    const int* src = &*img_grid.begin();   // Grid stores its elements row-major
+    int* dest = &*duplicate.begin();
+    int bands = (rows + SCATTER_BAND_ROWS - 1) / SCATTER_BAND_ROWS;
+    parallelFor(bands, [&](int band) {
+        RandomGenerator rng(key, band);
+        int rowEnd = min(rows, (band + 1) * SCATTER_BAND_ROWS);
+        for (int r = band * SCATTER_BAND_ROWS; r < rowEnd; r++) {
+            int lowR = max(-degree, -r);
+            int highR = min(degree, rows - 1 - r);
+            for (int c = 0; c < cols; c++) {
+                int ran_r = rng.nextInteger(lowR, highR);
+                int ran_c = rng.nextInteger(max(-degree, -c), min(degree, cols - 1 - c));
+                dest[r * cols + c] = src[(r + ran_r) * cols + (c + ran_c)];
+            }
+        }
+    }, workers);
+
+    return duplicate;
+}
+
+Grid<int> scatter(const Grid<int>& img_grid, int degree, int workers) {
+    unsigned long long key = (unsigned int) randomInteger(INT_MIN, INT_MAX);
+    key = (key << 32) | (unsigned int) randomInteger(INT_MIN, INT_MAX);
+    return scatterWithKey(img_grid, degree, key, workers);
+}
+
+Grid<int> scatter(const Grid<int>& img_grid, int degree, RandomGenerator& rng, int workers) {
+    return scatterWithKey(img_grid, degree, rng.next(), workers);
+}
+
+bool isEdge(const Grid<int>& img_grid, int threshold, int r, int c) {
+
+    int r1, g1, b1, r2, g2, b2;
+
+    GBufferedImage::getRedGreenBlue(img_grid[r][c], r1, g1, b1);
+    for(int i=-1; i<=1; i++){
+        for (int j=-1; j<=1; j++){
+            if(img_grid.inBounds(r+i, c+j)){
+                GBufferedImage::getRedGreenBlue(img_grid[r+i][c+j], r2, g2, b2);
+                if(max(abs(r1-r2), max(abs(g1-g2), abs(b1-b2))) > threshold){
+                    return true;
+                }
+            }
+
+        }
+    }
+    return false;
+}
+
+Grid<int> edgeDetect(const Grid<int>& img_grid, int threshold) {
+    if (img_grid.isEmpty()) {
+        return img_grid;
+    }
+    int rows = img_grid.numRows();
+    int cols = img_grid.numCols();
+    Grid<int> duplicate(rows, cols);
+    int* dest = &*duplicate.begin();
+    if (threshold < 0) {
+        // even a pixel's zero difference from itself exceeds the threshold
+        fill(dest, dest + rows * cols, BLACK);
+        return duplicate;
+    }
+    threshold = min(threshold, 255);
+
+    // diff[c] collects the largest channel difference between pixel (r, c)
+    // and any of its neighbors, one neighbor direction at a time
+    PlanarImage planes = toPlanar(img_grid);
+    const unsigned char* channels[] = { &planes.red[0], &planes.green[0], &planes.blue[0] };
+    vector<unsigned char> diff(cols), mask(cols);
+    for (int r = 0; r < rows; r++) {
+        fill(diff.begin(), diff.end(), 0);
+        for (int i = -1; i <= 1; i++) {
+            if (r + i < 0 || r + i >= rows) continue;
+            for (int j = -1; j <= 1; j++) {
+                if ((i == 0 && j == 0) || cols - abs(j) <= 0) continue;
+                int first = max(0, -j);    // first column whose neighbor is in bounds
+                for (int ch = 0; ch < 3; ch++) {
+                    const unsigned char* center = channels[ch] + r * cols + first;
+                    kernels::maxAbsDiff(center, center + i * cols + j, &diff[first],
+                                        cols - abs(j));
+                }
+            }
+        }
+        kernels::thresholdMask(&diff[0], threshold, &mask[0], cols);
+        int* out = dest + r * cols;
+        for (int c = 0; c < cols; c++) {
+            out[c] = mask[c] ? BLACK : WHITE;
+        }
+    }
+
+    return duplicate;
+}
+
+bool isGreen(const Grid<int>& stk_grid, int row, int col, int tol) {
+
+    int r1, g1, b1, r2, g2, b2;
+    GBufferedImage::getRedGreenBlue(GREEN, r1, g1, b1);
+
+    GBufferedImage::getRedGreenBlue(stk_grid[row][col], r2, g2, b2);
+
+    if (max(abs(r1-r2), max(abs(g1-g2), abs(b1-b2))) < tol) {
+        return  true;
+    }
+    else {
+        return false;
+    }
+}
+
+Grid<int> greenScreen(const Grid<int>& img_grid, GridView<const int> stk_grid,
+                      int tol, int row, int col) {
+    Grid<int> duplicate = img_grid;
+
+    // only the part of the sticker that lands on the image matters
+    int rowStart = max(0, -row);
+    int rowEnd = min(stk_grid.numRows(), img_grid.numRows() - row);
+    int colStart = max(0, -col);
+    int colEnd = min(stk_grid.numCols(), img_grid.numCols() - col);
+    if (rowStart >= rowEnd || colStart >= colEnd || tol > 255) {
+        return duplicate;   // nothing overlaps, or every pixel counts as green
+    }
+    int height = rowEnd - rowStart;
+    int width = colEnd - colStart;
+    GridView<const int> visible = stk_grid.subView(rowStart, colStart, height, width);
+    GridView<int> target = GridView<int>(duplicate).subView(row + rowStart, col + colStart,
+                                                           height, width);
+
+    // a pixel is green when max(red, 255 - green, blue) < tol, so the mask
+    // of pixels to paste is that maximum compared against tol - 1
+    PlanarImage sticker = toPlanar(visible);
+    vector<unsigned char> zeros(width, 0), full(width, 255), dist(width), paste(width);
+    for (int r = 0; r < height; r++) {
+        int offset = r * width;
+        if (tol <= 0) {
+            fill(paste.begin(), paste.end(), 255);
+        } else {
+            fill(dist.begin(), dist.end(), 0);
+            kernels::maxAbsDiff(&sticker.red[offset], &zeros[0], &dist[0], width);
+            kernels::maxAbsDiff(&sticker.green[offset], &full[0], &dist[0], width);
+            kernels::maxAbsDiff(&sticker.blue[offset], &zeros[0], &dist[0], width);
+            kernels::thresholdMask(&dist[0], tol - 1, &paste[0], width);
+        }
+        int* out = target.rowPointer(r);
+        for (int c = 0; c < width; c++) {
+            if (paste[c]) {
+                out[c] = visible(r, c);
+            }
+        }
+    }
+    return duplicate;
+}
+
+int countDiffPixels(GridView<const int> grid1, GridView<const int> grid2) {
+    int w1 = grid1.width();
+    int h1 = grid1.height();
+    int w2 = grid2.width();
+    int h2 = grid2.height();
+
+    int wmin = min(w1, w2);
+    int hmin = min(h1, h2);
+
+    int overlap = wmin * hmin;
+    int diffPxCount = (w1 * h1 - overlap) + (w2 * h2 - overlap);
+    if (overlap == 0) {
+        return diffPxCount;
+    }
+
+    // the packed pixels are compared in place, a row at a time, without
+    // unpacking channels
+    bool contiguous = grid1.hasContiguousRows() && grid2.hasContiguousRows();
+    for (int y = 0; y < hmin; y++) {
+        if (contiguous) {
+            diffPxCount += kernels::countDifferent(grid1.rowPointer(y), grid2.rowPointer(y),
+                                                   wmin);
+        } else {
+            for (int x = 0; x < wmin; x++) {
+                diffPxCount += grid1(y, x) != grid2(y, x);
+            }
+        }
+    }
+    return diffPxCount;
+}
+
+Grid<int> rotate(const Grid<int>& img_grid, int angle) {
+
+    Grid<int> duplicate = img_grid;
+
+    int rows = img_grid.numRows();
+    int cols = img_grid.numCols();
+
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+
+            int row_r = -(c * sinDegrees(angle)) + (r + cosDegrees(angle)) + rows/2;
+            int col_r = (c * cosDegrees(angle) + (r * sinDegrees(angle)));
+
+            if(img_grid.inBounds(row_r, col_r)) {
+                duplicate[r][c] = img_grid[row_r][col_r];
+            } else {
+                duplicate[r][c] = WHITE;
+            }
+
+
+        }
+    }
+
+    return duplicate;
+}
+
+/*
+ * The blur works on three planes of channel values instead of packed pixels.
+ * Rows are processed in bands for the horizontal pass and columns in strips
+ * for the vertical pass, each band or strip being one parallelFor task.
+ * Every output value is still the sum kernel[0]*x[0] + kernel[1]*x[1] + ...
+ * accumulated in the same order in a double and truncated to an int, so the
+ * result is bit-identical to the straightforward one-pixel-at-a-time loops;
+ * the kernels in planar.h just compute that sum for many pixels at once.
+ */
+static const int BLUR_BAND_ROWS = 16;
+static const int BLUR_STRIP_COLS = 256;
+
+Grid<int> gaussianBlur(GridView<const int> img_grid, int radius, int workers) {
+    if (radius < 1 || img_grid.isEmpty()) {
+        return img_grid.toGrid();
+    }
+
+    Vector<double> kernelVector = gaussKernelForRadius(radius);
+    vector<double> kernel(kernelVector.begin(), kernelVector.end());
+    int taps = kernel.size();
+
+    int rows = img_grid.height();
+    int cols = img_grid.width();
+
+    // horizontal pass: img_grid -> planes, one band of rows per task
+    PlanarImage planes(cols, rows);
+    unsigned char* channels[] = { &planes.red[0], &planes.green[0], &planes.blue[0] };
+    int bands = (rows + BLUR_BAND_ROWS - 1) / BLUR_BAND_ROWS;
+    parallelFor(bands, [&](int band) {
+        // each row is unpacked with 'radius' copies of its edge pixels on both
+        // sides, which replaces the clamping tests in the inner loop
+        vector<double> padded[3];
+        vector<const double*> shifted[3];
+        for (int ch = 0; ch < 3; ch++) {
+            padded[ch].resize(cols + 2 * radius);
+            for (int k = 0; k < taps; k++) {
+                shifted[ch].push_back(&padded[ch][k]);
+            }
+        }
+        int rowEnd = min(rows, (band + 1) * BLUR_BAND_ROWS);
+        for (int j = band * BLUR_BAND_ROWS; j < rowEnd; j++) {
+            for (int i = -radius; i < cols + radius; i++) {
+                int rgb = img_grid(j, i < 0 ? 0 : (i >= cols ? cols - 1 : i));
+                padded[0][i + radius] = (rgb >> 16) & 0xff;
+                padded[1][i + radius] = (rgb >> 8) & 0xff;
+                padded[2][i + radius] = rgb & 0xff;
+            }
+            for (int ch = 0; ch < 3; ch++) {
+                kernels::convolve(&shifted[ch][0], &kernel[0], taps,
+                                  channels[ch] + j * cols, cols);
+            }
+        }
+    }, workers);
+
+    // vertical pass: planes -> result, one strip of columns per task
+    Grid<int> result(rows, cols);
+    int* dest = &*result.begin();
+    int strips = (cols + BLUR_STRIP_COLS - 1) / BLUR_STRIP_COLS;
+    parallelFor(strips, [&](int strip) {
+        int colStart = strip * BLUR_STRIP_COLS;
+        int width = min(cols, colStart + BLUR_STRIP_COLS) - colStart;
+        // the last 'taps' source rows of the strip, converted to doubles once
+        // each; source row u (which may lie past an edge) lives in slot
+        // (u + radius) % taps
+        vector<double> window[3];
+        vector<const double*> taprows(taps);
+        vector<unsigned char> blurred[3];
+        for (int ch = 0; ch < 3; ch++) {
+            window[ch].resize(taps * width);
+            blurred[ch].resize(width);
+        }
+        auto loadRow = [&](int u) {
+            int y = u < 0 ? 0 : (u >= rows ? rows - 1 : u);
+            int slot = (u + radius) % taps;
+            for (int ch = 0; ch < 3; ch++) {
+                kernels::widen(channels[ch] + y * cols + colStart,
+                               &window[ch][slot * width], width);
+            }
+        };
+        for (int u = -radius; u < radius; u++) {
+            loadRow(u);
+        }
+        for (int j = 0; j < rows; j++) {
+            loadRow(j + radius);
+            for (int ch = 0; ch < 3; ch++) {
+                for (int k = 0; k < taps; k++) {
+                    taprows[k] = &window[ch][((j + k) % taps) * width];
+                }
+                kernels::convolve(&taprows[0], &kernel[0], taps, &blurred[ch][0], width);
+            }
+            int* out = dest + j * cols + colStart;
+            for (int i = 0; i < width; i++) {
+                out[i] = (blurred[0][i] << 16) | (blurred[1][i] << 8) | blurred[2][i];
+            }
+        }
+    }, workers);
+
+    return result;
+}
+
+/*
+ * The fast blur replaces the Gaussian kernel with a cascade of box filters,
+ * each of which averages 2h+1 neighbors.  A box filter is computed with a
+ * running sum that adds the value entering the window and subtracts the one
+ * leaving it, so it costs two additions per value whatever its width, and
+ * the cascade costs the same per pixel for every radius.  The half-widths
+ * are chosen so that the variance of the cascade, which is the sum of the
+ * box variances h(h+1)/3, is as close as possible to the variance of
+ * gaussKernelForRadius(radius).  As in gaussianBlur, the horizontal pass is
+ * truncated to bytes in planes before the vertical pass.  The vertical pass
+ * runs the same running sums down whole rows of a narrow strip at once.
+ *
+ * gaussKernelForRadius cuts the Gaussian off one standard deviation from
+ * its center, so its shape lies between a box and a bell.  On a 1920x1080
+ * test image one pass stays within 1.5 of the exact blur on average (and
+ * 15 at most) for every radius from 4 to 64; three passes stay within 1.0
+ * on average for radii 2 to 16 and 4.0 at radius 64 (and 30 at most),
+ * giving a smoother bell that is closer to a true Gaussian of the same
+ * variance.  tests/fastblurtest.cpp checks these bounds.
+ */
+static const int BOX_STRIP_COLS = 64;
+
+static vector<int> boxHalfWidths(int radius, int passes) {
+    Vector<double> kernel = gaussKernelForRadius(radius);
+    double variance = 0.0;
+    for (int i = 0; i < kernel.size(); i++) {
+        variance += kernel[i] * (i - radius) * (i - radius);
+    }
+    int low = 0;
+    while ((low + 1) * (low + 2) / 3.0 <= variance / passes) {
+        low++;
+    }
+    double lowVariance = low * (low + 1) / 3.0;
+    double highVariance = (low + 1) * (low + 2) / 3.0;
+    int lowCount = (int) floor((passes * highVariance - variance)
+                               / (highVariance - lowVariance) + 0.5);
+    lowCount = max(0, min(passes, lowCount));
+    vector<int> halves(lowCount, low);
+    halves.resize(passes, low + 1);
+    return halves;
+}
+
+static inline int clampIndex(int i, int n) {
+    return i < 0 ? 0 : (i >= n ? n - 1 : i);
+}
+
+/*
+ * Box-filters n lines of 'width' values each, stored one after another,
+ * across the lines: out line j is the average of in lines j-half..j+half,
+ * with lines past either end replaced by the nearest one.
+ */
+static void boxFilter(const double* in, double* out, int n, int width, int half,
+                      vector<double>& sum) {
+    double scale = 1.0 / (2 * half + 1);
+    sum.assign(width, 0.0);
+    for (int u = -half; u <= half; u++) {
+        const double* x = in + clampIndex(u, n) * width;
+        for (int i = 0; i < width; i++) {
+            sum[i] += x[i];
+        }
+    }
+    for (int j = 0; j < n; j++) {
+        if (j > 0) {
+            const double* entering = in + clampIndex(j + half, n) * width;
+            const double* leaving = in + clampIndex(j - half - 1, n) * width;
+            for (int i = 0; i < width; i++) {
+                sum[i] += entering[i] - leaving[i];
+            }
+        }
+        double* y = out + j * width;
+        for (int i = 0; i < width; i++) {
+            y[i] = sum[i] * scale;
+        }
+    }
+}
+
+/*
+ * Runs the box filters with the given half-widths over 'line', using
+ * 'scratch' (of the same size) for the intermediate results, and returns
+ * whichever of the two holds the final result.
+ */
+static double* boxCascade(double* line, double* scratch, int n, int width,
+                          const vector<int>& halves, vector<double>& sum) {
+    for (size_t k = 0; k < halves.size(); k++) {
+        if (halves[k] > 0) {
+            boxFilter(line, scratch, n, width, halves[k], sum);
+            swap(line, scratch);
+        }
+    }
+    return line;
+}
+
+Grid<int> fastGaussianBlur(GridView<const int> img_grid, int radius, int passes, int workers) {
+    if (passes < 1) {
+        error("fastGaussianBlur: passes must be at least 1");
+    }
+    if (radius < 1 || img_grid.isEmpty()) {
+        return img_grid.toGrid();
+    }
+    vector<int> halves = boxHalfWidths(radius, passes);
+
+    int rows = img_grid.height();
+    int cols = img_grid.width();
+
+    // horizontal pass: img_grid -> planes, one band of rows per task
+    PlanarImage planes(cols, rows);
+    unsigned char* channels[] = { &planes.red[0], &planes.green[0], &planes.blue[0] };
+    int bands = (rows + BLUR_BAND_ROWS - 1) / BLUR_BAND_ROWS;
+    parallelFor(bands, [&](int band) {
+        vector<double> line(cols), scratch(cols), sum;
+        int rowEnd = min(rows, (band + 1) * BLUR_BAND_ROWS);
+        for (int j = band * BLUR_BAND_ROWS; j < rowEnd; j++) {
+            for (int ch = 0; ch < 3; ch++) {
+                int shift = 16 - 8 * ch;
+                for (int i = 0; i < cols; i++) {
+                    line[i] = (img_grid(j, i) >> shift) & 0xff;
+                }
+                double* blurred = boxCascade(&line[0], &scratch[0], cols, 1, halves, sum);
+                unsigned char* out = channels[ch] + j * cols;
+                for (int i = 0; i < cols; i++) {
+                    out[i] = (int) blurred[i];
+                }
+            }
+        }
+    }, workers);
+
+    // vertical pass: planes -> result, one strip of columns per task
+    Grid<int> result(rows, cols);
+    int* dest = &*result.begin();
+    int strips = (cols + BOX_STRIP_COLS - 1) / BOX_STRIP_COLS;
+    parallelFor(strips, [&](int strip) {
+        int colStart = strip * BOX_STRIP_COLS;
+        int width = min(cols, colStart + BOX_STRIP_COLS) - colStart;
+        vector<double> lines(rows * width), scratch(rows * width), sum;
+        for (int j = 0; j < rows; j++) {
+            for (int i = 0; i < width; i++) {
+                dest[j * cols + colStart + i] = 0;
+            }
+        }
+        for (int ch = 0; ch < 3; ch++) {
+            for (int j = 0; j < rows; j++) {
+                kernels::widen(channels[ch] + j * cols + colStart, &lines[j * width], width);
+            }
+            double* blurred = boxCascade(&lines[0], &scratch[0], rows, width, halves, sum);
+            int shift = 16 - 8 * ch;
+            for (int j = 0; j < rows; j++) {
+                int* out = dest + j * cols + colStart;
+                for (int i = 0; i < width; i++) {
+                    out[i] |= (int) blurred[j * width + i] << shift;
+                }
+            }
+        }
+    }, workers);
+
+    return result;
+}
+
+/*
+ * This is a helper function for the Gaussian blur option.
+ *
+ * The function takes a radius and computes a 1-dimensional Gaussian blur kernel
+ * with that radius. The 1-dimensional kernel can be applied to a
+ * 2-dimensional image in two separate passes: first pass goes over
+ * each row and does the horizontal convolutions, second pass goes
+ * over each column and does the vertical convolutions. This is more
+ * efficient than creating a 2-dimensional kernel and applying it in
+ * one convolution pass.
+ *
+ * This code is based on the C# code posted by Stack Overflow user
+ * "Cecil has a name" at this link:
+ * http://stackoverflow.com/questions/1696113/how-do-i-gaussian-blur-an-image-without-using-any-in-built-gaussian-functions
+ *
+ */
+Vector<double> gaussKernelForRadius(int radius) {
+    if (radius < 1) {
+        Vector<double> empty;
+        return empty;
+    }
+    Vector<double> kernel(radius * 2 + 1);
+    double magic1 = 1.0 / (2.0 * radius * radius);
+    double magic2 = 1.0 / (sqrt(2.0 * PI) * radius);
+    int r = -radius;
+    double div = 0.0;
+    for (int i = 0; i < kernel.size(); i++) {
+        double x = r * r;
+        kernel[i] = magic2 * exp(-x * magic1);
+        r++;
+        div += kernel[i];
+    }
+    for (int i = 0; i < kernel.size(); i++) {
+        kernel[i] /= div;
+    }
+    return kernel;
+}
@@ -0,0 +1,95 @@
+/*
+ * File: filters.h
+ * ---------------
+ * The Fauxtoshop image filters, as functions from one grid of RGB pixels
+ * to another.  They take all of their settings as parameters and never
+ * prompt the user or touch a GBufferedImage, so they can be run both from
+ * the interactive program and from the headless batch mode in batch.h.
+ * The functions that take a GridView<const int> accept a whole grid as
+ * well as any view of one, such as a sub-rectangle or a transposed view.
+ */
+
+#ifndef _filters_h
+#define _filters_h
+
+#include "grid.h"
+#include "gridview.h"
+#include "random.h"
+#include "vector.h"
+
+/*
+ * Moves each pixel to a random spot up to 'degree' pixels away.
+ * The work is split across up to 'workers' threads (0 means one per
+ * processor); for a given random seed the result does not depend on the
+ * number of threads.
+ */
+Grid<int> scatter(const Grid<int>& img_grid, int degree, int workers = 0);
+
+/*
+ * Like scatter above, but draws its randomness from 'rng' rather than the
+ * shared generator, so that a caller that gives each job its own generator
+ * gets the same result for a job however the jobs are scheduled.
+ */
+Grid<int> scatter(const Grid<int>& img_grid, int degree, RandomGenerator& rng,
+                  int workers = 0);
+
+/*
+ * Returns true if any neighbor of pixel (r, c) differs from it by more than
+ * 'threshold' in some color channel.
+ */
+bool isEdge(const Grid<int>& img_grid, int threshold, int r, int c);
+
+/*
+ * Turns edge pixels black and all other pixels white.
+ */
+Grid<int> edgeDetect(const Grid<int>& img_grid, int threshold);
+
+/*
+ * Returns true if the given pixel is within 'tol' of pure green.
+ */
+bool isGreen(const Grid<int>& stk_grid, int row, int col, int tol);
+
+/*
+ * Pastes the non-green pixels of the sticker onto the image with the
+ * sticker's upper-left corner at (row, col).
+ */
+Grid<int> greenScreen(const Grid<int>& img_grid, GridView<const int> stk_grid,
+                      int tol, int row, int col);
+
+/*
+ * Returns the number of pixels that differ between the two images,
+ * counting every pixel outside their overlap as different.
+ */
+int countDiffPixels(GridView<const int> grid1, GridView<const int> grid2);
+
+/*
+ * Rotates the image by the given number of degrees, filling uncovered
+ * pixels with white.
+ */
+Grid<int> rotate(const Grid<int>& img_grid, int angle);
+
+/*
+ * Blurs the image with a Gaussian kernel of the given radius, clamping at
+ * the image borders.  A radius below 1 leaves the image unchanged.
+ * The work is split across up to 'workers' threads (0 means one per
+ * processor); the result does not depend on the number of threads.
+ */
+Grid<int> gaussianBlur(GridView<const int> img_grid, int radius, int workers = 0);
+
+/*
+ * Approximates gaussianBlur with 'passes' box filters in a row, each run
+ * with a running sum, so the time taken does not grow with the radius.
+ * More passes cost more time; see the notes in filters.cpp for how closely
+ * each number of passes follows the exact blur.  Raises an error if
+ * 'passes' is less than 1.
+ */
+Grid<int> fastGaussianBlur(GridView<const int> img_grid, int radius, int passes = 3,
+                           int workers = 0);
+
+/*
+ * Returns the normalized 1-dimensional Gaussian kernel for the given radius,
+ * or an empty vector if the radius is less than 1.
+ */
+Vector<double> gaussKernelForRadius(int radius);
+
+#endif
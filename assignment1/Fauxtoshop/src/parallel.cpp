@@ -0,0 +1,131 @@
+/*
+ * File: parallel.cpp
+ * ------------------
+ * Implements the work-stealing loop declared in parallel.h.
+ *
+ * Each worker owns a range [next, end) of indexes guarded by its own mutex.
+ * A worker takes indexes from the front of its range; a thief takes the back
+ * half of a victim's range and makes it its own.  Tiles are coarse (whole row
+ * bands or column strips) so the locking cost is negligible.
+ */
+
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+struct WorkRange {
+    mutex lock;
+    int next;
+    int end;
+};
+
+int defaultWorkerCount() {
+    int n = (int) thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+/*
+ * Takes the next index from the worker's own range, or returns -1 if empty.
+ */
+static int takeOwn(WorkRange& range) {
+    lock_guard<mutex> guard(range.lock);
+    return range.next < range.end ? range.next++ : -1;
+}
+
+/*
+ * Moves the back half of the fullest other range into 'mine' and returns
+ * true, or returns false if every range is empty.
+ */
+static bool steal(vector<WorkRange>& ranges, int self) {
+    while (true) {
+        int victim = -1, most = 0;
+        for (int i = 0; i < (int) ranges.size(); i++) {
+            if (i == self) continue;
+            lock_guard<mutex> guard(ranges[i].lock);
+            int left = ranges[i].end - ranges[i].next;
+            if (left > most) {
+                most = left;
+                victim = i;
+            }
+        }
+        if (victim < 0) {
+            return false;
+        }
+        int from, to;
+        {
+            lock_guard<mutex> guard(ranges[victim].lock);
+            int left = ranges[victim].end - ranges[victim].next;
+            if (left <= 0) continue;   // someone else got there first
+            int half = (left + 1) / 2;
+            to = ranges[victim].end;
+            from = to - half;
+            ranges[victim].end = from;
+        }
+        lock_guard<mutex> guard(ranges[self].lock);
+        ranges[self].next = from;
+        ranges[self].end = to;
+        return true;
+    }
+}
+
+void parallelFor(int count, const function<void(int)>& body, int workers) {
+    if (count <= 0) {
+        return;
+    }
+    if (workers <= 0) {
+        workers = defaultWorkerCount();
+    }
+    workers = min(workers, count);
+    if (workers == 1) {
+        for (int i = 0; i < count; i++) {
+            body(i);
+        }
+        return;
+    }
+
+    vector<WorkRange> ranges(workers);
+    for (int w = 0; w < workers; w++) {
+        ranges[w].next = (int) ((long long) count * w / workers);
+        ranges[w].end = (int) ((long long) count * (w + 1) / workers);
+    }
+    atomic<bool> failed(false);
+    exception_ptr firstError;
+    mutex errorLock;
+
+    auto work = [&](int self) {
+        try {
+            while (!failed) {
+                int i = takeOwn(ranges[self]);
+                if (i < 0) {
+                    if (!steal(ranges, self)) break;
+                    continue;
+                }
+                body(i);
+            }
+        } catch (...) {
+            lock_guard<mutex> guard(errorLock);
+            if (!failed) {
+                firstError = current_exception();
+                failed = true;
+            }
+        }
+    };
+
+    vector<thread> threads;
+    for (int w = 1; w < workers; w++) {
+        threads.push_back(thread(work, w));
+    }
+    work(0);
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+    if (firstError) {
+        rethrow_exception(firstError);
+    }
+}
@@ -0,0 +1,32 @@
+/*
+ * File: parallel.h
+ * ----------------
+ * A small work-stealing parallel loop for splitting image filters into
+ * independent tiles.
+ */
+
+#ifndef _parallel_h
+#define _parallel_h
+
+#include <functional>
+
+/*
+ * Calls body(i) once for every i in [0, count), spread across worker
+ * threads.  Each worker starts with an equal contiguous share of the
+ * indexes and, once its own share is used up, steals the back half of the
+ * largest share still remaining, so uneven tiles do not leave threads idle.
+ * The calls for different indexes may run concurrently and in any order;
+ * parallelFor returns once all of them have finished.
+ *
+ * 'workers' is the maximum number of threads to use, counting the calling
+ * thread; 0 means one per processor.  An exception thrown by the body is
+ * rethrown to the caller after the other workers stop.
+ */
+void parallelFor(int count, const std::function<void(int)>& body, int workers = 0);
+
+/*
+ * Returns the number of worker threads parallelFor uses by default.
+ */
+int defaultWorkerCount();
+
+#endif
@@ -0,0 +1,444 @@
+/*
+ * File: planar.cpp
+ * ----------------
+ * Implements the planar image type and the kernels declared in planar.h.
+ *
+ * Every kernel is written three times: a plain loop, an SSE2 version and an
+ * AVX2 version.  The vector versions are compiled with per-function target
+ * attributes rather than global compiler flags, so the program still runs
+ * on processors without AVX2; which version is used is decided at run time.
+ * The convolution keeps the scalar code's double-precision sums and adds the
+ * products in the same order, only for several pixels at once, so its
+ * results do not depend on the version either.
+ */
+
+#include "planar.h"
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PLANAR_X86
+#include <immintrin.h>
+#define SSE2_TARGET __attribute__((target("sse2")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+using namespace std;
+
+PlanarImage::PlanarImage() : width(0), height(0) {
+    /* Empty */
+}
+
+PlanarImage::PlanarImage(int width, int height)
+        : width(width), height(height),
+          red(width * height), green(width * height), blue(width * height) {
+    /* Empty */
+}
+
+PlanarImage toPlanar(GridView<const int> grid) {
+    PlanarImage image(grid.width(), grid.height());
+    if (grid.isEmpty()) {
+        return image;
+    }
+    for (int y = 0; y < image.height; y++) {
+        unsigned char* r = &image.red[y * image.width];
+        unsigned char* g = &image.green[y * image.width];
+        unsigned char* b = &image.blue[y * image.width];
+        for (int x = 0; x < image.width; x++) {
+            int rgb = grid(y, x);
+            r[x] = (unsigned char) (rgb >> 16);
+            g[x] = (unsigned char) (rgb >> 8);
+            b[x] = (unsigned char) rgb;
+        }
+    }
+    return image;
+}
+
+Grid<int> fromPlanar(const PlanarImage& image) {
+    Grid<int> grid(image.height, image.width);
+    int count = image.width * image.height;
+    if (count == 0) {
+        return grid;
+    }
+    int* dest = &*grid.begin();
+    const unsigned char* r = &image.red[0];
+    const unsigned char* g = &image.green[0];
+    const unsigned char* b = &image.blue[0];
+    for (int i = 0; i < count; i++) {
+        dest[i] = (r[i] << 16) | (g[i] << 8) | b[i];
+    }
+    return grid;
+}
+
+namespace kernels {
+
+/*
+ * Scalar versions.  The vector versions fall back on these for the pixels
+ * left over at the end of a row.
+ */
+
+static void maxAbsDiffScalar(const unsigned char* a, const unsigned char* b,
+                             unsigned char* acc, int count) {
+    for (int i = 0; i < count; i++) {
+        unsigned char d = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+        if (d > acc[i]) {
+            acc[i] = d;
+        }
+    }
+}
+
+static void thresholdMaskScalar(const unsigned char* in, int threshold,
+                                unsigned char* out, int count) {
+    for (int i = 0; i < count; i++) {
+        out[i] = in[i] > threshold ? 255 : 0;
+    }
+}
+
+static int countDifferentScalar(const int* a, const int* b, int count) {
+    int diff = 0;
+    for (int i = 0; i < count; i++) {
+        if (a[i] != b[i]) {
+            diff++;
+        }
+    }
+    return diff;
+}
+
+static void widenScalar(const unsigned char* in, double* out, int count) {
+    for (int i = 0; i < count; i++) {
+        out[i] = in[i];
+    }
+}
+
+/*
+ * Computes out[i] for i in [start, count) only, since the rows cannot be
+ * offset as a whole the way the other kernels offset their arrays.
+ */
+static void convolveScalar(const double* const* rows, const double* kernel, int taps,
+                           unsigned char* out, int start, int count) {
+    for (int i = start; i < count; i++) {
+        double sum = 0;
+        for (int k = 0; k < taps; k++) {
+            sum += kernel[k] * rows[k][i];
+        }
+        out[i] = (unsigned char) (int) sum;
+    }
+}
+
+#ifdef PLANAR_X86
+
+/*
+ * SSE2 versions: 16 bytes, 4 ints or 2 doubles per instruction.
+ */
+
+SSE2_TARGET
+static void maxAbsDiffSse2(const unsigned char* a, const unsigned char* b,
+                           unsigned char* acc, int count) {
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i*) (a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*) (b + i));
+        __m128i d = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        __m128i* p = (__m128i*) (acc + i);
+        _mm_storeu_si128(p, _mm_max_epu8(_mm_loadu_si128(p), d));
+    }
+    maxAbsDiffScalar(a + i, b + i, acc + i, count - i);
+}
+
+SSE2_TARGET
+static void thresholdMaskSse2(const unsigned char* in, int threshold,
+                              unsigned char* out, int count) {
+    __m128i t = _mm_set1_epi8((char) threshold);
+    __m128i zero = _mm_setzero_si128();
+    __m128i ones = _mm_set1_epi8((char) 0xff);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        // in > t exactly when the saturating difference in - t is nonzero
+        __m128i above = _mm_subs_epu8(_mm_loadu_si128((const __m128i*) (in + i)), t);
+        __m128i mask = _mm_xor_si128(_mm_cmpeq_epi8(above, zero), ones);
+        _mm_storeu_si128((__m128i*) (out + i), mask);
+    }
+    thresholdMaskScalar(in + i, threshold, out + i, count - i);
+}
+
+SSE2_TARGET
+static int countDifferentSse2(const int* a, const int* b, int count) {
+    // equal lanes compare to -1, so subtracting the comparisons counts them
+    __m128i same = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) (a + i)),
+                                     _mm_loadu_si128((const __m128i*) (b + i)));
+        same = _mm_sub_epi32(same, eq);
+    }
+    int lanes[4];
+    _mm_storeu_si128((__m128i*) lanes, same);
+    return (i - lanes[0] - lanes[1] - lanes[2] - lanes[3])
+            + countDifferentScalar(a + i, b + i, count - i);
+}
+
+/*
+ * Converts 8 bytes at p to doubles, two per register.
+ */
+SSE2_TARGET
+static inline void loadDoublesSse2(const unsigned char* p, __m128d* v) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i words = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*) p), zero);
+    __m128i lo = _mm_unpacklo_epi16(words, zero);
+    __m128i hi = _mm_unpackhi_epi16(words, zero);
+    v[0] = _mm_cvtepi32_pd(lo);
+    v[1] = _mm_cvtepi32_pd(_mm_shuffle_epi32(lo, 0xee));
+    v[2] = _mm_cvtepi32_pd(hi);
+    v[3] = _mm_cvtepi32_pd(_mm_shuffle_epi32(hi, 0xee));
+}
+
+/*
+ * Truncates 8 sums to ints and stores them as bytes.
+ */
+SSE2_TARGET
+static inline void storeBytesSse2(const __m128d* sum, unsigned char* out) {
+    __m128i lo = _mm_unpacklo_epi64(_mm_cvttpd_epi32(sum[0]), _mm_cvttpd_epi32(sum[1]));
+    __m128i hi = _mm_unpacklo_epi64(_mm_cvttpd_epi32(sum[2]), _mm_cvttpd_epi32(sum[3]));
+    __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(lo, hi), _mm_setzero_si128());
+    _mm_storel_epi64((__m128i*) out, bytes);
+}
+
+SSE2_TARGET
+static void widenSse2(const unsigned char* in, double* out, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128d v[4];
+        loadDoublesSse2(in + i, v);
+        for (int j = 0; j < 4; j++) {
+            _mm_storeu_pd(out + i + 2 * j, v[j]);
+        }
+    }
+    widenScalar(in + i, out + i, count - i);
+}
+
+SSE2_TARGET
+static void convolveSse2(const double* const* rows, const double* kernel, int taps,
+                         unsigned char* out, int count) {
+    // eight independent sums hide the latency of the additions
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128d sum[8];
+        for (int j = 0; j < 8; j++) {
+            sum[j] = _mm_setzero_pd();
+        }
+        for (int k = 0; k < taps; k++) {
+            __m128d weight = _mm_set1_pd(kernel[k]);
+            const double* in = rows[k] + i;
+            for (int j = 0; j < 8; j++) {
+                sum[j] = _mm_add_pd(sum[j], _mm_mul_pd(weight, _mm_loadu_pd(in + 2 * j)));
+            }
+        }
+        storeBytesSse2(sum, out + i);
+        storeBytesSse2(sum + 4, out + i + 8);
+    }
+    convolveScalar(rows, kernel, taps, out, i, count);
+}
+
+/*
+ * AVX2 versions: 32 bytes, 8 ints or 4 doubles per instruction.  Only the
+ * avx2 target is enabled, not fma, so a multiply followed by an add is never
+ * fused into one differently rounded instruction.
+ */
+
+AVX2_TARGET
+static void maxAbsDiffAvx2(const unsigned char* a, const unsigned char* b,
+                           unsigned char* acc, int count) {
+    int i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i va = _mm256_loadu_si256((const __m256i*) (a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*) (b + i));
+        __m256i d = _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+        __m256i* p = (__m256i*) (acc + i);
+        _mm256_storeu_si256(p, _mm256_max_epu8(_mm256_loadu_si256(p), d));
+    }
+    maxAbsDiffScalar(a + i, b + i, acc + i, count - i);
+}
+
+AVX2_TARGET
+static void thresholdMaskAvx2(const unsigned char* in, int threshold,
+                              unsigned char* out, int count) {
+    __m256i t = _mm256_set1_epi8((char) threshold);
+    __m256i zero = _mm256_setzero_si256();
+    __m256i ones = _mm256_set1_epi8((char) 0xff);
+    int i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i above = _mm256_subs_epu8(_mm256_loadu_si256((const __m256i*) (in + i)), t);
+        __m256i mask = _mm256_xor_si256(_mm256_cmpeq_epi8(above, zero), ones);
+        _mm256_storeu_si256((__m256i*) (out + i), mask);
+    }
+    thresholdMaskScalar(in + i, threshold, out + i, count - i);
+}
+
+AVX2_TARGET
+static int countDifferentAvx2(const int* a, const int* b, int count) {
+    __m256i same = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (a + i)),
+                                        _mm256_loadu_si256((const __m256i*) (b + i)));
+        same = _mm256_sub_epi32(same, eq);
+    }
+    int lanes[8];
+    _mm256_storeu_si256((__m256i*) lanes, same);
+    int diff = i;
+    for (int j = 0; j < 8; j++) {
+        diff -= lanes[j];
+    }
+    return diff + countDifferentScalar(a + i, b + i, count - i);
+}
+
+/*
+ * Converts 16 bytes at p to doubles, four per register.
+ */
+AVX2_TARGET
+static inline void loadDoublesAvx2(const unsigned char* p, __m256d* v) {
+    __m128i bytes = _mm_loadu_si128((const __m128i*) p);
+    v[0] = _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(bytes));
+    v[1] = _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_srli_si128(bytes, 4)));
+    v[2] = _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_srli_si128(bytes, 8)));
+    v[3] = _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_srli_si128(bytes, 12)));
+}
+
+/*
+ * Truncates 16 sums to ints and stores them as bytes.
+ */
+AVX2_TARGET
+static inline void storeBytesAvx2(const __m256d* sum, unsigned char* out) {
+    __m128i lo = _mm_packs_epi32(_mm256_cvttpd_epi32(sum[0]), _mm256_cvttpd_epi32(sum[1]));
+    __m128i hi = _mm_packs_epi32(_mm256_cvttpd_epi32(sum[2]), _mm256_cvttpd_epi32(sum[3]));
+    _mm_storeu_si128((__m128i*) out, _mm_packus_epi16(lo, hi));
+}
+
+AVX2_TARGET
+static void widenAvx2(const unsigned char* in, double* out, int count) {
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256d v[4];
+        loadDoublesAvx2(in + i, v);
+        for (int j = 0; j < 4; j++) {
+            _mm256_storeu_pd(out + i + 4 * j, v[j]);
+        }
+    }
+    widenScalar(in + i, out + i, count - i);
+}
+
+AVX2_TARGET
+static void convolveAvx2(const double* const* rows, const double* kernel, int taps,
+                         unsigned char* out, int count) {
+    int i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256d sum[8];
+        for (int j = 0; j < 8; j++) {
+            sum[j] = _mm256_setzero_pd();
+        }
+        for (int k = 0; k < taps; k++) {
+            __m256d weight = _mm256_set1_pd(kernel[k]);
+            const double* in = rows[k] + i;
+            for (int j = 0; j < 8; j++) {
+                sum[j] = _mm256_add_pd(sum[j], _mm256_mul_pd(weight, _mm256_loadu_pd(in + 4 * j)));
+            }
+        }
+        storeBytesAvx2(sum, out + i);
+        storeBytesAvx2(sum + 4, out + i + 16);
+    }
+    convolveScalar(rows, kernel, taps, out, i, count);
+}
+
+#endif // PLANAR_X86
+
+/*
+ * Run-time dispatch.  The level is detected on first use and kept in an
+ * atomic so that filters running on several threads can share it.
+ */
+
+static SimdLevel bestSupportedLevel() {
+#ifdef PLANAR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SIMD_SSE2;
+    }
+#endif
+    return SIMD_SCALAR;
+}
+
+static atomic<int> currentLevel(-1);
+
+SimdLevel simdLevel() {
+    int level = currentLevel.load(memory_order_relaxed);
+    if (level < 0) {
+        level = bestSupportedLevel();
+        currentLevel.store(level, memory_order_relaxed);
+    }
+    return (SimdLevel) level;
+}
+
+SimdLevel setSimdLevel(SimdLevel level) {
+    SimdLevel best = bestSupportedLevel();
+    if (level > best) {
+        level = best;
+    }
+    currentLevel.store(level, memory_order_relaxed);
+    return level;
+}
+
+void maxAbsDiff(const unsigned char* a, const unsigned char* b,
+                unsigned char* acc, int count) {
+    switch (simdLevel()) {
+#ifdef PLANAR_X86
+    case SIMD_AVX2: maxAbsDiffAvx2(a, b, acc, count); return;
+    case SIMD_SSE2: maxAbsDiffSse2(a, b, acc, count); return;
+#endif
+    default: maxAbsDiffScalar(a, b, acc, count); return;
+    }
+}
+
+void thresholdMask(const unsigned char* in, int threshold,
+                   unsigned char* out, int count) {
+    switch (simdLevel()) {
+#ifdef PLANAR_X86
+    case SIMD_AVX2: thresholdMaskAvx2(in, threshold, out, count); return;
+    case SIMD_SSE2: thresholdMaskSse2(in, threshold, out, count); return;
+#endif
+    default: thresholdMaskScalar(in, threshold, out, count); return;
+    }
+}
+
+int countDifferent(const int* a, const int* b, int count) {
+    switch (simdLevel()) {
+#ifdef PLANAR_X86
+    case SIMD_AVX2: return countDifferentAvx2(a, b, count);
+    case SIMD_SSE2: return countDifferentSse2(a, b, count);
+#endif
+    default: return countDifferentScalar(a, b, count);
+    }
+}
+
+void widen(const unsigned char* in, double* out, int count) {
+    switch (simdLevel()) {
+#ifdef PLANAR_X86
+    case SIMD_AVX2: widenAvx2(in, out, count); return;
+    case SIMD_SSE2: widenSse2(in, out, count); return;
+#endif
+    default: widenScalar(in, out, count); return;
+    }
+}
+
+void convolve(const double* const* rows, const double* kernel, int taps,
+              unsigned char* out, int count) {
+    switch (simdLevel()) {
+#ifdef PLANAR_X86
+    case SIMD_AVX2: convolveAvx2(rows, kernel, taps, out, count); return;
+    case SIMD_SSE2: convolveSse2(rows, kernel, taps, out, count); return;
+#endif
+    default: convolveScalar(rows, kernel, taps, out, 0, count); return;
+    }
+}
+
+} // namespace kernels
@@ -0,0 +1,101 @@
+/*
+ * File: planar.h
+ * --------------
+ * A planar image representation with separate 8-bit red, green and blue
+ * planes, and the vectorized kernels the filters in filters.h run on it.
+ *
+ * A packed Grid<int> keeps the three channels of a pixel together, so a
+ * per-channel test has to unpack every pixel first.  In a PlanarImage each
+ * channel is a contiguous array of bytes, which lets one SSE2 instruction
+ * handle 16 pixels (32 with AVX2).  Each kernel has a scalar version plus
+ * SSE2 and AVX2 versions on x86 processors; the fastest one the running
+ * processor supports is picked the first time a kernel is called.  All
+ * versions give exactly the same results.
+ */
+
+#ifndef _planar_h
+#define _planar_h
+
+#include <vector>
+#include "grid.h"
+#include "gridview.h"
+
+/*
+ * Three planes of channel values, each stored row-major with 'width'
+ * bytes per row.
+ */
+struct PlanarImage {
+    int width;
+    int height;
+    std::vector<unsigned char> red;
+    std::vector<unsigned char> green;
+    std::vector<unsigned char> blue;
+
+    PlanarImage();
+    PlanarImage(int width, int height);
+};
+
+/*
+ * Splits the packed RGB pixels of a grid, or of any view of one, into
+ * planes, and back.
+ */
+PlanarImage toPlanar(GridView<const int> grid);
+Grid<int> fromPlanar(const PlanarImage& image);
+
+namespace kernels {
+
+/*
+ * The instruction sets a kernel can be implemented with.
+ */
+enum SimdLevel { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 };
+
+/*
+ * Returns the instruction set the kernels currently use.
+ */
+SimdLevel simdLevel();
+
+/*
+ * Makes the kernels use the given instruction set, or the best one the
+ * processor supports if that one is not available.  Returns the level
+ * actually chosen.
+ */
+SimdLevel setSimdLevel(SimdLevel level);
+
+/*
+ * For each i in [0, count): acc[i] = max(acc[i], |a[i] - b[i]|).
+ */
+void maxAbsDiff(const unsigned char* a, const unsigned char* b,
+                unsigned char* acc, int count);
+
+/*
+ * For each i in [0, count): out[i] = in[i] > threshold ? 255 : 0.
+ * 'threshold' must be in [0, 255].
+ */
+void thresholdMask(const unsigned char* in, int threshold,
+                   unsigned char* out, int count);
+
+/*
+ * Returns the number of positions at which a and b hold different values.
+ * This works on packed pixels directly, so grids need no conversion.
+ */
+int countDifferent(const int* a, const int* b, int count);
+
+/*
+ * Converts bytes to doubles, for the inputs of convolve.
+ */
+void widen(const unsigned char* in, double* out, int count);
+
+/*
+ * One-dimensional convolution:
+ * out[i] = (int) (kernel[0] * rows[0][i] + ... + kernel[taps-1] * rows[taps-1][i])
+ * for i in [0, count), summed in that order in double precision.  For a
+ * vertical pass the rows are image rows; for a horizontal pass rows[k] is
+ * the padded input row shifted by k.  The kernel weights must be
+ * non-negative and sum to 1 so that every result fits in a byte.
+ */
+void convolve(const double* const* rows, const double* kernel, int taps,
+              unsigned char* out, int count);
+
+} // namespace kernels
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * File: benchutil.h
+ * -----------------
+ * Small helpers shared by the benchmark programs in this folder.
+ *
+ * @version 2026/10/18
+ * @since 2026/10/18
+ */
+
+#ifndef _benchutil_h
+#define _benchutil_h
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+/*
+ * Returns the problem size given on the command line, the first argument
+ * that is a positive number, or 'defaultSize' if there is none.
+ */
+inline int benchmarkSize(int argc, char** argv, int defaultSize) {
+    for (int i = 1; i < argc; i++) {
+        int size = std::atoi(argv[i]);
+        if (size > 0) {
+            return size;
+        }
+    }
+    return defaultSize;
+}
+
+/*
+ * Runs fn 'repeats' times and returns the fastest run in milliseconds.
+ */
+template <typename Function>
+double timeMs(Function fn, int repeats = 3) {
+    double best = 0.0;
+    for (int i = 0; i < repeats; i++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+        if (i == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+/*
+ * Prints one line of a comparison between an old and a new implementation.
+ */
+inline void printTiming(const std::string& label, double oldMs, double newMs) {
+    std::cout << std::left << std::setw(34) << label << std::right << std::fixed
+              << std::setprecision(2) << std::setw(10) << oldMs << " ms"
+              << std::setw(10) << newMs << " ms" << std::setw(8)
+              << std::setprecision(2) << (newMs > 0 ? oldMs / newMs : 0.0) << "x"
+              << std::endl;
+}
+
+/*
+ * Prints the header for printTiming's lines.
+ */
+inline void printTimingHeader(const std::string& title, const std::string& oldName,
+                              const std::string& newName) {
+    std::cout << title << std::endl;
+    std::cout << std::left << std::setw(34) << "" << std::right << std::setw(13)
+              << oldName << std::setw(13) << newName << std::setw(9) << "speedup"
+              << std::endl;
+}
+
+#endif
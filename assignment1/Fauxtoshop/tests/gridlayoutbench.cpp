@@ -0,0 +1,96 @@
+/*
+ * File: gridlayoutbench.cpp
+ * -------------------------
+ * Times row-major and column-major traversals of a Grid of ints in each
+ * of its layouts.  RowMajorLayout stores the elements exactly as Grid did
+ * before layouts were added, one row after another, so it is the baseline
+ * the padded and tiled layouts are compared with.  Every layout must
+ * give the same sums; the program fails if they do not.
+ *
+ * Usage: gridlayoutbench [N]   (an N x N grid; default 2048)
+ *
+ * @version 2026/10/18
+ * @since 2026/10/18
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "benchutil.h"
+#include "grid.h"
+#include "strlib.h"
+
+using namespace std;
+
+static const int OPERATIONS = 4;
+
+/*
+ * Times the traversals of an n x n grid with the given layout, storing the
+ * times and the sums they compute.
+ */
+template <typename Layout>
+static void runLayout(int n, double times[OPERATIONS], long long sums[OPERATIONS]) {
+    Grid<int, Layout> grid(n, n);
+    for (int r = 0; r < n; r++) {
+        for (int c = 0; c < n; c++) {
+            grid.set(r, c, (r * 31 + c * 17) & 0xffff);
+        }
+    }
+    const Grid<int, Layout>& constGrid = grid;
+    long long sum = 0;
+    auto add = [&](int value) { sum += value; };
+
+    times[0] = timeMs([&]() { sum = 0; constGrid.mapAll(add); });
+    sums[0] = sum;
+    times[1] = timeMs([&]() { sum = 0; constGrid.mapAllColumnMajor(add); });
+    sums[1] = sum;
+    times[2] = timeMs([&]() {
+        sum = 0;
+        for (int r = 0; r < n; r++) {
+            for (int c = 0; c < n; c++) {
+                sum += constGrid[r][c] ^ c;
+            }
+        }
+    });
+    sums[2] = sum;
+    times[3] = timeMs([&]() {
+        sum = 0;
+        for (int c = 0; c < n; c++) {
+            for (int r = 0; r < n; r++) {
+                sum += constGrid[r][c] ^ c;
+            }
+        }
+    });
+    sums[3] = sum;
+}
+
+int main(int argc, char** argv) {
+    static const char* LABELS[OPERATIONS] = {
+        "mapAll (row-major)", "mapAllColumnMajor",
+        "grid[r][c], rows outer", "grid[r][c], columns outer"
+    };
+    int n = benchmarkSize(argc, argv, 2048);
+    double times[3][OPERATIONS];
+    long long sums[3][OPERATIONS];
+    runLayout<RowMajorLayout>(n, times[0], sums[0]);
+    runLayout<PaddedRowLayout>(n, times[1], sums[1]);
+    runLayout<TiledLayout>(n, times[2], sums[2]);
+
+    cout << "Traversals of a " << n << "x" << n << " Grid<int>, in ms" << endl;
+    cout << left << setw(28) << "" << right << setw(12) << "RowMajor"
+         << setw(12) << "PaddedRow" << setw(12) << "Tiled" << endl;
+    bool ok = true;
+    for (int op = 0; op < OPERATIONS; op++) {
+        cout << left << setw(28) << LABELS[op] << right << fixed << setprecision(2);
+        for (int layout = 0; layout < 3; layout++) {
+            cout << setw(12) << times[layout][op];
+            ok = ok && sums[layout][op] == sums[0][op];
+        }
+        cout << endl;
+    }
+    if (!ok) {
+        cout << "FAIL: the layouts disagree" << endl;
+        return 1;
+    }
+    return 0;
+}
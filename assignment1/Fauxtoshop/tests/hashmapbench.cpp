@@ -0,0 +1,119 @@
+/*
+ * File: hashmapbench.cpp
+ * ----------------------
+ * Compares FlatHashMap with the chained HashMap it can replace, for int and
+ * string keys: adding N entries, looking up every key, looking up N keys
+ * that are absent, iterating, and removing half of the keys.  Both maps
+ * must give the same answers; the program fails if they do not.
+ *
+ * Usage: hashmapbench [N]   (default 100000)
+ *
+ * @version 2026/10/18
+ * @since 2026/10/18
+ */
+
+#include <string>
+#include <vector>
+#include "benchutil.h"
+#include "flathashmap.h"
+#include "hashmap.h"
+#include "strlib.h"
+
+using namespace std;
+
+/*
+ * The results of one run of the operations, compared between the maps.
+ */
+struct Totals {
+    long long found;
+    long long missing;
+    long long iterated;
+    int remaining;
+
+    bool operator ==(const Totals& other) const {
+        return found == other.found && missing == other.missing
+                && iterated == other.iterated && remaining == other.remaining;
+    }
+};
+
+/*
+ * Times each operation on a map of type MapType with the given keys, none
+ * of which appear in 'absent'.
+ */
+template <typename MapType, typename KeyType>
+static Totals runMap(const vector<KeyType>& keys, const vector<KeyType>& absent,
+                     double times[5]) {
+    Totals totals = {0, 0, 0, 0};
+    MapType map;
+    times[0] = timeMs([&]() {
+        map.clear();
+        for (size_t i = 0; i < keys.size(); i++) {
+            map.put(keys[i], (int) i);
+        }
+    });
+    times[1] = timeMs([&]() {
+        totals.found = 0;
+        for (size_t i = 0; i < keys.size(); i++) {
+            totals.found += map.get(keys[i]);
+        }
+    });
+    times[2] = timeMs([&]() {
+        totals.missing = 0;
+        for (size_t i = 0; i < absent.size(); i++) {
+            totals.missing += map.containsKey(absent[i]);
+        }
+    });
+    times[3] = timeMs([&]() {
+        totals.iterated = 0;
+        for (const KeyType& key : map) {
+            totals.iterated += map[key];
+        }
+    });
+    times[4] = timeMs([&]() {
+        MapType copy = map;
+        for (size_t i = 0; i < keys.size(); i += 2) {
+            copy.remove(keys[i]);
+        }
+        totals.remaining = copy.size();
+    }, 1);
+    return totals;
+}
+
+template <typename KeyType>
+static bool compareMaps(const string& title, const vector<KeyType>& keys,
+                        const vector<KeyType>& absent) {
+    static const char* LABELS[5] = {
+        "put N keys", "get N present keys", "containsKey N absent keys",
+        "iterate", "copy, then remove N/2 keys"
+    };
+    double oldTimes[5], newTimes[5];
+    Totals oldTotals = runMap<HashMap<KeyType, int> >(keys, absent, oldTimes);
+    Totals newTotals = runMap<FlatHashMap<KeyType, int> >(keys, absent, newTimes);
+    printTimingHeader(title, "HashMap", "FlatHashMap");
+    for (int i = 0; i < 5; i++) {
+        printTiming(LABELS[i], oldTimes[i], newTimes[i]);
+    }
+    if (!(oldTotals == newTotals)) {
+        cout << "FAIL: the maps disagree" << endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int n = benchmarkSize(argc, argv, 100000);
+    vector<int> intKeys, intAbsent;
+    vector<string> stringKeys, stringAbsent;
+    for (int i = 0; i < n; i++) {
+        // 2iK is distinct for each i when K is odd, so the odd keys are
+        // scattered and none of the even ones is present
+        intKeys.push_back((int) (2u * i * 2654435761u + 1));
+        intAbsent.push_back((int) (2u * i * 2654435761u));
+        stringKeys.push_back("key" + integerToString(i));
+        stringAbsent.push_back("absent" + integerToString(i));
+    }
+    bool ok = compareMaps("int keys, N = " + integerToString(n), intKeys, intAbsent);
+    cout << endl;
+    ok = compareMaps("string keys, N = " + integerToString(n), stringKeys, stringAbsent) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+/*
+ * File: huffmanbench.cpp
+ * ----------------------
+ * Compares the table-driven HuffmanCode with the way the Huffman assignment
+ * codes data: a tree of nodes walked one bit at a time with readBit, and a
+ * string of '0's and '1's per symbol written with writeBit.  The tree holds
+ * the same canonical code, so both coders must write identical bits and
+ * read back the original data; the program fails if they do not.
+ *
+ * Usage: huffmanbench [N]   (default 1000000 bytes)
+ *
+ * @version 2026/10/18
+ * @since 2026/10/18
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "benchutil.h"
+#include "bitstream.h"
+#include "huffmancode.h"
+#include "random.h"
+#include "strlib.h"
+
+using namespace std;
+
+/*
+ * A node of the tree walked by the bit-at-a-time decoder; a leaf has no
+ * children.
+ */
+struct TreeNode {
+    int symbol;
+    TreeNode* zero;
+    TreeNode* one;
+
+    TreeNode() : symbol(-1), zero(NULL), one(NULL) {}
+
+    ~TreeNode() {
+        delete zero;
+        delete one;
+    }
+};
+
+/*
+ * The assignment-style coder for the canonical code in 'code': the tree
+ * and the string of bits for each symbol.
+ */
+struct TreeCoder {
+    TreeNode root;
+    vector<string> bits;
+
+    explicit TreeCoder(const HuffmanCode& code) : bits(code.symbolCount()) {
+        // canonical order: shorter codes first, then by symbol
+        vector<int> order;
+        for (int symbol = 0; symbol < code.symbolCount(); symbol++) {
+            if (code.codeLength(symbol) > 0) {
+                order.push_back(symbol);
+            }
+        }
+        stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            return code.codeLength(a) < code.codeLength(b);
+        });
+        unsigned int next = 0;
+        int length = 0;
+        for (int symbol : order) {
+            next <<= code.codeLength(symbol) - length;
+            length = code.codeLength(symbol);
+            TreeNode* node = &root;
+            for (int i = length - 1; i >= 0; i--) {
+                bool bit = (next >> i) & 1;
+                bits[symbol] += bit ? '1' : '0';
+                TreeNode*& child = bit ? node->one : node->zero;
+                if (child == NULL) {
+                    child = new TreeNode();
+                }
+                node = child;
+            }
+            node->symbol = symbol;
+            next++;
+        }
+    }
+
+    void encode(obitstream& out, const string& data) const {
+        for (unsigned char ch : data) {
+            for (char bit : bits[ch]) {
+                out.writeBit(bit == '1');
+            }
+        }
+    }
+
+    string decode(ibitstream& in, int n) const {
+        string data;
+        for (int i = 0; i < n; i++) {
+            const TreeNode* node = &root;
+            while (node->zero != NULL || node->one != NULL) {
+                node = in.readBit() ? node->one : node->zero;
+            }
+            data += (char) node->symbol;
+        }
+        return data;
+    }
+};
+
+/*
+ * Text-like data: letters drawn with skewed frequencies, with spaces and
+ * an occasional punctuation mark or digit.
+ */
+static string makeData(int n) {
+    static const string COMMON = "etaoinshrdlcumwfgypbvkjxqz";
+    RandomGenerator rng(106);
+    string data;
+    for (int i = 0; i < n; i++) {
+        double p = rng.nextReal(0, 1);
+        if (p < 0.17) {
+            data += ' ';
+        } else if (p < 0.19) {
+            data += ".,;:!?'\"0123456789"[rng.nextInteger(0, 17)];
+        } else {
+            // a geometric choice favors the letters early in COMMON
+            int index = 0;
+            while (index < 25 && rng.nextChance(0.2)) {
+                index++;
+            }
+            data += rng.nextChance(0.03) ? toupper(COMMON[index]) : COMMON[index];
+        }
+    }
+    return data;
+}
+
+int main(int argc, char** argv) {
+    int n = benchmarkSize(argc, argv, 1000000);
+    string data = makeData(n);
+    vector<unsigned long long> frequencies(256, 0);
+    for (unsigned char ch : data) {
+        frequencies[ch]++;
+    }
+    HuffmanCode code(frequencies);
+    TreeCoder tree(code);
+    const unsigned char* bytes = (const unsigned char*) data.data();
+
+    string tableBits, treeBits;
+    double tableEncode = timeMs([&]() {
+        ostringbitstream out;
+        code.encode(out, bytes, n);
+        tableBits = out.str();
+    });
+    double treeEncode = timeMs([&]() {
+        ostringbitstream out;
+        tree.encode(out, data);
+        treeBits = out.str();
+    });
+
+    string tableData, treeData;
+    double tableDecode = timeMs([&]() {
+        istringbitstream in(tableBits);
+        vector<unsigned char> symbols(n);
+        int count = code.decode(in, &symbols[0], n);
+        tableData.assign(symbols.begin(), symbols.begin() + count);
+    });
+    double treeDecode = timeMs([&]() {
+        istringbitstream in(treeBits);
+        treeData = tree.decode(in, n);
+    });
+
+    double megabytes = n / 1e6;
+    printTimingHeader("Huffman coding of " + integerToString(n) + " bytes into "
+                      + integerToString((int) tableBits.size()) + " bytes",
+                      "tree/bits", "HuffmanCode");
+    printTiming("encode", treeEncode, tableEncode);
+    printTiming("decode", treeDecode, tableDecode);
+    cout << "decode throughput: " << megabytes / (treeDecode / 1000) << " MB/s by tree, "
+         << megabytes / (tableDecode / 1000) << " MB/s by table" << endl;
+
+    if (tableBits != treeBits || tableData != data || treeData != data) {
+        cout << "FAIL: the coders disagree" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,186 @@
+/*
+ * File: oldpqueue.h
+ * -----------------
+ * The binary heap that PriorityQueue used before it became a 4-ary indexed
+ * heap, kept so that pqueuebench can compare the two.  Only the methods the
+ * benchmark needs are copied; their bodies are unchanged from the 2015/07/05
+ * pqueue.h apart from the class name.
+ *
+ * @version 2026/10/18
+ * @since 2026/10/18
+ */
+
+#ifndef _oldpqueue_h
+#define _oldpqueue_h
+
+#include "error.h"
+#include "vector.h"
+
+/*
+ * Class: BinaryHeapPriorityQueue<ValueType>
+ * -----------------------------------------
+ * The old PriorityQueue: a binary heap of entries holding the values
+ * themselves, with changePriority searching the heap for the value.
+ */
+template <typename ValueType>
+class BinaryHeapPriorityQueue {
+public:
+    BinaryHeapPriorityQueue() {
+        clear();
+    }
+
+    void changePriority(ValueType value, double newPriority);
+    void clear();
+    ValueType dequeue();
+    void enqueue(const ValueType& value, double priority);
+
+    bool isEmpty() const {
+        return count == 0;
+    }
+
+    int size() const {
+        return count;
+    }
+
+private:
+    /* Type used for each heap entry */
+    struct HeapEntry {
+        ValueType value;
+        double priority;
+        long sequence;
+    };
+
+    /* Instance variables */
+    Vector<HeapEntry> heap;
+    long enqueueCount;
+    int backIndex;
+    int count;
+
+    /* Private function prototypes */
+    bool takesPriority(int i1, int i2);
+    void swapHeapEntries(int i1, int i2);
+};
+
+template <typename ValueType>
+void BinaryHeapPriorityQueue<ValueType>::changePriority(ValueType value, double newPriority) {
+    if (!(newPriority == newPriority)) {
+        error("PriorityQueue::changePriority: Attempted to use NaN as a priority.");
+    }
+    if (newPriority == -0.0) {
+        newPriority = 0.0;
+    }
+
+    // find the element in the pqueue; must use a simple iteration over elements
+    for (int i = 0; i < count; i++) {
+        if (heap[i].value == value) {
+            if (heap[i].priority < newPriority) {
+                error("PriorityQueue::changePriority: new priority cannot be less urgent than current priority.");
+            }
+            heap[i].priority = newPriority;
+
+            // after changing the priority, must percolate up to proper level
+            // to maintain heap ordering
+            while (i > 0) {
+                int parent = (i - 1) / 2;
+                if (takesPriority(parent, i)) {
+                    break;
+                }
+                swapHeapEntries(parent, i);
+                i = parent;
+            }
+
+            return;
+        }
+    }
+
+    // if we get here, the element was not ever found
+    error("PriorityQueue::changePriority: Element value not found.");
+}
+
+template <typename ValueType>
+void BinaryHeapPriorityQueue<ValueType>::clear() {
+    heap.clear();
+    count = 0;
+    enqueueCount = 0;
+}
+
+template <typename ValueType>
+ValueType BinaryHeapPriorityQueue<ValueType>::dequeue() {
+    if (count == 0) {
+        error("PriorityQueue::dequeue: Attempting to dequeue an empty queue");
+    }
+    count--;
+    bool wasBack = (backIndex == count);
+    ValueType value = heap[0].value;
+    swapHeapEntries(0, count);
+    int index = 0;
+    while (true) {
+        int left = 2 * index + 1;
+        int right = 2 * index + 2;
+        if (left >= count) {
+            break;
+        }
+        int child = left;
+        if (right < count && takesPriority(right, left)) {
+            child = right;
+        }
+        if (takesPriority(index, child)) {
+            break;
+        }
+        swapHeapEntries(index, child);
+        index = child;
+    }
+    if (wasBack) {
+        backIndex = index;
+    }
+    return value;
+}
+
+template <typename ValueType>
+void BinaryHeapPriorityQueue<ValueType>::enqueue(const ValueType& value, double priority) {
+    if (!(priority == priority)) {
+        error("PriorityQueue::enqueue: Attempted to use NaN as a priority.");
+    }
+    if (priority == -0.0) {
+        priority = 0.0;
+    }
+
+    if (count == heap.size()) {
+        heap.add(HeapEntry());
+    }
+    int index = count++;
+    heap[index].value = value;
+    heap[index].priority = priority;
+    heap[index].sequence = enqueueCount++;
+    if (index == 0 || takesPriority(backIndex, index)) {
+        backIndex = index;
+    }
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (takesPriority(parent, index)) {
+            break;
+        }
+        swapHeapEntries(parent, index);
+        index = parent;
+    }
+}
+
+template <typename ValueType>
+void BinaryHeapPriorityQueue<ValueType>::swapHeapEntries(int i1, int i2) {
+    HeapEntry entry = heap[i1];
+    heap[i1] = heap[i2];
+    heap[i2] = entry;
+}
+
+template <typename ValueType>
+bool BinaryHeapPriorityQueue<ValueType>::takesPriority(int i1, int i2) {
+    if (heap[i1].priority < heap[i2].priority) {
+        return true;
+    }
+    if (heap[i1].priority > heap[i2].priority) {
+        return false;
+    }
+    return (heap[i1].sequence < heap[i2].sequence);
+}
+
+#endif
@@ -0,0 +1,117 @@
+/*
+ * File: pqueuebench.cpp
+ * ---------------------
+ * Compares the 4-ary indexed PriorityQueue with the binary heap it replaced
+ * (oldpqueue.h): enqueueing N values, dequeueing them all, building a
+ * queue from N pairs, and raising the priority of N/4 of the values, as a
+ * shortest-path search does.  The old queue searches for the value to
+ * change; the new one is given the handle enqueue returned.  Many of the
+ * priorities are equal, so both queues must dequeue the values in the same
+ * order, ties in FIFO order; the program fails if they do not.
+ *
+ * Usage: pqueuebench [N]   (default 20000)
+ *
+ * @version 2026/10/18
+ * @since 2026/10/18
+ */
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "benchutil.h"
+#include "oldpqueue.h"
+#include "pqueue.h"
+#include "random.h"
+#include "strlib.h"
+
+using namespace std;
+
+/*
+ * Dequeues every value in pq, appending them to 'order'.
+ */
+template <typename QueueType>
+static void dequeueAll(QueueType& pq, vector<int>& order) {
+    order.clear();
+    while (!pq.isEmpty()) {
+        order.push_back(pq.dequeue());
+    }
+}
+
+int main(int argc, char** argv) {
+    int n = benchmarkSize(argc, argv, 20000);
+    RandomGenerator rng(106);
+    vector<pair<int, double> > entries;
+    for (int i = 0; i < n; i++) {
+        entries.push_back(make_pair(i, rng.nextInteger(0, n / 8)));
+    }
+    // each change lowers a random value's priority below its current one
+    vector<pair<int, double> > changes;
+    vector<double> priorities(n);
+    for (int i = 0; i < n; i++) {
+        priorities[i] = entries[i].second;
+    }
+    for (int i = 0; i < n / 4; i++) {
+        int value = rng.nextInteger(0, n - 1);
+        priorities[value] -= rng.nextInteger(0, n / 8);
+        changes.push_back(make_pair(value, priorities[value]));
+    }
+
+    BinaryHeapPriorityQueue<int> oldQueue;
+    PriorityQueue<int> newQueue;
+    vector<PriorityQueue<int>::Handle> handles(n);
+    vector<int> oldOrder, newOrder;
+    bool ok = true;
+
+    double oldEnqueue = timeMs([&]() {
+        oldQueue.clear();
+        for (const pair<int, double>& entry : entries) {
+            oldQueue.enqueue(entry.first, entry.second);
+        }
+    });
+    double newEnqueue = timeMs([&]() {
+        newQueue.clear();
+        for (const pair<int, double>& entry : entries) {
+            handles[entry.first] = newQueue.enqueue(entry.first, entry.second);
+        }
+    });
+
+    // changing priorities and dequeueing empty the queues, so they run once
+    double oldChange = timeMs([&]() {
+        for (const pair<int, double>& change : changes) {
+            oldQueue.changePriority(change.first, change.second);
+        }
+    }, 1);
+    double newChange = timeMs([&]() {
+        for (const pair<int, double>& change : changes) {
+            newQueue.changePriority(handles[change.first], change.second);
+        }
+    }, 1);
+    double oldDequeue = timeMs([&]() { dequeueAll(oldQueue, oldOrder); }, 1);
+    double newDequeue = timeMs([&]() { dequeueAll(newQueue, newOrder); }, 1);
+    ok = ok && oldOrder == newOrder && (int) oldOrder.size() == n;
+
+    double oldBuild = timeMs([&]() {
+        oldQueue.clear();
+        for (const pair<int, double>& entry : entries) {
+            oldQueue.enqueue(entry.first, entry.second);
+        }
+    });
+    double newBuild = timeMs([&]() {
+        newQueue = PriorityQueue<int>(entries.begin(), entries.end());
+    });
+    dequeueAll(oldQueue, oldOrder);
+    dequeueAll(newQueue, newOrder);
+    ok = ok && oldOrder == newOrder && (int) oldOrder.size() == n;
+
+    printTimingHeader("N = " + integerToString(n), "binary heap", "4-ary heap");
+    printTiming("enqueue N values", oldEnqueue, newEnqueue);
+    printTiming("changePriority of N/4 values", oldChange, newChange);
+    printTiming("dequeue N values", oldDequeue, newDequeue);
+    printTiming("build from N pairs", oldBuild, newBuild);
+
+    if (!ok) {
+        cout << "FAIL: the queues disagree" << endl;
+        return 1;
+    }
+    return 0;
+}